@@ -193,6 +193,7 @@ struct LCUI_Graph_ {
 	float opacity;			/**< 全局不透明度，取值范围为 0~1.0 */
 	size_t mem_size;		/**< 像素数据缓冲区大小 */
 	uchar_t *palette;		/**< 调色板 */
+	LCUI_BOOL in_arena;		/**< 像素数据是否分配自帧内存池 */
 };
 
 /** 样式值枚举，用于代替使用字符串 */
@@ -231,7 +232,16 @@ typedef enum LCUI_StyleValue {
 	SV_FLOAT_RIGHT,
 	SV_BLOCK,
 	SV_INLINE_BLOCK,
-	SV_NOWRAP
+	SV_NOWRAP,
+	SV_FLEX,
+	SV_ROW,
+	SV_COLUMN,
+	SV_WRAP,
+	SV_FLEX_START,
+	SV_FLEX_END,
+	SV_STRETCH,
+	SV_SPACE_BETWEEN,
+	SV_SPACE_AROUND
 } LCUI_StyleValue;
 
 typedef struct LCUI_StyleRec_ {
@@ -115,6 +115,12 @@ LCUI_API void LCUIDisplay_Render( void );
 /** 呈现渲染后的内容 */
 LCUI_API void LCUIDisplay_Present( void );
 
+/**
+ * 检测是否有待处理的更新
+ * 在没有待处理的部件任务和无效区域时，主循环可以进入休眠，直到有新的事件。
+ */
+LCUI_API LCUI_BOOL LCUIDisplay_HasPendingUpdate( void );
+
 LCUI_API void LCUIDisplay_ShowRectBorder( void );
 
 LCUI_API void LCUIDisplay_HideRectBorder( void );
@@ -128,6 +134,15 @@ LCUI_API int LCUIDisplay_GetWidth( void );
 /** 获取屏幕高度 */
 LCUI_API int LCUIDisplay_GetHeight( void );
 
+/**
+ * 设置渲染线程的数量
+ * 大于 1 时，无效区域会被切分成互不重叠的分块，由多个线程并行渲染，部件的
+ * 绘制函数需要是可重入的。
+ * @param[in] n 线程数量，包括主线程，小于等于 1 时使用单线程渲染
+ * @returns 设置成功返回 0，创建线程失败返回 -1
+ */
+LCUI_API int LCUIDisplay_SetRenderThreads( int n );
+
 /** 添加无效区域 */
 LCUI_API void LCUIDisplay_InvalidateArea( LCUI_Rect *rect );
 
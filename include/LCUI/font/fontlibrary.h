@@ -48,13 +48,32 @@ typedef struct LCUI_FontBitmap_ {
 	int left;		/**< 与左边框的距离 */
 	int width;		/**< 位图宽度 */
 	int rows;		/**< 位图行数 */
-	int pitch;
+	int pitch;		/**< 每行数据占用的字节数 */
 	uchar_t *buffer;	/**< 字体位图数据 */
 	short num_grays;
 	char pixel_mode;
 	LCUI_Pos advance;	/**< XY轴的跨距 */
 } LCUI_FontBitmap;
 
+/** 字形，记录了字体位图在一段文本中的绘制位置和颜色 */
+typedef struct LCUI_GlyphRec_ {
+	int x;				/**< 字体位图相对于文本原点的 X 坐标 */
+	int y;				/**< 字体位图相对于文本原点的 Y 坐标 */
+	LCUI_Color color;		/**< 颜色 */
+	const LCUI_FontBitmap *bitmap;	/**< 字体位图 */
+} LCUI_GlyphRec, *LCUI_Glyph;
+
+/** 字体位图缓存的统计数据 */
+typedef struct LCUI_FontCacheStatsRec_ {
+	size_t hits;			/**< 命中次数 */
+	size_t misses;			/**< 未命中次数 */
+	size_t evictions;		/**< 因超出内存上限而被淘汰的字体位图数量 */
+	size_t count;			/**< 当前缓存的字体位图数量 */
+	size_t pages;			/**< 当前存放字体位图数据的图集页数量 */
+	size_t size;			/**< 当前占用的内存大小 */
+	size_t max_size;		/**< 占用内存的上限 */
+} LCUI_FontCacheStatsRec, *LCUI_FontCacheStats;
+
 typedef struct LCUI_FontEngine	LCUI_FontEngine;
 
 typedef struct LCUI_Font {
@@ -107,6 +126,17 @@ LCUI_API int FontBitmap_Print( LCUI_FontBitmap *fontbmp );
 LCUI_API int FontBitmap_Mix( LCUI_Graph *graph, LCUI_Pos pos,
 			     const LCUI_FontBitmap *bmp, LCUI_Color color );
 
+/**
+ * 将一串字形绘制到目标图像上
+ * 与逐个调用 FontBitmap_Mix() 的结果相同，但只需获取一次目标图像的有效区域
+ * 和混合函数，适合绘制一整行文本
+ * @param[in] pos 文本原点在目标图像中的坐标
+ * @param[in] glyphs 字形数组
+ * @param[in] n 字形数量
+ */
+LCUI_API int FontBitmap_MixGlyphs( LCUI_Graph *graph, LCUI_Pos pos,
+				   const LCUI_GlyphRec *glyphs, int n );
+
 /** 载入字体位图 */
 LCUI_API int FontBitmap_Load( LCUI_FontBitmap *buff, wchar_t ch,
 			   int font_id, int pixel_size );
@@ -137,8 +167,8 @@ LCUI_API void LCUIFont_SetDefault( int id );
  * @param[in] font_id 使用的字体ID
  * @param[in] size 字体大小（单位为像素）
  * @param[out] bmp 要添加的字体位图
- * @warning 此函数仅仅是将 bmp 复制进缓存中，并未重新分配新的空间储存位图数
- * 据，因此，请勿在调用此函数后手动释放 bmp。
+ * @warning 位图数据会被拷贝到缓存的图集页中，bmp 原有的位图数据会被释放，
+ * 因此，请勿在调用此函数后继续使用或手动释放 bmp。
  */
 LCUI_API LCUI_FontBitmap* LCUIFont_AddBitmap( wchar_t ch, int font_id,
 				int size, const LCUI_FontBitmap *bmp );
@@ -150,11 +180,27 @@ LCUI_API LCUI_FontBitmap* LCUIFont_AddBitmap( wchar_t ch, int font_id,
  * @param[in] size 字体大小（单位为像素）
  * @param[out] bmp 输出的字体位图的引用
  * @warning 请勿释放 bmp，bmp 仅仅是引用缓存中的字体位图，并未建分配新
- * 空间存储字体位图的拷贝。
+ * 空间存储字体位图的拷贝。缓存超出内存上限时，bmp 可能会在之后获取其它字体
+ * 位图时被淘汰，如需长期持有，请调用 LCUIFont_PinBitmap() 引用它。
  */
 LCUI_API int LCUIFont_GetBitmap( wchar_t ch, int font_id, int size,
 				 const LCUI_FontBitmap **bmp );
 
+/** 引用缓存中的字体位图，被引用的字体位图不会被淘汰 */
+LCUI_API void LCUIFont_PinBitmap( const LCUI_FontBitmap *bmp );
+
+/** 解除对缓存中的字体位图的引用 */
+LCUI_API void LCUIFont_UnpinBitmap( const LCUI_FontBitmap *bmp );
+
+/** 获取字体位图缓存的统计数据 */
+LCUI_API void LCUIFont_GetCacheStats( LCUI_FontCacheStats stats );
+
+/**
+ * 设置字体位图缓存占用内存的上限
+ * 超出上限时，最久没有使用且没有被引用的字体位图会被淘汰
+ */
+LCUI_API void LCUIFont_SetCacheMaxSize( size_t size );
+
 /** 载入字体至数据库中 */
 LCUI_API int LCUIFont_LoadFile( const char *filepath );
 
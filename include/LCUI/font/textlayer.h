@@ -59,11 +59,16 @@ typedef enum EOLChar {
 /* 文本行 */
 typedef struct TextRowRec_ {
         int width;			/**< 宽度 */
+	int visible_width;		/**< 有位图数据的文字的宽度之和 */
         int height;			/**< 高度 */
 	int text_height;		/**< 当前行中最大字体的高度 */
         int length;			/**< 该行文本长度 */
         TextChar *string;		/**< 该行文本的数据 */
 	EOLChar eol;			/**< 行尾结束类型 */
+	LCUI_GlyphRec *glyphs;		/**< 该行文本的字形，在更新图层时生成 */
+	int glyphs_length;		/**< 字形数量 */
+	LCUI_BOOL glyphs_dirty;		/**< 字形是否需要重新生成 */
+	LCUI_BOOL layout_dirty;		/**< 断行位置是否需要重新计算 */
 } TextRowRec, *TextRow;
 
 /* 文本行列表 */
@@ -219,6 +224,8 @@ LCUI_API void TextLayer_Update( LCUI_TextLayer layer, LinkedList *rects );
 
 /** 
  * 将文本图层中的指定区域的内容绘制至目标图像中
+ * 绘制时只读取图层的数据，可以在多个线程中同时绘制同一个图层的不同区域，
+ * 但在此之前需要先调用 TextLayer_Update() 更新图层
  * @param layer 要使用的文本图层
  * @param area 文本图层中需要绘制的区域
  * @param layer_pos 文本图层在目标图像中的位置
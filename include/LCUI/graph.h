@@ -55,11 +55,37 @@ enum GraphColorType {
 	COLOR_TYPE_RGB555,	/**< RGB555 */
 	COLOR_TYPE_RGB565,	/**< RGB565 */
 	COLOR_TYPE_RGB888,	/**< RGB888 */
-	COLOR_TYPE_ARGB8888	/**< RGB8888 */
+	COLOR_TYPE_ARGB8888,	/**< RGB8888 */
+	COLOR_TYPE_PARGB8888	/**< 预乘 alpha 的 ARGB8888 */
 };
 
 #define COLOR_TYPE_RGB COLOR_TYPE_RGB888
 #define COLOR_TYPE_ARGB COLOR_TYPE_ARGB8888
+#define COLOR_TYPE_PARGB COLOR_TYPE_PARGB8888
+
+/** 像素混合内核所使用的指令集 */
+enum GraphBlendKernel {
+	BLEND_KERNEL_SCALAR,	/**< 定点数标量实现，作为参考实现 */
+	BLEND_KERNEL_SSE2,	/**< SSE2 */
+	BLEND_KERNEL_AVX2,	/**< AVX2 */
+	BLEND_KERNEL_NEON	/**< ARM NEON */
+};
+
+/** 帧内存池的统计数据 */
+typedef struct LCUI_FrameArenaStatsRec_ {
+	size_t allocs;		/**< 从内存池中分配像素数据的次数 */
+	size_t heap_allocs;	/**< 内存池向系统申请内存的次数 */
+	size_t used;		/**< 同时使用的字节数的峰值 */
+	size_t capacity;	/**< 内存池的总容量 */
+} LCUI_FrameArenaStatsRec, *LCUI_FrameArenaStats;
+
+/** 帧内存池中的位置标记，用于回收在它之后分配的像素数据 */
+typedef struct LCUI_FrameArenaMarkRec_ {
+	void *stack;		/**< 当前线程的内存栈 */
+	void *block;		/**< 当时正在使用的内存块 */
+	size_t block_used;	/**< 当时内存块已使用的字节数 */
+	size_t used;		/**< 当时内存栈已使用的字节数 */
+} LCUI_FrameArenaMarkRec, *LCUI_FrameArenaMark;
 
 /* 将两个像素点的颜色值进行alpha混合 */
 #define _ALPHA_BLEND(__back__ , __fore__, __alpha__)	\
@@ -70,6 +96,9 @@ enum GraphColorType {
     __back__ =_ALPHA_BLEND(__back__,__fore__,__alpha__);	\
 }
 
+/** 将 0~65535 范围内的整数除以 255，并四舍五入 */
+#define DIV255(X) ((((X) + 128) + (((X) + 128) >> 8)) >> 8)
+
 #define PIXEL_BLEND(px1, px2, a) {		\
 	ALPHA_BLEND( (px1)->r, (px2)->r, a );	\
 	ALPHA_BLEND( (px1)->g, (px2)->g, a );	\
@@ -148,6 +177,43 @@ LCUI_API void Graph_Copy( LCUI_Graph *des, const LCUI_Graph *src );
 
 LCUI_API void Graph_Free( LCUI_Graph *graph );
 
+/**
+ * 创建图像，像素数据从帧内存池中分配
+ * 适用于只在一帧内使用的临时图像，像素数据会在 Graph_ReleaseFrameArena() 或
+ * Graph_ResetFrameArena() 时统一回收，调用 Graph_Free() 不会释放内存。帧内存
+ * 池未初始化时与 Graph_Create() 相同。
+ */
+LCUI_API int Graph_CreateInFrame( LCUI_Graph *graph, int w, int h );
+
+/**
+ * 标记当前线程在帧内存池中的位置
+ * 每个线程有各自的内存栈，标记和回收需要在同一个线程中成对调用。
+ */
+LCUI_API void Graph_MarkFrameArena( LCUI_FrameArenaMark mark );
+
+/**
+ * 回收当前线程在标记之后从帧内存池中分配的像素数据
+ * 调用后，这些像素数据所属的图像都不能再使用。
+ */
+LCUI_API void Graph_ReleaseFrameArena( LCUI_FrameArenaMark mark );
+
+/** 初始化帧内存池 */
+LCUI_API void Graph_InitFrameArena( void );
+
+/** 释放帧内存池占用的内存 */
+LCUI_API void Graph_FreeFrameArena( void );
+
+/**
+ * 重置帧内存池，回收本帧分配的所有像素数据
+ * 调用时不能有线程正在使用帧内存池。如果本帧向系统申请过内存，则将各个线程
+ * 的内存块合并成一块，让之后的帧不再需要申请内存；如果最近的一段时间内只用
+ * 到不到一半的容量，则收缩到这段时间内用到的大小。
+ */
+LCUI_API void Graph_ResetFrameArena( void );
+
+/** 获取上一帧的帧内存池统计数据 */
+LCUI_API void Graph_GetFrameArenaStats( LCUI_FrameArenaStats stats );
+
 /**
  * 为图像创建一个引用
  * @param self 用于存放图像引用的缓存区
@@ -156,11 +222,15 @@ LCUI_API void Graph_Free( LCUI_Graph *graph );
  */
 LCUI_API int Graph_Quote( LCUI_Graph *self, LCUI_Graph *source, const LCUI_Rect *rect );
 
+/** 判断色彩类型是否有Alpha透明通道 */
+#define ColorType_HasAlpha(T) \
+	((T) == COLOR_TYPE_ARGB || (T) == COLOR_TYPE_PARGB)
+
 /** 判断图像是否有Alpha透明通道 */
 #define Graph_HasAlpha(G) 						\
 	((G)->quote.is_valid ? (					\
-		(G)->quote.source->color_type == COLOR_TYPE_ARGB	\
-	) : ((G)->color_type == COLOR_TYPE_ARGB))
+		ColorType_HasAlpha( (G)->quote.source->color_type )	\
+	) : ColorType_HasAlpha( (G)->color_type ))
 
 /** 判断图像是否有效 */
 #define Graph_IsValid(G)						\
@@ -208,6 +278,8 @@ LCUI_API int Graph_Tile( LCUI_Graph *buff, const LCUI_Graph *graph,
 /**
  * 混合两张图层
  * 将前景图混合到背景图上
+ * 背景图为 COLOR_TYPE_PARGB 时只需乘加运算，不需要逐通道做除法，适合用作中间
+ * 图层，此时总是会计算 alpha 通道，with_alpha 参数无效
  * @param[in][out] back 背景图层
  * @param[in] fore 前景图层
  * @param[in] left 前景图层的左边距
@@ -219,6 +291,17 @@ LCUI_API int Graph_Mix( LCUI_Graph *back, const LCUI_Graph *fore,
 
 LCUI_API int Graph_Replace( LCUI_Graph *back, const LCUI_Graph *fore, int left, int top );
 
+/**
+ * 设置像素混合内核
+ * 默认会在首次混合时根据 CPU 支持的指令集自动选择，所有内核的混合结果都是相同的
+ * @param[in] kernel 内核，取值为 GraphBlendKernel 枚举中的值
+ * @returns 设置成功返回 0，当前 CPU 或编译环境不支持该内核则返回 -1
+ */
+LCUI_API int Graph_SetBlendKernel( int kernel );
+
+/** 获取当前使用的像素混合内核 */
+LCUI_API int Graph_GetBlendKernel( void );
+
 LCUI_END_HEADER
 
 #include <LCUI/draw.h>
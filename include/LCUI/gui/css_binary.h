@@ -0,0 +1,89 @@
+﻿/* ***************************************************************************
+ * css_binary.h -- precompiled binary css format
+ *
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ *
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ *
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ *
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *
+ * The LCUI project is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ *
+ * You should have received a copy of the GPLv2 along with this file. It is
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/* ****************************************************************************
+ * css_binary.h -- 预编译的二进制样式数据格式
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ *
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ *
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ *
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+#ifndef LCUI_CSS_BINARY_H
+#define LCUI_CSS_BINARY_H
+
+LCUI_BEGIN_HEADER
+
+/** 二进制样式数据的格式版本，格式有变动时递增 */
+#define LCUI_CSS_BINARY_VERSION 2
+
+/** CSS 编译器，将解析出的样式规则转换成可直接映射到内存中使用的二进制数据 */
+typedef struct LCUI_CSSCompilerRec_ *LCUI_CSSCompiler;
+
+LCUI_API LCUI_CSSCompiler CSSCompiler( void );
+
+LCUI_API void CSSCompiler_Delete( LCUI_CSSCompiler compiler );
+
+/** 编译 CSS 文件中的样式规则 */
+LCUI_API int CSSCompiler_AddFile( LCUI_CSSCompiler compiler,
+				  const char *filepath );
+
+/** 编译 CSS 代码中的样式规则 */
+LCUI_API int CSSCompiler_AddString( LCUI_CSSCompiler compiler,
+				    const char *str, const char *space );
+
+/** 获取已编译的样式规则数量 */
+LCUI_API size_t CSSCompiler_GetRuleCount( LCUI_CSSCompiler compiler );
+
+/**
+ * 生成二进制样式数据
+ * @param[out] size 数据的大小
+ * @returns 数据的内存地址，不再使用时需要用 free() 释放
+ */
+LCUI_API void *CSSCompiler_Build( LCUI_CSSCompiler compiler, size_t *size );
+
+/** 将二进制样式数据保存至文件中 */
+LCUI_API int CSSCompiler_Save( LCUI_CSSCompiler compiler,
+			       const char *filepath );
+
+/**
+ * 从内存中载入二进制样式数据，并导入至样式库中
+ * 不需要解析 CSS 代码，样式规则的顺序和优先级与编译时的一致。
+ * @returns 成功返回载入的样式规则数量，数据无效则返回负数
+ */
+LCUI_API int LCUI_LoadCSSBinary( const void *data, size_t size );
+
+/** 从文件中载入二进制样式数据，并导入至样式库中 */
+LCUI_API int LCUI_LoadCSSBinaryFile( const char *filepath );
+
+LCUI_END_HEADER
+
+#endif
@@ -128,6 +128,16 @@ enum LCUI_StyleKeyName {
 	key_box_shadow_color,
 	// box shadow end
 
+	// flex box start
+	key_flex_grow,
+	key_flex_shrink,
+	key_flex_basis,
+	key_flex_direction,
+	key_flex_wrap,
+	key_justify_content,
+	key_align_items,
+	// flex box end
+
 	key_pointer_events,
 	key_focusable,
 	STYLE_KEY_TOTAL
@@ -147,6 +157,8 @@ enum LCUI_StyleKeyName {
 #define key_background_end	key_background_origin
 #define key_box_shadow_start	key_box_shadow_x
 #define key_box_shadow_end	key_box_shadow_color
+#define key_flex_box_start	key_flex_grow
+#define key_flex_box_end	key_align_items
 
 typedef struct LCUI_StyleSheetRec_ {
 	LCUI_Style sheet;
@@ -155,10 +167,10 @@ typedef struct LCUI_StyleSheetRec_ {
 
 /** 选择器结点结构 */
 typedef struct LCUI_SelectorNodeRec_ {
-	char *id;			/**< ID */
-	char *type;			/**< 类型名称 */
-	char **classes;			/**< 样式类列表 */
-	char **status;			/**< 状态列表 */
+	LCUI_Atom id;			/**< ID */
+	LCUI_Atom type;			/**< 类型名称 */
+	LCUI_Atom *classes;		/**< 样式类列表 */
+	LCUI_Atom *status;		/**< 状态列表 */
 	char *fullname;			/**< 全名，由 id、type、classes、status 组合而成 */
 	int rank;			/**< 权值 */
 } LCUI_SelectorNodeRec, *LCUI_SelectorNode;
@@ -173,6 +185,22 @@ typedef struct LCUI_SelectorRec_ {
 } LCUI_SelectorRec, *LCUI_Selector;
 
 
+/** 样式表缓存的统计数据 */
+typedef struct LCUI_StyleCacheStatsRec_ {
+	size_t hits;			/**< 命中次数 */
+	size_t misses;			/**< 未命中次数 */
+	size_t evictions;		/**< 因超出内存上限而被淘汰的记录数 */
+	size_t invalidations;		/**< 因添加样式表而失效的记录数 */
+	size_t count;			/**< 当前的记录数 */
+	size_t size;			/**< 当前占用的内存大小 */
+	size_t max_size;		/**< 占用内存的上限 */
+} LCUI_StyleCacheStatsRec, *LCUI_StyleCacheStats;
+
+/** 名称出现在选择器最右边的结点中，会影响拥有它的部件 */
+#define SELECTOR_DEP_SUBJECT	1
+/** 名称出现在选择器的祖先结点中，会影响拥有它的部件的后代部件 */
+#define SELECTOR_DEP_ANCESTOR	2
+
 #define CheckStyleType(S, K, T) (S[K].is_valid && S[K].type == SVT_##T)
 #define CheckStyleValue(S, K, V) (S[K].is_valid && S[K].type == SV_##V)
 
@@ -230,6 +258,34 @@ LCUI_API int LCUI_FindStyleSheetFromGroup( int group, const char *name,
 
 LCUI_API void LCUI_GetStyleSheet( LCUI_Selector s, LCUI_StyleSheet out_ss );
 
+/** 获取样式表缓存的统计数据 */
+LCUI_API void LCUI_GetStyleCacheStats( LCUI_StyleCacheStats stats );
+
+/**
+ * 设置样式表缓存占用内存的上限
+ * 超出上限时，最久没有使用的样式表会被淘汰
+ */
+LCUI_API void LCUI_SetStyleCacheMaxSize( size_t size );
+
+/** 获取样式库的版本号，样式库中的样式表有变动时，版本号会改变 */
+LCUI_API unsigned int LCUI_GetStyleLibraryVersion( void );
+
+/**
+ * 获取类名或状态名在样式库的选择器中被用到的位置
+ * @param[in] type 名称的种类，0 为类名，1 为状态名
+ * @param[in] atom 名称的原子
+ * @returns 由 SELECTOR_DEP_* 组成的标志，没有被用到则返回 0
+ */
+LCUI_API int LCUI_GetSelectorDependency( int type, LCUI_Atom atom );
+
+/**
+ * 判断选择器结点是否会受到祖先结点中的类名或状态名的影响
+ * 如果样式库中有选择器在祖先结点中用到了该名称，且它最右边的结点能与 sn
+ * 匹配，那么祖先结点添加或移除这个名称后，sn 匹配到的样式表可能会变化
+ */
+LCUI_API LCUI_BOOL LCUI_IsSelectorNodeAffected( int type, LCUI_Atom atom,
+						LCUI_SelectorNode sn );
+
 LCUI_API int LCUI_SetStyleName( int key, const char *name );
 
 LCUI_API int LCUI_AddStyleName( const char *name );
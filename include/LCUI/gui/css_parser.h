@@ -58,6 +58,21 @@ LCUI_API const char *LCUI_GetStyleName( int key );
 /** 初始化 LCUI 的 CSS 代码解析功能 */
 LCUI_API void LCUI_InitCSSParser( void );
 
+/**
+ * 样式规则的处理函数
+ * 参数依次为：选择器、样式表、样式记录所属的空间、附加数据
+ */
+typedef void (*LCUI_CSSRuleHandler)(LCUI_Selector, LCUI_StyleSheet,
+				    const char*, void*);
+
+/** 解析 CSS 文件，并将解析出的每条样式规则交给处理函数 */
+LCUI_API int LCUI_ParseCSSFile( const char *filepath,
+				LCUI_CSSRuleHandler handler, void *data );
+
+/** 解析 CSS 代码，并将解析出的每条样式规则交给处理函数 */
+LCUI_API int LCUI_ParseCSSString( const char *str, const char *space,
+				  LCUI_CSSRuleHandler handler, void *data );
+
 /** 从文件中载入CSS样式数据，并导入至样式库中 */
 LCUI_API int LCUI_LoadCSSFile( const char *filepath );
 
@@ -45,6 +45,16 @@
 
 LCUI_BEGIN_HEADER
 
+/** 弹性布局样式 */
+typedef struct LCUI_FlexBoxStyle {
+	float grow;			/**< 剩余空间的分配比例 */
+	float shrink;			/**< 空间不足时的收缩比例 */
+	LCUI_StyleValue direction;	/**< 主轴方向，row 或 column */
+	LCUI_StyleValue wrap;		/**< 是否换行，nowrap 或 wrap */
+	LCUI_StyleValue justify_content;/**< 子部件在主轴上的对齐方式 */
+	LCUI_StyleValue align_items;	/**< 子部件在交叉轴上的对齐方式 */
+} LCUI_FlexBoxStyle;
+
 /** 部件样式 */
 typedef struct LCUI_WidgetStyle {
 	LCUI_BOOL visible;		/**< 是否可见 */
@@ -64,6 +74,7 @@ typedef struct LCUI_WidgetStyle {
 	LCUI_Background background;	/**< 背景 */
 	LCUI_BoxShadow shadow;		/**< 阴影 */
 	LCUI_Border border;		/**< 边框 */
+	LCUI_FlexBoxStyle flex;		/**< 弹性布局样式 */
 	int pointer_events;		/**< 事件的处理方式 */
 } LCUI_WidgetStyle;
 
@@ -77,6 +88,7 @@ enum WidgetTaskType {
 	WTT_PADDING,
 	WTT_MARGIN,
 	WTT_VISIBLE,
+	WTT_FLEX,		/**< 更新弹性布局样式 */
 	WTT_SHADOW,
 	WTT_BORDER,
 	WTT_BACKGROUND,
@@ -88,7 +100,7 @@ enum WidgetTaskType {
 	WTT_BODY,
 	WTT_REFRESH,
 	WTT_USER,
-	WTT_TOTAL_NUM
+	WTT_TOTAL_NUM		/**< 任务以标志位记录，数量不能超过 32 */
 };
 
 typedef struct LCUI_WidgetBoxRect {
@@ -99,10 +111,18 @@ typedef struct LCUI_WidgetBoxRect {
 	LCUI_RectF graph;	/**< 图层的区域，包括边框盒和阴影区域 */
 } LCUI_WidgetBoxRect;
 
+/** 可被多个部件共用的样式表，引用计数归零时释放 */
+typedef struct LCUI_SharedStyleSheetRec_ {
+	int refs;			/**< 引用计数 */
+	LCUI_StyleSheet sheet;		/**< 样式表 */
+	LCUI_BOOL is_mixed;		/**< 共用它的部件的祖先结点已不再相同，不能用作子部件的共享键 */
+} LCUI_SharedStyleSheetRec, *LCUI_SharedStyleSheet;
+
 typedef struct LCUI_WidgetTaskBoxRec_ {
-	LCUI_BOOL for_self;			/**< 标志，指示当前部件是否有待处理的任务 */
-	LCUI_BOOL for_children;			/**< 标志，指示是否有待处理的子级部件 */
-	LCUI_BOOL buffer[WTT_TOTAL_NUM];	/**< 记录缓存 */
+	unsigned int flags;		/**< 待处理任务的标志位，第 n 位对应第 n 种任务 */
+	LCUI_BOOL for_children;		/**< 标志，指示是否有还未加入任务队列的子级部件 */
+	int depth;			/**< 部件在任务队列中的层级，不在队列中时为 -1 */
+	LinkedListNode node;		/**< 部件在任务队列中的结点 */
 } LCUI_WidgetTaskBoxRec;
 
 /** 部件状态 */
@@ -161,6 +181,27 @@ typedef struct LCUI_WidgetAttributeRec_ {
 	} value;
 } LCUI_WidgetAttributeRec, *LCUI_WidgetAttribute;
 
+/**
+ * 部件的布局缓存
+ * 子级部件按顺序排列，每个子级部件都记录了布局到它之后的状态，有变动时只需
+ * 要从第一个有变动的子级部件开始继续布局。
+ */
+typedef struct LCUI_WidgetLayoutRec_ {
+	LCUI_BOOL needs_layout;		/**< 是否需要重新布局全部子级部件 */
+	LCUI_Widget dirty_child;	/**< 第一个需要重新布局的子级部件，没有则为 NULL */
+	LCUI_Widget dirty_size_child;	/**< 第一个占用区域有变动的子级部件，没有则为 NULL */
+	LCUI_BOOL has_height_dependents;/**< 是否有子级部件依赖本部件的高度 */
+	float x, y;			/**< 在父级部件中布局完本部件后的位置 */
+	float line_height;		/**< 在父级部件中布局完本部件后的行高 */
+	int prev_display;		/**< 在父级部件中布局完本部件后，上一个参与布局的部件的显示方式 */
+	float content_width;		/**< 本部件及之前的兄弟部件占用的区域宽度 */
+	float content_height;		/**< 本部件及之前的兄弟部件占用的区域高度 */
+	float natural_width;		/**< 未经弹性布局调整的边框盒宽度，尚未测量时为 -1 */
+	float natural_height;		/**< 未经弹性布局调整的边框盒高度，尚未测量时为 -1 */
+	float flex_width;		/**< 弹性布局分配的边框盒宽度，未分配时为 -1 */
+	float flex_height;		/**< 弹性布局分配的边框盒高度，未分配时为 -1 */
+} LCUI_WidgetLayoutRec;
+
 /** 部件结构 */
 typedef struct LCUI_WidgetRec_ {
 	int			state;			/**< 状态 */
@@ -170,15 +211,15 @@ typedef struct LCUI_WidgetRec_ {
 	int			index;			/**< 部件索引位置 */
 	char			*id;			/**< ID */
 	char			*type;			/**< 类型 */
-	char			**classes;		/**< 类列表 */
-	char			**status;		/**< 状态列表 */
+	LCUI_Atom		*classes;		/**< 类列表 */
+	LCUI_Atom		*status;		/**< 状态列表 */
 	wchar_t			*title;			/**< 标题 */
 	LCUI_Rect2F		padding;		/**< 内边距框 */
 	LCUI_Rect2F		margin;			/**< 外边距框 */
 	LCUI_WidgetBoxRect	box;			/**< 部件的各个区域信息 */
 	LCUI_StyleSheet		style;			/**< 当前完整样式表 */
 	LCUI_StyleSheet		custom_style;		/**< 自定义样式表 */
-	LCUI_StyleSheet		inherited_style;	/**< 通过继承得到的样式表 */
+	LCUI_SharedStyleSheet	inherited_style;	/**< 通过继承得到的样式表，可能与其它部件共用 */
 	LCUI_WidgetStyle	computed_style;		/**< 已经计算的样式数据 */
 	LCUI_Widget		parent;			/**< 父部件 */
 	LinkedList		children;		/**< 子部件 */
@@ -186,13 +227,16 @@ typedef struct LCUI_WidgetRec_ {
 	LCUI_WidgetData		data;			/**< 私有数据 */
 	Dict			*attributes;
 	LCUI_WidgetPrototypeC	proto;			/**< 原型 */
-	LCUI_BOOL		enable_graph;		/**< 是否启用位图缓存 */
-	LCUI_Graph		graph;			/**< 位图缓存 */
+	LCUI_BOOL		enable_graph;		/**< 是否启用图层缓存，不透明度小于 1 时会自动启用 */
+	LCUI_Graph		graph;			/**< 图层缓存，保存部件及其子级部件渲染后的图层 */
+	LCUI_RegionRec		dirty_layer_rects;	/**< 图层缓存中的无效区域 */
+	LCUI_Mutex		layer_mutex;		/**< 图层缓存的互斥锁，部件可能会被多个线程同时渲染 */
 	LCUI_EventTrigger	trigger;		/**< 事件触发器 */
 	LCUI_WidgetTaskBoxRec	task;			/**< 任务记录 */
-	LinkedList		dirty_rects;		/**< 记录无效区域（脏矩形） */
+	LCUI_RegionRec		dirty_rects;		/**< 记录无效区域（脏矩形） */
 	LCUI_BOOL		has_dirty_child;	/**< 子级部件是否有无效区域 */
 	LCUI_BOOL		layout_locked;		/**< 子级部件布局是否已锁定 */
+	LCUI_WidgetLayoutRec	layout;			/**< 布局缓存 */
 	LCUI_BOOL		event_blocked;		/**< 是否阻止自己和子级部件的事件处理 */
 	LCUI_BOOL		disabled;		/**< 是否禁用 */
 } LCUI_WidgetRec;
@@ -257,6 +301,9 @@ LCUI_API void Widget_UpdateBoxShadow( LCUI_Widget w );
 /** 刷新可见性 */
 LCUI_API void Widget_UpdateVisibility( LCUI_Widget w );
 
+/** 刷新弹性布局样式 */
+LCUI_API void Widget_UpdateFlexBox( LCUI_Widget w );
+
 /** 设置部件为顶级部件 */
 LCUI_API int Widget_Top( LCUI_Widget w );
 
@@ -350,10 +397,14 @@ LCUI_API void Widget_LockLayout( LCUI_Widget w );
 /** 解除锁定子部件的布局 */
 LCUI_API void Widget_UnlockLayout( LCUI_Widget w );
 
+/** 更新全部子部件的布局 */
 LCUI_API void Widget_UpdateLayout( LCUI_Widget w );
 
-/** 更新子部件的布局 */
-LCUI_API void Widget_UpdateLayout( LCUI_Widget w );
+/** 从指定的子部件开始更新布局，它之前的子部件的布局保持不变 */
+LCUI_API void Widget_UpdateLayoutFrom( LCUI_Widget w, LCUI_Widget child );
+
+/** 在子部件被移出前更新布局缓存，并更新它之后的子部件的布局 */
+void Widget_RemoveLayoutChild( LCUI_Widget w, LCUI_Widget child );
 
 LCUI_API void Widget_ExecUpdateLayout( LCUI_Widget w );
 
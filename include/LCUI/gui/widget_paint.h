@@ -43,6 +43,13 @@
 
 LCUI_BEGIN_HEADER
 
+/** 部件绘制的统计数据 */
+typedef struct LCUI_WidgetPaintStatsRec_ {
+	size_t culled_paints;	/**< 因被不透明的部件遮挡而跳过的绘制次数 */
+	size_t layer_composites;/**< 直接混合图层缓存的次数 */
+	size_t layer_repaints;	/**< 重绘图层缓存中的无效区域的次数 */
+} LCUI_WidgetPaintStatsRec, *LCUI_WidgetPaintStats;
+
 /** 
  * 标记部件内的一个区域为无效的，以使其重绘
  * @param[in] w		目标部件
@@ -78,9 +85,9 @@ LCUI_API void Widget_ValidateArea( LCUI_Widget w, LCUI_Rect *r, int box_type );
 /**
  * 处理部件及其子级部件中的脏矩形，并合并至一个记录中
  * @param[in]	w	目标部件
- * @param[out]	rlist	合并后的脏矩形记录
+ * @param[out]	region	合并后的无效区域
  */
-LCUI_API int Widget_ProcInvalidArea( LCUI_Widget w, LinkedList *rlist );
+LCUI_API int Widget_ProcInvalidArea( LCUI_Widget w, LCUI_Region region );
 
 /** 
  * 将部件中的矩形区域转换成指定范围框内有效的矩形区域
@@ -99,6 +106,16 @@ LCUI_API int Widget_ConvertArea( LCUI_Widget w, LCUI_Rect *in_rect,
  */
 LCUI_API void Widget_Render( LCUI_Widget w, LCUI_PaintContext paint );
 
+/** 获取部件绘制的统计数据 */
+LCUI_API void LCUIWidget_GetPaintStats( LCUI_WidgetPaintStats stats );
+
+/** 重置部件绘制的统计数据 */
+LCUI_API void LCUIWidget_ResetPaintStats( void );
+
+void LCUIWidget_InitPaint( void );
+
+void LCUIWidget_ExitPaint( void );
+
 LCUI_END_HEADER
 
 #endif
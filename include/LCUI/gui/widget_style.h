@@ -41,6 +41,13 @@
 #ifndef LCUI_WIDGET_STYLE_LIBRARY_H
 #define LCUI_WIDGET_STYLE_LIBRARY_H
 
+/** 样式刷新的统计数据，用于衡量类和状态的变动导致了多少部件刷新样式 */
+typedef struct LCUI_WidgetStyleStatsRec_ {
+	size_t changes;		/**< 类和状态的变动次数 */
+	size_t checked;		/**< 检查过的后代部件数量 */
+	size_t restyled;	/**< 被标记为需要刷新样式的部件数量 */
+} LCUI_WidgetStyleStatsRec, *LCUI_WidgetStyleStats;
+
 /** 初始化 */
 void LCUIWidget_InitStyle( void );
 
@@ -87,6 +94,9 @@ LCUI_API void LCUI_PrintCSSLibrary(void);
 /** 计算部件继承得到的样式表 */
 LCUI_API void Widget_GetInheritStyle( LCUI_Widget w, LCUI_StyleSheet out_ss );
 
+/** 释放部件继承得到的样式表 */
+void Widget_ReleaseInheritStyle( LCUI_Widget w );
+
 /** 更新当前部件的样式 */
 LCUI_API void Widget_UpdateStyle( LCUI_Widget w, LCUI_BOOL is_update_all );
 
@@ -102,7 +112,26 @@ LCUI_SelectorNode Widget_GetSelectorNode( LCUI_Widget w );
 /** 获取选择器 */
 LCUI_API LCUI_Selector Widget_GetSelector( LCUI_Widget w );
 
-/** 处理子级部件样式变化 */
+/**
+ * 处理子级部件样式变化
+ * 只标记匹配到的样式表可能变化的后代部件
+ * @param[in] type 名称的种类，0 为类名，1 为状态名
+ * @returns 被标记为需要刷新样式的后代部件数量
+ */
 LCUI_API int Widget_HandleChildrenStyleChange( LCUI_Widget w, int type, const char *name );
 
+/**
+ * 处理部件的类或状态的变动
+ * 根据样式库中记录的选择器依赖，标记部件自身及受影响的后代部件需要刷新样式
+ * @param[in] type 名称的种类，0 为类名，1 为状态名
+ * @returns 被标记为需要刷新样式的部件数量
+ */
+int Widget_HandleStyleChange( LCUI_Widget w, int type, const char *name );
+
+/** 获取样式刷新的统计数据 */
+LCUI_API void LCUIWidget_GetStyleStats( LCUI_WidgetStyleStats stats );
+
+/** 重置样式刷新的统计数据 */
+LCUI_API void LCUIWidget_ResetStyleStats( void );
+
 #endif
@@ -50,9 +50,16 @@ LCUI_API void Widget_UpdateTaskStatus( LCUI_Widget widget );
 /** 添加任务 */
 LCUI_API void Widget_AddTask( LCUI_Widget widget, int task_type );
 
-/** 处理部件中当前积累的任务 */
+/**
+ * 处理部件及其子级部件中当前积累的任务
+ * 会遍历整个子级部件树，一般用于在部件添加到根部件前立即完成更新，已添加到
+ * 根部件中的部件会由 LCUIWidget_Update() 通过任务队列处理。
+ */
 LCUI_API int Widget_UpdateEx( LCUI_Widget w, LCUI_BOOL has_timeout );
 
+/** 清除部件的全部任务，并将它移出任务队列 */
+LCUI_API void Widget_ClearTasks( LCUI_Widget w );
+
 /** 将部件标记为垃圾，等待销毁 */
 LCUI_API void Widget_AddToTrash( LCUI_Widget w );
 
@@ -68,6 +75,9 @@ void LCUIWidget_ExitTasks( void );
 /** 处理一次当前积累的部件任务 */
 void LCUIWidget_Update( void );
 
+/** 检测是否还有待处理的部件任务 */
+LCUI_API LCUI_BOOL LCUIWidget_HasPendingTasks( void );
+
 LCUI_END_HEADER
 
 #endif
@@ -85,6 +85,11 @@ LCUI_API int LCUI_InitImageReader( LCUI_ImageReader reader );
 /** 销毁图像读取器 */
 LCUI_API void LCUI_DestroyImageReader( LCUI_ImageReader reader );
 
+/**
+ * 读取 PNG 图像
+ * 若 graph 的色彩类型预先设置为 COLOR_TYPE_PARGB，则带 alpha 通道的图像会以
+ * 预乘 alpha 的格式输出，便于直接混合到 PARGB 格式的图层上
+ */
 LCUI_API int LCUI_ReadPNG( LCUI_ImageReader reader, LCUI_Graph *graph );
 
 LCUI_API int LCUI_ReadJPEG( LCUI_ImageReader reader, LCUI_Graph *graph );
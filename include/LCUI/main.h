@@ -161,6 +161,13 @@ LCUI_API void LCUI_SetTaskAgent( LCUI_BOOL enabled );
 /** 处理当前所有事件 */
 LCUI_API void LCUI_ProcessEvents( void );
 
+/**
+ * 设置每帧处理任务的时间预算
+ * 超出预算后剩余的任务会留到下一帧处理，以免大量任务拖慢界面的更新
+ * @param[in] ms 时间（毫秒），小于等于 0 时使用默认值
+ */
+LCUI_API void LCUI_SetTaskBudget( int ms );
+
 /**
  * 添加任务
  * 该任务将会添加至 UI 线程中执行
@@ -0,0 +1,115 @@
+/* ***************************************************************************
+ * atom.h -- Global string interning table
+ * 
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ * 
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ * 
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ * 
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *  
+ * The LCUI project is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ * 
+ * You should have received a copy of the GPLv2 along with this file. It is 
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+ 
+/* ****************************************************************************
+ * atom.h -- 全局字符串驻留表
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ * 
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ * 
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ * 
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>. 
+ * ****************************************************************************/
+
+#ifndef LCUI_UTIL_ATOM_H
+#define LCUI_UTIL_ATOM_H
+
+LCUI_BEGIN_HEADER
+
+/**
+ * 原子
+ * 由字符串驻留表分配的整数标识，同一个字符串总是对应同一个原子，因此比较两个
+ * 字符串是否相等只需比较它们的原子。0 表示无效的原子。
+ */
+typedef unsigned int LCUI_Atom;
+
+/** 初始化字符串驻留表，重复调用不会有影响 */
+LCUI_API void LCUI_InitAtomTable( void );
+
+/**
+ * 获取字符串对应的原子，如果该字符串还没有原子，则为它分配一个
+ * 原子在程序运行期间不会被释放，所以不要用它来记录数量没有上限的字符串，例如
+ * 部件的 ID，这类字符串可以用 LCUIAtom_Find() 查找已有的原子。
+ * @returns 成功返回原子，字符串为空时返回 0，驻留表已满或内存不足时会输出错
+ * 误信息并返回 0
+ */
+LCUI_API LCUI_Atom LCUIAtom_Get( const char *name );
+
+/**
+ * 查找字符串对应的原子，不会分配新的原子
+ * @returns 找到则返回原子，否则返回 0
+ */
+LCUI_API LCUI_Atom LCUIAtom_Find( const char *name );
+
+/** 获取原子对应的字符串，在程序运行期间一直有效 */
+LCUI_API const char *LCUIAtom_GetName( LCUI_Atom atom );
+
+/**
+ * 原子列表
+ * 以 0 结尾、按从小到大排列的原子数组，可用 free() 释放
+ */
+
+/** 获取原子列表的长度 */
+LCUI_API int AtomList_Length( const LCUI_Atom *list );
+
+/** 复制原子列表 */
+LCUI_API LCUI_Atom *AtomList_Duplicate( const LCUI_Atom *list );
+
+/**
+ * 向原子列表添加原子
+ * @returns 添加成功返回 1，原子已存在或内存不足则返回 0
+ */
+LCUI_API int AtomList_Add( LCUI_Atom **list, LCUI_Atom atom );
+
+/** 判断原子列表中是否包含指定原子 */
+LCUI_API LCUI_BOOL AtomList_Has( const LCUI_Atom *list, LCUI_Atom atom );
+
+/**
+ * 从原子列表中删除原子，列表为空时会被释放
+ * @returns 删除成功返回 1，否则返回 0
+ */
+LCUI_API int AtomList_Delete( LCUI_Atom **list, LCUI_Atom atom );
+
+/**
+ * 向原子列表添加一组名称
+ * @param[in] names 名称列表，多个名称之间用空格隔开
+ * @returns 新添加的原子数量
+ */
+LCUI_API int AtomList_AddNames( LCUI_Atom **list, const char *names );
+
+/**
+ * 从原子列表中删除一组名称
+ * @param[in] names 名称列表，多个名称之间用空格隔开
+ * @returns 被删除的原子数量
+ */
+LCUI_API int AtomList_DeleteNames( LCUI_Atom **list, const char *names );
+
+LCUI_END_HEADER
+
+#endif
@@ -0,0 +1,105 @@
+﻿/* ***************************************************************************
+ * region.h -- Banded region, a set of non-overlapping rectangles
+ * 
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ * 
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ * 
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ * 
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *  
+ * The LCUI project is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ * 
+ * You should have received a copy of the GPLv2 along with this file. It is 
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+ 
+/* ****************************************************************************
+ * region.h -- 带状区域，由互不重叠的矩形组成的区域集合
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ * 
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ * 
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ * 
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>. 
+ * ****************************************************************************/
+
+#ifndef LCUI_UTIL_REGION_H
+#define LCUI_UTIL_REGION_H
+
+LCUI_BEGIN_HEADER
+
+/**
+ * 区域
+ * 区域内的矩形互不重叠，按“行带”（band）自上而下排列：同一行带内的矩形有相同
+ * 的 y 坐标和高度，且自左而右排列、互不相邻；上下相邻且横向分布相同的行带会被
+ * 合并成一个。
+ */
+typedef struct LCUI_RegionRec_ {
+	LCUI_Rect extents;		/**< 外接矩形 */
+	LCUI_Rect *rects;		/**< 矩形数组 */
+	int length;			/**< 矩形数量 */
+	int capacity;			/**< 矩形数组的容量 */
+	LCUI_Rect *buffer;		/**< 运算结果的缓存，与矩形数组交替使用 */
+	int buffer_capacity;		/**< 缓存的容量 */
+} LCUI_RegionRec, *LCUI_Region;
+
+/** 遍历区域内的矩形，用法：for( Region_Each( rect, region ) ) { ... } */
+#define Region_Each(RECT, REGION) RECT = (REGION)->rects; \
+	RECT < (REGION)->rects + (REGION)->length; ++RECT
+
+#define Region_IsEmpty(REGION) ((REGION)->length == 0)
+
+/** 初始化区域 */
+LCUI_API void Region_Init( LCUI_Region region );
+
+/** 清空区域，保留已分配的内存以便复用 */
+LCUI_API void Region_Clear( LCUI_Region region );
+
+/** 释放区域占用的内存 */
+LCUI_API void Region_Free( LCUI_Region region );
+
+/** 复制区域 */
+LCUI_API int Region_Copy( LCUI_Region dst, LCUI_Region src );
+
+/** 将区域平移 */
+LCUI_API void Region_Translate( LCUI_Region region, int dx, int dy );
+
+/** 判断区域是否完全包含矩形 */
+LCUI_API LCUI_BOOL Region_ContainsRect( LCUI_Region region,
+					const LCUI_Rect *rect );
+
+/** 将矩形并入区域 */
+LCUI_API int Region_UnionRect( LCUI_Region region, const LCUI_Rect *rect );
+
+/** 从区域中减去矩形 */
+LCUI_API int Region_SubtractRect( LCUI_Region region, const LCUI_Rect *rect );
+
+/** 将区域裁剪为它与矩形的交集 */
+LCUI_API int Region_IntersectRect( LCUI_Region region, const LCUI_Rect *rect );
+
+/** 将另一个区域并入区域 */
+LCUI_API int Region_Union( LCUI_Region region, LCUI_Region other );
+
+/** 从区域中减去另一个区域 */
+LCUI_API int Region_Subtract( LCUI_Region region, LCUI_Region other );
+
+/** 将区域裁剪为它与另一个区域的交集 */
+LCUI_API int Region_Intersect( LCUI_Region region, LCUI_Region other );
+
+LCUI_END_HEADER
+
+#endif
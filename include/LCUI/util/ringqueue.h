@@ -0,0 +1,95 @@
+/* ***************************************************************************
+ * ringqueue.h -- Bounded lock-free ring queue for passing data between threads
+ * 
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ * 
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ * 
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ * 
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *  
+ * The LCUI project is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ * 
+ * You should have received a copy of the GPLv2 along with this file. It is 
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+ 
+/* ****************************************************************************
+ * ringqueue.h -- 容量固定的无锁环形队列，用于在线程间传递数据
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ * 
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ * 
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ * 
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>. 
+ * ****************************************************************************/
+
+#ifndef LCUI_UTIL_RINGQUEUE_H
+#define LCUI_UTIL_RINGQUEUE_H
+
+LCUI_BEGIN_HEADER
+
+/** 缓存行的大小，用于隔开写入位置和读取位置，避免多个线程争用同一缓存行 */
+#define RINGQUEUE_CACHELINE_SIZE 64
+
+/**
+ * 环形队列
+ * 容量固定，允许多个线程同时写入，但同一时刻只能有一个线程读取，读写都不需要
+ * 加锁。每个格子都有一个序号，写入线程和读取线程通过它判断格子是否可用。
+ */
+typedef struct RingQueueRec_ {
+	volatile unsigned int head;	/**< 下一个写入位置，由写入线程竞争更新 */
+	char head_padding[RINGQUEUE_CACHELINE_SIZE - sizeof( unsigned int )];
+	unsigned int tail;		/**< 下一个读取位置，只有读取线程会修改 */
+	char tail_padding[RINGQUEUE_CACHELINE_SIZE - sizeof( unsigned int )];
+	unsigned int mask;		/**< 容量减一，容量必须是 2 的幂 */
+	size_t item_size;		/**< 每个元素的大小 */
+	volatile unsigned int *seqs;	/**< 每个格子的序号 */
+	char *items;			/**< 元素数组 */
+} RingQueueRec, *RingQueue;
+
+/**
+ * 初始化环形队列
+ * @param[in] item_size 每个元素的大小
+ * @param[in] capacity 容量，会被向上取整为 2 的幂
+ */
+LCUI_API int RingQueue_Init( RingQueue queue, size_t item_size,
+			     unsigned int capacity );
+
+/** 销毁环形队列，释放元素数组占用的内存 */
+LCUI_API void RingQueue_Destroy( RingQueue queue );
+
+/**
+ * 写入一个元素，可在多个线程中同时调用
+ * @returns 成功返回 0，队列已满或未初始化则返回 -1
+ */
+LCUI_API int RingQueue_Push( RingQueue queue, const void *item );
+
+/**
+ * 读取一个元素，同一时刻只能有一个线程调用
+ * @returns 成功返回 0，队列为空则返回 -1
+ */
+LCUI_API int RingQueue_Pop( RingQueue queue, void *item );
+
+/** 判断队列是否为空，在读取线程以外调用时结果只能作为参考 */
+LCUI_API LCUI_BOOL RingQueue_IsEmpty( RingQueue queue );
+
+/** 在读写共享数据之间设置完整的内存屏障 */
+LCUI_API void RingQueue_Barrier( void );
+
+LCUI_END_HEADER
+
+#endif
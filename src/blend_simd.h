@@ -0,0 +1,151 @@
+/* ***************************************************************************
+ * blend_simd.h -- SIMD helpers shared by the graph and font blending kernels.
+ *
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ *
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ *
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ *
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *
+ * The LCUI project is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ *
+ * You should have received a copy of the GPLv2 along with this file. It is
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/* ****************************************************************************
+ * blend_simd.h -- 图像和字体混合内核共用的 SIMD 辅助函数
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ *
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ *
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ *
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>.
+ * ***************************************************************************/
+
+/* 这是库内部使用的头文件，不会被安装 */
+
+#ifndef LCUI_BLEND_SIMD_H
+#define LCUI_BLEND_SIMD_H
+
+/* 检测编译器和目标平台支持的指令集 */
+#if defined(__GNUC__) && defined(__SSE2__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define LCUI_BLEND_SSE2
+#define LCUI_BLEND_AVX2
+#define LCUI_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LCUI_BLEND_SSE2
+#if _MSC_VER >= 1700
+#define LCUI_BLEND_AVX2
+#endif
+#define LCUI_TARGET_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define LCUI_BLEND_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef LCUI_BLEND_SSE2
+
+/** 计算 x / 255 并四舍五入，每个通道都是 16 位整数，x 不能超过 65025 */
+static __m128i SSE2_Div255( __m128i x )
+{
+	x = _mm_add_epi16( x, _mm_set1_epi16( 128 ) );
+	x = _mm_add_epi16( x, _mm_srli_epi16( x, 8 ) );
+	return _mm_srli_epi16( x, 8 );
+}
+
+/** 将每个像素的 alpha 值复制到该像素的所有通道中 */
+static __m128i SSE2_ExpandAlpha( __m128i px )
+{
+	px = _mm_shufflelo_epi16( px, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	return _mm_shufflehi_epi16( px, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+}
+
+/** 计算两组 16 位无符号整数的乘积，结果为 32 位整数 */
+static void SSE2_Multiply( __m128i a, __m128i b, __m128i *lo, __m128i *hi )
+{
+	__m128i l = _mm_mullo_epi16( a, b ), h = _mm_mulhi_epu16( a, b );
+	*lo = _mm_unpacklo_epi16( l, h );
+	*hi = _mm_unpackhi_epi16( l, h );
+}
+
+/**
+ * 计算 num / den，每个通道都是 32 位整数，den 不能为 0
+ * 参与运算的值都小于 2^24，单精度浮点数的除法结果在截断后与整数除法相同
+ */
+static __m128i SSE2_Divide( __m128i num, __m128i den )
+{
+	return _mm_cvttps_epi32( _mm_div_ps( _mm_cvtepi32_ps( num ),
+					     _mm_cvtepi32_ps( den ) ) );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_AVX2
+
+LCUI_TARGET_AVX2 static __m256i AVX2_Div255( __m256i x )
+{
+	x = _mm256_add_epi16( x, _mm256_set1_epi16( 128 ) );
+	x = _mm256_add_epi16( x, _mm256_srli_epi16( x, 8 ) );
+	return _mm256_srli_epi16( x, 8 );
+}
+
+LCUI_TARGET_AVX2 static __m256i AVX2_ExpandAlpha( __m256i px )
+{
+	px = _mm256_shufflelo_epi16( px, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	return _mm256_shufflehi_epi16( px, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+}
+
+LCUI_TARGET_AVX2 static void AVX2_Multiply( __m256i a, __m256i b,
+					    __m256i *lo, __m256i *hi )
+{
+	__m256i l = _mm256_mullo_epi16( a, b ), h = _mm256_mulhi_epu16( a, b );
+	*lo = _mm256_unpacklo_epi16( l, h );
+	*hi = _mm256_unpackhi_epi16( l, h );
+}
+
+LCUI_TARGET_AVX2 static __m256i AVX2_Divide( __m256i num, __m256i den )
+{
+	return _mm256_cvttps_epi32( _mm256_div_ps( _mm256_cvtepi32_ps( num ),
+						   _mm256_cvtepi32_ps( den ) ) );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_NEON
+
+static uint16x8_t NEON_Div255( uint16x8_t x )
+{
+	x = vaddq_u16( x, vdupq_n_u16( 128 ) );
+	x = vaddq_u16( x, vshrq_n_u16( x, 8 ) );
+	return vshrq_n_u16( x, 8 );
+}
+
+static uint32x4_t NEON_Divide( uint32x4_t num, uint32x4_t den )
+{
+	return vcvtq_u32_f32( vdivq_f32( vcvtq_f32_u32( num ),
+					 vcvtq_f32_u32( den ) ) );
+}
+
+#endif
+
+#endif /* LCUI_BLEND_SIMD_H */
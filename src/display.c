@@ -53,11 +53,15 @@
 
 #define DEFAULT_WIDTH	800
 #define DEFAULT_HEIGHT	600
+#define RENDER_TILE_SIZE	128
+#define MAX_RENDER_THREADS	64
+/** 无效区域的矩形数量超过它时，按分块合并后再渲染，避免大量零碎的绘制 */
+#define MAX_RENDER_RECTS	64
 
 /** surface 记录 */
 typedef struct SurfaceRecordRec_ {
 	LCUI_BOOL rendered;		/**< 是否已渲染了新内容 */
-	LinkedList rects;		/**< 需重绘的区域列表 */
+	LCUI_RegionRec rects;		/**< 需重绘的区域 */
 	LCUI_Surface surface;		/**< surface */
 	LCUI_Widget widget;		/**< surface 所映射的 widget */
 } SurfaceRecordRec, *SurfaceRecord;
@@ -70,10 +74,25 @@ static struct DisplayContext {
 	LCUI_BOOL is_working;		/**< 标志，指示当前模块是否处于工作状态 */
 	LCUI_Thread thread;		/**< 线程，负责画面更新工作 */
 	LinkedList surfaces;		/**< surface 列表 */
-	LinkedList rects;		/**< 无效区域列表 */
+	LCUI_RegionRec rects;		/**< 无效区域 */
 	LCUI_DisplayDriver driver;
 } display;
 
+/** 渲染线程池，用于并行渲染互不重叠的分块 */
+static struct RenderThreadPool {
+	int n_threads;			/**< 参与渲染的线程数量，包括主线程 */
+	LCUI_BOOL is_running;		/**< 工作线程是否在运行 */
+	LCUI_Thread *threads;		/**< 工作线程 */
+	LCUI_Mutex mutex;		/**< 互斥锁，保护以下各成员 */
+	LCUI_Cond cond_task;		/**< 条件变量，有新的分块需要渲染 */
+	LCUI_Cond cond_done;		/**< 条件变量，所有分块已渲染完 */
+	LCUI_Widget widget;		/**< 当前需要渲染的部件 */
+	LCUI_PaintContext *paints;	/**< 各个分块的绘制上下文 */
+	int n_paints;			/**< 分块数量 */
+	int next_paint;			/**< 下一个待渲染的分块 */
+	int n_done;			/**< 已渲染完的分块数量 */
+} render_pool;
+
 #define LCUIDisplay_CleanSurfaces() \
 LinkedList_Clear( &display.surfaces, OnDestroySurfaceRecord )
 
@@ -81,6 +100,7 @@ static void OnDestroySurfaceRecord( void *data )
 {
 	SurfaceRecord record = data;
 	Surface_Close( record->surface );
+	Region_Free( &record->rects );
 }
 
 static void DrawBorder( LCUI_PaintContext paint )
@@ -100,6 +120,219 @@ static void DrawBorder( LCUI_PaintContext paint )
 	Graph_DrawHorizLine( &paint->canvas, color, 1, pos, end_x );
 }
 
+static void RenderTile( LCUI_Widget w, LCUI_PaintContext paint )
+{
+	Widget_Render( w, paint );
+	if( display.show_rect_border ) {
+		DrawBorder( paint );
+	}
+}
+
+/** 领取并渲染分块，直到没有剩余的分块，调用前需锁定线程池 */
+static void RenderPool_Work( void )
+{
+	LCUI_Widget w;
+	LCUI_PaintContext paint;
+	while( render_pool.next_paint < render_pool.n_paints ) {
+		w = render_pool.widget;
+		paint = render_pool.paints[render_pool.next_paint++];
+		LCUIMutex_Unlock( &render_pool.mutex );
+		RenderTile( w, paint );
+		LCUIMutex_Lock( &render_pool.mutex );
+		if( ++render_pool.n_done == render_pool.n_paints ) {
+			LCUICond_Signal( &render_pool.cond_done );
+		}
+	}
+}
+
+static void RenderThread( void *arg )
+{
+	LCUIMutex_Lock( &render_pool.mutex );
+	while( render_pool.is_running ) {
+		if( render_pool.next_paint < render_pool.n_paints ) {
+			RenderPool_Work();
+			continue;
+		}
+		LCUICond_Wait( &render_pool.cond_task, &render_pool.mutex );
+	}
+	LCUIMutex_Unlock( &render_pool.mutex );
+	LCUIThread_Exit( NULL );
+}
+
+/** 用线程池渲染各个分块，在所有分块渲染完后返回 */
+static void RenderPool_Run( LCUI_Widget w, LCUI_PaintContext *paints, int n )
+{
+	LCUIMutex_Lock( &render_pool.mutex );
+	render_pool.widget = w;
+	render_pool.paints = paints;
+	render_pool.n_paints = n;
+	render_pool.next_paint = 0;
+	render_pool.n_done = 0;
+	LCUICond_Broadcast( &render_pool.cond_task );
+	/* 主线程也参与渲染 */
+	RenderPool_Work();
+	while( render_pool.n_done < render_pool.n_paints ) {
+		LCUICond_Wait( &render_pool.cond_done, &render_pool.mutex );
+	}
+	render_pool.paints = NULL;
+	render_pool.n_paints = 0;
+	render_pool.next_paint = 0;
+	LCUIMutex_Unlock( &render_pool.mutex );
+}
+
+static void RenderPool_Stop( void )
+{
+	int i;
+	if( !render_pool.threads ) {
+		return;
+	}
+	LCUIMutex_Lock( &render_pool.mutex );
+	render_pool.is_running = FALSE;
+	LCUICond_Broadcast( &render_pool.cond_task );
+	LCUIMutex_Unlock( &render_pool.mutex );
+	for( i = 0; i < render_pool.n_threads - 1; ++i ) {
+		LCUIThread_Join( render_pool.threads[i], NULL );
+	}
+	free( render_pool.threads );
+	render_pool.threads = NULL;
+	render_pool.n_threads = 1;
+	LCUICond_Destroy( &render_pool.cond_done );
+	LCUICond_Destroy( &render_pool.cond_task );
+	LCUIMutex_Destroy( &render_pool.mutex );
+}
+
+int LCUIDisplay_SetRenderThreads( int n )
+{
+	int i;
+	if( n > MAX_RENDER_THREADS ) {
+		n = MAX_RENDER_THREADS;
+	}
+	RenderPool_Stop();
+	if( n <= 1 ) {
+		return 0;
+	}
+	render_pool.threads = NEW( LCUI_Thread, n - 1 );
+	if( !render_pool.threads ) {
+		return -1;
+	}
+	/* 混合内核是延迟初始化的，需要在启动工作线程前完成初始化 */
+	Graph_GetBlendKernel();
+	LCUIMutex_Init( &render_pool.mutex );
+	LCUICond_Init( &render_pool.cond_task );
+	LCUICond_Init( &render_pool.cond_done );
+	render_pool.n_paints = 0;
+	render_pool.next_paint = 0;
+	render_pool.is_running = TRUE;
+	for( i = 0; i < n - 1; ++i ) {
+		if( LCUIThread_Create( &render_pool.threads[i],
+				       RenderThread, NULL ) != 0 ) {
+			break;
+		}
+	}
+	render_pool.n_threads = i + 1;
+	if( i < n - 1 ) {
+		RenderPool_Stop();
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * 按照屏幕上的网格将无效区域切分成互不重叠的分块
+ * 每个网格内的分块是该网格与各个无效区域的重叠区域的外接矩形
+ */
+static int SplitTiles( LCUI_Region region, LCUI_Rect **tiles )
+{
+	LCUI_Rect cell, tile, overlay, bound, tmp, *rect;
+	int n = 0, x, y, max_tiles;
+
+	*tiles = NULL;
+	if( Region_IsEmpty( region ) ) {
+		return 0;
+	}
+	bound = region->extents;
+	/* 将外接矩形对齐到网格 */
+	bound.width += bound.x - bound.x / RENDER_TILE_SIZE * RENDER_TILE_SIZE;
+	bound.height += bound.y - bound.y / RENDER_TILE_SIZE * RENDER_TILE_SIZE;
+	bound.x = bound.x / RENDER_TILE_SIZE * RENDER_TILE_SIZE;
+	bound.y = bound.y / RENDER_TILE_SIZE * RENDER_TILE_SIZE;
+	max_tiles = (bound.width / RENDER_TILE_SIZE + 1) *
+		    (bound.height / RENDER_TILE_SIZE + 1);
+	*tiles = NEW( LCUI_Rect, max_tiles );
+	if( !*tiles ) {
+		return -1;
+	}
+	cell.width = cell.height = RENDER_TILE_SIZE;
+	for( y = 0; y < bound.height; y += RENDER_TILE_SIZE ) {
+		for( x = 0; x < bound.width; x += RENDER_TILE_SIZE ) {
+			cell.x = bound.x + x;
+			cell.y = bound.y + y;
+			tile.width = tile.height = 0;
+			for( Region_Each( rect, region ) ) {
+				/* 区域内的矩形是自上而下排列的 */
+				if( rect->y >= cell.y + cell.height ) {
+					break;
+				}
+				if( !LCUIRect_GetOverlayRect( rect, &cell,
+							      &overlay ) ) {
+					continue;
+				}
+				if( tile.width > 0 && tile.height > 0 ) {
+					tmp = tile;
+					LCUIRect_MergeRect( &tile, &tmp,
+							    &overlay );
+				} else {
+					tile = overlay;
+				}
+			}
+			if( tile.width > 0 && tile.height > 0 ) {
+				(*tiles)[n++] = tile;
+			}
+		}
+	}
+	return n;
+}
+
+/** 将 surface 上的无效区域切分成分块，有多个渲染线程时并行渲染 */
+static void LCUIDisplay_RenderTiles( SurfaceRecord record )
+{
+	int i, n, count = 0;
+	LCUI_Rect *tiles;
+	LCUI_PaintContext *paints;
+
+	n = SplitTiles( &record->rects, &tiles );
+	if( n <= 0 ) {
+		return;
+	}
+	paints = NEW( LCUI_PaintContext, n );
+	if( !paints ) {
+		free( tiles );
+		return;
+	}
+	/* surface 的绘制操作只在主线程中进行 */
+	for( i = 0; i < n; ++i ) {
+		paints[count] = Surface_BeginPaint( record->surface, &tiles[i] );
+		if( paints[count] ) {
+			++count;
+		}
+	}
+	if( render_pool.n_threads > 1 ) {
+		RenderPool_Run( record->widget, paints, count );
+	} else {
+		for( i = 0; i < count; ++i ) {
+			RenderTile( record->widget, paints[i] );
+		}
+	}
+	for( i = 0; i < count; ++i ) {
+		Surface_EndPaint( record->surface, paints[i] );
+	}
+	if( count > 0 ) {
+		record->rendered = TRUE;
+	}
+	free( paints );
+	free( tiles );
+}
+
 void LCUIDisplay_Update( void )
 {
 	LCUI_Surface surface;
@@ -126,12 +359,14 @@ void LCUIDisplay_Update( void )
 	if( display.mode == LCDM_SEAMLESS || !record ) {
 		return;
 	}
-	LinkedList_Concat( &record->rects, &display.rects );
+	Region_Union( &record->rects, &display.rects );
+	Region_Clear( &display.rects );
 }
 
 void LCUIDisplay_Render( void )
 {
-	LinkedListNode *sn, *rn;
+	LinkedListNode *sn;
+	LCUI_Rect *rect;
 	LCUI_PaintContext paint;
 
 	if( !display.is_working ) {
@@ -147,9 +382,15 @@ void LCUIDisplay_Render( void )
 			continue;
 		}
 		record->rendered = FALSE;
+		if( render_pool.n_threads > 1 ||
+		    record->rects.length > MAX_RENDER_RECTS ) {
+			LCUIDisplay_RenderTiles( record );
+			Region_Clear( &record->rects );
+			continue;
+		}
 		/* 在 surface 上逐个重绘无效区域 */
-		for( LinkedList_Each( rn, &record->rects ) ) {
-			paint = Surface_BeginPaint( surface, rn->data );
+		for( Region_Each( rect, &record->rects ) ) {
+			paint = Surface_BeginPaint( surface, rect );
 			if( !paint ) {
 				continue;
 			}
@@ -164,7 +405,7 @@ void LCUIDisplay_Render( void )
 			Surface_EndPaint( surface, paint );
 			record->rendered = TRUE;
 		}
-		RectList_Clear( &record->rects );
+		Region_Clear( &record->rects );
 	}
 }
 
@@ -184,6 +425,36 @@ void LCUIDisplay_Present( void )
 			Surface_Present( surface );
 		}
 	}
+	/* 这一帧已经呈现完了，回收渲染时用的临时图像 */
+	Graph_ResetFrameArena();
+}
+
+LCUI_BOOL LCUIDisplay_HasPendingUpdate( void )
+{
+	LinkedListNode *node;
+	if( !display.is_working ) {
+		return FALSE;
+	}
+	if( LCUIWidget_HasPendingTasks() ) {
+		return TRUE;
+	}
+	/* 无缝模式下不会处理 display.rects 和根部件的无效区域 */
+	if( display.mode != LCDM_SEAMLESS &&
+	    !Region_IsEmpty( &display.rects ) ) {
+		return TRUE;
+	}
+	for( LinkedList_Each( node, &display.surfaces ) ) {
+		SurfaceRecord record = node->data;
+		if( !record->widget || !record->surface ) {
+			continue;
+		}
+		if( !Region_IsEmpty( &record->rects ) ||
+		    !Region_IsEmpty( &record->widget->dirty_rects ) ||
+		    record->widget->has_dirty_child ) {
+			return TRUE;
+		}
+	}
+	return FALSE;
 }
 
 void LCUIDisplay_InvalidateArea( LCUI_Rect *rect )
@@ -199,7 +470,7 @@ void LCUIDisplay_InvalidateArea( LCUI_Rect *rect )
 		screen.height = LCUIDisplay_GetHeight();
 		rect = &screen;
 	}
-	RectList_Add( &display.rects, rect );
+	Region_UnionRect( &display.rects, rect );
 }
 
 static LCUI_Widget LCUIDisplay_GetBindWidget( LCUI_Surface surface )
@@ -265,7 +536,7 @@ static void LCUIDisplay_BindSurface( LCUI_Widget widget )
 	record->surface = Surface_New();
 	record->widget = widget;
 	record->rendered = FALSE;
-	LinkedList_Init( &record->rects );
+	Region_Init( &record->rects );
 	Surface_SetCaptionW( record->surface, widget->title );
 	if( widget->style->sheet[key_top].is_valid &&
 	    widget->style->sheet[key_left].is_valid ) {
@@ -291,6 +562,7 @@ static void LCUIDisplay_UnbindSurface( LCUI_Widget widget )
 		SurfaceRecord record = node->data;
 		if( record && record->widget == widget ) {
 			Surface_Close( record->surface );
+			Region_Free( &record->rects );
 			LinkedList_DeleteNode( &display.surfaces, node );
 			break;
 		}
@@ -645,7 +917,7 @@ int LCUI_InitDisplay( LCUI_DisplayDriver driver )
 	LOG( "[display] init ...\n" );
 	display.mode = 0;
 	root = LCUIWidget_GetRoot();
-	LinkedList_Init( &display.rects );
+	Region_Init( &display.rects );
 	LinkedList_Init( &display.surfaces );
 	if( !driver ) {
 		driver = LCUI_CreateDisplayDriver();
@@ -658,6 +930,11 @@ int LCUI_InitDisplay( LCUI_DisplayDriver driver )
 	display.is_working = TRUE;
 	display.width = DEFAULT_WIDTH;
 	display.height = DEFAULT_HEIGHT;
+	/* 渲染线程可能在初始化之前就已经设置好了，不能覆盖掉 */
+	if( render_pool.n_threads < 1 ) {
+		render_pool.n_threads = 1;
+	}
+	Graph_InitFrameArena();
 	display.driver->bindEvent( DET_RESIZE, OnResize, NULL, NULL );
 	display.driver->bindEvent( DET_PAINT, OnPaint, NULL, NULL );
 	Widget_BindEvent( root, "surface", OnSurfaceEvent, NULL, NULL );
@@ -673,7 +950,9 @@ int LCUI_ExitDisplay( void )
 		return -1;
 	}
 	display.is_working = FALSE;
-	RectList_Clear( &display.rects );
+	RenderPool_Stop();
+	Region_Free( &display.rects );
 	LCUIDisplay_CleanSurfaces();
+	Graph_FreeFrameArena();
 	return 0;
 }
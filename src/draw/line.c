@@ -29,7 +29,7 @@ Graph_DrawHorizLine( LCUI_Graph *graph, LCUI_Color color, int size, LCUI_Pos sta
 	if( start.y + size > area.y + area.height ) {
 		size = area.y + area.height - start.y;
 	}
-	if( des->color_type == COLOR_TYPE_ARGB ) {
+	if( Graph_HasAlpha( des ) ) {
 		LCUI_ARGB *pPixel, *pRowPixel;
 		pRowPixel = des->argb + start.y*des->w + start.x;
 		for( y=0; y<size; ++y ) {
@@ -87,7 +87,7 @@ Graph_DrawVertiLine( LCUI_Graph *graph, LCUI_Color color, int size, LCUI_Pos sta
 		len = area.y + area.height - start.y;
 	}
 
-	if( des->color_type == COLOR_TYPE_ARGB ) {
+	if( Graph_HasAlpha( des ) ) {
 		LCUI_ARGB *pPixel, *pRowPixel;
 		pRowPixel = des->argb + start.y*des->w + start.x;
 		for( y=0; y<len; ++y ) {
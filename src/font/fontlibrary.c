@@ -45,14 +45,21 @@
 #include <LCUI/graph.h>
 #include <LCUI/font.h>
 
+#include "../blend_simd.h"
+
 #define FONT_CACHE_SIZE	32
+#define FONT_BITMAP_CACHE_SLOTS	256
+#define FONT_ATLAS_PAGE_SIZE	256
+#define DEFAULT_FONT_BITMAP_CACHE_SIZE	(4 * 1024 * 1024)
 
 /**
- * 库中缓存的字体位图是分组存放的，共有三级分组，分别为：
- * 字符->字体信息->字体大小
- * 获取字体位图时的搜索顺序为：先找到字符的记录，然后在记录中的字体数据库里找
- * 到指定字体样式标识号的字体位图库，之后在字体位图库中找到指定像素大小的字体
- * 位图。
+ * 库中缓存的字体位图都存放在一个开放寻址的哈希表中，以字符码、字体标识号和
+ * 像素大小作为键，获取字体位图时只需计算一次哈希值，然后在相邻的几个槽位中
+ * 就能找到它。
+ * 字体位图的数据不单独分配内存，而是按货架式的排列方式存放在共用的 8 位图集
+ * 页中，同一段文本的字体位图在内存中相邻，也减少了内存碎片。
+ * 缓存占用的内存超出上限时，以页为单位回收最久没有使用的图集页，含有被引用
+ * 着的字体位图的图集页则会一直保留，直到没有对象引用它们。
  */
 
 /** 字体字族索引结点 */
@@ -61,6 +68,49 @@ typedef struct LCUI_FontFamilyNode {
 	LinkedList styles;	/**< 该字族下的各种样式的字体信息 */
 } LCUI_FontFamilyNode;
 
+/** 图集页中的货架，高度相近的字体位图从左到右依次摆放在同一个货架上 */
+typedef struct FontAtlasShelfRec_ {
+	int x;				/**< 下一个字体位图的位置 */
+	int y;				/**< 货架的顶边位置 */
+	int height;			/**< 货架的高度 */
+} FontAtlasShelfRec, *FontAtlasShelf;
+
+/** 字形图集页，多个字体位图共用其中的一块 8 位位图数据 */
+typedef struct FontAtlasPageRec_ {
+	uchar_t *buffer;		/**< 位图数据 */
+	int width;			/**< 宽度 */
+	int height;			/**< 高度 */
+	int bottom;			/**< 已有货架的底边位置 */
+	int num_shelves;		/**< 货架数量 */
+	FontAtlasShelf shelves;		/**< 货架列表 */
+	unsigned int refs;		/**< 页中的字体位图被引用的总次数 */
+	LinkedList glyphs;		/**< 存放在该页中的字体位图缓存项 */
+	LinkedListNode node;		/**< 在淘汰队列中的结点 */
+	LinkedListNode page_node;	/**< 在图集页列表中的结点 */
+} FontAtlasPageRec, *FontAtlasPage;
+
+/** 字体位图缓存项 */
+typedef struct FontBitmapCacheRec_ {
+	LCUI_FontBitmap bitmap;		/**< 字体位图，放在开头以便由它的地址得到缓存项 */
+	wchar_t ch;			/**< 字符码 */
+	int font_id;			/**< 字体标识号 */
+	int size;			/**< 像素大小 */
+	unsigned int hash;		/**< 键的哈希值 */
+	unsigned int refs;		/**< 引用次数 */
+	FontAtlasPage page;		/**< 位图数据所在的图集页 */
+	LinkedListNode node;		/**< 在图集页的字体位图列表中的结点 */
+} FontBitmapCacheRec, *FontBitmapCache;
+
+/** 字体位图缓存表 */
+typedef struct FontBitmapCacheTableRec_ {
+	FontBitmapCache *slots;		/**< 槽位列表，槽位数量总是 2 的幂 */
+	size_t capacity;		/**< 槽位数量 */
+	FontAtlasPage current;		/**< 当前用于存放新的字体位图的图集页 */
+	LinkedList pages;		/**< 所有的图集页 */
+	LinkedList lru;			/**< 没有被引用的图集页，按最近使用的时间排列 */
+	LCUI_FontCacheStatsRec stats;	/**< 统计数据 */
+} FontBitmapCacheTableRec;
+
 /** 字体路径索引结点 */
 typedef struct LCUI_FontPathNode {
 	char *path;		/**< 路径  */
@@ -72,7 +122,7 @@ static struct LCUI_FontLibraryContext {
 	int font_cache_num;			/**< 字体信息缓存区的数量 */
 	LCUI_BOOL is_inited;			/**< 标记，指示数据库是否初始化 */
 	RBTree family_tree;		/**< 字族信息树，按字族名称记录着各个字体的信息 */
-	RBTree bitmap_cache;		/**< 字体位图缓存区 */
+	FontBitmapCacheTableRec bitmap_cache;	/**< 字体位图缓存区 */
 	LCUI_Font ***font_cache;		/**< 字体信息缓存区 */
 	LCUI_Font *default_font;		/**< 默认字体的信息 */
 	LCUI_Font *incore_font;			/**< 内置字体的信息 */
@@ -82,9 +132,6 @@ static struct LCUI_FontLibraryContext {
 
 /** 检测位图数据是否有效 */
 #define FontBitmap_IsValid(fbmp) (fbmp && fbmp->width>0 && fbmp->rows>0)
-#define SelectChar(ch) (RBTree*)RBTree_GetData( &fontlib.bitmap_cache, ch )
-#define SelectFont(ch, font_id) (RBTree*)RBTree_GetData( ch, font_id )
-#define SelectBitmap(font, size) (LCUI_FontBitmap*)RBTree_GetData( font, size )
 #define SelectFontFamliy(family_name) (LCUI_FontFamilyNode*)\
 	RBTree_CustomGetData( &fontlib.family_tree, family_name );
 #define SelectFontCache(id) \
@@ -105,18 +152,6 @@ static void DestroyFontFamilyNode( void *arg )
 	LinkedList_Clear( &node->styles, NULL );
 }
 
-static void DestroyFontBitmap( void *arg )
-{
-	FontBitmap_Free( arg );
-	free( arg );
-}
-
-static void DestroyTreeNode( void *arg )
-{
-	RBTree_Destroy( arg );
-	free( arg );
-}
-
 int LCUIFont_Add( LCUI_Font *font )
 {
 	LCUI_Font *f;
@@ -222,61 +257,410 @@ void LCUIFont_SetDefault( int id )
 	}
 }
 
-LCUI_FontBitmap* LCUIFont_AddBitmap( wchar_t ch, int font_id,
-				     int size, const LCUI_FontBitmap *bmp )
+/** 计算字体位图缓存项的键的哈希值 */
+static unsigned int FontBitmapCache_Hash( wchar_t ch, int font_id, int size )
+{
+	unsigned int key = (unsigned int)font_id << 16 ^ (unsigned int)size;
+	return Dict_IntHashFunction( (unsigned int)ch ^
+				     Dict_IntHashFunction( key ) );
+}
+
+/** 将缓存项放入第一个空闲的槽位中 */
+static void FontBitmapCache_Put( FontBitmapCache cache )
 {
-	LCUI_FontBitmap *bmp_cache;
-	RBTree *tree_font, *tree_bmp;
+	size_t mask = fontlib.bitmap_cache.capacity - 1;
+	size_t i = cache->hash & mask;
+	FontBitmapCache *slots = fontlib.bitmap_cache.slots;
 
-	if( !fontlib.is_inited ) {
+	while( slots[i] ) {
+		i = (i + 1) & mask;
+	}
+	slots[i] = cache;
+}
+
+/** 查找缓存项所在的槽位，找不到时返回槽位数量 */
+static size_t FontBitmapCache_Find( wchar_t ch, int font_id, int size,
+				    unsigned int hash )
+{
+	FontBitmapCache cache;
+	size_t mask = fontlib.bitmap_cache.capacity - 1;
+	size_t i = hash & mask;
+
+	while( (cache = fontlib.bitmap_cache.slots[i]) ) {
+		if( cache->hash == hash && cache->ch == ch &&
+		    cache->font_id == font_id && cache->size == size ) {
+			return i;
+		}
+		i = (i + 1) & mask;
+	}
+	return fontlib.bitmap_cache.capacity;
+}
+
+/** 扩大槽位列表，并将已有的缓存项重新放入新的槽位中 */
+static int FontBitmapCache_Grow( void )
+{
+	size_t i, capacity;
+	FontBitmapCache *slots;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	capacity = table->capacity;
+	slots = table->slots;
+	table->slots = NEW( FontBitmapCache, capacity * 2 );
+	if( !table->slots ) {
+		table->slots = slots;
+		return -1;
+	}
+	table->capacity = capacity * 2;
+	for( i = 0; i < capacity; ++i ) {
+		if( slots[i] ) {
+			FontBitmapCache_Put( slots[i] );
+		}
+	}
+	free( slots );
+	return 0;
+}
+
+/** 移除槽位中的缓存项，并将后面的缓存项前移，以免打断它们的探测序列 */
+static void FontBitmapCache_RemoveSlot( size_t i )
+{
+	size_t j, k;
+	FontBitmapCache *slots = fontlib.bitmap_cache.slots;
+	size_t mask = fontlib.bitmap_cache.capacity - 1;
+
+	slots[i] = NULL;
+	for( j = (i + 1) & mask; slots[j]; j = (j + 1) & mask ) {
+		k = slots[j]->hash & mask;
+		/* 理想槽位 k 在 (i, j] 范围内的缓存项不需要移动 */
+		if( i <= j ? (i < k && k <= j) : (i < k || k <= j) ) {
+			continue;
+		}
+		slots[i] = slots[j];
+		slots[j] = NULL;
+		i = j;
+	}
+}
+
+/** 删除缓存项，它在图集页中占用的区域要等到整页被回收时才会释放 */
+static void FontBitmapCache_Delete( FontBitmapCache cache )
+{
+	size_t i;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	i = FontBitmapCache_Find( cache->ch, cache->font_id,
+				  cache->size, cache->hash );
+	if( i < table->capacity ) {
+		FontBitmapCache_RemoveSlot( i );
+	}
+	LinkedList_Unlink( &cache->page->glyphs, &cache->node );
+	table->stats.size -= sizeof( FontBitmapCacheRec );
+	table->stats.count -= 1;
+	free( cache );
+}
+
+/** 回收图集页，存放在其中的字体位图也会一起被删除 */
+static void FontAtlasPage_Delete( FontAtlasPage page )
+{
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	while( page->glyphs.length > 0 ) {
+		FontBitmapCache_Delete( page->glyphs.head.next->data );
+	}
+	if( page->refs == 0 ) {
+		LinkedList_Unlink( &table->lru, &page->node );
+	}
+	if( table->current == page ) {
+		table->current = NULL;
+	}
+	LinkedList_Unlink( &table->pages, &page->page_node );
+	table->stats.size -= page->width * page->height;
+	table->stats.pages -= 1;
+	free( page->shelves );
+	free( page->buffer );
+	free( page );
+}
+
+/**
+ * 回收最久没有使用的图集页，直到能再容纳 size 字节的数据
+ * 含有被引用的字体位图的图集页不在淘汰队列中，所以占用的内存可能仍会超出上限
+ */
+static void FontBitmapCache_Trim( size_t size )
+{
+	FontAtlasPage page;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	while( table->stats.size + size > table->stats.max_size &&
+	       table->lru.length > 0 ) {
+		page = table->lru.head.next->data;
+		table->stats.evictions += page->glyphs.length;
+		FontAtlasPage_Delete( page );
+	}
+}
+
+/** 新建图集页，新建前会先按内存上限回收旧的图集页 */
+static FontAtlasPage FontAtlasPage_New( int width, int height )
+{
+	FontAtlasPage page;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	FontBitmapCache_Trim( width * height );
+	page = NEW( FontAtlasPageRec, 1 );
+	if( !page ) {
 		return NULL;
 	}
-	/* 获取字符的字体信息集 */
-	tree_font = SelectChar( ch );
-	if( !tree_font ) {
-		tree_font = NEW(RBTree, 1);
-		if( !tree_font ) {
+	page->buffer = malloc( width * height );
+	if( !page->buffer ) {
+		free( page );
+		return NULL;
+	}
+	page->width = width;
+	page->height = height;
+	page->bottom = 0;
+	page->refs = 0;
+	page->shelves = NULL;
+	page->num_shelves = 0;
+	page->node.data = page;
+	page->page_node.data = page;
+	LinkedList_Init( &page->glyphs );
+	LinkedList_AppendNode( &table->lru, &page->node );
+	LinkedList_AppendNode( &table->pages, &page->page_node );
+	table->stats.size += width * height;
+	table->stats.pages += 1;
+	return page;
+}
+
+/** 在图集页的货架上分配一块区域 */
+static int FontAtlasPage_Alloc( FontAtlasPage page, int width, int height,
+				int *x, int *y )
+{
+	int i;
+	FontAtlasShelf shelf = NULL, shelves;
+
+	/* 空白的字体位图不占用区域 */
+	if( width == 0 || height == 0 ) {
+		*x = *y = 0;
+		return 0;
+	}
+	/* 优先放在高度相近的货架上，以免浪费货架的空间 */
+	for( i = 0; i < page->num_shelves; ++i ) {
+		shelves = &page->shelves[i];
+		if( height <= shelves->height &&
+		    height * 4 >= shelves->height * 3 &&
+		    shelves->x + width <= page->width ) {
+			shelf = shelves;
+			break;
+		}
+	}
+	if( !shelf && page->bottom + height <= page->height ) {
+		shelves = realloc( page->shelves, sizeof( FontAtlasShelfRec ) *
+				   (page->num_shelves + 1) );
+		if( !shelves ) {
+			return -1;
+		}
+		page->shelves = shelves;
+		shelf = &shelves[page->num_shelves++];
+		shelf->x = 0;
+		shelf->y = page->bottom;
+		shelf->height = height;
+		page->bottom += height;
+	}
+	/* 页面已经放不下新的货架，那就找个足够高的货架凑合一下 */
+	for( i = 0; !shelf && i < page->num_shelves; ++i ) {
+		shelves = &page->shelves[i];
+		if( height <= shelves->height &&
+		    shelves->x + width <= page->width ) {
+			shelf = shelves;
+		}
+	}
+	if( !shelf ) {
+		return -1;
+	}
+	*x = shelf->x;
+	*y = shelf->y;
+	shelf->x += width;
+	return 0;
+}
+
+/** 为字体位图分配图集页中的区域 */
+static FontAtlasPage FontAtlas_Alloc( int width, int height, int *x, int *y )
+{
+	FontAtlasPage page;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	/* 比图集页还大的字体位图单独占用一页 */
+	if( width > FONT_ATLAS_PAGE_SIZE || height > FONT_ATLAS_PAGE_SIZE ) {
+		page = FontAtlasPage_New( width, height );
+		if( !page || FontAtlasPage_Alloc( page, width, height,
+						  x, y ) != 0 ) {
 			return NULL;
 		}
-		RBTree_Init( tree_font );
-		RBTree_OnDestroy( tree_font, DestroyTreeNode );
-		RBTree_Insert( &fontlib.bitmap_cache, ch, tree_font );
+		return page;
+	}
+	page = table->current;
+	if( page && FontAtlasPage_Alloc( page, width, height, x, y ) == 0 ) {
+		return page;
+	}
+	page = FontAtlasPage_New( FONT_ATLAS_PAGE_SIZE, FONT_ATLAS_PAGE_SIZE );
+	if( !page || FontAtlasPage_Alloc( page, width, height, x, y ) != 0 ) {
+		return NULL;
+	}
+	table->current = page;
+	return page;
+}
+
+/**
+ * 将字体位图数据拷贝到图集页中
+ * 拷贝后 bmp 的位图数据会被释放，改为引用图集页中的区域
+ */
+static FontAtlasPage FontAtlas_Put( LCUI_FontBitmap *bmp )
+{
+	int x, y, row;
+	uchar_t *dst, *src;
+	FontAtlasPage page;
+	int width = FontBitmap_IsValid( bmp ) ? bmp->width : 0;
+	int rows = width > 0 ? bmp->rows : 0;
+
+	page = FontAtlas_Alloc( width, rows, &x, &y );
+	if( !page ) {
+		return NULL;
+	}
+	dst = page->buffer + y * page->width + x;
+	for( row = 0, src = bmp->buffer; row < rows; ++row ) {
+		memcpy( dst, src, width );
+		dst += page->width;
+		src += width;
+	}
+	free( bmp->buffer );
+	bmp->buffer = page->buffer + y * page->width + x;
+	bmp->pitch = page->width;
+	return page;
+}
+
+/** 增加图集页的引用次数，被引用的图集页不会被回收 */
+static void FontAtlasPage_Pin( FontAtlasPage page )
+{
+	if( page->refs == 0 ) {
+		LinkedList_Unlink( &fontlib.bitmap_cache.lru, &page->node );
+	}
+	page->refs += 1;
+}
+
+/** 减少图集页的引用次数，减少到 0 时放回淘汰队列中 */
+static void FontAtlasPage_Unpin( FontAtlasPage page )
+{
+	page->refs -= 1;
+	if( page->refs == 0 ) {
+		LinkedList_AppendNode( &fontlib.bitmap_cache.lru, &page->node );
+	}
+}
+
+static void FontBitmapCache_Init( void )
+{
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+	table->capacity = FONT_BITMAP_CACHE_SLOTS;
+	table->slots = NEW( FontBitmapCache, table->capacity );
+	table->current = NULL;
+	LinkedList_Init( &table->lru );
+	LinkedList_Init( &table->pages );
+	memset( &table->stats, 0, sizeof( table->stats ) );
+	table->stats.max_size = DEFAULT_FONT_BITMAP_CACHE_SIZE;
+}
+
+static void FontBitmapCache_Destroy( void )
+{
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+	while( table->pages.length > 0 ) {
+		FontAtlasPage_Delete( table->pages.head.next->data );
+	}
+	free( table->slots );
+	table->slots = NULL;
+	table->capacity = 0;
+}
+
+LCUI_FontBitmap* LCUIFont_AddBitmap( wchar_t ch, int font_id,
+				     int size, const LCUI_FontBitmap *bmp )
+{
+	size_t i;
+	unsigned int n, hash;
+	FontAtlasPage page;
+	FontBitmapCache cache;
+	LCUI_FontBitmap bitmap = *bmp;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
+
+	if( !fontlib.is_inited ) {
+		return NULL;
 	}
 	/* 当字体ID不大于0时，使用内置字体 */
 	if( font_id <= 0 ) {
 		font_id = fontlib.incore_font->id;
 	}
-	/* 获取相应字体样式标识号的字体位图库 */
-	tree_bmp = SelectFont( tree_font, font_id );
-	if( !tree_bmp ) {
-		tree_bmp = NEW(RBTree, 1);
-		if( !tree_bmp ) {
-			return NULL;
+	hash = FontBitmapCache_Hash( ch, font_id, size );
+	i = FontBitmapCache_Find( ch, font_id, size, hash );
+	if( i < table->capacity ) {
+		cache = table->slots[i];
+		if( bmp == &cache->bitmap ) {
+			return &cache->bitmap;
 		}
-		RBTree_Init( tree_bmp );
-		RBTree_OnDestroy( tree_bmp, DestroyFontBitmap );
-		RBTree_Insert( tree_font, font_id, tree_bmp );
-	}
-	/* 在字体位图库中获取指定像素大小的字体位图 */
-	bmp_cache = SelectBitmap( tree_bmp, size );
-	if( !bmp_cache ) {
-		bmp_cache = NEW(LCUI_FontBitmap, 1);
-		if( !bmp_cache ) {
-			return NULL;
+		/* 没被引用的旧缓存可以直接删除，然后当作新的缓存项添加 */
+		if( cache->refs == 0 ) {
+			FontBitmapCache_Delete( cache );
+		} else {
+			/* 被引用的旧缓存只能原地替换，它所在的图集页也
+			 * 不会在分配区域时被回收 */
+			page = FontAtlas_Put( &bitmap );
+			if( !page ) {
+				FontBitmap_Free( &bitmap );
+				return NULL;
+			}
+			for( n = 0; n < cache->refs; ++n ) {
+				FontAtlasPage_Pin( page );
+				FontAtlasPage_Unpin( cache->page );
+			}
+			LinkedList_Unlink( &cache->page->glyphs, &cache->node );
+			LinkedList_AppendNode( &page->glyphs, &cache->node );
+			cache->page = page;
+			cache->bitmap = bitmap;
+			return &cache->bitmap;
 		}
-		RBTree_Insert( tree_bmp, size, bmp_cache );
 	}
-	/* 拷贝数据至该空间内 */
-	memcpy( bmp_cache, bmp, sizeof(LCUI_FontBitmap) );
-	return bmp_cache;
+	if( (table->stats.count + 1) * 2 > table->capacity &&
+	    FontBitmapCache_Grow() != 0 ) {
+		return NULL;
+	}
+	cache = NEW( FontBitmapCacheRec, 1 );
+	if( !cache ) {
+		return NULL;
+	}
+	page = FontAtlas_Put( &bitmap );
+	if( !page ) {
+		FontBitmap_Free( &bitmap );
+		free( cache );
+		return NULL;
+	}
+	cache->bitmap = bitmap;
+	cache->ch = ch;
+	cache->font_id = font_id;
+	cache->size = size;
+	cache->hash = hash;
+	cache->refs = 0;
+	cache->page = page;
+	cache->node.data = cache;
+	FontBitmapCache_Put( cache );
+	LinkedList_AppendNode( &page->glyphs, &cache->node );
+	table->stats.size += sizeof( FontBitmapCacheRec );
+	table->stats.count += 1;
+	return &cache->bitmap;
 }
 
 int LCUIFont_GetBitmap( wchar_t ch, int font_id, int size,
 			const LCUI_FontBitmap **bmp )
 {
 	int ret;
-	RBTree *ctx;
+	size_t i;
+	unsigned int hash;
+	FontAtlasPage page;
+	FontBitmapCache cache;
 	LCUI_FontBitmap bmp_cache;
+	FontBitmapCacheTableRec *table = &fontlib.bitmap_cache;
 
 	*bmp = NULL;
 	if( !fontlib.is_inited ) {
@@ -289,21 +673,21 @@ int LCUIFont_GetBitmap( wchar_t ch, int font_id, int size,
 			font_id = fontlib.incore_font->id;
 		}
 	}
-	/* 这里的 while 只是为了减少缩进 */
-	while( TRUE ) {
-		if( !(ctx = SelectChar(ch)) ) {
-			break;
+	hash = FontBitmapCache_Hash( ch, font_id, size );
+	i = FontBitmapCache_Find( ch, font_id, size, hash );
+	if( i < table->capacity ) {
+		cache = table->slots[i];
+		page = cache->page;
+		table->stats.hits += 1;
+		/* 将图集页移到淘汰队列的末尾，标记为最近使用过 */
+		if( page->refs == 0 ) {
+			LinkedList_Unlink( &table->lru, &page->node );
+			LinkedList_AppendNode( &table->lru, &page->node );
 		}
-		ctx = SelectFont( ctx, font_id );
-		if( !ctx ) {
-			break;
-		}
-		*bmp = SelectBitmap( ctx, size );
-		if( *bmp ) {
-			return 0;
-		}
-		break;
+		*bmp = &cache->bitmap;
+		return 0;
 	}
+	table->stats.misses += 1;
 	if( ch == 0 ) {
 		return -1;
 	}
@@ -316,10 +700,46 @@ int LCUIFont_GetBitmap( wchar_t ch, int font_id, int size,
 	ret = LCUIFont_GetBitmap( 0, font_id, size, bmp );
 	if( ret != 0 ) {
 		*bmp = LCUIFont_AddBitmap( 0, font_id, size, &bmp_cache );
+	} else {
+		FontBitmap_Free( &bmp_cache );
 	}
 	return -1;
 }
 
+void LCUIFont_PinBitmap( const LCUI_FontBitmap *bmp )
+{
+	FontBitmapCache cache = (FontBitmapCache)bmp;
+	if( !bmp || !fontlib.is_inited ) {
+		return;
+	}
+	FontAtlasPage_Pin( cache->page );
+	cache->refs += 1;
+}
+
+void LCUIFont_UnpinBitmap( const LCUI_FontBitmap *bmp )
+{
+	FontBitmapCache cache = (FontBitmapCache)bmp;
+	if( !bmp || !fontlib.is_inited || cache->refs == 0 ) {
+		return;
+	}
+	cache->refs -= 1;
+	FontAtlasPage_Unpin( cache->page );
+	if( cache->page->refs == 0 ) {
+		FontBitmapCache_Trim( 0 );
+	}
+}
+
+void LCUIFont_GetCacheStats( LCUI_FontCacheStats stats )
+{
+	*stats = fontlib.bitmap_cache.stats;
+}
+
+void LCUIFont_SetCacheMaxSize( size_t size )
+{
+	fontlib.bitmap_cache.stats.max_size = size;
+	FontBitmapCache_Trim( 0 );
+}
+
 int LCUIFont_LoadFile( const char *filepath )
 {
 	LCUI_Font **fonts;
@@ -360,6 +780,7 @@ void FontBitmap_Init( LCUI_FontBitmap *bitmap )
 {
 	bitmap->rows = 0;
 	bitmap->width = 0;
+	bitmap->pitch = 0;
 	bitmap->top = 0;
 	bitmap->left = 0;
 	bitmap->buffer = NULL;
@@ -387,6 +808,7 @@ int FontBitmap_Create( LCUI_FontBitmap *bitmap, int width, int rows )
 	}
 	bitmap->width = width;
 	bitmap->rows = rows;
+	bitmap->pitch = width;
 	size = width*rows*sizeof(uchar_t);
 	bitmap->buffer = (uchar_t*)malloc( size );
 	if( bitmap->buffer == NULL ) {
@@ -400,7 +822,7 @@ int FontBitmap_Print( LCUI_FontBitmap *fontbmp )
 {
 	int x,y,m;
 	for(y = 0;y < fontbmp->rows; ++y){
-		m = y*fontbmp->width;
+		m = y*fontbmp->pitch;
 		for(x = 0; x < fontbmp->width; ++x,++m){
 			if(fontbmp->buffer[m] > 128) {
 				LOG("#");
@@ -416,40 +838,572 @@ int FontBitmap_Print( LCUI_FontBitmap *fontbmp )
 	return 0;
 }
 
-static void FontBitmap_MixARGB( LCUI_Graph *graph, LCUI_Rect *write_rect,
+/**
+ * 字体位图的混合
+ * 字体位图中的值是字形对像素的覆盖率 ca，混合时将它作为文字颜色的 alpha 值，
+ * 全部使用整数运算：
+ * - 背景不透明或是 PARGB 图像时，out = DIV255(c * ca + d * (255 - ca))
+ * - 其它情况下，以 1/65025 为单位计算权重，ws = ca * 255，
+ *   wd = da * (255 - ca)，out = (c * ws + d * wd) / (ws + wd)
+ * 两个公式在背景不透明时的结果完全相同，SIMD 内核可以按像素组选择其中一个。
+ * 覆盖率为 0 的像素保持不变，SIMD 内核会跳过覆盖率全为 0 的像素组。
+ */
+
+/** 单行像素的字体位图混合函数 */
+typedef void( *GlyphRowFunc )(LCUI_ARGB*, const uchar_t*, int, LCUI_ARGB);
+
+static void GlyphRow_ARGB( LCUI_ARGB *dst, const uchar_t *cov,
+			   int n, LCUI_ARGB color )
+{
+	uint_t ca, inv, ws, wd, out_a;
+	const uchar_t *end = cov + n;
+
+	for( ; cov < end; ++cov, ++dst ) {
+		ca = *cov;
+		if( ca == 0 ) {
+			continue;
+		}
+		if( ca == 255 ) {
+			*dst = color;
+			continue;
+		}
+		inv = 255 - ca;
+		if( dst->a == 255 ) {
+			dst->r = DIV255( color.r * ca + dst->r * inv );
+			dst->g = DIV255( color.g * ca + dst->g * inv );
+			dst->b = DIV255( color.b * ca + dst->b * inv );
+			continue;
+		}
+		ws = ca * 255;
+		wd = dst->a * inv;
+		out_a = ws + wd;
+		dst->r = (color.r * ws + dst->r * wd + (out_a >> 1)) / out_a;
+		dst->g = (color.g * ws + dst->g * wd + (out_a >> 1)) / out_a;
+		dst->b = (color.b * ws + dst->b * wd + (out_a >> 1)) / out_a;
+		dst->a = DIV255( out_a );
+	}
+}
+
+/** 混合到 PARGB 图像，只需要乘加运算 */
+static void GlyphRow_PARGB( LCUI_ARGB *dst, const uchar_t *cov,
+			    int n, LCUI_ARGB color )
+{
+	uint_t ca, inv;
+	const uchar_t *end = cov + n;
+
+	for( ; cov < end; ++cov, ++dst ) {
+		ca = *cov;
+		if( ca == 0 ) {
+			continue;
+		}
+		if( ca == 255 ) {
+			*dst = color;
+			continue;
+		}
+		inv = 255 - ca;
+		dst->r = DIV255( color.r * ca + dst->r * inv );
+		dst->g = DIV255( color.g * ca + dst->g * inv );
+		dst->b = DIV255( color.b * ca + dst->b * inv );
+		dst->a = DIV255( 255 * ca + dst->a * inv );
+	}
+}
+
+#ifdef LCUI_BLEND_SSE2
+
+/**
+ * 按覆盖率在背景和文字颜色之间插值，参数中的每个通道都是 16 位整数
+ * 文字颜色的 alpha 值为 255，所以也适用于 PARGB 图像
+ */
+static __m128i SSE2_GlyphLerp( __m128i c, __m128i d, __m128i ca )
+{
+	__m128i inv = _mm_sub_epi16( _mm_set1_epi16( 255 ), ca );
+	return SSE2_Div255( _mm_add_epi16( _mm_mullo_epi16( c, ca ),
+					   _mm_mullo_epi16( d, inv ) ) );
+}
+
+/** 将文字颜色混合到半透明的背景上 */
+static __m128i SSE2_GlyphBlend( __m128i c, __m128i d, __m128i ca )
+{
+	__m128i ws, wd, out_a, mask, lo, hi, lo2, hi2, den_lo, den_hi;
+	const __m128i zero = _mm_setzero_si128();
+
+	ws = _mm_mullo_epi16( ca, _mm_set1_epi16( 255 ) );
+	wd = _mm_mullo_epi16( SSE2_ExpandAlpha( d ),
+			      _mm_sub_epi16( _mm_set1_epi16( 255 ), ca ) );
+	out_a = _mm_add_epi16( ws, wd );
+	SSE2_Multiply( c, ws, &lo, &hi );
+	SSE2_Multiply( d, wd, &lo2, &hi2 );
+	den_lo = _mm_unpacklo_epi16( out_a, zero );
+	den_hi = _mm_unpackhi_epi16( out_a, zero );
+	lo = _mm_add_epi32( _mm_add_epi32( lo, lo2 ),
+			    _mm_srli_epi32( den_lo, 1 ) );
+	hi = _mm_add_epi32( _mm_add_epi32( hi, hi2 ),
+			    _mm_srli_epi32( den_hi, 1 ) );
+	/* 覆盖率和背景 alpha 值都为 0 时 den 为 0，这种像素最后会保持不变 */
+	den_lo = _mm_sub_epi32( den_lo, _mm_cmpeq_epi32( den_lo, zero ) );
+	den_hi = _mm_sub_epi32( den_hi, _mm_cmpeq_epi32( den_hi, zero ) );
+	lo = _mm_packs_epi32( SSE2_Divide( lo, den_lo ),
+			      SSE2_Divide( hi, den_hi ) );
+	mask = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+	lo = _mm_or_si128( _mm_and_si128( mask, SSE2_Div255( out_a ) ),
+			   _mm_andnot_si128( mask, lo ) );
+	mask = _mm_cmpeq_epi16( ca, zero );
+	return _mm_or_si128( _mm_and_si128( mask, d ),
+			     _mm_andnot_si128( mask, lo ) );
+}
+
+/** 将 4 个覆盖率扩展到 4 个像素的所有通道中 */
+static __m128i SSE2_ExpandCoverage( const uchar_t *cov )
+{
+	int value;
+	__m128i c;
+
+	memcpy( &value, cov, sizeof( value ) );
+	c = _mm_cvtsi32_si128( value );
+	c = _mm_unpacklo_epi8( c, c );
+	return _mm_unpacklo_epi16( c, c );
+}
+
+/** 混合 4 个像素，c 是已解包为 16 位整数的文字颜色 */
+static void GlyphQuad_ARGB_SSE2( LCUI_ARGB *dst, const uchar_t *cov,
+				 __m128i c )
+{
+	__m128i d, ca, da, lo, hi;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32( (int)0xff000000 );
+
+	ca = SSE2_ExpandCoverage( cov );
+	if( _mm_movemask_epi8( _mm_cmpeq_epi32( ca, zero ) ) == 0xffff ) {
+		return;
+	}
+	d = _mm_loadu_si128( (const __m128i*)dst );
+	da = _mm_cmpeq_epi32( _mm_and_si128( d, amask ), amask );
+	lo = _mm_unpacklo_epi8( d, zero );
+	hi = _mm_unpackhi_epi8( d, zero );
+	/* 背景像素都是不透明的，只需插值 */
+	if( _mm_movemask_epi8( da ) == 0xffff ) {
+		lo = SSE2_GlyphLerp( c, lo, _mm_unpacklo_epi8( ca, zero ) );
+		hi = SSE2_GlyphLerp( c, hi, _mm_unpackhi_epi8( ca, zero ) );
+	} else {
+		lo = SSE2_GlyphBlend( c, lo, _mm_unpacklo_epi8( ca, zero ) );
+		hi = SSE2_GlyphBlend( c, hi, _mm_unpackhi_epi8( ca, zero ) );
+	}
+	_mm_storeu_si128( (__m128i*)dst, _mm_packus_epi16( lo, hi ) );
+}
+
+static void GlyphQuad_PARGB_SSE2( LCUI_ARGB *dst, const uchar_t *cov,
+				  __m128i c )
+{
+	__m128i d, ca, lo, hi;
+	const __m128i zero = _mm_setzero_si128();
+
+	ca = SSE2_ExpandCoverage( cov );
+	d = _mm_loadu_si128( (const __m128i*)dst );
+	lo = SSE2_GlyphLerp( c, _mm_unpacklo_epi8( d, zero ),
+			     _mm_unpacklo_epi8( ca, zero ) );
+	hi = SSE2_GlyphLerp( c, _mm_unpackhi_epi8( d, zero ),
+			     _mm_unpackhi_epi8( ca, zero ) );
+	_mm_storeu_si128( (__m128i*)dst, _mm_packus_epi16( lo, hi ) );
+}
+
+/** 检查 16 个覆盖率是否都为 0 */
+static LCUI_BOOL SSE2_IsBlank( const uchar_t *cov )
+{
+	__m128i ca = _mm_loadu_si128( (const __m128i*)cov );
+	ca = _mm_cmpeq_epi8( ca, _mm_setzero_si128() );
+	return _mm_movemask_epi8( ca ) == 0xffff;
+}
+
+/**
+ * 每次处理 16 个像素，跳过覆盖率全为 0 的部分，剩下的像素按每组 4 个处理
+ * 字形的宽度通常不到 16 像素，所以也需要按组处理
+ */
+static void GlyphRow_ARGB_SSE2( LCUI_ARGB *dst, const uchar_t *cov,
+				int n, LCUI_ARGB color )
+{
+	int i;
+	__m128i c;
+
+	c = _mm_set1_epi32( (int)color.value );
+	c = _mm_unpacklo_epi8( c, _mm_setzero_si128() );
+	for( i = 0; i + 16 <= n; i += 16 ) {
+		if( SSE2_IsBlank( cov + i ) ) {
+			continue;
+		}
+		GlyphQuad_ARGB_SSE2( dst + i, cov + i, c );
+		GlyphQuad_ARGB_SSE2( dst + i + 4, cov + i + 4, c );
+		GlyphQuad_ARGB_SSE2( dst + i + 8, cov + i + 8, c );
+		GlyphQuad_ARGB_SSE2( dst + i + 12, cov + i + 12, c );
+	}
+	for( ; i + 4 <= n; i += 4 ) {
+		GlyphQuad_ARGB_SSE2( dst + i, cov + i, c );
+	}
+	GlyphRow_ARGB( dst + i, cov + i, n - i, color );
+}
+
+static void GlyphRow_PARGB_SSE2( LCUI_ARGB *dst, const uchar_t *cov,
+				 int n, LCUI_ARGB color )
+{
+	int i;
+	__m128i c;
+
+	c = _mm_set1_epi32( (int)color.value );
+	c = _mm_unpacklo_epi8( c, _mm_setzero_si128() );
+	for( i = 0; i + 16 <= n; i += 16 ) {
+		if( SSE2_IsBlank( cov + i ) ) {
+			continue;
+		}
+		GlyphQuad_PARGB_SSE2( dst + i, cov + i, c );
+		GlyphQuad_PARGB_SSE2( dst + i + 4, cov + i + 4, c );
+		GlyphQuad_PARGB_SSE2( dst + i + 8, cov + i + 8, c );
+		GlyphQuad_PARGB_SSE2( dst + i + 12, cov + i + 12, c );
+	}
+	for( ; i + 4 <= n; i += 4 ) {
+		GlyphQuad_PARGB_SSE2( dst + i, cov + i, c );
+	}
+	GlyphRow_PARGB( dst + i, cov + i, n - i, color );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_AVX2
+
+LCUI_TARGET_AVX2 static __m256i AVX2_GlyphLerp( __m256i c, __m256i d,
+						__m256i ca )
+{
+	__m256i inv = _mm256_sub_epi16( _mm256_set1_epi16( 255 ), ca );
+	return AVX2_Div255( _mm256_add_epi16( _mm256_mullo_epi16( c, ca ),
+					      _mm256_mullo_epi16( d, inv ) ) );
+}
+
+LCUI_TARGET_AVX2 static __m256i AVX2_GlyphBlend( __m256i c, __m256i d,
+						 __m256i ca )
+{
+	__m256i ws, wd, out_a, mask, lo, hi, lo2, hi2, den_lo, den_hi;
+	const __m256i zero = _mm256_setzero_si256();
+
+	ws = _mm256_mullo_epi16( ca, _mm256_set1_epi16( 255 ) );
+	wd = _mm256_mullo_epi16( AVX2_ExpandAlpha( d ), _mm256_sub_epi16(
+		_mm256_set1_epi16( 255 ), ca ) );
+	out_a = _mm256_add_epi16( ws, wd );
+	AVX2_Multiply( c, ws, &lo, &hi );
+	AVX2_Multiply( d, wd, &lo2, &hi2 );
+	den_lo = _mm256_unpacklo_epi16( out_a, zero );
+	den_hi = _mm256_unpackhi_epi16( out_a, zero );
+	lo = _mm256_add_epi32( _mm256_add_epi32( lo, lo2 ),
+			       _mm256_srli_epi32( den_lo, 1 ) );
+	hi = _mm256_add_epi32( _mm256_add_epi32( hi, hi2 ),
+			       _mm256_srli_epi32( den_hi, 1 ) );
+	den_lo = _mm256_max_epi32( den_lo, _mm256_set1_epi32( 1 ) );
+	den_hi = _mm256_max_epi32( den_hi, _mm256_set1_epi32( 1 ) );
+	lo = _mm256_packs_epi32( AVX2_Divide( lo, den_lo ),
+				 AVX2_Divide( hi, den_hi ) );
+	mask = _mm256_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0,
+				 -1, 0, 0, 0, -1, 0, 0, 0 );
+	lo = _mm256_blendv_epi8( lo, AVX2_Div255( out_a ), mask );
+	return _mm256_blendv_epi8( lo, d, _mm256_cmpeq_epi16( ca, zero ) );
+}
+
+/** 将 8 个覆盖率扩展到 8 个像素的所有通道中 */
+LCUI_TARGET_AVX2 static __m256i AVX2_ExpandCoverage( const uchar_t *cov )
+{
+	__m256i c;
+
+	c = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)cov ) );
+	c = _mm256_or_si256( c, _mm256_slli_epi32( c, 8 ) );
+	return _mm256_or_si256( c, _mm256_slli_epi32( c, 16 ) );
+}
+
+LCUI_TARGET_AVX2 static void GlyphOctet_ARGB_AVX2( LCUI_ARGB *dst,
+						   const uchar_t *cov,
+						   __m256i c )
+{
+	__m256i d, ca, da, lo, hi;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32( (int)0xff000000 );
+
+	ca = AVX2_ExpandCoverage( cov );
+	if( _mm256_testz_si256( ca, ca ) ) {
+		return;
+	}
+	d = _mm256_loadu_si256( (const __m256i*)dst );
+	da = _mm256_cmpeq_epi32( _mm256_and_si256( d, amask ), amask );
+	lo = _mm256_unpacklo_epi8( d, zero );
+	hi = _mm256_unpackhi_epi8( d, zero );
+	if( _mm256_movemask_epi8( da ) == -1 ) {
+		lo = AVX2_GlyphLerp( c, lo, _mm256_unpacklo_epi8( ca, zero ) );
+		hi = AVX2_GlyphLerp( c, hi, _mm256_unpackhi_epi8( ca, zero ) );
+	} else {
+		lo = AVX2_GlyphBlend( c, lo, _mm256_unpacklo_epi8( ca, zero ) );
+		hi = AVX2_GlyphBlend( c, hi, _mm256_unpackhi_epi8( ca, zero ) );
+	}
+	_mm256_storeu_si256( (__m256i*)dst, _mm256_packus_epi16( lo, hi ) );
+}
+
+LCUI_TARGET_AVX2 static void GlyphOctet_PARGB_AVX2( LCUI_ARGB *dst,
+						    const uchar_t *cov,
+						    __m256i c )
+{
+	__m256i d, ca, lo, hi;
+	const __m256i zero = _mm256_setzero_si256();
+
+	ca = AVX2_ExpandCoverage( cov );
+	d = _mm256_loadu_si256( (const __m256i*)dst );
+	lo = AVX2_GlyphLerp( c, _mm256_unpacklo_epi8( d, zero ),
+			     _mm256_unpacklo_epi8( ca, zero ) );
+	hi = AVX2_GlyphLerp( c, _mm256_unpackhi_epi8( d, zero ),
+			     _mm256_unpackhi_epi8( ca, zero ) );
+	_mm256_storeu_si256( (__m256i*)dst, _mm256_packus_epi16( lo, hi ) );
+}
+
+/**
+ * 每次处理 16 个像素，剩下的像素按每组 8 个处理
+ * 在调用标量版本的函数前需要清除 YMM 寄存器的高位，否则之后的 SSE 指令会
+ * 变得很慢
+ */
+LCUI_TARGET_AVX2 static void GlyphRow_ARGB_AVX2( LCUI_ARGB *dst,
+						 const uchar_t *cov,
+						 int n, LCUI_ARGB color )
+{
+	int i;
+	__m256i c;
+
+	c = _mm256_set1_epi32( (int)color.value );
+	c = _mm256_unpacklo_epi8( c, _mm256_setzero_si256() );
+	for( i = 0; i + 16 <= n; i += 16 ) {
+		if( SSE2_IsBlank( cov + i ) ) {
+			continue;
+		}
+		GlyphOctet_ARGB_AVX2( dst + i, cov + i, c );
+		GlyphOctet_ARGB_AVX2( dst + i + 8, cov + i + 8, c );
+	}
+	if( i + 8 <= n ) {
+		GlyphOctet_ARGB_AVX2( dst + i, cov + i, c );
+		i += 8;
+	}
+	_mm256_zeroupper();
+	GlyphRow_ARGB( dst + i, cov + i, n - i, color );
+}
+
+LCUI_TARGET_AVX2 static void GlyphRow_PARGB_AVX2( LCUI_ARGB *dst,
+						  const uchar_t *cov,
+						  int n, LCUI_ARGB color )
+{
+	int i;
+	__m256i c;
+
+	c = _mm256_set1_epi32( (int)color.value );
+	c = _mm256_unpacklo_epi8( c, _mm256_setzero_si256() );
+	for( i = 0; i + 16 <= n; i += 16 ) {
+		if( SSE2_IsBlank( cov + i ) ) {
+			continue;
+		}
+		GlyphOctet_PARGB_AVX2( dst + i, cov + i, c );
+		GlyphOctet_PARGB_AVX2( dst + i + 8, cov + i + 8, c );
+	}
+	if( i + 8 <= n ) {
+		GlyphOctet_PARGB_AVX2( dst + i, cov + i, c );
+		i += 8;
+	}
+	_mm256_zeroupper();
+	GlyphRow_PARGB( dst + i, cov + i, n - i, color );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_NEON
+
+static uint16x8_t NEON_GlyphLerp( uint16x8_t c, uint16x8_t d, uint16x8_t ca )
+{
+	uint16x8_t inv = vsubq_u16( vdupq_n_u16( 255 ), ca );
+	return NEON_Div255( vmlaq_u16( vmulq_u16( c, ca ), d, inv ) );
+}
+
+/** 将文字颜色混合到半透明的背景上，da 是已展开到每个通道的 alpha 值 */
+static uint16x8_t NEON_GlyphBlend( uint16x8_t c, uint16x8_t d,
+				   uint16x8_t da, uint16x8_t ca )
+{
+	uint16x8_t ws, wd, out_a, out;
+	uint32x4_t lo, hi, den_lo, den_hi;
+	static const uint16_t mask_data[8] = {
+		0, 0, 0, 0xffff, 0, 0, 0, 0xffff
+	};
+
+	ws = vmulq_u16( ca, vdupq_n_u16( 255 ) );
+	wd = vmulq_u16( da, vsubq_u16( vdupq_n_u16( 255 ), ca ) );
+	out_a = vaddq_u16( ws, wd );
+	den_lo = vmovl_u16( vget_low_u16( out_a ) );
+	den_hi = vmovl_u16( vget_high_u16( out_a ) );
+	lo = vmull_u16( vget_low_u16( c ), vget_low_u16( ws ) );
+	lo = vmlal_u16( lo, vget_low_u16( d ), vget_low_u16( wd ) );
+	lo = vaddq_u32( lo, vshrq_n_u32( den_lo, 1 ) );
+	hi = vmull_u16( vget_high_u16( c ), vget_high_u16( ws ) );
+	hi = vmlal_u16( hi, vget_high_u16( d ), vget_high_u16( wd ) );
+	hi = vaddq_u32( hi, vshrq_n_u32( den_hi, 1 ) );
+	den_lo = vmaxq_u32( den_lo, vdupq_n_u32( 1 ) );
+	den_hi = vmaxq_u32( den_hi, vdupq_n_u32( 1 ) );
+	lo = NEON_Divide( lo, den_lo );
+	hi = NEON_Divide( hi, den_hi );
+	out = vbslq_u16( vld1q_u16( mask_data ), NEON_Div255( out_a ),
+			 vcombine_u16( vmovn_u32( lo ), vmovn_u32( hi ) ) );
+	return vbslq_u16( vceqq_u16( ca, vdupq_n_u16( 0 ) ), d, out );
+}
+
+/** 混合 4 个像素，ca 是已扩展到每个通道的覆盖率 */
+static void GlyphQuad_ARGB_NEON( LCUI_ARGB *dst, uint8x16_t ca,
+				 uint16x8_t c )
+{
+	uint16x8_t lo, hi;
+	uint8x16_t d, da;
+	static const uint8_t index_data[16] = {
+		3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15
+	};
+
+	if( vmaxvq_u8( ca ) == 0 ) {
+		return;
+	}
+	d = vld1q_u8( (const uint8_t*)dst );
+	da = vqtbl1q_u8( d, vld1q_u8( index_data ) );
+	if( vminvq_u8( da ) == 255 ) {
+		lo = NEON_GlyphLerp( c, vmovl_u8( vget_low_u8( d ) ),
+				     vmovl_u8( vget_low_u8( ca ) ) );
+		hi = NEON_GlyphLerp( c, vmovl_u8( vget_high_u8( d ) ),
+				     vmovl_u8( vget_high_u8( ca ) ) );
+	} else {
+		lo = NEON_GlyphBlend( c, vmovl_u8( vget_low_u8( d ) ),
+				      vmovl_u8( vget_low_u8( da ) ),
+				      vmovl_u8( vget_low_u8( ca ) ) );
+		hi = NEON_GlyphBlend( c, vmovl_u8( vget_high_u8( d ) ),
+				      vmovl_u8( vget_high_u8( da ) ),
+				      vmovl_u8( vget_high_u8( ca ) ) );
+	}
+	vst1q_u8( (uint8_t*)dst, vcombine_u8( vqmovn_u16( lo ),
+					      vqmovn_u16( hi ) ) );
+}
+
+static void GlyphQuad_PARGB_NEON( LCUI_ARGB *dst, uint8x16_t ca,
+				  uint16x8_t c )
+{
+	uint16x8_t lo, hi;
+	uint8x16_t d = vld1q_u8( (const uint8_t*)dst );
+
+	lo = NEON_GlyphLerp( c, vmovl_u8( vget_low_u8( d ) ),
+			     vmovl_u8( vget_low_u8( ca ) ) );
+	hi = NEON_GlyphLerp( c, vmovl_u8( vget_high_u8( d ) ),
+			     vmovl_u8( vget_high_u8( ca ) ) );
+	vst1q_u8( (uint8_t*)dst, vcombine_u8( vqmovn_u16( lo ),
+					      vqmovn_u16( hi ) ) );
+}
+
+/** 将 4 个覆盖率扩展到 4 个像素的所有通道中 */
+static uint8x16_t NEON_ExpandCoverage( const uchar_t *cov )
+{
+	uint32_t value;
+	uint8x8_t c;
+
+	memcpy( &value, cov, sizeof( value ) );
+	c = vreinterpret_u8_u32( vdup_n_u32( value ) );
+	c = vzip1_u8( c, c );
+	return vreinterpretq_u8_u16( vzip1q_u16(
+		vreinterpretq_u16_u8( vcombine_u8( c, c ) ),
+		vreinterpretq_u16_u8( vcombine_u8( c, c ) ) ) );
+}
+
+static void GlyphRow_ARGB_NEON( LCUI_ARGB *dst, const uchar_t *cov,
+				int n, LCUI_ARGB color )
+{
+	int i, j;
+	uint16x8_t c;
+
+	c = vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( color.value ) ) );
+	for( i = 0; i + 16 <= n; i += 16 ) {
+		if( vmaxvq_u8( vld1q_u8( cov + i ) ) == 0 ) {
+			continue;
+		}
+		for( j = i; j < i + 16; j += 4 ) {
+			GlyphQuad_ARGB_NEON( dst + j,
+					     NEON_ExpandCoverage( cov + j ), c );
+		}
+	}
+	for( ; i + 4 <= n; i += 4 ) {
+		GlyphQuad_ARGB_NEON( dst + i, NEON_ExpandCoverage( cov + i ),
+				     c );
+	}
+	GlyphRow_ARGB( dst + i, cov + i, n - i, color );
+}
+
+static void GlyphRow_PARGB_NEON( LCUI_ARGB *dst, const uchar_t *cov,
+				 int n, LCUI_ARGB color )
+{
+	int i, j;
+	uint16x8_t c;
+
+	c = vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( color.value ) ) );
+	for( i = 0; i + 16 <= n; i += 16 ) {
+		if( vmaxvq_u8( vld1q_u8( cov + i ) ) == 0 ) {
+			continue;
+		}
+		for( j = i; j < i + 16; j += 4 ) {
+			GlyphQuad_PARGB_NEON( dst + j,
+					      NEON_ExpandCoverage( cov + j ),
+					      c );
+		}
+	}
+	for( ; i + 4 <= n; i += 4 ) {
+		GlyphQuad_PARGB_NEON( dst + i, NEON_ExpandCoverage( cov + i ),
+				      c );
+	}
+	GlyphRow_PARGB( dst + i, cov + i, n - i, color );
+}
+
+#endif
+
+/**
+ * 根据当前使用的像素混合内核，选择字体位图的混合函数
+ * RGB 图像没有对应的混合函数，返回 NULL
+ */
+static GlyphRowFunc FontBitmap_GetRowFunc( int color_type )
+{
+	LCUI_BOOL pargb = color_type == COLOR_TYPE_PARGB;
+	if( color_type != COLOR_TYPE_ARGB && !pargb ) {
+		return NULL;
+	}
+	switch( Graph_GetBlendKernel() ) {
+#ifdef LCUI_BLEND_SSE2
+	case BLEND_KERNEL_SSE2:
+		return pargb ? GlyphRow_PARGB_SSE2 : GlyphRow_ARGB_SSE2;
+#endif
+#ifdef LCUI_BLEND_AVX2
+	case BLEND_KERNEL_AVX2:
+		return pargb ? GlyphRow_PARGB_AVX2 : GlyphRow_ARGB_AVX2;
+#endif
+#ifdef LCUI_BLEND_NEON
+	case BLEND_KERNEL_NEON:
+		return pargb ? GlyphRow_PARGB_NEON : GlyphRow_ARGB_NEON;
+#endif
+	default: break;
+	}
+	return pargb ? GlyphRow_PARGB : GlyphRow_ARGB;
+}
+
+/** 将字体位图混合到 ARGB 或 PARGB 图像上 */
+static void FontBitmap_MixRows( LCUI_Graph *graph, LCUI_Rect *write_rect,
 				const LCUI_FontBitmap *bmp, LCUI_Color color,
-				LCUI_Rect *read_rect )
+				LCUI_Rect *read_rect, GlyphRowFunc mix )
 {
-	int x, y;
-	LCUI_ARGB *px, *px_row_des;
-	uchar_t *byte_ptr, *byte_row_ptr;
-	double a, out_a, out_r, out_g, out_b, src_a;
-	byte_row_ptr = bmp->buffer + read_rect->y*bmp->width;
+	int y;
+	LCUI_ARGB *px_row_des;
+	const uchar_t *byte_row_ptr;
+
+	color.a = 255;
+	byte_row_ptr = bmp->buffer + read_rect->y*bmp->pitch;
 	byte_row_ptr += read_rect->x;
 	px_row_des = graph->argb + write_rect->y * graph->w;
 	px_row_des += write_rect->x;
 	for( y = 0; y < read_rect->height; ++y ) {
-		px = px_row_des;
-		byte_ptr = byte_row_ptr;
-		for( x = 0; x < read_rect->width; ++x, ++byte_ptr, ++px ) {
-			src_a = *byte_ptr / 255.0;
-			a = (1.0 - src_a) * px->a / 255.0;
-			out_r = px->r * a + color.r * src_a;
-			out_g = px->g * a + color.g * src_a;
-			out_b = px->b * a + color.b * src_a;
-			out_a = src_a + a;
-			if( out_a > 0 ) {
-				out_r /= out_a;
-				out_g /= out_a;
-				out_b /= out_a;
-			}
-			px->r = (uchar_t)(out_r + 0.5);
-			px->g = (uchar_t)(out_g + 0.5);
-			px->b = (uchar_t)(out_b + 0.5);
-			px->a = (uchar_t)(255.0 * out_a + 0.5);
-		}
+		mix( px_row_des, byte_row_ptr, read_rect->width, color );
 		px_row_des += graph->w;
-		byte_row_ptr += bmp->width;
+		byte_row_ptr += bmp->pitch;
 	}
 }
 
@@ -459,7 +1413,7 @@ static void FontBitmap_MixRGB( LCUI_Graph *graph, LCUI_Rect *write_rect,
 {
 	int x, y;
 	uchar_t *byte_src, *byte_row_src, *byte_row_des, *byte_des;
-	byte_row_src = bmp->buffer + read_rect->y*bmp->width + read_rect->x;
+	byte_row_src = bmp->buffer + read_rect->y*bmp->pitch + read_rect->x;
 	byte_row_des = graph->bytes + write_rect->y * graph->bytes_per_row;
 	byte_row_des += write_rect->x*graph->bytes_per_pixel;
 	for( y=0; y<read_rect->height; ++y ) {
@@ -475,7 +1429,7 @@ static void FontBitmap_MixRGB( LCUI_Graph *graph, LCUI_Rect *write_rect,
 			++byte_src;
 		}
 		byte_row_des += graph->bytes_per_row;
-		byte_row_src += bmp->width;
+		byte_row_src += bmp->pitch;
 	}
 }
 
@@ -483,6 +1437,7 @@ static void FontBitmap_MixRGB( LCUI_Graph *graph, LCUI_Rect *write_rect,
 int FontBitmap_Mix( LCUI_Graph *graph, LCUI_Pos pos,
 		    const LCUI_FontBitmap *bmp, LCUI_Color color )
 {
+	GlyphRowFunc mix;
 	LCUI_Graph write_slot;
 	LCUI_Rect r_rect, w_rect;
 	if( pos.x > graph->w || pos.y > graph->h ) {
@@ -503,18 +1458,69 @@ int FontBitmap_Mix( LCUI_Graph *graph, LCUI_Pos pos,
 	Graph_GetValidRect( &write_slot, &w_rect );
 	/* 获取背景图引用的源图形 */
 	graph = Graph_GetQuote( graph );
-	if( graph->color_type == COLOR_TYPE_ARGB ) {
-		FontBitmap_MixARGB( graph, &w_rect, bmp, color, &r_rect );
+	mix = FontBitmap_GetRowFunc( graph->color_type );
+	if( mix ) {
+		FontBitmap_MixRows( graph, &w_rect, bmp, color, &r_rect, mix );
 	} else {
 		FontBitmap_MixRGB( graph, &w_rect, bmp, color, &r_rect );
 	}
 	return 0;
 }
 
+int FontBitmap_MixGlyphs( LCUI_Graph *graph, LCUI_Pos pos,
+			  const LCUI_GlyphRec *glyphs, int n )
+{
+	int i, right, bottom;
+	GlyphRowFunc mix;
+	LCUI_Rect valid, r_rect, w_rect;
+	const LCUI_GlyphRec *glyph = glyphs;
+
+	/* 目标图像的有效区域和混合函数对所有字形都一样，只需获取一次 */
+	Graph_GetValidRect( graph, &valid );
+	if( valid.width <= 0 || valid.height <= 0 ) {
+		return -2;
+	}
+	graph = Graph_GetQuote( graph );
+	mix = FontBitmap_GetRowFunc( graph->color_type );
+	for( i = 0; i < n; ++i, ++glyph ) {
+		w_rect.x = pos.x + glyph->x;
+		w_rect.y = pos.y + glyph->y;
+		right = w_rect.x + glyph->bitmap->width;
+		bottom = w_rect.y + glyph->bitmap->rows;
+		/* 裁剪掉超出目标图像的部分 */
+		if( right > valid.width ) {
+			right = valid.width;
+		}
+		if( bottom > valid.height ) {
+			bottom = valid.height;
+		}
+		r_rect.x = w_rect.x < 0 ? -w_rect.x : 0;
+		r_rect.y = w_rect.y < 0 ? -w_rect.y : 0;
+		r_rect.width = right - w_rect.x - r_rect.x;
+		r_rect.height = bottom - w_rect.y - r_rect.y;
+		if( r_rect.width <= 0 || r_rect.height <= 0 ) {
+			continue;
+		}
+		w_rect.x += r_rect.x + valid.x;
+		w_rect.y += r_rect.y + valid.y;
+		w_rect.width = r_rect.width;
+		w_rect.height = r_rect.height;
+		if( mix ) {
+			FontBitmap_MixRows( graph, &w_rect, glyph->bitmap,
+					    glyph->color, &r_rect, mix );
+		} else {
+			FontBitmap_MixRGB( graph, &w_rect, glyph->bitmap,
+					   glyph->color, &r_rect );
+		}
+	}
+	return 0;
+}
+
 /** 载入字体位图 */
 int FontBitmap_Load( LCUI_FontBitmap *buff, wchar_t ch,
 		     int font_id, int pixel_size )
 {
+	int ret;
 	LCUI_Font *info = fontlib.default_font;
 	while( 1 ) {
 		if( font_id < 0 || !fontlib.engine ) {
@@ -534,7 +1540,10 @@ int FontBitmap_Load( LCUI_FontBitmap *buff, wchar_t ch,
 	if( !info ) {
 		return -1;
 	}
-	return info->engine->render( buff, ch, pixel_size, info );
+	ret = info->engine->render( buff, ch, pixel_size, info );
+	/* 字体引擎输出的位图数据是逐行紧密排列的 */
+	buff->pitch = buff->width;
+	return ret;
 }
 
 /** 初始化字体处理模块 */
@@ -581,11 +1590,10 @@ void LCUI_InitFont( void )
 	fontlib.font_cache_num = 1;
 	fontlib.font_cache = NEW( LCUI_Font**, 1 );
 	fontlib.font_cache[0] = NEW( LCUI_Font*, FONT_CACHE_SIZE );
-	RBTree_Init( &fontlib.bitmap_cache );
+	FontBitmapCache_Init();
 	RBTree_Init( &fontlib.family_tree );
 	RBTree_OnCompare( &fontlib.family_tree, OnCompareFamily );
 	RBTree_OnDestroy( &fontlib.family_tree, DestroyFontFamilyNode );
-	RBTree_OnDestroy( &fontlib.bitmap_cache, DestroyTreeNode );
 	fontlib.is_inited = TRUE;
 
 	/* 先初始化内置的字体引擎 */
@@ -628,7 +1636,7 @@ void LCUI_ExitFont( void )
 		return;
 	}
 	fontlib.is_inited = FALSE;
-	RBTree_Destroy( &fontlib.bitmap_cache );
+	FontBitmapCache_Destroy();
 	while( fontlib.font_cache_num > 0 ) {
 		--fontlib.font_cache_num;
 		for( i=0; i<FONT_CACHE_SIZE; ++i ) {
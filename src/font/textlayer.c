@@ -52,6 +52,10 @@ enum TextAddType {
 #define TextRowList_AddNewRow(ROWLIST) TextRowList_InsertNewRow(ROWLIST, (ROWLIST)->length)
 #define TextLayer_GetRow(layer, n) (n >= layer->rowlist.length) ? NULL:layer->rowlist.rows[n]
 
+/** 获取字形的跨距的右端相对于行左边界的 X 坐标 */
+#define Glyph_GetRight(G) \
+	((G)->x - (G)->bitmap->left + (G)->bitmap->advance.x)
+
 /* 根据对齐方式，计算文本行的起始X轴位置 */
 static int TextLayer_GetRowStartX( LCUI_TextLayer layer, TextRow txtrow )
 {
@@ -97,20 +101,43 @@ int TextLayer_GetRowTextLength( LCUI_TextLayer layer, int row )
 /** 添加 更新文本排版 的任务 */
 void TextLayer_AddUpdateTypeset( LCUI_TextLayer layer, int start_row )
 {
-	if( start_row < layer->task.typeset_start_row ) {
+	if( !layer->task.update_typeset ||
+	    start_row < layer->task.typeset_start_row ) {
 		layer->task.typeset_start_row = start_row;
 	}
 	layer->task.update_typeset = TRUE;
 }
 
+/** 添加 对所有文本行重新排版 的任务，用于会影响所有行的断行位置的设置 */
+static void TextLayer_AddUpdateAllTypeset( LCUI_TextLayer layer )
+{
+	int row;
+	for( row = 0; row < layer->rowlist.length; ++row ) {
+		layer->rowlist.rows[row]->layout_dirty = TRUE;
+	}
+	TextLayer_AddUpdateTypeset( layer, 0 );
+}
+
 static void TextRow_Init( TextRow txtrow )
 {
 	txtrow->width = 0;
+	txtrow->visible_width = 0;
 	txtrow->height = 0;
 	txtrow->length = 0;
 	txtrow->string = NULL;
 	txtrow->eol = EOL_NONE;
 	txtrow->text_height = 0;
+	txtrow->glyphs = NULL;
+	txtrow->glyphs_length = 0;
+	txtrow->glyphs_dirty = TRUE;
+	txtrow->layout_dirty = TRUE;
+}
+
+/** 销毁字符数据，并解除对字体位图的引用 */
+static void TextChar_Destroy( TextChar txtchar )
+{
+	LCUIFont_UnpinBitmap( txtchar->bitmap );
+	free( txtchar );
 }
 
 static void TextRow_Destroy( TextRow txtrow )
@@ -118,10 +145,11 @@ static void TextRow_Destroy( TextRow txtrow )
 	int i;
 	for( i=0; i<txtrow->length; ++i ) {
 		if( txtrow->string[i] ) {
-			free( txtrow->string[i] );
+			TextChar_Destroy( txtrow->string[i] );
 		}
 	}
 	txtrow->width = 0;
+	txtrow->visible_width = 0;
 	txtrow->height = 0;
 	txtrow->length = 0;
 	txtrow->text_height = 0;
@@ -129,6 +157,12 @@ static void TextRow_Destroy( TextRow txtrow )
 		free( txtrow->string );
 	}
 	txtrow->string = NULL;
+	if( txtrow->glyphs ) {
+		free( txtrow->glyphs );
+	}
+	txtrow->glyphs = NULL;
+	txtrow->glyphs_length = 0;
+	txtrow->glyphs_dirty = TRUE;
 }
 
 /** 向文本行列表中插入新的文本行 */
@@ -182,7 +216,10 @@ static void TextLayer_UpdateRowSize( LCUI_TextLayer layer, TextRow txtrow )
 {
 	int i;
 	TextChar txtchar;
+	/* 字形的位置依赖行的尺寸，需要重新生成 */
+	txtrow->glyphs_dirty = TRUE;
 	txtrow->width = 0;
+	txtrow->visible_width = 0;
 	txtrow->text_height = layer->text_style.pixel_size;
 	for( i = 0; i < txtrow->length; ++i ) {
 		txtchar = txtrow->string[i];
@@ -190,6 +227,9 @@ static void TextLayer_UpdateRowSize( LCUI_TextLayer layer, TextRow txtrow )
 			continue;
 		}
 		txtrow->width += txtchar->bitmap->advance.x;
+		if( txtchar->bitmap->buffer ) {
+			txtrow->visible_width += txtchar->bitmap->advance.x;
+		}
 		if( txtrow->text_height < txtchar->bitmap->advance.y ) {
 			txtrow->text_height = txtchar->bitmap->advance.y;
 		}
@@ -224,6 +264,8 @@ static int TextRow_SetLength( TextRow txtrow, int len )
 	txtstr[len] = NULL;
 	txtrow->string = txtstr;
 	txtrow->length = len;
+	txtrow->glyphs_dirty = TRUE;
+	txtrow->layout_dirty = TRUE;
 	return 0;
 }
 
@@ -253,6 +295,8 @@ static int TextRow_InsertCopy( TextRow txtrow, int ins_pos, TextChar txtchar )
 	TextChar txtchar2;
 	txtchar2 = malloc( sizeof(TextCharRec) );
 	*txtchar2 = *txtchar;
+	/* 字符数据会一直使用这个字体位图，所以需要引用它，以免被缓存淘汰 */
+	LCUIFont_PinBitmap( txtchar2->bitmap );
 	return TextRow_Insert( txtrow, ins_pos, txtchar2 );
 }
 
@@ -267,6 +311,8 @@ static void TextRow_LeftMove( TextRow txtrow, int n )
 		n = txtrow->length;
 	}
 	txtrow->length -= n;
+	txtrow->glyphs_dirty = TRUE;
+	txtrow->layout_dirty = TRUE;
 	for( i=0,j=n; i<txtrow->length; ++i,++j ) {
 		txtrow->string[i] = txtrow->string[j];
 	}
@@ -582,6 +628,7 @@ static void TextLayer_BreakTextRow( LCUI_TextLayer layer, int i_row,
 		txtrow->string[n] = NULL;
 	}
 	txtrow->length = col;
+	txtrow->layout_dirty = TRUE;
 	TextLayer_UpdateRowSize( layer, txtrow );
 	TextLayer_UpdateRowSize( layer, next_txtrow );
 }
@@ -677,14 +724,76 @@ static void TextLayer_TextRowTypeset( LCUI_TextLayer layer, int row )
 	}
 }
 
-/** 从指定行开始，对文本进行排版 */
+/**
+ * 生成文本行的字形
+ * 记录各个字体位图相对于行左上角的位置和颜色。字形在排版时生成，绘制时只读
+ * 取它们，因为绘制可能会在多个渲染线程中同时进行
+ */
+static int TextLayer_UpdateRowGlyphs( LCUI_TextLayer layer, TextRow txtrow )
+{
+	int i, x, baseline;
+	TextChar txtchar;
+	LCUI_GlyphRec *glyph, *glyphs;
+
+	if( !txtrow->glyphs_dirty ) {
+		return 0;
+	}
+	glyphs = realloc( txtrow->glyphs,
+			  sizeof( LCUI_GlyphRec ) * (txtrow->length + 1) );
+	if( !glyphs ) {
+		return -1;
+	}
+	baseline = txtrow->text_height * 4 / 5;
+	baseline += (txtrow->height - txtrow->text_height) / 2;
+	for( x = 0, i = 0, glyph = glyphs; i < txtrow->length; ++i ) {
+		txtchar = txtrow->string[i];
+		/* 忽略无字体位图的文字 */
+		if( !txtchar->bitmap ) {
+			continue;
+		}
+		glyph->x = x + txtchar->bitmap->left;
+		glyph->y = baseline - txtchar->bitmap->top;
+		glyph->bitmap = txtchar->bitmap;
+		/* 判断文字使用的前景颜色 */
+		if( txtchar->style && txtchar->style->has_fore_color ) {
+			glyph->color = txtchar->style->fore_color;
+		} else {
+			glyph->color = layer->text_style.fore_color;
+		}
+		x += txtchar->bitmap->advance.x;
+		++glyph;
+	}
+	txtrow->glyphs = glyphs;
+	txtrow->glyphs_length = glyph - glyphs;
+	txtrow->glyphs_dirty = FALSE;
+	return 0;
+}
+
+/**
+ * 从指定行开始，对文本进行排版
+ * 一行的断行位置只取决于它自己的内容和同一段落中下一行开头的文字，如果这两者
+ * 都没有变化，这一行就不需要重新排版。因此编辑文本后只会重新排版被修改的行，
+ * 以及断行位置随之变化的行，不会一直排版到文本末尾。
+ */
 static void TextLayer_TextTypeset( LCUI_TextLayer layer, int start_row )
 {
 	int row;
+	TextRow txtrow, next_txtrow;
+	/* 上一行可能需要转移起始行开头的文字 */
+	if( start_row > 0 ) {
+		--start_row;
+	}
 	/* 记录排版前各个文本行的矩形区域 */
 	TextLayer_InvalidateRowsRect( layer, start_row, -1 );
 	for( row = start_row; row < layer->rowlist.length; ++row ) {
-		TextLayer_TextRowTypeset( layer, row );
+		txtrow = layer->rowlist.rows[row];
+		next_txtrow = TextLayer_GetRow( layer, row + 1 );
+		if( txtrow->layout_dirty || (txtrow->eol == EOL_NONE &&
+		    next_txtrow && next_txtrow->layout_dirty) ) {
+			TextLayer_TextRowTypeset( layer, row );
+			txtrow->layout_dirty = FALSE;
+		}
+		TextLayer_UpdateRowGlyphs( layer, txtrow );
 	}
 	/* 记录排版后各个文本行的矩形区域 */
 	TextLayer_InvalidateRowsRect( layer, start_row, -1 );
@@ -912,20 +1021,14 @@ LCUI_Graph* TextLayer_GetGraphBuffer( LCUI_TextLayer layer )
 
 int TextLayer_GetWidth( LCUI_TextLayer layer )
 {
-	int i, row, w, max_w;
+	int row, max_w;
 	TextRow txtrow;
 
+	/* 各行的宽度在更新行尺寸时已经算好，不需要再遍历每个文字 */
 	for( row = 0, max_w = 0; row < layer->rowlist.length; ++row ) {
 		txtrow = layer->rowlist.rows[row];
-		for( i = 0, w = 0; i < txtrow->length; ++i ) {
-			if( !txtrow->string[i]->bitmap ||
-			    !txtrow->string[i]->bitmap->buffer ) {
-				continue;
-			}
-			w += txtrow->string[i]->bitmap->advance.x;
-		}
-		if( w > max_w ) {
-			max_w = w;
+		if( txtrow->visible_width > max_w ) {
+			max_w = txtrow->visible_width;
 		}
 	}
 	return max_w;
@@ -942,30 +1045,31 @@ int TextLayer_GetHeight( LCUI_TextLayer layer )
 
 int TextLayer_SetFixedSize( LCUI_TextLayer layer, int width, int height )
 {
+	/* 断行位置只与宽度有关，宽度没变的话不需要重新排版 */
+	LCUI_BOOL width_changed = layer->fixed_width != width;
 	layer->fixed_width = width;
 	layer->fixed_height = height;
 	if( layer->is_using_buffer ) {
 		Graph_Create( &layer->graph, width, height );
 	}
 	layer->task.redraw_all = TRUE;
-	if( layer->is_autowrap_mode ) {
-		layer->task.typeset_start_row = 0;
-		layer->task.update_typeset = TRUE;
+	if( layer->is_autowrap_mode && width_changed ) {
+		TextLayer_AddUpdateAllTypeset( layer );
 	}
 	return 0;
 }
 
 int TextLayer_SetMaxSize( LCUI_TextLayer layer, int width, int height )
 {
+	LCUI_BOOL width_changed = layer->max_width != width;
 	layer->max_width = width;
 	layer->max_height = height;
 	if( layer->is_using_buffer ) {
 		Graph_Create( &layer->graph, width, height );
 	}
 	layer->task.redraw_all = TRUE;
-	if( layer->is_autowrap_mode ) {
-		layer->task.typeset_start_row = 0;
-		layer->task.update_typeset = TRUE;
+	if( layer->is_autowrap_mode && width_changed ) {
+		TextLayer_AddUpdateAllTypeset( layer );
 	}
 	return 0;
 }
@@ -976,7 +1080,7 @@ void TextLayer_SetMultiline( LCUI_TextLayer layer, int is_true )
 	if( (layer->is_mulitiline_mode && !is_true)
 	 || (!layer->is_mulitiline_mode && is_true) ) {
 		layer->is_mulitiline_mode = is_true;
-		TextLayer_AddUpdateTypeset( layer, 0 );;
+		TextLayer_AddUpdateAllTypeset( layer );
 	}
 }
 
@@ -1040,8 +1144,10 @@ static int TextLayer_TextDeleteEx( LCUI_TextLayer layer, int char_y,
 	if( end_x == char_x && end_y == char_y ) {
 		return 0;
 	}
+	/* 计算结束点时 txtrow 被用来遍历文本行，这里需要重新获取起始行 */
+	txtrow = layer->rowlist.rows[char_y];
 	/* 获取上一行文本 */
-	prev_txtrow = layer->rowlist.rows[char_y - 1];
+	prev_txtrow = char_y > 0 ? layer->rowlist.rows[char_y - 1] : NULL;
 	// 计算起始行与结束行拼接后的长度
 	// 起始行：0 1 2 3 4 5，起点位置：2
 	// 结束行：0 1 2 3 4 5，终点位置：4
@@ -1057,26 +1163,33 @@ static int TextLayer_TextDeleteEx( LCUI_TextLayer layer, int char_y,
 		}
 		TextLayer_InvalidateRowRect( layer, char_y, char_x, -1 );
 		TextLayer_AddUpdateTypeset( layer, char_y );
+		for( i = char_x; i < end_x; ++i ) {
+			TextChar_Destroy( txtrow->string[i] );
+		}
 		for( i = char_x, j = end_x; j < txtrow->length; ++i, ++j ) {
 			txtrow->string[i] = txtrow->string[j];
 		}
-		/* 如果当前行为空，也不是第一行，并且上一行没有结束符 */
-		if( len <= 0 && end_y > 0 && prev_txtrow->eol != EOL_NONE ) {
-			TextRowList_RemoveRow( &layer->rowlist, end_y );
-		}
 		/* 调整起始行的容量 */
 		TextRow_SetLength( txtrow, len );
 		/* 更新文本行的尺寸 */
 		TextLayer_UpdateRowSize( layer, txtrow );
+		/* 如果当前行为空，也不是第一行，并且上一行没有结束符 */
+		if( len <= 0 && end_y > 0 && prev_txtrow->eol != EOL_NONE ) {
+			TextRowList_RemoveRow( &layer->rowlist, end_y );
+		}
 		return 0;
 	}
 	/* 如果结束点在行尾，并且该行不是最后一行 */
 	if( end_x == end_txtrow->length && end_y < layer->rowlist.length - 1 ) {
 		++end_y;
 		end_txtrow = TextLayer_GetRow( layer, end_y );
-		end_x = -1;
+		end_x = 0;
 		len = char_x + end_txtrow->length;
 	}
+	/* 释放起始行中被删除的字符 */
+	for( i = char_x; i < txtrow->length; ++i ) {
+		TextChar_Destroy( txtrow->string[i] );
+	}
 	TextRow_SetLength( txtrow, len );
 	/* 标记当前行后面的所有行的矩形需区域需要刷新 */
 	TextLayer_InvalidateRowsRect( layer, char_y + 1, -1 );
@@ -1086,12 +1199,14 @@ static int TextLayer_TextDeleteEx( LCUI_TextLayer layer, int char_y,
 		TextRowList_RemoveRow( &layer->rowlist, i );
 	}
 	i = char_x;
-	j = end_x + 1;
+	j = end_x;
 	end_y = char_y + 1;
 	/* 将结束行的内容拼接至起始行 */
 	for( ; i < len && j < end_txtrow->length; ++i, ++j ) {
 		txtrow->string[i] = end_txtrow->string[j];
 	}
+	/* 拼接过去的字符已经归起始行所有，结束行只需释放被删除的字符 */
+	end_txtrow->length = end_x;
 	TextLayer_UpdateRowSize( layer, txtrow );
 	TextLayer_InvalidateRowRect( layer, end_y, 0, -1 );
 	/* 移除结束行 */
@@ -1166,7 +1281,7 @@ void TextLayer_SetAutoWrap( LCUI_TextLayer layer, int is_true )
 	if( (!layer->is_autowrap_mode && is_true)
 	 || (layer->is_autowrap_mode && !is_true) ) {
 		layer->is_autowrap_mode = is_true;
-		TextLayer_AddUpdateTypeset( layer, 0 );
+		TextLayer_AddUpdateAllTypeset( layer );
 	}
 }
 
@@ -1184,10 +1299,15 @@ void TextLayer_ReloadCharBitmap( LCUI_TextLayer layer )
 		TextRow txtrow = layer->rowlist.rows[row];
 		for( col = 0; col < txtrow->length; ++col ) {
 			TextChar txtchar = txtrow->string[col];
+			const LCUI_FontBitmap *bitmap = txtchar->bitmap;
 			TextChar_UpdateBitmap( txtchar, &layer->text_style );
+			LCUIFont_PinBitmap( txtchar->bitmap );
+			LCUIFont_UnpinBitmap( bitmap );
 		}
 		TextLayer_UpdateRowSize( layer, txtrow );
 	}
+	/* 文字的宽度变了，断行位置也需要重新计算 */
+	TextLayer_AddUpdateAllTypeset( layer );
 }
 
 void TextLayer_Update( LCUI_TextLayer layer, LinkedList *rects )
@@ -1223,9 +1343,9 @@ int TextLayer_DrawToGraph( LCUI_TextLayer layer, LCUI_Rect area,
 			   LCUI_Pos layer_pos, LCUI_Graph *graph )
 {
 	TextRow txtrow;
-	TextChar txtchar;
-	LCUI_Pos char_pos;
-	int x, y, row, col, width, height;
+	LCUI_Pos row_pos;
+	LCUI_GlyphRec *glyphs;
+	int x, y, row, start, end, width, height;
 	y = layer->offset_y;
 	if( layer->fixed_width > 0 ) {
 		width = layer->fixed_width;
@@ -1252,53 +1372,35 @@ int TextLayer_DrawToGraph( LCUI_TextLayer layer, LCUI_Rect area,
 	}
 	for( ; row < layer->rowlist.length; ++row ) {
 		txtrow = TextLayer_GetRow( layer, row );
+		/* 排版之后又被修改过的行，字形已失效，等下次更新图层后再绘制 */
+		if( txtrow->glyphs_dirty ) {
+			y += txtrow->height;
+			continue;
+		}
+		glyphs = txtrow->glyphs;
 		x = TextLayer_GetRowStartX( layer, txtrow );
 		x += layer->offset_x;
-		/* 确定从哪个文字开始绘制 */
-		for( col = 0; col < txtrow->length; ++col ) {
-			txtchar = txtrow->string[col];
-			/* 忽略无字体位图的文字 */
-			if( !txtchar->bitmap ) {
-				continue;
-			}
-			x += txtchar->bitmap->advance.x;
-			if( x > area.x ) {
-				x -= txtchar->bitmap->advance.x;
+		/* 确定从哪个字形开始绘制 */
+		for( start = 0; start < txtrow->glyphs_length; ++start ) {
+			if( x + Glyph_GetRight( &glyphs[start] ) > area.x ) {
 				break;
 			}
 		}
-		/* 若一整行的文本都不在可绘制区域内 */
-		if( col >= txtrow->length ) {
-			y += txtrow->height;
-			continue;
-		}
-		/* 遍历该行的文字 */
-		for( ; col < txtrow->length; ++col ) {
-			txtchar = txtrow->string[col];
-			if( !txtchar->bitmap ) {
-				continue;
-			}
-			/* 计算字体位图的绘制坐标 */
-			char_pos.x = layer_pos.x + x;
-			char_pos.y = layer_pos.y + y;
-			char_pos.x += txtchar->bitmap->left;
-			char_pos.y += txtrow->text_height * 4 / 5;
-			char_pos.y += (txtrow->height - txtrow->text_height) / 2;
-			char_pos.y -= txtchar->bitmap->top;
-			x += txtchar->bitmap->advance.x;
-			/* 判断文字使用的前景颜色，再进行绘制 */
-			if( txtchar->style && txtchar->style->has_fore_color ) {
-				FontBitmap_Mix( graph, char_pos, txtchar->bitmap,
-						txtchar->style->fore_color );
-			} else {
-				FontBitmap_Mix( graph, char_pos, txtchar->bitmap,
-						layer->text_style.fore_color );
-			}
-			/* 如果超过绘制区域则不继续绘制该行文本 */
-			if( x > area.x + area.width ) {
+		/* 绘制到第一个超出绘制区域的字形为止 */
+		for( end = start; end < txtrow->glyphs_length; ++end ) {
+			if( x + Glyph_GetRight( &glyphs[end] ) >
+			    area.x + area.width ) {
+				++end;
 				break;
 			}
 		}
+		/* 一整行的字形只需要计算一次裁剪区域 */
+		if( start < end ) {
+			row_pos.x = layer_pos.x + x;
+			row_pos.y = layer_pos.y + y;
+			FontBitmap_MixGlyphs( graph, row_pos, glyphs + start,
+					      end - start );
+		}
 		y += txtrow->height;
 		/* 超出绘制区域范围就不绘制了 */
 		if( y > area.y + area.height ) {
@@ -1342,12 +1444,46 @@ void TextLayer_ClearInvalidRect( LCUI_TextLayer layer )
 	RectList_Clear( &layer->dirty_rect );
 }
 
+/** 判断两个文本样式使用的字体和字号是否相同 */
+static LCUI_BOOL TextStyle_IsSameFont( const LCUI_TextStyle *a,
+				       const LCUI_TextStyle *b )
+{
+	int i;
+	if( a->pixel_size != b->pixel_size ) {
+		return FALSE;
+	}
+	if( !a->font_ids || !b->font_ids ) {
+		return a->font_ids == b->font_ids;
+	}
+	for( i = 0; a->font_ids[i] == b->font_ids[i]; ++i ) {
+		if( a->font_ids[i] == -1 ) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 /** 设置全局文本样式 */
 void TextLayer_SetTextStyle( LCUI_TextLayer layer, LCUI_TextStyle *style )
 {
+	int row;
+	LCUI_BOOL color_changed;
+	/* 字体和字号没变的话，不需要重新载入字体位图和排版 */
+	if( !TextStyle_IsSameFont( &layer->text_style, style ) ) {
+		layer->task.update_bitmap = TRUE;
+	}
+	color_changed = layer->text_style.fore_color.value !=
+			style->fore_color.value;
 	TextStyle_Destroy( &layer->text_style );
 	TextStyle_Copy( &layer->text_style, style );
-	layer->task.update_bitmap = TRUE;
+	if( !color_changed || layer->task.update_bitmap ) {
+		return;
+	}
+	/* 只有颜色变了，不需要重新断行，排版时更新字形的颜色就行 */
+	for( row = 0; row < layer->rowlist.length; ++row ) {
+		layer->rowlist.rows[row]->glyphs_dirty = TRUE;
+	}
+	TextLayer_AddUpdateTypeset( layer, 0 );
 }
 
 /** 设置文本对齐方式 */
@@ -1362,8 +1498,8 @@ void TextLayer_SetTextAlign( LCUI_TextLayer layer, int align )
 void TextLayer_SetLineHeight( LCUI_TextLayer layer, LCUI_Style val )
 {
 	layer->line_height = *val;
-	layer->task.update_typeset = TRUE;
-	layer->task.typeset_start_row = 0;
+	/* 行高变化后需要重新计算每一行的尺寸 */
+	TextLayer_AddUpdateAllTypeset( layer );
 }
 
 void TextLayer_SetOffset( LCUI_TextLayer layer, int offset_x, int offset_y )
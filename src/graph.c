@@ -44,6 +44,52 @@
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/graph.h>
+#include <LCUI/thread.h>
+
+#include "blend_simd.h"
+
+/** 帧内存池中的内存块的最小容量 */
+#define FRAME_ARENA_BLOCK_SIZE	(1024 * 1024)
+/** 连续多少帧只用到不到一半的容量时，收缩帧内存池 */
+#define FRAME_ARENA_TRIM_FRAMES	30
+/** 帧内存池中的像素数据按 32 字节对齐，方便 SIMD 内核访问 */
+#define FRAME_ARENA_ALIGN(N)	(((N) + 31) & ~(size_t)31)
+
+typedef struct FrameArenaBlockRec_ *FrameArenaBlock;
+typedef struct FrameArenaBlockRec_ {
+	FrameArenaBlock next;
+	size_t size;		/**< 数据区的大小 */
+	size_t used;		/**< 数据区已使用的大小 */
+	uchar_t *data;		/**< 数据区，位于内存块头部之后 */
+} FrameArenaBlockRec;
+
+/**
+ * 帧内存栈
+ * 每个渲染线程各有一个，只由所属的线程分配和回收，所以不需要加锁。渲染时
+ * 各级部件的临时图像是按后进先出的顺序使用的，可以在一级部件渲染完后回收它
+ * 用过的内存，让下一个部件接着使用。
+ */
+typedef struct FrameArenaStackRec_ {
+	LCUI_Thread tid;		/**< 所属线程 */
+	FrameArenaBlock blocks;		/**< 正在使用的内存块，第一块是当前使用的 */
+	FrameArenaBlock spare;		/**< 被回收的内存块，供之后的分配使用 */
+	size_t used;			/**< 已使用的字节数 */
+	size_t peak;			/**< 本帧已使用的字节数的峰值 */
+	size_t capacity;		/**< 所有内存块的总容量 */
+	size_t allocs;			/**< 本帧分配像素数据的次数 */
+	size_t heap_allocs;		/**< 本帧向系统申请内存的次数 */
+	size_t trim_size;		/**< 最近几帧中的峰值，用于收缩内存 */
+	int trim_frames;		/**< 连续有多少帧用到的不到总容量的一半 */
+} FrameArenaStackRec, *FrameArenaStack;
+
+/** 帧内存池，渲染可能在多个线程中进行，访问内存栈列表时需要加锁 */
+static struct FrameArena {
+	LCUI_BOOL is_inited;
+	LCUI_Mutex mutex;
+	FrameArenaStack *stacks;	/**< 各个线程的内存栈 */
+	int n_stacks;			/**< 内存栈的数量 */
+	LCUI_FrameArenaStatsRec last;	/**< 上一帧的统计数据 */
+} frame_arena;
 
 void Graph_PrintInfo( LCUI_Graph *graph )
 {
@@ -77,6 +123,7 @@ void Graph_Init( LCUI_Graph *graph )
 	graph->height = 0;
 	graph->bytes_per_pixel = 3;
 	graph->bytes_per_row = 0;
+	graph->in_arena = FALSE;
 }
 
 LCUI_Graph *Graph_New( void )
@@ -120,11 +167,1043 @@ static size_t get_pixel_size( int color_type )
 	case COLOR_TYPE_RGB888:
 		return 3;
 	case COLOR_TYPE_ARGB8888:
+	case COLOR_TYPE_PARGB8888:
 	default:break;
 	}
 	return 4;
 }
 
+/*------------------------------ Blend Kernels -----------------------------*/
+
+/*
+ * 像素混合内核
+ * 所有内核都以定点数方式进行计算，标量版本是参考实现，SIMD 版本的计算结果必须
+ * 与其逐位相同。opacity 参数为 0~255 的全局不透明度，255 表示不透明。
+ * 预乘 alpha 的像素（PARGB）的颜色分量不能大于其 alpha 值，混合到 PARGB 的
+ * 内核只有乘加运算，out = DIV255(s * ws + d * (255 - sa))。
+ */
+
+/** 单行像素的混合函数，ARGB 混合到 ARGB */
+typedef void( *BlendRowFunc )(LCUI_ARGB*, const LCUI_ARGB*, int, int);
+
+/** 单行像素的混合函数，ARGB 混合到 RGB888 */
+typedef void( *BlendRGBRowFunc )(uchar_t*, const LCUI_ARGB*, int, int);
+
+static struct BlendKernelRec_ {
+	int id;				/**< 当前内核的标识 */
+	LCUI_BOOL ready;		/**< 是否已经初始化 */
+	BlendRowFunc mix_argb;		/**< 混合 ARGB，并计算 alpha 通道 */
+	BlendRowFunc mix_color;		/**< 混合 ARGB，保留背景的 alpha 通道 */
+	BlendRGBRowFunc mix_rgb;	/**< 混合至 RGB888 */
+	BlendRowFunc mix_pargb;		/**< PARGB 混合到 PARGB */
+	BlendRowFunc mix_argb_pargb;	/**< ARGB 混合到 PARGB */
+	BlendRGBRowFunc mix_pargb_rgb;	/**< PARGB 混合到 RGB888 */
+} blend_kernel;
+
+static void BlendRow_ARGB( LCUI_ARGB *dst, const LCUI_ARGB *src,
+			   int n, int opacity )
+{
+	uint_t ws, wd, out_a;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, ++dst ) {
+		/* 权重以 1/65025 为单位，避免在 alpha 值较小时损失精度 */
+		ws = src->a * opacity;
+		if( ws == 65025 ) {
+			*dst = *src;
+			continue;
+		}
+		if( ws == 0 && dst->a > 0 ) {
+			continue;
+		}
+		wd = (dst->a * (65025 - ws) + 127) / 255;
+		out_a = ws + wd;
+		if( out_a == 0 ) {
+			dst->value = 0;
+			continue;
+		}
+		dst->r = (src->r * ws + dst->r * wd + (out_a >> 1)) / out_a;
+		dst->g = (src->g * ws + dst->g * wd + (out_a >> 1)) / out_a;
+		dst->b = (src->b * ws + dst->b * wd + (out_a >> 1)) / out_a;
+		dst->a = DIV255( out_a );
+	}
+}
+
+static void BlendRow_Color( LCUI_ARGB *dst, const LCUI_ARGB *src,
+			    int n, int opacity )
+{
+	uint_t sa, inv;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, ++dst ) {
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		}
+		if( sa == 0 ) {
+			continue;
+		}
+		inv = 255 - sa;
+		dst->r = DIV255( src->r * sa + dst->r * inv );
+		dst->g = DIV255( src->g * sa + dst->g * inv );
+		dst->b = DIV255( src->b * sa + dst->b * inv );
+	}
+}
+
+static void BlendRow_RGB( uchar_t *dst, const LCUI_ARGB *src,
+			  int n, int opacity )
+{
+	uint_t sa, inv;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, dst += 3 ) {
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		}
+		if( sa == 0 ) {
+			continue;
+		}
+		inv = 255 - sa;
+		dst[0] = DIV255( src->b * sa + dst[0] * inv );
+		dst[1] = DIV255( src->g * sa + dst[1] * inv );
+		dst[2] = DIV255( src->r * sa + dst[2] * inv );
+	}
+}
+
+static void BlendRow_PARGB( LCUI_ARGB *dst, const LCUI_ARGB *src,
+			    int n, int opacity )
+{
+	uint_t sa, inv;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, ++dst ) {
+		if( src->value == 0 ) {
+			continue;
+		}
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		} else if( sa == 255 ) {
+			*dst = *src;
+			continue;
+		}
+		inv = 255 - sa;
+		dst->r = DIV255( src->r * opacity + dst->r * inv );
+		dst->g = DIV255( src->g * opacity + dst->g * inv );
+		dst->b = DIV255( src->b * opacity + dst->b * inv );
+		dst->a = DIV255( src->a * opacity + dst->a * inv );
+	}
+}
+
+/** 将 ARGB 混合到 PARGB，源像素在混合时预乘 alpha */
+static void BlendRow_ARGBToPARGB( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				  int n, int opacity )
+{
+	uint_t sa, inv;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, ++dst ) {
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		}
+		if( sa == 0 ) {
+			continue;
+		}
+		if( sa == 255 ) {
+			*dst = *src;
+			continue;
+		}
+		inv = 255 - sa;
+		dst->r = DIV255( src->r * sa + dst->r * inv );
+		dst->g = DIV255( src->g * sa + dst->g * inv );
+		dst->b = DIV255( src->b * sa + dst->b * inv );
+		dst->a = DIV255( 255 * sa + dst->a * inv );
+	}
+}
+
+static void BlendRow_PARGBToRGB( uchar_t *dst, const LCUI_ARGB *src,
+				 int n, int opacity )
+{
+	uint_t sa, inv;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, dst += 3 ) {
+		if( src->value == 0 ) {
+			continue;
+		}
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		}
+		inv = 255 - sa;
+		dst[0] = DIV255( src->b * opacity + dst[0] * inv );
+		dst[1] = DIV255( src->g * opacity + dst[1] * inv );
+		dst[2] = DIV255( src->r * opacity + dst[2] * inv );
+	}
+}
+
+/**
+ * 将 PARGB 混合到 ARGB
+ * 结果需要还原成非预乘 alpha 的颜色，只有标量版本，中间图层不应使用这种组合
+ */
+static void BlendRow_PARGBToARGB( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				  int n, int opacity )
+{
+	uint_t sa, inv, wd, out_a;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, ++dst ) {
+		if( src->value == 0 && dst->a > 0 ) {
+			continue;
+		}
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		}
+		inv = 255 - sa;
+		/* 以 1/65025 为单位计算 alpha 值 */
+		wd = dst->a * inv;
+		out_a = src->a * opacity + wd;
+		if( out_a == 0 ) {
+			dst->value = 0;
+			continue;
+		}
+		dst->r = (src->r * opacity * 255 + dst->r * wd +
+			  (out_a >> 1)) / out_a;
+		dst->g = (src->g * opacity * 255 + dst->g * wd +
+			  (out_a >> 1)) / out_a;
+		dst->b = (src->b * opacity * 255 + dst->b * wd +
+			  (out_a >> 1)) / out_a;
+		dst->a = DIV255( out_a );
+	}
+}
+
+/** 将 PARGB 混合到 ARGB，保留背景的 alpha 通道 */
+static void BlendRow_PARGBColor( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				 int n, int opacity )
+{
+	uint_t sa, inv;
+	const LCUI_ARGB *end = src + n;
+
+	for( ; src < end; ++src, ++dst ) {
+		if( src->value == 0 ) {
+			continue;
+		}
+		sa = src->a;
+		if( opacity < 255 ) {
+			sa = DIV255( sa * opacity );
+		}
+		inv = 255 - sa;
+		dst->r = DIV255( src->r * opacity + dst->r * inv );
+		dst->g = DIV255( src->g * opacity + dst->g * inv );
+		dst->b = DIV255( src->b * opacity + dst->b * inv );
+	}
+}
+
+#if defined(LCUI_BLEND_SSE2) || defined(LCUI_BLEND_AVX2) || \
+    defined(LCUI_BLEND_NEON)
+
+/** 缓存区能容纳的像素数量，用于将 RGB888 转换为 ARGB 后再用 SIMD 内核处理 */
+#define BLEND_CHUNK_SIZE 256
+
+/** 将 RGB888 转换为不透明的 ARGB 后，借助 SIMD 内核进行混合 */
+static void BlendRow_RGBChunks( uchar_t *dst, const LCUI_ARGB *src,
+				int n, int opacity, BlendRowFunc mix )
+{
+	int i, count;
+	uchar_t *p;
+	LCUI_ARGB buffer[BLEND_CHUNK_SIZE];
+
+	while( n > 0 ) {
+		count = n < BLEND_CHUNK_SIZE ? n : BLEND_CHUNK_SIZE;
+		for( i = 0, p = dst; i < count; ++i, p += 3 ) {
+			buffer[i].b = p[0];
+			buffer[i].g = p[1];
+			buffer[i].r = p[2];
+			buffer[i].a = 255;
+		}
+		mix( buffer, src, count, opacity );
+		for( i = 0, p = dst; i < count; ++i, p += 3 ) {
+			p[0] = buffer[i].b;
+			p[1] = buffer[i].g;
+			p[2] = buffer[i].r;
+		}
+		dst += count * 3;
+		src += count;
+		n -= count;
+	}
+}
+
+static void BlendRow_RGBWithKernel( uchar_t *dst, const LCUI_ARGB *src,
+				    int n, int opacity )
+{
+	BlendRow_RGBChunks( dst, src, n, opacity, blend_kernel.mix_color );
+}
+
+static void BlendRow_PARGBToRGBWithKernel( uchar_t *dst, const LCUI_ARGB *src,
+					   int n, int opacity )
+{
+	BlendRow_RGBChunks( dst, src, n, opacity, blend_kernel.mix_pargb );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_SSE2
+
+/** 将 0~65535 范围内的 32 位整数打包为 16 位无符号整数 */
+static __m128i SSE2_PackU32( __m128i lo, __m128i hi )
+{
+	const __m128i bias = _mm_set1_epi32( 32768 );
+	lo = _mm_packs_epi32( _mm_sub_epi32( lo, bias ),
+			      _mm_sub_epi32( hi, bias ) );
+	return _mm_add_epi16( lo, _mm_set1_epi16( -32768 ) );
+}
+
+/** 混合两个像素，参数中的每个通道都是 16 位整数 */
+static __m128i SSE2_BlendARGB( __m128i s, __m128i d, __m128i opacity )
+{
+	__m128i ws, wd, out_a, mask, lo, hi, lo2, hi2, den_lo, den_hi;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i k127 = _mm_set1_epi32( 127 );
+	const __m128i k255 = _mm_set1_epi32( 255 );
+
+	ws = _mm_mullo_epi16( SSE2_ExpandAlpha( s ), opacity );
+	wd = _mm_sub_epi16( _mm_set1_epi16( (short)65025 ), ws );
+	SSE2_Multiply( SSE2_ExpandAlpha( d ), wd, &lo, &hi );
+	lo = SSE2_Divide( _mm_add_epi32( lo, k127 ), k255 );
+	hi = SSE2_Divide( _mm_add_epi32( hi, k127 ), k255 );
+	wd = SSE2_PackU32( lo, hi );
+	out_a = _mm_add_epi16( ws, wd );
+	SSE2_Multiply( s, ws, &lo, &hi );
+	SSE2_Multiply( d, wd, &lo2, &hi2 );
+	den_lo = _mm_unpacklo_epi16( out_a, zero );
+	den_hi = _mm_unpackhi_epi16( out_a, zero );
+	lo = _mm_add_epi32( _mm_add_epi32( lo, lo2 ),
+			    _mm_srli_epi32( den_lo, 1 ) );
+	hi = _mm_add_epi32( _mm_add_epi32( hi, hi2 ),
+			    _mm_srli_epi32( den_hi, 1 ) );
+	/* den 为 0 时 num 也为 0，将 den 改为 1 即可得到 0 */
+	den_lo = _mm_sub_epi32( den_lo, _mm_cmpeq_epi32( den_lo, zero ) );
+	den_hi = _mm_sub_epi32( den_hi, _mm_cmpeq_epi32( den_hi, zero ) );
+	lo = _mm_packs_epi32( SSE2_Divide( lo, den_lo ),
+			      SSE2_Divide( hi, den_hi ) );
+	mask = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+	return _mm_or_si128( _mm_and_si128( mask, SSE2_Div255( out_a ) ),
+			     _mm_andnot_si128( mask, lo ) );
+}
+
+/** 混合两个像素的颜色，保留背景像素的 alpha 通道 */
+static __m128i SSE2_BlendColor( __m128i s, __m128i d, __m128i opacity )
+{
+	__m128i sa, inv, out, mask;
+
+	sa = SSE2_Div255( _mm_mullo_epi16( SSE2_ExpandAlpha( s ), opacity ) );
+	inv = _mm_sub_epi16( _mm_set1_epi16( 255 ), sa );
+	out = _mm_add_epi16( _mm_mullo_epi16( s, sa ),
+			     _mm_mullo_epi16( d, inv ) );
+	out = SSE2_Div255( out );
+	mask = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+	return _mm_or_si128( _mm_and_si128( mask, d ),
+			     _mm_andnot_si128( mask, out ) );
+}
+
+static void BlendRow_ARGB_SSE2( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				int n, int opacity )
+{
+	int i;
+	__m128i s, d, lo, hi, sa, da, op;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32( (int)0xff000000 );
+
+	op = _mm_set1_epi16( (short)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		s = _mm_loadu_si128( (const __m128i*)(src + i) );
+		d = _mm_loadu_si128( (const __m128i*)(dst + i) );
+		sa = _mm_and_si128( s, amask );
+		da = _mm_and_si128( d, amask );
+		/* 源像素都是不透明的，直接覆盖 */
+		if( opacity == 255 && _mm_movemask_epi8(
+			_mm_cmpeq_epi32( sa, amask ) ) == 0xffff ) {
+			_mm_storeu_si128( (__m128i*)(dst + i), s );
+			continue;
+		}
+		/* 源像素都是透明的，且背景像素都有颜色，则无需混合 */
+		if( _mm_movemask_epi8( _mm_cmpeq_epi32( sa, zero ) ) == 0xffff
+		    && _mm_movemask_epi8( _mm_cmpeq_epi32( da, zero ) ) == 0 ) {
+			continue;
+		}
+		lo = SSE2_BlendARGB( _mm_unpacklo_epi8( s, zero ),
+				     _mm_unpacklo_epi8( d, zero ), op );
+		hi = SSE2_BlendARGB( _mm_unpackhi_epi8( s, zero ),
+				     _mm_unpackhi_epi8( d, zero ), op );
+		_mm_storeu_si128( (__m128i*)(dst + i),
+				  _mm_packus_epi16( lo, hi ) );
+	}
+	BlendRow_ARGB( dst + i, src + i, n - i, opacity );
+}
+
+static void BlendRow_Color_SSE2( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				 int n, int opacity )
+{
+	int i;
+	__m128i s, d, lo, hi, op;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32( (int)0xff000000 );
+
+	op = _mm_set1_epi16( (short)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		s = _mm_loadu_si128( (const __m128i*)(src + i) );
+		if( _mm_movemask_epi8( _mm_cmpeq_epi32(
+			_mm_and_si128( s, amask ), zero ) ) == 0xffff ) {
+			continue;
+		}
+		d = _mm_loadu_si128( (const __m128i*)(dst + i) );
+		lo = SSE2_BlendColor( _mm_unpacklo_epi8( s, zero ),
+				      _mm_unpacklo_epi8( d, zero ), op );
+		hi = SSE2_BlendColor( _mm_unpackhi_epi8( s, zero ),
+				      _mm_unpackhi_epi8( d, zero ), op );
+		_mm_storeu_si128( (__m128i*)(dst + i),
+				  _mm_packus_epi16( lo, hi ) );
+	}
+	BlendRow_Color( dst + i, src + i, n - i, opacity );
+}
+
+/** 混合两个 PARGB 像素，out = DIV255(s * opacity + d * (255 - sa)) */
+static __m128i SSE2_BlendPARGB( __m128i s, __m128i d, __m128i opacity )
+{
+	__m128i inv;
+
+	inv = SSE2_Div255( _mm_mullo_epi16( SSE2_ExpandAlpha( s ), opacity ) );
+	inv = _mm_sub_epi16( _mm_set1_epi16( 255 ), inv );
+	return SSE2_Div255( _mm_add_epi16( _mm_mullo_epi16( s, opacity ),
+					   _mm_mullo_epi16( d, inv ) ) );
+}
+
+/** 将 ARGB 像素混合到 PARGB 像素上，源像素的 alpha 通道按 255 参与乘法 */
+static __m128i SSE2_BlendARGBToPARGB( __m128i s, __m128i d, __m128i opacity )
+{
+	__m128i sa, inv;
+
+	sa = SSE2_Div255( _mm_mullo_epi16( SSE2_ExpandAlpha( s ), opacity ) );
+	inv = _mm_sub_epi16( _mm_set1_epi16( 255 ), sa );
+	s = _mm_or_si128( s, _mm_set_epi16( 255, 0, 0, 0, 255, 0, 0, 0 ) );
+	return SSE2_Div255( _mm_add_epi16( _mm_mullo_epi16( s, sa ),
+					   _mm_mullo_epi16( d, inv ) ) );
+}
+
+static void BlendRow_PARGB_SSE2( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				 int n, int opacity )
+{
+	int i;
+	__m128i s, d, lo, hi, op;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32( (int)0xff000000 );
+
+	op = _mm_set1_epi16( (short)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		s = _mm_loadu_si128( (const __m128i*)(src + i) );
+		if( _mm_movemask_epi8( _mm_cmpeq_epi32( s, zero ) ) == 0xffff ) {
+			continue;
+		}
+		if( opacity == 255 && _mm_movemask_epi8( _mm_cmpeq_epi32(
+			_mm_and_si128( s, amask ), amask ) ) == 0xffff ) {
+			_mm_storeu_si128( (__m128i*)(dst + i), s );
+			continue;
+		}
+		d = _mm_loadu_si128( (const __m128i*)(dst + i) );
+		lo = SSE2_BlendPARGB( _mm_unpacklo_epi8( s, zero ),
+				      _mm_unpacklo_epi8( d, zero ), op );
+		hi = SSE2_BlendPARGB( _mm_unpackhi_epi8( s, zero ),
+				      _mm_unpackhi_epi8( d, zero ), op );
+		_mm_storeu_si128( (__m128i*)(dst + i),
+				  _mm_packus_epi16( lo, hi ) );
+	}
+	BlendRow_PARGB( dst + i, src + i, n - i, opacity );
+}
+
+static void BlendRow_ARGBToPARGB_SSE2( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				       int n, int opacity )
+{
+	int i;
+	__m128i s, d, sa, lo, hi, op;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i amask = _mm_set1_epi32( (int)0xff000000 );
+
+	op = _mm_set1_epi16( (short)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		s = _mm_loadu_si128( (const __m128i*)(src + i) );
+		sa = _mm_and_si128( s, amask );
+		if( _mm_movemask_epi8( _mm_cmpeq_epi32( sa, zero ) ) == 0xffff ) {
+			continue;
+		}
+		if( opacity == 255 && _mm_movemask_epi8(
+			_mm_cmpeq_epi32( sa, amask ) ) == 0xffff ) {
+			_mm_storeu_si128( (__m128i*)(dst + i), s );
+			continue;
+		}
+		d = _mm_loadu_si128( (const __m128i*)(dst + i) );
+		lo = SSE2_BlendARGBToPARGB( _mm_unpacklo_epi8( s, zero ),
+					    _mm_unpacklo_epi8( d, zero ), op );
+		hi = SSE2_BlendARGBToPARGB( _mm_unpackhi_epi8( s, zero ),
+					    _mm_unpackhi_epi8( d, zero ), op );
+		_mm_storeu_si128( (__m128i*)(dst + i),
+				  _mm_packus_epi16( lo, hi ) );
+	}
+	BlendRow_ARGBToPARGB( dst + i, src + i, n - i, opacity );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_AVX2
+
+LCUI_TARGET_AVX2 static __m256i AVX2_BlendARGB( __m256i s, __m256i d,
+						__m256i opacity )
+{
+	__m256i ws, wd, out_a, mask, lo, hi, lo2, hi2, den_lo, den_hi;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i k127 = _mm256_set1_epi32( 127 );
+	const __m256i k255 = _mm256_set1_epi32( 255 );
+
+	ws = _mm256_mullo_epi16( AVX2_ExpandAlpha( s ), opacity );
+	wd = _mm256_sub_epi16( _mm256_set1_epi16( (short)65025 ), ws );
+	AVX2_Multiply( AVX2_ExpandAlpha( d ), wd, &lo, &hi );
+	lo = AVX2_Divide( _mm256_add_epi32( lo, k127 ), k255 );
+	hi = AVX2_Divide( _mm256_add_epi32( hi, k127 ), k255 );
+	wd = _mm256_packus_epi32( lo, hi );
+	out_a = _mm256_add_epi16( ws, wd );
+	AVX2_Multiply( s, ws, &lo, &hi );
+	AVX2_Multiply( d, wd, &lo2, &hi2 );
+	den_lo = _mm256_unpacklo_epi16( out_a, zero );
+	den_hi = _mm256_unpackhi_epi16( out_a, zero );
+	lo = _mm256_add_epi32( _mm256_add_epi32( lo, lo2 ),
+			       _mm256_srli_epi32( den_lo, 1 ) );
+	hi = _mm256_add_epi32( _mm256_add_epi32( hi, hi2 ),
+			       _mm256_srli_epi32( den_hi, 1 ) );
+	den_lo = _mm256_max_epi32( den_lo, _mm256_set1_epi32( 1 ) );
+	den_hi = _mm256_max_epi32( den_hi, _mm256_set1_epi32( 1 ) );
+	lo = _mm256_packs_epi32( AVX2_Divide( lo, den_lo ),
+				 AVX2_Divide( hi, den_hi ) );
+	mask = _mm256_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0,
+				 -1, 0, 0, 0, -1, 0, 0, 0 );
+	return _mm256_blendv_epi8( lo, AVX2_Div255( out_a ), mask );
+}
+
+LCUI_TARGET_AVX2 static __m256i AVX2_BlendColor( __m256i s, __m256i d,
+						 __m256i opacity )
+{
+	__m256i sa, inv, out, mask;
+
+	sa = AVX2_Div255( _mm256_mullo_epi16( AVX2_ExpandAlpha( s ),
+					      opacity ) );
+	inv = _mm256_sub_epi16( _mm256_set1_epi16( 255 ), sa );
+	out = _mm256_add_epi16( _mm256_mullo_epi16( s, sa ),
+				_mm256_mullo_epi16( d, inv ) );
+	out = AVX2_Div255( out );
+	mask = _mm256_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0,
+				 -1, 0, 0, 0, -1, 0, 0, 0 );
+	return _mm256_blendv_epi8( out, d, mask );
+}
+
+LCUI_TARGET_AVX2 static void BlendRow_ARGB_AVX2( LCUI_ARGB *dst,
+						 const LCUI_ARGB *src,
+						 int n, int opacity )
+{
+	int i;
+	__m256i s, d, lo, hi, sa, da, op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32( (int)0xff000000 );
+
+	op = _mm256_set1_epi16( (short)opacity );
+	for( i = 0; i + 8 <= n; i += 8 ) {
+		s = _mm256_loadu_si256( (const __m256i*)(src + i) );
+		d = _mm256_loadu_si256( (const __m256i*)(dst + i) );
+		sa = _mm256_and_si256( s, amask );
+		da = _mm256_and_si256( d, amask );
+		if( opacity == 255 && _mm256_movemask_epi8(
+			_mm256_cmpeq_epi32( sa, amask ) ) == -1 ) {
+			_mm256_storeu_si256( (__m256i*)(dst + i), s );
+			continue;
+		}
+		if( _mm256_movemask_epi8( _mm256_cmpeq_epi32( sa, zero ) ) == -1
+		    && _mm256_movemask_epi8(
+			    _mm256_cmpeq_epi32( da, zero ) ) == 0 ) {
+			continue;
+		}
+		lo = AVX2_BlendARGB( _mm256_unpacklo_epi8( s, zero ),
+				     _mm256_unpacklo_epi8( d, zero ), op );
+		hi = AVX2_BlendARGB( _mm256_unpackhi_epi8( s, zero ),
+				     _mm256_unpackhi_epi8( d, zero ), op );
+		_mm256_storeu_si256( (__m256i*)(dst + i),
+				     _mm256_packus_epi16( lo, hi ) );
+	}
+	BlendRow_ARGB( dst + i, src + i, n - i, opacity );
+}
+
+LCUI_TARGET_AVX2 static void BlendRow_Color_AVX2( LCUI_ARGB *dst,
+						  const LCUI_ARGB *src,
+						  int n, int opacity )
+{
+	int i;
+	__m256i s, d, lo, hi, op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32( (int)0xff000000 );
+
+	op = _mm256_set1_epi16( (short)opacity );
+	for( i = 0; i + 8 <= n; i += 8 ) {
+		s = _mm256_loadu_si256( (const __m256i*)(src + i) );
+		if( _mm256_movemask_epi8( _mm256_cmpeq_epi32(
+			_mm256_and_si256( s, amask ), zero ) ) == -1 ) {
+			continue;
+		}
+		d = _mm256_loadu_si256( (const __m256i*)(dst + i) );
+		lo = AVX2_BlendColor( _mm256_unpacklo_epi8( s, zero ),
+				      _mm256_unpacklo_epi8( d, zero ), op );
+		hi = AVX2_BlendColor( _mm256_unpackhi_epi8( s, zero ),
+				      _mm256_unpackhi_epi8( d, zero ), op );
+		_mm256_storeu_si256( (__m256i*)(dst + i),
+				     _mm256_packus_epi16( lo, hi ) );
+	}
+	BlendRow_Color( dst + i, src + i, n - i, opacity );
+}
+
+LCUI_TARGET_AVX2 static __m256i AVX2_BlendPARGB( __m256i s, __m256i d,
+						 __m256i opacity )
+{
+	__m256i inv;
+
+	inv = AVX2_Div255( _mm256_mullo_epi16( AVX2_ExpandAlpha( s ),
+					       opacity ) );
+	inv = _mm256_sub_epi16( _mm256_set1_epi16( 255 ), inv );
+	return AVX2_Div255( _mm256_add_epi16( _mm256_mullo_epi16( s, opacity ),
+					      _mm256_mullo_epi16( d, inv ) ) );
+}
+
+LCUI_TARGET_AVX2 static __m256i AVX2_BlendARGBToPARGB( __m256i s, __m256i d,
+						       __m256i opacity )
+{
+	__m256i sa, inv;
+
+	sa = AVX2_Div255( _mm256_mullo_epi16( AVX2_ExpandAlpha( s ),
+					      opacity ) );
+	inv = _mm256_sub_epi16( _mm256_set1_epi16( 255 ), sa );
+	s = _mm256_or_si256( s, _mm256_set_epi16( 255, 0, 0, 0, 255, 0, 0, 0,
+						  255, 0, 0, 0, 255, 0, 0, 0 ) );
+	return AVX2_Div255( _mm256_add_epi16( _mm256_mullo_epi16( s, sa ),
+					      _mm256_mullo_epi16( d, inv ) ) );
+}
+
+LCUI_TARGET_AVX2 static void BlendRow_PARGB_AVX2( LCUI_ARGB *dst,
+						  const LCUI_ARGB *src,
+						  int n, int opacity )
+{
+	int i;
+	__m256i s, d, lo, hi, op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32( (int)0xff000000 );
+
+	op = _mm256_set1_epi16( (short)opacity );
+	for( i = 0; i + 8 <= n; i += 8 ) {
+		s = _mm256_loadu_si256( (const __m256i*)(src + i) );
+		if( _mm256_testz_si256( s, s ) ) {
+			continue;
+		}
+		if( opacity == 255 && _mm256_movemask_epi8( _mm256_cmpeq_epi32(
+			_mm256_and_si256( s, amask ), amask ) ) == -1 ) {
+			_mm256_storeu_si256( (__m256i*)(dst + i), s );
+			continue;
+		}
+		d = _mm256_loadu_si256( (const __m256i*)(dst + i) );
+		lo = AVX2_BlendPARGB( _mm256_unpacklo_epi8( s, zero ),
+				      _mm256_unpacklo_epi8( d, zero ), op );
+		hi = AVX2_BlendPARGB( _mm256_unpackhi_epi8( s, zero ),
+				      _mm256_unpackhi_epi8( d, zero ), op );
+		_mm256_storeu_si256( (__m256i*)(dst + i),
+				     _mm256_packus_epi16( lo, hi ) );
+	}
+	BlendRow_PARGB( dst + i, src + i, n - i, opacity );
+}
+
+LCUI_TARGET_AVX2 static void BlendRow_ARGBToPARGB_AVX2( LCUI_ARGB *dst,
+							const LCUI_ARGB *src,
+							int n, int opacity )
+{
+	int i;
+	__m256i s, d, sa, lo, hi, op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i amask = _mm256_set1_epi32( (int)0xff000000 );
+
+	op = _mm256_set1_epi16( (short)opacity );
+	for( i = 0; i + 8 <= n; i += 8 ) {
+		s = _mm256_loadu_si256( (const __m256i*)(src + i) );
+		sa = _mm256_and_si256( s, amask );
+		if( _mm256_testz_si256( sa, sa ) ) {
+			continue;
+		}
+		if( opacity == 255 && _mm256_movemask_epi8(
+			_mm256_cmpeq_epi32( sa, amask ) ) == -1 ) {
+			_mm256_storeu_si256( (__m256i*)(dst + i), s );
+			continue;
+		}
+		d = _mm256_loadu_si256( (const __m256i*)(dst + i) );
+		lo = AVX2_BlendARGBToPARGB( _mm256_unpacklo_epi8( s, zero ),
+					    _mm256_unpacklo_epi8( d, zero ),
+					    op );
+		hi = AVX2_BlendARGBToPARGB( _mm256_unpackhi_epi8( s, zero ),
+					    _mm256_unpackhi_epi8( d, zero ),
+					    op );
+		_mm256_storeu_si256( (__m256i*)(dst + i),
+				     _mm256_packus_epi16( lo, hi ) );
+	}
+	BlendRow_ARGBToPARGB( dst + i, src + i, n - i, opacity );
+}
+
+#endif
+
+#ifdef LCUI_BLEND_NEON
+
+/** 混合两个像素，sa 和 da 是已展开到每个通道的 alpha 值 */
+static uint16x8_t NEON_BlendARGB( uint16x8_t s, uint16x8_t d,
+				  uint16x8_t sa, uint16x8_t da,
+				  uint16x8_t opacity )
+{
+	uint16x8_t ws, wd, out_a;
+	uint32x4_t lo, hi, den_lo, den_hi;
+	const uint32x4_t k127 = vdupq_n_u32( 127 );
+	const uint32x4_t k255 = vdupq_n_u32( 255 );
+	static const uint16_t mask_data[8] = {
+		0, 0, 0, 0xffff, 0, 0, 0, 0xffff
+	};
+
+	ws = vmulq_u16( sa, opacity );
+	wd = vsubq_u16( vdupq_n_u16( 65025 ), ws );
+	lo = vmull_u16( vget_low_u16( da ), vget_low_u16( wd ) );
+	hi = vmull_u16( vget_high_u16( da ), vget_high_u16( wd ) );
+	lo = NEON_Divide( vaddq_u32( lo, k127 ), k255 );
+	hi = NEON_Divide( vaddq_u32( hi, k127 ), k255 );
+	wd = vcombine_u16( vmovn_u32( lo ), vmovn_u32( hi ) );
+	out_a = vaddq_u16( ws, wd );
+	den_lo = vmovl_u16( vget_low_u16( out_a ) );
+	den_hi = vmovl_u16( vget_high_u16( out_a ) );
+	lo = vmull_u16( vget_low_u16( s ), vget_low_u16( ws ) );
+	lo = vmlal_u16( lo, vget_low_u16( d ), vget_low_u16( wd ) );
+	lo = vaddq_u32( lo, vshrq_n_u32( den_lo, 1 ) );
+	hi = vmull_u16( vget_high_u16( s ), vget_high_u16( ws ) );
+	hi = vmlal_u16( hi, vget_high_u16( d ), vget_high_u16( wd ) );
+	hi = vaddq_u32( hi, vshrq_n_u32( den_hi, 1 ) );
+	den_lo = vmaxq_u32( den_lo, vdupq_n_u32( 1 ) );
+	den_hi = vmaxq_u32( den_hi, vdupq_n_u32( 1 ) );
+	lo = NEON_Divide( lo, den_lo );
+	hi = NEON_Divide( hi, den_hi );
+	return vbslq_u16( vld1q_u16( mask_data ), NEON_Div255( out_a ),
+			  vcombine_u16( vmovn_u32( lo ), vmovn_u32( hi ) ) );
+}
+
+static uint16x8_t NEON_BlendColor( uint16x8_t s, uint16x8_t d,
+				   uint16x8_t sa, uint16x8_t opacity )
+{
+	uint16x8_t inv, out;
+	static const uint16_t mask_data[8] = {
+		0, 0, 0, 0xffff, 0, 0, 0, 0xffff
+	};
+
+	sa = NEON_Div255( vmulq_u16( sa, opacity ) );
+	inv = vsubq_u16( vdupq_n_u16( 255 ), sa );
+	out = NEON_Div255( vaddq_u16( vmulq_u16( s, sa ),
+				      vmulq_u16( d, inv ) ) );
+	return vbslq_u16( vld1q_u16( mask_data ), d, out );
+}
+
+static void BlendRow_ARGB_NEON( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				int n, int opacity )
+{
+	int i;
+	uint16x8_t op;
+	uint8x16_t s, d, sa, da;
+	static const uint8_t index_data[16] = {
+		3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15
+	};
+	const uint8x16_t index = vld1q_u8( index_data );
+
+	op = vdupq_n_u16( (uint16_t)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		uint16x8_t lo, hi;
+		s = vld1q_u8( (const uint8_t*)(src + i) );
+		d = vld1q_u8( (const uint8_t*)(dst + i) );
+		sa = vqtbl1q_u8( s, index );
+		da = vqtbl1q_u8( d, index );
+		if( opacity == 255 && vminvq_u8( sa ) == 255 ) {
+			vst1q_u8( (uint8_t*)(dst + i), s );
+			continue;
+		}
+		if( vmaxvq_u8( sa ) == 0 && vminvq_u8( da ) > 0 ) {
+			continue;
+		}
+		lo = NEON_BlendARGB( vmovl_u8( vget_low_u8( s ) ),
+				     vmovl_u8( vget_low_u8( d ) ),
+				     vmovl_u8( vget_low_u8( sa ) ),
+				     vmovl_u8( vget_low_u8( da ) ), op );
+		hi = NEON_BlendARGB( vmovl_u8( vget_high_u8( s ) ),
+				     vmovl_u8( vget_high_u8( d ) ),
+				     vmovl_u8( vget_high_u8( sa ) ),
+				     vmovl_u8( vget_high_u8( da ) ), op );
+		vst1q_u8( (uint8_t*)(dst + i),
+			  vcombine_u8( vqmovn_u16( lo ), vqmovn_u16( hi ) ) );
+	}
+	BlendRow_ARGB( dst + i, src + i, n - i, opacity );
+}
+
+static void BlendRow_Color_NEON( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				 int n, int opacity )
+{
+	int i;
+	uint16x8_t op;
+	uint8x16_t s, d, sa;
+	static const uint8_t index_data[16] = {
+		3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15
+	};
+	const uint8x16_t index = vld1q_u8( index_data );
+
+	op = vdupq_n_u16( (uint16_t)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		uint16x8_t lo, hi;
+		s = vld1q_u8( (const uint8_t*)(src + i) );
+		sa = vqtbl1q_u8( s, index );
+		if( vmaxvq_u8( sa ) == 0 ) {
+			continue;
+		}
+		d = vld1q_u8( (const uint8_t*)(dst + i) );
+		lo = NEON_BlendColor( vmovl_u8( vget_low_u8( s ) ),
+				      vmovl_u8( vget_low_u8( d ) ),
+				      vmovl_u8( vget_low_u8( sa ) ), op );
+		hi = NEON_BlendColor( vmovl_u8( vget_high_u8( s ) ),
+				      vmovl_u8( vget_high_u8( d ) ),
+				      vmovl_u8( vget_high_u8( sa ) ), op );
+		vst1q_u8( (uint8_t*)(dst + i),
+			  vcombine_u8( vqmovn_u16( lo ), vqmovn_u16( hi ) ) );
+	}
+	BlendRow_Color( dst + i, src + i, n - i, opacity );
+}
+
+/** 混合两个 PARGB 像素，sa 是已展开到每个通道的 alpha 值 */
+static uint16x8_t NEON_BlendPARGB( uint16x8_t s, uint16x8_t d,
+				   uint16x8_t sa, uint16x8_t opacity )
+{
+	uint16x8_t inv;
+
+	inv = vsubq_u16( vdupq_n_u16( 255 ),
+			 NEON_Div255( vmulq_u16( sa, opacity ) ) );
+	return NEON_Div255( vaddq_u16( vmulq_u16( s, opacity ),
+				       vmulq_u16( d, inv ) ) );
+}
+
+static uint16x8_t NEON_BlendARGBToPARGB( uint16x8_t s, uint16x8_t d,
+					 uint16x8_t sa, uint16x8_t opacity )
+{
+	uint16x8_t inv;
+	static const uint16_t alpha_data[8] = { 0, 0, 0, 255, 0, 0, 0, 255 };
+
+	sa = NEON_Div255( vmulq_u16( sa, opacity ) );
+	inv = vsubq_u16( vdupq_n_u16( 255 ), sa );
+	s = vorrq_u16( s, vld1q_u16( alpha_data ) );
+	return NEON_Div255( vaddq_u16( vmulq_u16( s, sa ),
+				       vmulq_u16( d, inv ) ) );
+}
+
+static void BlendRow_PARGB_NEON( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				 int n, int opacity )
+{
+	int i;
+	uint16x8_t op;
+	uint8x16_t s, d, sa;
+	static const uint8_t index_data[16] = {
+		3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15
+	};
+	const uint8x16_t index = vld1q_u8( index_data );
+
+	op = vdupq_n_u16( (uint16_t)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		uint16x8_t lo, hi;
+		s = vld1q_u8( (const uint8_t*)(src + i) );
+		if( vmaxvq_u8( s ) == 0 ) {
+			continue;
+		}
+		sa = vqtbl1q_u8( s, index );
+		if( opacity == 255 && vminvq_u8( sa ) == 255 ) {
+			vst1q_u8( (uint8_t*)(dst + i), s );
+			continue;
+		}
+		d = vld1q_u8( (const uint8_t*)(dst + i) );
+		lo = NEON_BlendPARGB( vmovl_u8( vget_low_u8( s ) ),
+				      vmovl_u8( vget_low_u8( d ) ),
+				      vmovl_u8( vget_low_u8( sa ) ), op );
+		hi = NEON_BlendPARGB( vmovl_u8( vget_high_u8( s ) ),
+				      vmovl_u8( vget_high_u8( d ) ),
+				      vmovl_u8( vget_high_u8( sa ) ), op );
+		vst1q_u8( (uint8_t*)(dst + i),
+			  vcombine_u8( vqmovn_u16( lo ), vqmovn_u16( hi ) ) );
+	}
+	BlendRow_PARGB( dst + i, src + i, n - i, opacity );
+}
+
+static void BlendRow_ARGBToPARGB_NEON( LCUI_ARGB *dst, const LCUI_ARGB *src,
+				       int n, int opacity )
+{
+	int i;
+	uint16x8_t op;
+	uint8x16_t s, d, sa;
+	static const uint8_t index_data[16] = {
+		3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15
+	};
+	const uint8x16_t index = vld1q_u8( index_data );
+
+	op = vdupq_n_u16( (uint16_t)opacity );
+	for( i = 0; i + 4 <= n; i += 4 ) {
+		uint16x8_t lo, hi;
+		s = vld1q_u8( (const uint8_t*)(src + i) );
+		sa = vqtbl1q_u8( s, index );
+		if( vmaxvq_u8( sa ) == 0 ) {
+			continue;
+		}
+		if( opacity == 255 && vminvq_u8( sa ) == 255 ) {
+			vst1q_u8( (uint8_t*)(dst + i), s );
+			continue;
+		}
+		d = vld1q_u8( (const uint8_t*)(dst + i) );
+		lo = NEON_BlendARGBToPARGB( vmovl_u8( vget_low_u8( s ) ),
+					    vmovl_u8( vget_low_u8( d ) ),
+					    vmovl_u8( vget_low_u8( sa ) ), op );
+		hi = NEON_BlendARGBToPARGB( vmovl_u8( vget_high_u8( s ) ),
+					    vmovl_u8( vget_high_u8( d ) ),
+					    vmovl_u8( vget_high_u8( sa ) ), op );
+		vst1q_u8( (uint8_t*)(dst + i),
+			  vcombine_u8( vqmovn_u16( lo ), vqmovn_u16( hi ) ) );
+	}
+	BlendRow_ARGBToPARGB( dst + i, src + i, n - i, opacity );
+}
+
+#endif
+
+static LCUI_BOOL Graph_IsBlendKernelSupported( int kernel )
+{
+	switch( kernel ) {
+	case BLEND_KERNEL_SCALAR:
+		return TRUE;
+#ifdef LCUI_BLEND_SSE2
+	case BLEND_KERNEL_SSE2:
+		return TRUE;
+#endif
+#ifdef LCUI_BLEND_AVX2
+	case BLEND_KERNEL_AVX2:
+#ifdef _MSC_VER
+	{
+		int info[4];
+		__cpuid( info, 1 );
+		/* 需要 OSXSAVE 和 AVX，并且操作系统保存了 YMM 寄存器 */
+		if( (info[2] & 0x18000000) != 0x18000000 ||
+		    (_xgetbv( 0 ) & 6) != 6 ) {
+			return FALSE;
+		}
+		__cpuidex( info, 7, 0 );
+		return (info[1] & 0x20) != 0;
+	}
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+#endif
+#ifdef LCUI_BLEND_NEON
+	case BLEND_KERNEL_NEON:
+		return TRUE;
+#endif
+	default: break;
+	}
+	return FALSE;
+}
+
+int Graph_SetBlendKernel( int kernel )
+{
+	if( !Graph_IsBlendKernelSupported( kernel ) ) {
+		return -1;
+	}
+	blend_kernel.mix_argb = BlendRow_ARGB;
+	blend_kernel.mix_color = BlendRow_Color;
+	blend_kernel.mix_rgb = BlendRow_RGB;
+	blend_kernel.mix_pargb = BlendRow_PARGB;
+	blend_kernel.mix_argb_pargb = BlendRow_ARGBToPARGB;
+	blend_kernel.mix_pargb_rgb = BlendRow_PARGBToRGB;
+	switch( kernel ) {
+#ifdef LCUI_BLEND_SSE2
+	case BLEND_KERNEL_SSE2:
+		blend_kernel.mix_argb = BlendRow_ARGB_SSE2;
+		blend_kernel.mix_color = BlendRow_Color_SSE2;
+		blend_kernel.mix_rgb = BlendRow_RGBWithKernel;
+		blend_kernel.mix_pargb = BlendRow_PARGB_SSE2;
+		blend_kernel.mix_argb_pargb = BlendRow_ARGBToPARGB_SSE2;
+		blend_kernel.mix_pargb_rgb = BlendRow_PARGBToRGBWithKernel;
+		break;
+#endif
+#ifdef LCUI_BLEND_AVX2
+	case BLEND_KERNEL_AVX2:
+		blend_kernel.mix_argb = BlendRow_ARGB_AVX2;
+		blend_kernel.mix_color = BlendRow_Color_AVX2;
+		blend_kernel.mix_rgb = BlendRow_RGBWithKernel;
+		blend_kernel.mix_pargb = BlendRow_PARGB_AVX2;
+		blend_kernel.mix_argb_pargb = BlendRow_ARGBToPARGB_AVX2;
+		blend_kernel.mix_pargb_rgb = BlendRow_PARGBToRGBWithKernel;
+		break;
+#endif
+#ifdef LCUI_BLEND_NEON
+	case BLEND_KERNEL_NEON:
+		blend_kernel.mix_argb = BlendRow_ARGB_NEON;
+		blend_kernel.mix_color = BlendRow_Color_NEON;
+		blend_kernel.mix_rgb = BlendRow_RGBWithKernel;
+		blend_kernel.mix_pargb = BlendRow_PARGB_NEON;
+		blend_kernel.mix_argb_pargb = BlendRow_ARGBToPARGB_NEON;
+		blend_kernel.mix_pargb_rgb = BlendRow_PARGBToRGBWithKernel;
+		break;
+#endif
+	default: break;
+	}
+	blend_kernel.id = kernel;
+	blend_kernel.ready = TRUE;
+	return 0;
+}
+
+/** 根据 CPU 支持的指令集选择最快的混合内核 */
+static void Graph_InitBlendKernel( void )
+{
+	if( Graph_SetBlendKernel( BLEND_KERNEL_AVX2 ) == 0 ||
+	    Graph_SetBlendKernel( BLEND_KERNEL_SSE2 ) == 0 ||
+	    Graph_SetBlendKernel( BLEND_KERNEL_NEON ) == 0 ) {
+		return;
+	}
+	Graph_SetBlendKernel( BLEND_KERNEL_SCALAR );
+}
+
+int Graph_GetBlendKernel( void )
+{
+	if( !blend_kernel.ready ) {
+		Graph_InitBlendKernel();
+	}
+	return blend_kernel.id;
+}
+
+/** 将全局不透明度转换成 0~255 的整数 */
+static int Graph_GetOpacity( const LCUI_Graph *graph )
+{
+	if( graph->opacity >= 1.0 ) {
+		return 255;
+	}
+	if( graph->opacity <= 0 ) {
+		return 0;
+	}
+	return (int)(graph->opacity * 255.0 + 0.5);
+}
+
+/*---------------------------- End Blend Kernels ---------------------------*/
+
 /*----------------------------------- RGB ----------------------------------*/
 
 static void Pixels_ARGBFormatToRGB( const uchar_t *in_pixels,
@@ -171,6 +1250,81 @@ static void Pixels_RGBFormatToARGB( const uchar_t *in_pixels,
 	}
 }
 
+static void Pixels_ARGBFormatToPARGB( const uchar_t *in_pixels,
+				      uchar_t *out_pixels,
+				      size_t pixel_count )
+{
+	const LCUI_ARGB8888 *p_px, *p_end_px;
+	LCUI_ARGB8888 *p_out_px;
+
+	p_px = (const LCUI_ARGB8888*)in_pixels;
+	p_out_px = (LCUI_ARGB8888*)out_pixels;
+	p_end_px = p_px + pixel_count;
+	for( ; p_px < p_end_px; ++p_px, ++p_out_px ) {
+		p_out_px->blue = DIV255( p_px->blue * p_px->alpha );
+		p_out_px->green = DIV255( p_px->green * p_px->alpha );
+		p_out_px->red = DIV255( p_px->red * p_px->alpha );
+		p_out_px->alpha = p_px->alpha;
+	}
+}
+
+static void Pixels_PARGBFormatToARGB( const uchar_t *in_pixels,
+				      uchar_t *out_pixels,
+				      size_t pixel_count )
+{
+	uint_t a;
+	const LCUI_ARGB8888 *p_px, *p_end_px;
+	LCUI_ARGB8888 *p_out_px;
+
+	p_px = (const LCUI_ARGB8888*)in_pixels;
+	p_out_px = (LCUI_ARGB8888*)out_pixels;
+	p_end_px = p_px + pixel_count;
+	for( ; p_px < p_end_px; ++p_px, ++p_out_px ) {
+		a = p_px->alpha;
+		if( a == 0 ) {
+			p_out_px->value = 0;
+			continue;
+		}
+		if( a == 255 ) {
+			*p_out_px = *p_px;
+			continue;
+		}
+		p_out_px->blue = (p_px->blue * 255 + (a >> 1)) / a;
+		p_out_px->green = (p_px->green * 255 + (a >> 1)) / a;
+		p_out_px->red = (p_px->red * 255 + (a >> 1)) / a;
+		p_out_px->alpha = a;
+	}
+}
+
+/**
+ * 将 PARGB 像素还原成 ARGB 后去掉 alpha 通道
+ * 输入和输出可以是同一块内存，写入的位置不会超过还未读取的像素
+ */
+static void Pixels_PARGBFormatToRGB( const uchar_t *in_pixels,
+				     uchar_t *out_pixels,
+				     size_t pixel_count )
+{
+	uint_t a;
+	uchar_t *p_out_byte;
+	const LCUI_ARGB8888 *p_px, *p_end_px;
+
+	p_out_byte = out_pixels;
+	p_px = (const LCUI_ARGB8888*)in_pixels;
+	p_end_px = p_px + pixel_count;
+	for( ; p_px < p_end_px; ++p_px ) {
+		a = p_px->alpha;
+		if( a == 0 || a == 255 ) {
+			*p_out_byte++ = p_px->blue;
+			*p_out_byte++ = p_px->green;
+			*p_out_byte++ = p_px->red;
+			continue;
+		}
+		*p_out_byte++ = (p_px->blue * 255 + (a >> 1)) / a;
+		*p_out_byte++ = (p_px->green * 255 + (a >> 1)) / a;
+		*p_out_byte++ = (p_px->red * 255 + (a >> 1)) / a;
+	}
+}
+
 void PixelsFormat( const uchar_t *in_pixels, int in_color_type,
 		   uchar_t *out_pixels, int out_color_type,
 		   size_t pixel_count )
@@ -180,14 +1334,29 @@ void PixelsFormat( const uchar_t *in_pixels, int in_color_type,
 		if( out_color_type == COLOR_TYPE_ARGB8888 ) {
 			return;
 		}
+		if( out_color_type == COLOR_TYPE_PARGB8888 ) {
+			Pixels_ARGBFormatToPARGB( in_pixels, out_pixels,
+						  pixel_count );
+			break;
+		}
 		Pixels_ARGBFormatToRGB( in_pixels, out_pixels, pixel_count );
 		break;
 	case COLOR_TYPE_RGB888:
 		if( out_color_type == COLOR_TYPE_RGB888 ) {
 			return;
 		}
+		/* 不透明的像素在预乘 alpha 前后是一样的 */
 		Pixels_RGBFormatToARGB( in_pixels, out_pixels, pixel_count );
 		break;
+	case COLOR_TYPE_PARGB8888:
+		if( out_color_type == COLOR_TYPE_ARGB8888 ) {
+			Pixels_PARGBFormatToARGB( in_pixels, out_pixels,
+						  pixel_count );
+		} else if( out_color_type == COLOR_TYPE_RGB888 ) {
+			Pixels_PARGBFormatToRGB( in_pixels, out_pixels,
+						 pixel_count );
+		}
+		break;
 	default: break;
 	}
 }
@@ -430,65 +1599,14 @@ static int Graph_CutARGB( const LCUI_Graph *graph, LCUI_Rect rect,
 static void Graph_ARGBMixARGB( LCUI_Graph *dst, LCUI_Rect des_rect,
 			       const LCUI_Graph *src, int src_x, int src_y )
 {
-	int x, y;
-	LCUI_ARGB *px_src, *px_dst;
+	int y, opacity;
 	LCUI_ARGB *px_row_src, *px_row_des;
-	double a, out_a, out_r, out_g, out_b, src_a;
 	px_row_src = src->argb + src_y*src->width + src_x;
 	px_row_des = dst->argb + des_rect.y*dst->width + des_rect.x;
-	if( src->opacity < 1.0 ) {
-		goto mix_with_opacity;
-	}
+	opacity = Graph_GetOpacity( src );
 	for( y = 0; y < des_rect.height; ++y ) {
-		px_src = px_row_src;
-		px_dst = px_row_des;
-		for( x = 0; x < des_rect.width; ++x ) {
-			src_a = px_src->a / 255.0;
-			a = (1.0 - src_a) * px_dst->a / 255.0;
-			out_r = px_dst->r * a + px_src->r * src_a;
-			out_g = px_dst->g * a + px_src->g * src_a;
-			out_b = px_dst->b * a + px_src->b * src_a;
-			out_a = src_a + a;
-			if( out_a > 0 ) {
-				out_r /= out_a;
-				out_g /= out_a;
-				out_b /= out_a;
-			}
-			px_dst->r = (uchar_t)(out_r + 0.5);
-			px_dst->g = (uchar_t)(out_g + 0.5);
-			px_dst->b = (uchar_t)(out_b + 0.5);
-			px_dst->a = (uchar_t)(255.0 * out_a + 0.5);
-			++px_src;
-			++px_dst;
-		}
-		px_row_des += dst->w;
-		px_row_src += src->w;
-	}
-	return;
-
-mix_with_opacity:
-	for( y = 0; y < des_rect.height; ++y ) {
-		px_src = px_row_src;
-		px_dst = px_row_des;
-		for( x = 0; x < des_rect.width; ++x ) {
-			src_a = px_src->a / 255.0 * src->opacity;
-			a = (1.0 - src_a) * px_dst->a / 255.0;
-			out_r = px_dst->r * a + px_src->r * src_a;
-			out_g = px_dst->g * a + px_src->g * src_a;
-			out_b = px_dst->b * a + px_src->b * src_a;
-			out_a = src_a + a;
-			if( out_a > 0 ) {
-				out_r /= out_a;
-				out_g /= out_a;
-				out_b /= out_a;
-			}
-			px_dst->r = (uchar_t)(out_r + 0.5);
-			px_dst->g = (uchar_t)(out_g + 0.5);
-			px_dst->b = (uchar_t)(out_b + 0.5);
-			px_dst->a = (uchar_t)(255.0 * out_a + 0.5);
-			++px_src;
-			++px_dst;
-		}
+		blend_kernel.mix_argb( px_row_des, px_row_src,
+				       des_rect.width, opacity );
 		px_row_des += dst->width;
 		px_row_src += src->width;
 	}
@@ -497,37 +1615,14 @@ mix_with_opacity:
 static void Graph_ARGBMixARGB2( LCUI_Graph *dest, LCUI_Rect des_rect,
 				const LCUI_Graph *src, int src_x, int src_y )
 {
-	int x, y, a;
-	LCUI_ARGB *px_src, *px_dest;
+	int y, opacity;
 	LCUI_ARGB *px_row_src, *px_row_des;
 	px_row_src = src->argb + src_y*src->width + src_x;
 	px_row_des = dest->argb + des_rect.y*dest->width + des_rect.x;
-	if( src->opacity < 1.0 ) {
-		goto mix_with_opacity;
-	}
-	for( y = 0; y < des_rect.height; ++y ) {
-		px_src = px_row_src;
-		px_dest = px_row_des;
-		for( x = 0; x < des_rect.width; ++x ) {
-			PIXEL_BLEND( px_dest, px_src, px_src->a );
-			++px_src;
-			++px_dest;
-		}
-		px_row_des += dest->width;
-		px_row_src += src->width;
-	}
-	return;
-
-mix_with_opacity:
+	opacity = Graph_GetOpacity( src );
 	for( y = 0; y < des_rect.height; ++y ) {
-		px_src = px_row_src;
-		px_dest = px_row_des;
-		for( x = 0; x < des_rect.width; ++x ) {
-			a = px_src->a * src->opacity;
-			PIXEL_BLEND( px_dest, px_src, a );
-			++px_src;
-			++px_dest;
-		}
+		blend_kernel.mix_color( px_row_des, px_row_src,
+					des_rect.width, opacity );
 		px_row_des += dest->width;
 		px_row_src += src->width;
 	}
@@ -536,47 +1631,18 @@ mix_with_opacity:
 static void Graph_RGBMixARGB( LCUI_Graph *des, LCUI_Rect des_rect,
 			      const LCUI_Graph *src, int src_x, int src_y )
 {
-	int x, y;
-	uchar_t a;
-	LCUI_ARGB *px, *px_row;
-	uchar_t *rowbytep, *bytep;
+	int y, opacity;
+	LCUI_ARGB *px_row;
+	uchar_t *rowbytep;
 
 	/* 计算并保存第一行的首个像素的位置 */
 	px_row = src->argb + src_y*src->w + src_x;
 	rowbytep = des->bytes + des_rect.y*des->bytes_per_row;
 	rowbytep += des_rect.x*des->bytes_per_pixel;
-	if( src->opacity < 1.0 ) {
-		goto mix_with_opacity;
-	}
-	for( y = 0; y < des_rect.height; ++y ) {
-		px = px_row;
-		bytep = rowbytep;
-		for( x = 0; x < des_rect.width; ++x, ++px ) {
-			*bytep = _ALPHA_BLEND( *bytep, px->b, px->a );
-			++bytep;
-			*bytep = _ALPHA_BLEND( *bytep, px->g, px->a );
-			++bytep;
-			*bytep = _ALPHA_BLEND( *bytep, px->r, px->a );
-			++bytep;
-		}
-		rowbytep += des->bytes_per_row;
-		px_row += src->w;
-	}
-	return;
-
-mix_with_opacity:
+	opacity = Graph_GetOpacity( src );
 	for( y = 0; y < des_rect.height; ++y ) {
-		px = px_row;
-		bytep = rowbytep;
-		for( x = 0; x < des_rect.width; ++x, ++px ) {
-			a = px->a * src->opacity;
-			*bytep = _ALPHA_BLEND( *bytep, px->b, a );
-			++bytep;
-			*bytep = _ALPHA_BLEND( *bytep, px->g, a );
-			++bytep;
-			*bytep = _ALPHA_BLEND( *bytep, px->r, a );
-			++bytep;
-		}
+		blend_kernel.mix_rgb( rowbytep, px_row,
+				      des_rect.width, opacity );
 		rowbytep += des->bytes_per_row;
 		px_row += src->w;
 	}
@@ -705,6 +1771,201 @@ static int Graph_FillRectARGB( LCUI_Graph *graph, LCUI_Color color,
 
 /*-------------------------------- End ARGB --------------------------------*/
 
+/*---------------------------------- PARGB ---------------------------------*/
+
+static int Graph_ARGBToPARGB( LCUI_Graph *graph )
+{
+	size_t n = graph->w * graph->h;
+	Pixels_ARGBFormatToPARGB( graph->bytes, graph->bytes, n );
+	graph->color_type = COLOR_TYPE_PARGB8888;
+	return 0;
+}
+
+static int Graph_PARGBToARGB( LCUI_Graph *graph )
+{
+	size_t n = graph->w * graph->h;
+	Pixels_PARGBFormatToARGB( graph->bytes, graph->bytes, n );
+	graph->color_type = COLOR_TYPE_ARGB8888;
+	return 0;
+}
+
+/** 逐行调用混合函数，目标图像和源图像都是 32 位像素 */
+static void Graph_MixRows( LCUI_Graph *dst, LCUI_Rect des_rect,
+			   const LCUI_Graph *src, int src_x, int src_y,
+			   BlendRowFunc mix )
+{
+	int y, opacity;
+	LCUI_ARGB *px_row_src, *px_row_des;
+	px_row_src = src->argb + src_y*src->width + src_x;
+	px_row_des = dst->argb + des_rect.y*dst->width + des_rect.x;
+	opacity = Graph_GetOpacity( src );
+	for( y = 0; y < des_rect.height; ++y ) {
+		mix( px_row_des, px_row_src, des_rect.width, opacity );
+		px_row_des += dst->width;
+		px_row_src += src->width;
+	}
+}
+
+static void Graph_PARGBMixPARGB( LCUI_Graph *dst, LCUI_Rect des_rect,
+				 const LCUI_Graph *src, int src_x, int src_y )
+{
+	Graph_MixRows( dst, des_rect, src, src_x, src_y,
+		       blend_kernel.mix_pargb );
+}
+
+static void Graph_PARGBMixARGB( LCUI_Graph *dst, LCUI_Rect des_rect,
+				const LCUI_Graph *src, int src_x, int src_y )
+{
+	Graph_MixRows( dst, des_rect, src, src_x, src_y,
+		       blend_kernel.mix_argb_pargb );
+}
+
+static void Graph_ARGBMixPARGB( LCUI_Graph *dst, LCUI_Rect des_rect,
+				const LCUI_Graph *src, int src_x, int src_y )
+{
+	Graph_MixRows( dst, des_rect, src, src_x, src_y,
+		       BlendRow_PARGBToARGB );
+}
+
+static void Graph_ARGBMixPARGB2( LCUI_Graph *dst, LCUI_Rect des_rect,
+				 const LCUI_Graph *src, int src_x, int src_y )
+{
+	Graph_MixRows( dst, des_rect, src, src_x, src_y,
+		       BlendRow_PARGBColor );
+}
+
+static void Graph_RGBMixPARGB( LCUI_Graph *des, LCUI_Rect des_rect,
+			       const LCUI_Graph *src, int src_x, int src_y )
+{
+	int y, opacity;
+	LCUI_ARGB *px_row;
+	uchar_t *rowbytep;
+
+	px_row = src->argb + src_y*src->w + src_x;
+	rowbytep = des->bytes + des_rect.y*des->bytes_per_row;
+	rowbytep += des_rect.x*des->bytes_per_pixel;
+	opacity = Graph_GetOpacity( src );
+	for( y = 0; y < des_rect.height; ++y ) {
+		blend_kernel.mix_pargb_rgb( rowbytep, px_row,
+					    des_rect.width, opacity );
+		rowbytep += des->bytes_per_row;
+		px_row += src->w;
+	}
+}
+
+/** 将 RGB、ARGB 或 PARGB 图像转换为 PARGB 后覆盖到 PARGB 图像上 */
+static void Graph_PARGBReplace( LCUI_Graph *des, LCUI_Rect des_rect,
+				const LCUI_Graph *src, int src_x, int src_y )
+{
+	int x, y, opacity;
+	uint_t a;
+	uchar_t *byte_row_src;
+	const LCUI_ARGB *px_src;
+	LCUI_ARGB *px_row_des, *px_des;
+
+	byte_row_src = src->bytes + src_y * src->bytes_per_row;
+	byte_row_src += src_x * src->bytes_per_pixel;
+	px_row_des = des->argb + des_rect.y*des->w + des_rect.x;
+	opacity = Graph_GetOpacity( src );
+	for( y = 0; y < des_rect.height; ++y ) {
+		px_des = px_row_des;
+		px_src = (const LCUI_ARGB*)byte_row_src;
+		switch( src->color_type ) {
+		case COLOR_TYPE_RGB888:
+			Pixels_RGBFormatToARGB( byte_row_src, (uchar_t*)px_des,
+						des_rect.width );
+			break;
+		case COLOR_TYPE_ARGB8888:
+			for( x = 0; x < des_rect.width; ++x ) {
+				a = DIV255( px_src->a * opacity );
+				px_des->r = DIV255( px_src->r * a );
+				px_des->g = DIV255( px_src->g * a );
+				px_des->b = DIV255( px_src->b * a );
+				px_des->a = a;
+				++px_src;
+				++px_des;
+			}
+			break;
+		case COLOR_TYPE_PARGB8888:
+			if( opacity == 255 ) {
+				memcpy( px_des, px_src,
+					sizeof( LCUI_ARGB )*des_rect.width );
+				break;
+			}
+			for( x = 0; x < des_rect.width; ++x ) {
+				px_des->r = DIV255( px_src->r * opacity );
+				px_des->g = DIV255( px_src->g * opacity );
+				px_des->b = DIV255( px_src->b * opacity );
+				px_des->a = DIV255( px_src->a * opacity );
+				++px_src;
+				++px_des;
+			}
+		default: break;
+		}
+		byte_row_src += src->bytes_per_row;
+		px_row_des += des->w;
+	}
+}
+
+/** 将 PARGB 图像还原成 ARGB 后覆盖到 ARGB 图像上 */
+static void Graph_ARGBReplacePARGB( LCUI_Graph *des, LCUI_Rect des_rect,
+				    const LCUI_Graph *src,
+				    int src_x, int src_y )
+{
+	int x, y, opacity;
+	LCUI_ARGB *px_row_src, *px_row_des;
+
+	px_row_src = src->argb + src_y*src->w + src_x;
+	px_row_des = des->argb + des_rect.y*des->w + des_rect.x;
+	opacity = Graph_GetOpacity( src );
+	for( y = 0; y < des_rect.height; ++y ) {
+		Pixels_PARGBFormatToARGB( (uchar_t*)px_row_src,
+					  (uchar_t*)px_row_des,
+					  des_rect.width );
+		for( x = 0; opacity < 255 && x < des_rect.width; ++x ) {
+			px_row_des[x].a = DIV255( px_row_des[x].a * opacity );
+		}
+		px_row_src += src->w;
+		px_row_des += des->w;
+	}
+}
+
+static int Graph_FillRectPARGB( LCUI_Graph *graph, LCUI_Color color,
+				LCUI_Rect rect, LCUI_BOOL with_alpha )
+{
+	int x, y;
+	LCUI_Rect rect_src;
+	LCUI_ARGB *px_p, *px_row_p;
+
+	if( with_alpha ) {
+		color.r = DIV255( color.r * color.a );
+		color.g = DIV255( color.g * color.a );
+		color.b = DIV255( color.b * color.a );
+		return Graph_FillRectARGB( graph, color, rect, TRUE );
+	}
+	if( !Graph_IsValid( graph ) ) {
+		return -1;
+	}
+	Graph_GetValidRect( graph, &rect_src );
+	graph = Graph_GetQuote( graph );
+	px_row_p = graph->argb + (rect_src.y + rect.y)*graph->w;
+	px_row_p += rect.x + rect_src.x;
+	/* 保留原有的 alpha 值，颜色需要按该值预乘 */
+	for( y = 0; y < rect.height; ++y ) {
+		px_p = px_row_p;
+		for( x = 0; x < rect.width; ++x ) {
+			px_p->r = DIV255( color.r * px_p->a );
+			px_p->g = DIV255( color.g * px_p->a );
+			px_p->b = DIV255( color.b * px_p->a );
+			++px_p;
+		}
+		px_row_p += graph->w;
+	}
+	return 0;
+}
+
+/*-------------------------------- End PARGB -------------------------------*/
+
 int Graph_SetColorType( LCUI_Graph *graph, int color_type )
 {
 	if( graph->color_type == color_type ) {
@@ -715,6 +1976,8 @@ int Graph_SetColorType( LCUI_Graph *graph, int color_type )
 		switch( color_type ) {
 		case COLOR_TYPE_RGB888:
 			return Graph_ARGBToRGB( graph );
+		case COLOR_TYPE_PARGB8888:
+			return Graph_ARGBToPARGB( graph );
 		default:break;
 		}
 		break;
@@ -722,6 +1985,22 @@ int Graph_SetColorType( LCUI_Graph *graph, int color_type )
 		switch( color_type ) {
 		case COLOR_TYPE_ARGB8888:
 			return Graph_RGBToARGB( graph );
+		case COLOR_TYPE_PARGB8888:
+			if( Graph_RGBToARGB( graph ) != 0 ) {
+				return -1;
+			}
+			graph->color_type = COLOR_TYPE_PARGB8888;
+			return 0;
+		default:break;
+		}
+		break;
+	case COLOR_TYPE_PARGB8888:
+		switch( color_type ) {
+		case COLOR_TYPE_ARGB8888:
+			return Graph_PARGBToARGB( graph );
+		case COLOR_TYPE_RGB888:
+			Graph_PARGBToARGB( graph );
+			return Graph_ARGBToRGB( graph );
 		default:break;
 		}
 		break;
@@ -790,7 +2069,11 @@ void Graph_Free( LCUI_Graph *graph )
 		graph->quote.is_valid = FALSE;
 		return;
 	}
-	if( graph->bytes ) {
+	/* 帧内存池中的像素数据会在帧结束时统一回收 */
+	if( graph->in_arena ) {
+		graph->in_arena = FALSE;
+		graph->bytes = NULL;
+	} else if( graph->bytes ) {
 		free( graph->bytes );
 		graph->bytes = NULL;
 	}
@@ -799,6 +2082,289 @@ void Graph_Free( LCUI_Graph *graph )
 	graph->mem_size = 0;
 }
 
+static FrameArenaBlock FrameArena_NewBlock( FrameArenaStack stack,
+					    size_t size )
+{
+	FrameArenaBlock block;
+	/* 多申请一些内存，用于将数据区的地址对齐 */
+	block = malloc( sizeof( FrameArenaBlockRec ) + size + 31 );
+	if( !block ) {
+		return NULL;
+	}
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	block->data = (uchar_t*)FRAME_ARENA_ALIGN( (size_t)(block + 1) );
+	stack->capacity += size;
+	stack->heap_allocs += 1;
+	return block;
+}
+
+static void FrameArena_FreeBlocks( FrameArenaStack stack )
+{
+	FrameArenaBlock block, next;
+	for( block = stack->blocks; block; block = next ) {
+		next = block->next;
+		free( block );
+	}
+	for( block = stack->spare; block; block = next ) {
+		next = block->next;
+		free( block );
+	}
+	stack->blocks = NULL;
+	stack->spare = NULL;
+	stack->capacity = 0;
+}
+
+/** 获取当前线程的内存栈，没有的话就创建一个 */
+static FrameArenaStack FrameArena_GetStack( void )
+{
+	int i;
+	FrameArenaStack stack = NULL, *stacks;
+	LCUI_Thread tid = LCUIThread_SelfID();
+
+	LCUIMutex_Lock( &frame_arena.mutex );
+	for( i = 0; i < frame_arena.n_stacks; ++i ) {
+		if( frame_arena.stacks[i]->tid == tid ) {
+			stack = frame_arena.stacks[i];
+			break;
+		}
+	}
+	if( !stack ) {
+		stacks = realloc( frame_arena.stacks, sizeof( FrameArenaStack ) *
+				  (frame_arena.n_stacks + 1) );
+		stack = calloc( 1, sizeof( FrameArenaStackRec ) );
+		if( stacks ) {
+			frame_arena.stacks = stacks;
+		}
+		if( stacks && stack ) {
+			stack->tid = tid;
+			stacks[frame_arena.n_stacks++] = stack;
+		} else if( stack ) {
+			free( stack );
+			stack = NULL;
+		}
+	}
+	LCUIMutex_Unlock( &frame_arena.mutex );
+	return stack;
+}
+
+/** 从内存栈中分配内存 */
+static uchar_t *FrameArena_Alloc( FrameArenaStack stack, size_t size )
+{
+	uchar_t *data;
+	FrameArenaBlock block = stack->blocks;
+	size = FRAME_ARENA_ALIGN( size );
+	if( !block || block->size - block->used < size ) {
+		/* 优先使用被回收的内存块 */
+		block = stack->spare;
+		if( block && block->size >= size ) {
+			stack->spare = block->next;
+		} else {
+			block = FrameArena_NewBlock( stack, max( size,
+						     FRAME_ARENA_BLOCK_SIZE ) );
+			if( !block ) {
+				return NULL;
+			}
+		}
+		block->used = 0;
+		block->next = stack->blocks;
+		stack->blocks = block;
+	}
+	data = block->data + block->used;
+	block->used += size;
+	stack->used += size;
+	stack->allocs += 1;
+	if( stack->used > stack->peak ) {
+		stack->peak = stack->used;
+	}
+	return data;
+}
+
+int Graph_CreateInFrame( LCUI_Graph *graph, int w, int h )
+{
+	size_t size;
+	FrameArenaStack stack;
+	if( !frame_arena.is_inited ) {
+		return Graph_Create( graph, w, h );
+	}
+	if( w > 10000 || h > 10000 ) {
+		_DEBUG_MSG( "graph size is too large!" );
+		abort();
+	}
+	Graph_Free( graph );
+	if( h <= 0 || w <= 0 ) {
+		return -1;
+	}
+	graph->bytes_per_pixel = get_pixel_size( graph->color_type );
+	graph->bytes_per_row = graph->bytes_per_pixel * w;
+	size = graph->bytes_per_row * h;
+	stack = FrameArena_GetStack();
+	if( stack ) {
+		graph->bytes = FrameArena_Alloc( stack, size );
+	}
+	if( !stack || !graph->bytes ) {
+		graph->w = 0;
+		graph->h = 0;
+		return -2;
+	}
+	memset( graph->bytes, 0, size );
+	graph->in_arena = TRUE;
+	graph->mem_size = size;
+	graph->w = w;
+	graph->h = h;
+	return 0;
+}
+
+void Graph_MarkFrameArena( LCUI_FrameArenaMark mark )
+{
+	FrameArenaStack stack = NULL;
+	if( frame_arena.is_inited ) {
+		stack = FrameArena_GetStack();
+	}
+	mark->stack = stack;
+	if( !stack ) {
+		return;
+	}
+	mark->block = stack->blocks;
+	mark->block_used = stack->blocks ? stack->blocks->used : 0;
+	mark->used = stack->used;
+}
+
+void Graph_ReleaseFrameArena( LCUI_FrameArenaMark mark )
+{
+	FrameArenaBlock block;
+	FrameArenaStack stack = mark->stack;
+	if( !stack ) {
+		return;
+	}
+	/* 标记之后才开始使用的内存块都已经空了，移到回收列表中 */
+	while( stack->blocks && stack->blocks != mark->block ) {
+		block = stack->blocks;
+		stack->blocks = block->next;
+		block->next = stack->spare;
+		stack->spare = block;
+	}
+	if( stack->blocks ) {
+		stack->blocks->used = mark->block_used;
+	}
+	stack->used = mark->used;
+}
+
+void Graph_InitFrameArena( void )
+{
+	if( frame_arena.is_inited ) {
+		return;
+	}
+	LCUIMutex_Init( &frame_arena.mutex );
+	memset( &frame_arena.last, 0, sizeof( frame_arena.last ) );
+	frame_arena.stacks = NULL;
+	frame_arena.n_stacks = 0;
+	frame_arena.is_inited = TRUE;
+}
+
+void Graph_FreeFrameArena( void )
+{
+	int i;
+	if( !frame_arena.is_inited ) {
+		return;
+	}
+	frame_arena.is_inited = FALSE;
+	for( i = 0; i < frame_arena.n_stacks; ++i ) {
+		FrameArena_FreeBlocks( frame_arena.stacks[i] );
+		free( frame_arena.stacks[i] );
+	}
+	free( frame_arena.stacks );
+	frame_arena.stacks = NULL;
+	frame_arena.n_stacks = 0;
+	LCUIMutex_Destroy( &frame_arena.mutex );
+}
+
+/** 重置内存栈，并按本帧和最近几帧的用量调整它的容量 */
+static void FrameArena_ResetStack( FrameArenaStack stack )
+{
+	int n_blocks = 0;
+	size_t size = stack->capacity;
+	FrameArenaBlock block, next;
+
+	/* 把回收的内存块放回去，一起处理 */
+	for( block = stack->spare; block; block = next ) {
+		next = block->next;
+		block->next = stack->blocks;
+		stack->blocks = block;
+	}
+	stack->spare = NULL;
+	for( block = stack->blocks; block; block = block->next ) {
+		block->used = 0;
+		++n_blocks;
+	}
+	if( stack->peak < stack->capacity / 2 ) {
+		stack->trim_size = max( stack->trim_size, stack->peak );
+		stack->trim_frames += 1;
+	} else {
+		stack->trim_size = 0;
+		stack->trim_frames = 0;
+	}
+	if( stack->trim_frames >= FRAME_ARENA_TRIM_FRAMES ) {
+		/* 最近几帧都只用了不到一半的容量，收缩到这几帧的峰值，如果
+		 * 一直没用过，例如所属的线程已经退出了，那就全部释放掉 */
+		size = stack->trim_size;
+		if( size > 0 ) {
+			size = max( size, FRAME_ARENA_BLOCK_SIZE );
+		}
+		stack->trim_size = 0;
+		stack->trim_frames = 0;
+	} else if( n_blocks > 1 ) {
+		/* 合并成一块刚好能容纳本帧峰值的内存块，下一帧就能在一块内
+		 * 存中分配完 */
+		size = max( stack->peak, FRAME_ARENA_BLOCK_SIZE );
+	}
+	if( n_blocks > 1 || size != stack->capacity ) {
+		FrameArena_FreeBlocks( stack );
+		if( size > 0 ) {
+			stack->blocks = FrameArena_NewBlock( stack, size );
+		}
+	}
+	stack->used = 0;
+	stack->peak = 0;
+	stack->allocs = 0;
+	stack->heap_allocs = 0;
+}
+
+void Graph_ResetFrameArena( void )
+{
+	int i;
+	FrameArenaStack stack;
+	LCUI_FrameArenaStatsRec stats;
+
+	if( !frame_arena.is_inited ) {
+		return;
+	}
+	memset( &stats, 0, sizeof( stats ) );
+	LCUIMutex_Lock( &frame_arena.mutex );
+	for( i = 0; i < frame_arena.n_stacks; ++i ) {
+		stack = frame_arena.stacks[i];
+		stats.allocs += stack->allocs;
+		stats.heap_allocs += stack->heap_allocs;
+		stats.used += stack->peak;
+		stats.capacity += stack->capacity;
+		FrameArena_ResetStack( stack );
+	}
+	frame_arena.last = stats;
+	LCUIMutex_Unlock( &frame_arena.mutex );
+}
+
+void Graph_GetFrameArenaStats( LCUI_FrameArenaStats stats )
+{
+	if( !frame_arena.is_inited ) {
+		memset( stats, 0, sizeof( *stats ) );
+		return;
+	}
+	LCUIMutex_Lock( &frame_arena.mutex );
+	*stats = frame_arena.last;
+	LCUIMutex_Unlock( &frame_arena.mutex );
+}
+
 int Graph_Quote( LCUI_Graph *self, LCUI_Graph *source, const LCUI_Rect *rect )
 {
 	LCUI_Rect quote_rect;
@@ -975,7 +2541,7 @@ int Graph_Zoom( const LCUI_Graph *graph, LCUI_Graph *buff,
 	if( Graph_Create( buff, width, height ) < 0 ) {
 		return -2;
 	}
-	if( graph->color_type == COLOR_TYPE_ARGB ) {
+	if( ColorType_HasAlpha( graph->color_type ) ) {
 		LCUI_ARGB *px_src, *px_des, *px_row_src;
 		for( y = 0; y < height; ++y ) {
 			src_y = y * scale_y;
@@ -1021,6 +2587,7 @@ int Graph_Cut( const LCUI_Graph *graph, LCUI_Rect rect,
 	}
 	switch( graph->color_type ) {
 	case COLOR_TYPE_ARGB8888:
+	case COLOR_TYPE_PARGB8888:
 		return Graph_CutARGB( graph, rect, buff );
 	case COLOR_TYPE_RGB888:
 		return Graph_CutRGB( graph, rect, buff );
@@ -1036,6 +2603,7 @@ int Graph_HorizFlip( const LCUI_Graph *graph, LCUI_Graph *buff )
 	case COLOR_TYPE_RGB888:
 		return Graph_HorizFlipRGB( graph, buff );
 	case COLOR_TYPE_ARGB8888:
+	case COLOR_TYPE_PARGB8888:
 		return Graph_HorizFlipARGB( graph, buff );
 	default:break;
 	}
@@ -1048,6 +2616,7 @@ int Graph_VertiFlip( const LCUI_Graph *graph, LCUI_Graph *buff )
 	case COLOR_TYPE_RGB888:
 		return Graph_VertiFlipRGB( graph, buff );
 	case COLOR_TYPE_ARGB8888:
+	case COLOR_TYPE_PARGB8888:
 		return Graph_VertiFlipARGB( graph, buff );
 	default:break;
 	}
@@ -1070,6 +2639,8 @@ int Graph_FillRect( LCUI_Graph *graph, LCUI_Color color,
 		return Graph_FillRectRGB( graph, color, rect2 );
 	case COLOR_TYPE_ARGB8888:
 		return Graph_FillRectARGB( graph, color, rect2, with_alpha );
+	case COLOR_TYPE_PARGB8888:
+		return Graph_FillRectPARGB( graph, color, rect2, with_alpha );
 	default:break;
 	}
 	return -1;
@@ -1090,6 +2661,24 @@ int Graph_FillAlpha( LCUI_Graph *graph, uchar_t alpha )
 		return -2;
 	}
 	pixel_row = graph->argb + rect.y*graph->w + rect.x;
+	if( graph->color_type == COLOR_TYPE_PARGB ) {
+		/* 先还原成非预乘 alpha 的颜色，再按新的 alpha 值预乘 */
+		for( y = 0; y < rect.height; ++y ) {
+			Pixels_PARGBFormatToARGB( (uchar_t*)pixel_row,
+						  (uchar_t*)pixel_row,
+						  rect.width );
+			pixel = pixel_row;
+			for( x = 0; x < rect.width; ++x ) {
+				pixel->alpha = alpha;
+				++pixel;
+			}
+			Pixels_ARGBFormatToPARGB( (uchar_t*)pixel_row,
+						  (uchar_t*)pixel_row,
+						  rect.width );
+			pixel_row += graph->w;
+		}
+		return 0;
+	}
 	for( y = 0; y < rect.height; ++y ) {
 		pixel = pixel_row;
 		for( x = 0; x < rect.width; ++x ) {
@@ -1154,6 +2743,9 @@ int Graph_Mix( LCUI_Graph *back, const LCUI_Graph *fore,
 	/* 获取引用的源图像 */
 	fore = Graph_GetQuote( fore );
 	back = Graph_GetQuote( back );
+	if( !blend_kernel.ready ) {
+		Graph_InitBlendKernel();
+	}
 	switch( fore->color_type ) {
 	case COLOR_TYPE_RGB888:
 		if( back->color_type == COLOR_TYPE_RGB888 ) {
@@ -1165,6 +2757,8 @@ int Graph_Mix( LCUI_Graph *back, const LCUI_Graph *fore,
 	case COLOR_TYPE_ARGB8888:
 		if( back->color_type == COLOR_TYPE_RGB888 ) {
 			mixer = Graph_RGBMixARGB;
+		} else if( back->color_type == COLOR_TYPE_PARGB8888 ) {
+			mixer = Graph_PARGBMixARGB;
 		} else {
 			if( with_alpha ) {
 				mixer = Graph_ARGBMixARGB;
@@ -1172,6 +2766,19 @@ int Graph_Mix( LCUI_Graph *back, const LCUI_Graph *fore,
 				mixer = Graph_ARGBMixARGB2;
 			}
 		}
+		break;
+	case COLOR_TYPE_PARGB8888:
+		if( back->color_type == COLOR_TYPE_RGB888 ) {
+			mixer = Graph_RGBMixPARGB;
+		} else if( back->color_type == COLOR_TYPE_PARGB8888 ) {
+			mixer = Graph_PARGBMixPARGB;
+		} else {
+			if( with_alpha ) {
+				mixer = Graph_ARGBMixPARGB;
+			} else {
+				mixer = Graph_ARGBMixPARGB2;
+			}
+		}
 	default:break;
 	}
 	if( mixer ) {
@@ -1204,12 +2811,26 @@ int Graph_Replace( LCUI_Graph *back, const LCUI_Graph *fore, int left, int top )
 	top = read_rect.y;
 	fore = Graph_GetQuote( fore );
 	back = Graph_GetQuote( back );
+	if( back->color_type == COLOR_TYPE_PARGB8888 ) {
+		Graph_PARGBReplace( back, write_rect, fore, left, top );
+		return 0;
+	}
 	switch( fore->color_type ) {
 	case COLOR_TYPE_RGB888:
 		Graph_RGBReplaceRGB( back, write_rect, fore, left, top );
 		break;
 	case COLOR_TYPE_ARGB8888:
 		Graph_ARGBReplaceARGB( back, write_rect, fore, left, top );
+		break;
+	case COLOR_TYPE_PARGB8888:
+		if( back->color_type == COLOR_TYPE_ARGB8888 ) {
+			Graph_ARGBReplacePARGB( back, write_rect,
+						fore, left, top );
+		} else if( back->color_type == COLOR_TYPE_RGB888 ) {
+			/* 图层缓存可能会直接覆盖到 RGB 格式的屏幕上 */
+			Graph_ARGBReplaceRGB( back, write_rect,
+					      fore, left, top );
+		}
 	default:break;
 	}
 	return -1;
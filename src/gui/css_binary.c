@@ -0,0 +1,857 @@
+﻿/* ***************************************************************************
+ * css_binary.c -- precompiled binary css format
+ *
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ *
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ *
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ *
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *
+ * The LCUI project is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ *
+ * You should have received a copy of the GPLv2 along with this file. It is
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/* ****************************************************************************
+ * css_binary.c -- 预编译的二进制样式数据
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ *
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ *
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ *
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/css_library.h>
+#include <LCUI/gui/css_parser.h>
+#include <LCUI/gui/css_binary.h>
+
+#if defined(LCUI_BUILD_IN_LINUX) && defined(HAVE_MUNMAP)
+#define USE_MMAP_CSS_FILE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/** 数据的标识，以小端字节序读取时为 "LCSS" */
+#define CSS_BINARY_MAGIC	0x5353434c
+/** 空字符串的编号 */
+#define CSS_BINARY_NONE		0xffffffff
+
+/**
+ * 数据头
+ * 除了字符串数据外，各个表都是由 32 位整数组成的定长记录数组，位置是相对于
+ * 数据起始处的字节偏移量，数据映射到内存中后不需要解析就能直接访问。
+ */
+typedef struct CSSBinaryHeaderRec_ {
+	uint32_t magic;			/**< 标识 */
+	uint32_t version;		/**< 格式版本 */
+	uint32_t size;			/**< 数据的总大小 */
+	uint32_t string_count;		/**< 字符串数量 */
+	uint32_t strings;		/**< 字符串偏移量表的位置 */
+	uint32_t rule_count;		/**< 样式规则数量 */
+	uint32_t rules;			/**< 样式规则表的位置 */
+	uint32_t node_count;		/**< 选择器结点数量 */
+	uint32_t nodes;			/**< 选择器结点表的位置 */
+	uint32_t name_count;		/**< 类名和状态名的数量 */
+	uint32_t names;			/**< 类名和状态名的字符串编号表的位置 */
+	uint32_t style_count;		/**< 样式属性数量 */
+	uint32_t styles;		/**< 样式属性表的位置 */
+} CSSBinaryHeaderRec, *CSSBinaryHeader;
+
+/**
+ * 样式规则，由一个选择器和作用于它的样式表组成
+ * 规则是按照在 CSS 代码中的先后顺序保存的，不需要另外记录批次号
+ */
+typedef struct CSSBinaryRuleRec_ {
+	uint32_t space;			/**< 所属空间的字符串编号 */
+	uint32_t rank;			/**< 选择器的权值 */
+	uint32_t node;			/**< 第一个选择器结点的编号 */
+	uint32_t node_count;		/**< 选择器结点数量 */
+	uint32_t style;			/**< 第一个样式属性的编号 */
+	uint32_t style_count;		/**< 样式属性数量 */
+} CSSBinaryRuleRec, *CSSBinaryRule;
+
+/** 选择器结点 */
+typedef struct CSSBinaryNodeRec_ {
+	uint32_t id;			/**< ID 的字符串编号 */
+	uint32_t type;			/**< 类型名称的字符串编号 */
+	uint32_t name;			/**< 第一个类名在名称表中的位置 */
+	uint32_t class_count;		/**< 类名数量 */
+	uint32_t status_count;		/**< 状态名数量，状态名紧跟在类名后面 */
+	uint32_t rank;			/**< 结点的权值 */
+} CSSBinaryNodeRec, *CSSBinaryNode;
+
+/**
+ * 样式属性
+ * 属性的标识码和样式值是在运行时注册的，可能与编译时的不同，所以属性名和
+ * 样式值都以名称的字符串编号保存，载入时再转换回来。
+ */
+typedef struct CSSBinaryStyleRec_ {
+	uint32_t key;			/**< 属性名的字符串编号 */
+	uint32_t type;			/**< 值的类型 */
+	uint32_t value;			/**< 值，浮点数以二进制位保存 */
+} CSSBinaryStyleRec, *CSSBinaryStyle;
+
+/** 可增长的缓存 */
+typedef struct CSSBinaryBufferRec_ {
+	char *data;
+	size_t length;
+	size_t size;
+} CSSBinaryBufferRec, *CSSBinaryBuffer;
+
+typedef struct LCUI_CSSCompilerRec_ {
+	Dict *string_ids;		/**< 字符串编号表，以字符串索引 */
+	CSSBinaryBufferRec string_data;	/**< 字符串数据 */
+	CSSBinaryBufferRec strings;	/**< 字符串在字符串数据中的偏移量 */
+	CSSBinaryBufferRec rules;	/**< 样式规则 */
+	CSSBinaryBufferRec nodes;	/**< 选择器结点 */
+	CSSBinaryBufferRec names;	/**< 类名和状态名 */
+	CSSBinaryBufferRec styles;	/**< 样式属性 */
+	size_t rule_count;		/**< 样式规则数量 */
+} LCUI_CSSCompilerRec;
+
+#define BufferCount(BUF, TYPE) (uint32_t)((BUF)->length / sizeof( TYPE ))
+
+/** 从缓存中分配一段空间，返回的指针在下次分配前有效 */
+static void *CSSBinaryBuffer_Alloc( CSSBinaryBuffer buf, size_t len )
+{
+	char *data;
+	size_t size = buf->size > 0 ? buf->size : 256;
+
+	while( buf->length + len > size ) {
+		size *= 2;
+	}
+	if( size != buf->size ) {
+		data = realloc( buf->data, size );
+		if( !data ) {
+			return NULL;
+		}
+		buf->data = data;
+		buf->size = size;
+	}
+	data = buf->data + buf->length;
+	buf->length += len;
+	memset( data, 0, len );
+	return data;
+}
+
+static void CSSBinaryBuffer_Destroy( CSSBinaryBuffer buf )
+{
+	if( buf->data ) {
+		free( buf->data );
+	}
+	buf->data = NULL;
+	buf->length = 0;
+	buf->size = 0;
+}
+
+static void OnDeleteStringId( void *privdata, void *val )
+{
+	free( val );
+}
+
+LCUI_CSSCompiler CSSCompiler( void )
+{
+	static DictType dicttype;
+	LCUI_CSSCompiler compiler = NEW( LCUI_CSSCompilerRec, 1 );
+	if( !compiler ) {
+		return NULL;
+	}
+	dicttype = DictType_StringCopyKey;
+	dicttype.valDestructor = OnDeleteStringId;
+	compiler->string_ids = Dict_Create( &dicttype, NULL );
+	return compiler;
+}
+
+void CSSCompiler_Delete( LCUI_CSSCompiler compiler )
+{
+	Dict_Release( compiler->string_ids );
+	CSSBinaryBuffer_Destroy( &compiler->string_data );
+	CSSBinaryBuffer_Destroy( &compiler->strings );
+	CSSBinaryBuffer_Destroy( &compiler->rules );
+	CSSBinaryBuffer_Destroy( &compiler->nodes );
+	CSSBinaryBuffer_Destroy( &compiler->names );
+	CSSBinaryBuffer_Destroy( &compiler->styles );
+	free( compiler );
+}
+
+/** 获取字符串的编号，相同的字符串只保存一份 */
+static uint32_t CSSCompiler_GetStringId( LCUI_CSSCompiler compiler,
+					 const char *str )
+{
+	size_t len;
+	char *data;
+	uint32_t *id, *offset;
+
+	if( !str ) {
+		return CSS_BINARY_NONE;
+	}
+	id = Dict_FetchValue( compiler->string_ids, str );
+	if( id ) {
+		return *id;
+	}
+	len = strlen( str ) + 1;
+	id = malloc( sizeof( uint32_t ) );
+	data = CSSBinaryBuffer_Alloc( &compiler->string_data, len );
+	offset = CSSBinaryBuffer_Alloc( &compiler->strings,
+					sizeof( uint32_t ) );
+	if( !id || !data || !offset ) {
+		free( id );
+		return CSS_BINARY_NONE;
+	}
+	memcpy( data, str, len );
+	*offset = (uint32_t)(data - compiler->string_data.data);
+	*id = BufferCount( &compiler->strings, uint32_t ) - 1;
+	Dict_Add( compiler->string_ids, (void*)str, id );
+	return *id;
+}
+
+static uint32_t CSSCompiler_GetAtomId( LCUI_CSSCompiler compiler,
+				       LCUI_Atom atom )
+{
+	if( !atom ) {
+		return CSS_BINARY_NONE;
+	}
+	return CSSCompiler_GetStringId( compiler, LCUIAtom_GetName( atom ) );
+}
+
+static int CSSCompiler_AddNames( LCUI_CSSCompiler compiler,
+				 const LCUI_Atom *atoms )
+{
+	int i;
+	uint32_t id, *name;
+
+	for( i = 0; atoms && atoms[i]; ++i ) {
+		id = CSSCompiler_GetAtomId( compiler, atoms[i] );
+		name = CSSBinaryBuffer_Alloc( &compiler->names,
+					      sizeof( uint32_t ) );
+		if( !name ) {
+			return -ENOMEM;
+		}
+		*name = id;
+	}
+	return 0;
+}
+
+static int CSSCompiler_AddNode( LCUI_CSSCompiler compiler,
+				LCUI_SelectorNode sn )
+{
+	CSSBinaryNode p;
+	CSSBinaryNodeRec node;
+
+	node.id = CSSCompiler_GetAtomId( compiler, sn->id );
+	node.type = CSSCompiler_GetAtomId( compiler, sn->type );
+	node.name = BufferCount( &compiler->names, uint32_t );
+	node.class_count = AtomList_Length( sn->classes );
+	node.status_count = AtomList_Length( sn->status );
+	node.rank = sn->rank;
+	if( CSSCompiler_AddNames( compiler, sn->classes ) != 0 ||
+	    CSSCompiler_AddNames( compiler, sn->status ) != 0 ) {
+		return -ENOMEM;
+	}
+	p = CSSBinaryBuffer_Alloc( &compiler->nodes, sizeof( node ) );
+	if( !p ) {
+		return -ENOMEM;
+	}
+	*p = node;
+	return 0;
+}
+
+/** 添加样式属性，图像等只存在于运行时的数据不会被保存 */
+static int CSSCompiler_AddStyle( LCUI_CSSCompiler compiler,
+				 int key, LCUI_Style s )
+{
+	const char *name;
+	CSSBinaryStyle p;
+	CSSBinaryStyleRec style;
+
+	name = LCUI_GetStyleName( key );
+	if( !name ) {
+		return -1;
+	}
+	style.type = s->type;
+	switch( s->type ) {
+	case SVT_SCALE:
+	case SVT_PX:
+	case SVT_PT:
+	case SVT_DP:
+		memcpy( &style.value, &s->val_px, sizeof( float ) );
+		break;
+	case SVT_COLOR:
+		style.value = (uint32_t)s->val_color.value;
+		break;
+	case SVT_STYLE:
+		style.value = CSSCompiler_GetStringId( compiler,
+			LCUI_GetStyleValueName( s->val_style ) );
+		if( style.value == CSS_BINARY_NONE ) {
+			return -1;
+		}
+		break;
+	case SVT_STRING:
+		style.value = CSSCompiler_GetStringId( compiler,
+						       s->val_string );
+		if( style.value == CSS_BINARY_NONE ) {
+			return -1;
+		}
+		break;
+	case SVT_NONE:
+	case SVT_AUTO:
+	case SVT_VALUE:
+	case SVT_BOOL:
+		style.value = (uint32_t)s->val_int;
+		break;
+	default: return -1;
+	}
+	style.key = CSSCompiler_GetStringId( compiler, name );
+	p = CSSBinaryBuffer_Alloc( &compiler->styles, sizeof( style ) );
+	if( !p ) {
+		return -ENOMEM;
+	}
+	*p = style;
+	return 0;
+}
+
+static void CSSCompiler_OnRule( LCUI_Selector s, LCUI_StyleSheet ss,
+				const char *space, void *data )
+{
+	int i, key;
+	CSSBinaryRule p;
+	CSSBinaryRuleRec rule;
+	LCUI_CSSCompiler compiler = data;
+
+	rule.space = CSSCompiler_GetStringId( compiler, space );
+	rule.rank = s->rank;
+	rule.node = BufferCount( &compiler->nodes, CSSBinaryNodeRec );
+	rule.node_count = s->length;
+	rule.style = BufferCount( &compiler->styles, CSSBinaryStyleRec );
+	rule.style_count = 0;
+	for( i = 0; i < s->length; ++i ) {
+		if( CSSCompiler_AddNode( compiler, s->nodes[i] ) != 0 ) {
+			return;
+		}
+	}
+	for( key = 0; key < ss->length; ++key ) {
+		if( !ss->sheet[key].is_valid ) {
+			continue;
+		}
+		if( CSSCompiler_AddStyle( compiler, key,
+					  &ss->sheet[key] ) == 0 ) {
+			rule.style_count += 1;
+		}
+	}
+	p = CSSBinaryBuffer_Alloc( &compiler->rules, sizeof( rule ) );
+	if( p ) {
+		*p = rule;
+		compiler->rule_count += 1;
+	}
+}
+
+int CSSCompiler_AddFile( LCUI_CSSCompiler compiler, const char *filepath )
+{
+	return LCUI_ParseCSSFile( filepath, CSSCompiler_OnRule, compiler );
+}
+
+int CSSCompiler_AddString( LCUI_CSSCompiler compiler,
+			   const char *str, const char *space )
+{
+	return LCUI_ParseCSSString( str, space, CSSCompiler_OnRule, compiler );
+}
+
+size_t CSSCompiler_GetRuleCount( LCUI_CSSCompiler compiler )
+{
+	return compiler->rule_count;
+}
+
+void *CSSCompiler_Build( LCUI_CSSCompiler compiler, size_t *size )
+{
+	char *data;
+	size_t i, offset;
+	uint32_t *strings;
+	CSSBinaryHeaderRec header;
+
+	header.magic = CSS_BINARY_MAGIC;
+	header.version = LCUI_CSS_BINARY_VERSION;
+	header.string_count = BufferCount( &compiler->strings, uint32_t );
+	header.rule_count = BufferCount( &compiler->rules, CSSBinaryRuleRec );
+	header.node_count = BufferCount( &compiler->nodes, CSSBinaryNodeRec );
+	header.name_count = BufferCount( &compiler->names, uint32_t );
+	header.style_count = BufferCount( &compiler->styles,
+					  CSSBinaryStyleRec );
+	offset = sizeof( header );
+	header.strings = (uint32_t)offset;
+	offset += compiler->strings.length;
+	header.rules = (uint32_t)offset;
+	offset += compiler->rules.length;
+	header.nodes = (uint32_t)offset;
+	offset += compiler->nodes.length;
+	header.names = (uint32_t)offset;
+	offset += compiler->names.length;
+	header.styles = (uint32_t)offset;
+	offset += compiler->styles.length;
+	/* 字符串数据放在最后，并以 0 结尾，方便载入时检查 */
+	*size = offset + compiler->string_data.length + 1;
+	if( *size > CSS_BINARY_NONE ) {
+		return NULL;
+	}
+	header.size = (uint32_t)*size;
+	data = malloc( *size );
+	if( !data ) {
+		return NULL;
+	}
+	memcpy( data, &header, sizeof( header ) );
+	strings = (uint32_t*)(data + header.strings);
+	for( i = 0; i < header.string_count; ++i ) {
+		strings[i] = ((uint32_t*)compiler->strings.data)[i];
+		strings[i] += (uint32_t)offset;
+	}
+	if( compiler->rules.length > 0 ) {
+		memcpy( data + header.rules, compiler->rules.data,
+			compiler->rules.length );
+	}
+	if( compiler->nodes.length > 0 ) {
+		memcpy( data + header.nodes, compiler->nodes.data,
+			compiler->nodes.length );
+	}
+	if( compiler->names.length > 0 ) {
+		memcpy( data + header.names, compiler->names.data,
+			compiler->names.length );
+	}
+	if( compiler->styles.length > 0 ) {
+		memcpy( data + header.styles, compiler->styles.data,
+			compiler->styles.length );
+	}
+	if( compiler->string_data.length > 0 ) {
+		memcpy( data + offset, compiler->string_data.data,
+			compiler->string_data.length );
+	}
+	data[*size - 1] = 0;
+	return data;
+}
+
+int CSSCompiler_Save( LCUI_CSSCompiler compiler, const char *filepath )
+{
+	FILE *fp;
+	void *data;
+	size_t size, n;
+
+	data = CSSCompiler_Build( compiler, &size );
+	if( !data ) {
+		return -ENOMEM;
+	}
+	fp = fopen( filepath, "wb" );
+	if( !fp ) {
+		free( data );
+		return -1;
+	}
+	n = fwrite( data, 1, size, fp );
+	fclose( fp );
+	free( data );
+	return n == size ? 0 : -1;
+}
+
+/** 检查表的位置和大小是否在数据范围内 */
+static LCUI_BOOL CSSBinary_CheckTable( const CSSBinaryHeaderRec *header,
+				       uint32_t offset, uint32_t count,
+				       size_t record_size )
+{
+	if( offset % sizeof( uint32_t ) != 0 || offset > header->size ) {
+		return FALSE;
+	}
+	return count <= (header->size - offset) / record_size;
+}
+
+static LCUI_BOOL CSSBinary_CheckRange( uint32_t start, uint32_t count,
+				       uint32_t total )
+{
+	return start <= total && count <= total - start;
+}
+
+/** 检查数据头和各个表，通过检查后，载入时只需要检查编号是否越界 */
+static LCUI_BOOL CSSBinary_Check( const char *data, size_t size )
+{
+	uint32_t i;
+	const uint32_t *strings;
+	const CSSBinaryHeaderRec *header = (const void*)data;
+
+	if( size < sizeof( CSSBinaryHeaderRec ) ||
+	    header->magic != CSS_BINARY_MAGIC ||
+	    header->version != LCUI_CSS_BINARY_VERSION ||
+	    header->size > size || header->size < sizeof( *header ) ) {
+		return FALSE;
+	}
+	if( !CSSBinary_CheckTable( header, header->strings,
+				   header->string_count,
+				   sizeof( uint32_t ) ) ||
+	    !CSSBinary_CheckTable( header, header->rules, header->rule_count,
+				   sizeof( CSSBinaryRuleRec ) ) ||
+	    !CSSBinary_CheckTable( header, header->nodes, header->node_count,
+				   sizeof( CSSBinaryNodeRec ) ) ||
+	    !CSSBinary_CheckTable( header, header->names, header->name_count,
+				   sizeof( uint32_t ) ) ||
+	    !CSSBinary_CheckTable( header, header->styles,
+				   header->style_count,
+				   sizeof( CSSBinaryStyleRec ) ) ) {
+		return FALSE;
+	}
+	/* 数据以 0 结尾，所以偏移量不越界的字符串都是以 0 结尾的 */
+	if( data[header->size - 1] != 0 ) {
+		return FALSE;
+	}
+	strings = (const uint32_t*)(data + header->strings);
+	for( i = 0; i < header->string_count; ++i ) {
+		if( strings[i] >= header->size ) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** 二进制数据的载入器 */
+typedef struct CSSBinaryLoaderRec_ {
+	const char *data;
+	const CSSBinaryHeaderRec *header;
+	const uint32_t *strings;
+	const uint32_t *names;
+	const CSSBinaryNodeRec *nodes;
+	const CSSBinaryStyleRec *styles;
+	int *keys;			/**< 字符串编号对应的属性标识码 */
+} CSSBinaryLoaderRec, *CSSBinaryLoader;
+
+static const char *CSSBinaryLoader_GetString( CSSBinaryLoader loader,
+					      uint32_t id )
+{
+	if( id >= loader->header->string_count ) {
+		return NULL;
+	}
+	return loader->data + loader->strings[id];
+}
+
+/**
+ * 将名称的字符串编号转换为原子
+ * @returns 成功返回 0，编号无效或无法分配原子时返回 -1
+ */
+static int CSSBinaryLoader_GetAtom( CSSBinaryLoader loader,
+				    uint32_t id, LCUI_Atom *atom )
+{
+	const char *name;
+
+	*atom = 0;
+	if( id == CSS_BINARY_NONE ) {
+		return 0;
+	}
+	name = CSSBinaryLoader_GetString( loader, id );
+	if( !name ) {
+		return -1;
+	}
+	*atom = LCUIAtom_Get( name );
+	return *atom ? 0 : -1;
+}
+
+/** 将一组名称的字符串编号转换为原子并添加到列表中 */
+static int CSSBinaryLoader_GetAtomList( CSSBinaryLoader loader,
+					const uint32_t *names, uint32_t count,
+					LCUI_Atom **list )
+{
+	uint32_t i;
+	LCUI_Atom atom;
+
+	for( i = 0; i < count; ++i ) {
+		if( CSSBinaryLoader_GetAtom( loader, names[i], &atom ) != 0 ||
+		    !atom ) {
+			return -1;
+		}
+		AtomList_Add( list, atom );
+	}
+	return 0;
+}
+
+/** 将属性名的字符串编号转换为属性标识码，结果会被缓存 */
+static int CSSBinaryLoader_GetKey( CSSBinaryLoader loader, uint32_t id )
+{
+	const char *name, *keyname;
+	int key, total = LCUI_GetStyleTotal();
+
+	if( id >= loader->header->string_count ) {
+		return -1;
+	}
+	if( loader->keys[id] != -2 ) {
+		return loader->keys[id];
+	}
+	loader->keys[id] = -1;
+	name = CSSBinaryLoader_GetString( loader, id );
+	for( key = 0; key < total; ++key ) {
+		keyname = LCUI_GetStyleName( key );
+		if( keyname && strcmp( keyname, name ) == 0 ) {
+			loader->keys[id] = key;
+			break;
+		}
+	}
+	return loader->keys[id];
+}
+
+static LCUI_SelectorNode CSSBinaryLoader_LoadNode( CSSBinaryLoader loader,
+						   const CSSBinaryNodeRec *n )
+{
+	LCUI_SelectorNode sn;
+	const uint32_t *names;
+
+	if( !CSSBinary_CheckRange( n->name, n->class_count,
+				   loader->header->name_count ) ||
+	    !CSSBinary_CheckRange( n->name + n->class_count, n->status_count,
+				   loader->header->name_count ) ) {
+		return NULL;
+	}
+	sn = NEW( LCUI_SelectorNodeRec, 1 );
+	if( !sn ) {
+		return NULL;
+	}
+	names = loader->names + n->name;
+	/* 缺少名称的结点会匹配到更多部件，所以不能载入 */
+	if( CSSBinaryLoader_GetAtom( loader, n->id, &sn->id ) != 0 ||
+	    CSSBinaryLoader_GetAtom( loader, n->type, &sn->type ) != 0 ||
+	    CSSBinaryLoader_GetAtomList( loader, names, n->class_count,
+					 &sn->classes ) != 0 ||
+	    CSSBinaryLoader_GetAtomList( loader, names + n->class_count,
+					 n->status_count, &sn->status ) != 0 ) {
+		SelectorNode_Delete( sn );
+		return NULL;
+	}
+	SelectorNode_Update( sn );
+	if( !sn->fullname ) {
+		SelectorNode_Delete( sn );
+		return NULL;
+	}
+	sn->rank = n->rank;
+	return sn;
+}
+
+/**
+ * 根据记录创建选择器
+ * 批次号由 Selector() 分配，规则是按先后顺序保存和载入的，所以载入后的相对
+ * 顺序与编译时的一致。
+ */
+static LCUI_Selector CSSBinaryLoader_LoadSelector( CSSBinaryLoader loader,
+						   const CSSBinaryRuleRec *rule )
+{
+	uint32_t i;
+	LCUI_Selector s;
+	LCUI_SelectorNode sn;
+
+	if( rule->node_count < 1 || rule->node_count >= MAX_SELECTOR_DEPTH ||
+	    !CSSBinary_CheckRange( rule->node, rule->node_count,
+				   loader->header->node_count ) ) {
+		return NULL;
+	}
+	s = Selector( NULL );
+	for( i = 0; i < rule->node_count; ++i ) {
+		sn = CSSBinaryLoader_LoadNode( loader,
+					       &loader->nodes[rule->node + i] );
+		if( !sn ) {
+			Selector_Delete( s );
+			return NULL;
+		}
+		s->nodes[i] = sn;
+		s->length = i + 1;
+	}
+	s->nodes[s->length] = NULL;
+	s->rank = rule->rank;
+	Selector_Update( s );
+	return s;
+}
+
+static LCUI_StyleSheet CSSBinaryLoader_LoadStyleSheet( CSSBinaryLoader loader,
+						       const CSSBinaryRuleRec *rule )
+{
+	int key;
+	uint32_t i;
+	LCUI_Style s;
+	const char *str;
+	LCUI_StyleSheet ss;
+	const CSSBinaryStyleRec *style;
+
+	if( !CSSBinary_CheckRange( rule->style, rule->style_count,
+				   loader->header->style_count ) ) {
+		return NULL;
+	}
+	ss = StyleSheet();
+	for( i = 0; i < rule->style_count; ++i ) {
+		style = &loader->styles[rule->style + i];
+		key = CSSBinaryLoader_GetKey( loader, style->key );
+		if( key < 0 || key >= ss->length ) {
+			continue;
+		}
+		s = &ss->sheet[key];
+		switch( style->type ) {
+		case SVT_SCALE:
+		case SVT_PX:
+		case SVT_PT:
+		case SVT_DP:
+			memcpy( &s->val_px, &style->value, sizeof( float ) );
+			break;
+		case SVT_COLOR:
+			s->val_color.value = (int32_t)style->value;
+			break;
+		case SVT_STYLE:
+			str = CSSBinaryLoader_GetString( loader, style->value );
+			s->val_style = str ? LCUI_GetStyleValue( str ) : -1;
+			if( s->val_style < 0 ) {
+				continue;
+			}
+			break;
+		case SVT_STRING:
+			str = CSSBinaryLoader_GetString( loader, style->value );
+			if( !str ) {
+				continue;
+			}
+			if( s->is_valid && s->type == SVT_STRING ) {
+				free( s->val_string );
+			}
+			s->val_string = strdup( str );
+			break;
+		case SVT_NONE:
+		case SVT_AUTO:
+		case SVT_VALUE:
+		case SVT_BOOL:
+			s->val_int = (int32_t)style->value;
+			break;
+		default: continue;
+		}
+		s->type = style->type;
+		s->is_valid = TRUE;
+	}
+	return ss;
+}
+
+static int CSSBinary_Load( const char *data, size_t size )
+{
+	uint32_t i;
+	int count = 0;
+	LCUI_Selector s;
+	LCUI_StyleSheet ss;
+	CSSBinaryLoaderRec loader;
+	const CSSBinaryRuleRec *rules, *rule;
+
+	if( !CSSBinary_Check( data, size ) ) {
+		return -1;
+	}
+	loader.data = data;
+	loader.header = (const void*)data;
+	loader.strings = (const void*)(data + loader.header->strings);
+	loader.names = (const void*)(data + loader.header->names);
+	loader.nodes = (const void*)(data + loader.header->nodes);
+	loader.styles = (const void*)(data + loader.header->styles);
+	loader.keys = malloc( sizeof( int ) *
+			      (loader.header->string_count + 1) );
+	if( !loader.keys ) {
+		return -ENOMEM;
+	}
+	for( i = 0; i < loader.header->string_count; ++i ) {
+		loader.keys[i] = -2;
+	}
+	rules = (const void*)(data + loader.header->rules);
+	for( i = 0; i < loader.header->rule_count; ++i ) {
+		rule = &rules[i];
+		s = CSSBinaryLoader_LoadSelector( &loader, rule );
+		if( !s ) {
+			continue;
+		}
+		ss = CSSBinaryLoader_LoadStyleSheet( &loader, rule );
+		if( ss ) {
+			LCUI_PutStyleSheet( s, ss, CSSBinaryLoader_GetString(
+					    &loader, rule->space ) );
+			StyleSheet_Delete( ss );
+			count += 1;
+		}
+		Selector_Delete( s );
+	}
+	free( loader.keys );
+	return count;
+}
+
+int LCUI_LoadCSSBinary( const void *data, size_t size )
+{
+	int ret;
+	void *buf;
+
+	/* 记录是按 32 位整数访问的，未对齐的数据需要先复制一份 */
+	if( (size_t)data % sizeof( uint32_t ) == 0 ) {
+		return CSSBinary_Load( data, size );
+	}
+	buf = malloc( size );
+	if( !buf ) {
+		return -ENOMEM;
+	}
+	memcpy( buf, data, size );
+	ret = CSSBinary_Load( buf, size );
+	free( buf );
+	return ret;
+}
+
+int LCUI_LoadCSSBinaryFile( const char *filepath )
+{
+	int ret;
+	FILE *fp;
+	long size;
+	void *data;
+#ifdef USE_MMAP_CSS_FILE
+	int fd;
+	struct stat st;
+
+	/* 直接映射文件内容，数据不需要解析，映射后就能使用 */
+	fd = open( filepath, O_RDONLY );
+	if( fd < 0 ) {
+		return -1;
+	}
+	if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) &&
+	    st.st_size > 0 ) {
+		data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data != MAP_FAILED ) {
+			close( fd );
+			ret = CSSBinary_Load( data, st.st_size );
+			munmap( data, st.st_size );
+			return ret;
+		}
+	}
+	close( fd );
+#endif
+	fp = fopen( filepath, "rb" );
+	if( !fp ) {
+		return -1;
+	}
+	fseek( fp, 0, SEEK_END );
+	size = ftell( fp );
+	fseek( fp, 0, SEEK_SET );
+	data = size > 0 ? malloc( size ) : NULL;
+	if( !data || fread( data, 1, size, fp ) != (size_t)size ) {
+		fclose( fp );
+		free( data );
+		return -1;
+	}
+	fclose( fp );
+	ret = CSSBinary_Load( data, size );
+	free( data );
+	return ret;
+}
@@ -50,6 +50,13 @@
 #define MAX_NAME_LEN	256
 #define LEN(A)		sizeof( A ) / sizeof( *A )
 
+/** 祖先结点布隆过滤器的位数 */
+#define SELECTOR_BLOOM_BITS	512
+#define SELECTOR_BLOOM_WORDS	(SELECTOR_BLOOM_BITS / 32)
+
+/** 样式表缓存占用内存的默认上限 */
+#define DEFAULT_STYLE_CACHE_SIZE	(2 * 1024 * 1024)
+
 enum SelectorRank {
 	GENERAL_RANK = 0,
 	TYPE_RANK = 1,
@@ -69,6 +76,44 @@ enum SelectorFinderLevel {
 	LEVEL_TOTAL_NUM
 };
 
+/** 选择器结点的匹配指令类型 */
+enum SelectorMatchOpType {
+	MATCH_TYPE,
+	MATCH_ID,
+	MATCH_CLASS,
+	MATCH_STATUS
+};
+
+/** 匹配指令，要求目标结点拥有指定类型和名称的属性 */
+typedef struct SelectorMatchOpRec_ {
+	int type;			/**< 指令类型 */
+	LCUI_Atom atom;			/**< 名称的原子 */
+} SelectorMatchOpRec, *SelectorMatchOp;
+
+/**
+ * 匹配程序
+ * 由选择器结点编译而来，把 id、type、classes、status 展开成一组扁平的指令，
+ * 匹配时只需比较指令类型和原子
+ */
+typedef struct SelectorMatchProgRec_ {
+	int length;			/**< 指令数量 */
+	SelectorMatchOp ops;		/**< 指令列表 */
+} SelectorMatchProgRec, *SelectorMatchProg;
+
+/**
+ * 选择器匹配器
+ * 在一次样式表查找中使用，保存了目标选择器各个结点编译后的匹配程序，以及由
+ * 祖先结点的匹配指令哈希值构成的布隆过滤器。blooms[i] 记录的是第 0 至 i - 1 个
+ * 结点，父级链接的匹配程序中只要有一条指令的哈希值不在过滤器中，就说明这些
+ * 祖先结点都不可能与它匹配。
+ */
+typedef struct SelectorMatcherRec_ {
+	LCUI_Selector selector;			/**< 目标选择器 */
+	SelectorMatchOp ops;			/**< 所有结点的指令 */
+	SelectorMatchProgRec nodes[MAX_SELECTOR_DEPTH];	/**< 各个结点的匹配程序 */
+	uint32_t blooms[MAX_SELECTOR_DEPTH][SELECTOR_BLOOM_WORDS];
+} SelectorMatcherRec, *SelectorMatcher;
+
 /* 样式表查找器的上下文数据结构 */
 typedef struct NamesFinderRec_ {
 	int level;			/**< 当前选择器层级 */
@@ -84,8 +129,33 @@ typedef struct StyleLinkGroupRec_ {
 	Dict *links;			/**< 样式链接表 */
 	char *name;			/**< 选择器名称 */
 	LCUI_SelectorNodeRec snode;	/**< 选择器结点 */
+	SelectorMatchProgRec prog;	/**< 选择器结点的匹配程序 */
 } StyleLinkGroupRec, *StyleLinkGroup;
 
+/**
+ * 选择器依赖记录
+ * 记录一个类名或状态名在哪些位置被选择器用到，如果出现在祖先结点中，还会记录
+ * 这些选择器最右边的结点所在的组，用于判断哪些后代部件会受到它的影响
+ */
+typedef struct SelectorDependencyRec_ {
+	int flags;			/**< 由 SELECTOR_DEP_* 组成的标志 */
+	LinkedList subjects;		/**< 最右边结点所在的组 */
+} SelectorDependencyRec, *SelectorDependency;
+
+/**
+ * 样式表缓存记录
+ * 保存了一个选择器最终匹配到的样式表，以及用于判断新添加的样式表是否会影响它
+ * 的信息：最右边结点的匹配程序和由祖先结点构成的布隆过滤器
+ */
+typedef struct StyleSheetCacheRec_ {
+	unsigned int hash;		/**< 选择器的哈希值 */
+	size_t size;			/**< 占用的内存大小 */
+	LCUI_StyleSheet sheet;		/**< 样式表 */
+	SelectorMatchProgRec subject;	/**< 最右边结点的匹配程序 */
+	uint32_t ancestors[SELECTOR_BLOOM_WORDS];	/**< 祖先结点的过滤器 */
+	LinkedListNode node;		/**< 在 LRU 链表中的结点 */
+} StyleSheetCacheRec, *StyleSheetCache;
+
 /** 样式结点记录 */
 typedef struct StyleNodeRec_ {
 	int rank;		/**< 权值，决定优先级 */
@@ -101,6 +171,7 @@ typedef struct StyleLinkRec_ {
 	StyleLinkGroup group;	/**< 所属组 */
 	LinkedList styles;	/**< 作用于当前选择器的样式 */
 	Dict *parents;		/**< 父级节点 */
+	LinkedList parent_list;	/**< 父级节点列表，用于在查找时遍历 */
 } StyleLinkRec, *StyleLink;
 
 static struct {
@@ -108,10 +179,15 @@ static struct {
 	LCUI_Mutex mutex;		/**< 互斥锁 */
 	LinkedList groups;		/**< 样式组列表 */
 	Dict *cache;			/**< 样式表缓存，以选择器的 hash 值索引 */
+	LinkedList cache_lru;		/**< 样式表缓存，按最近使用的时间排列 */
+	LCUI_StyleCacheStatsRec cache_stats;	/**< 样式表缓存的统计数据 */
 	Dict *names;			/**< 样式属性名称表，以值的名称索引 */
 	Dict *value_keys;		/**< 样式属性值表，以值的名称索引 */
 	Dict *value_names;		/**< 样式属性值名称表，以值索引 */
+	Dict *dependencies;		/**< 选择器依赖表，以名称的种类和原子索引 */
 	size_t count;			/**< 当前记录的属性数量 */
+	unsigned int version;		/**< 版本号，每次添加样式表后递增 */
+	LCUI_Atom universal;		/**< 通用选择器 "*" 的原子 */
 } library;
 
 /** 样式字符串值与标识码 */
@@ -169,6 +245,13 @@ static KeyNameGroupRec style_name_map[] = {
 	{ key_box_shadow_blur, "box-shadow-blur" },
 	{ key_box_shadow_spread, "box-shadow-spread" },
 	{ key_box_shadow_color, "box-shadow-color" },
+	{ key_flex_grow, "flex-grow" },
+	{ key_flex_shrink, "flex-shrink" },
+	{ key_flex_basis, "flex-basis" },
+	{ key_flex_direction, "flex-direction" },
+	{ key_flex_wrap, "flex-wrap" },
+	{ key_justify_content, "justify-content" },
+	{ key_align_items, "align-items" },
 	{ key_pointer_events, "pointer-events" },
 	{ key_focusable, "focusable" },
 	{ key_box_sizing, "box-sizing" }
@@ -208,7 +291,16 @@ static KeyNameGroupRec style_value_map[] = {
 	{ SV_ABSOLUTE, "absolute" },
 	{ SV_BLOCK, "block" },
 	{ SV_INLINE_BLOCK, "inline-block" },
-	{ SV_NOWRAP, "nowrap" }
+	{ SV_NOWRAP, "nowrap" },
+	{ SV_FLEX, "flex" },
+	{ SV_ROW, "row" },
+	{ SV_COLUMN, "column" },
+	{ SV_WRAP, "wrap" },
+	{ SV_FLEX_START, "flex-start" },
+	{ SV_FLEX_END, "flex-end" },
+	{ SV_STRETCH, "stretch" },
+	{ SV_SPACE_BETWEEN, "space-between" },
+	{ SV_SPACE_AROUND, "space-around" }
 };
 
 static int LCUI_DirectAddStyleName( int key, const char *name )
@@ -308,50 +400,32 @@ int LCUI_GetStyleTotal( void )
 	return library.count;
 }
 
+/** 判断选择器结点是否有类型，通用选择器 "*" 不算 */
+static LCUI_BOOL SelectorNode_HasType( LCUI_SelectorNode node )
+{
+	return node->type && node->type != library.universal;
+}
+
 LCUI_BOOL SelectorNode_Match( LCUI_SelectorNode sn1, 
 			      LCUI_SelectorNode sn2 )
 {
-	int i, j;
-	if( sn2->id ) {
-		if( !sn1->id || strcmp( sn1->id, sn2->id ) != 0 ) {
-			return FALSE;
-		}
+	int i;
+	if( sn2->id && sn1->id != sn2->id ) {
+		return FALSE;
 	}
-	if( sn2->type && strcmp(sn2->type, "*") != 0 ) {
-		if( !sn1->type || strcmp( sn1->type, sn2->type ) != 0 ) {
-			return FALSE;
-		}
+	if( SelectorNode_HasType( sn2 ) && sn1->type != sn2->type ) {
+		return FALSE;
 	}
 	if( sn2->classes ) {
-		if( !sn1->classes ) {
-			return FALSE;
-		}
 		for( i = 0; sn2->classes[i]; ++i ) {
-			for( j = 0; sn1->classes[j]; ++j ) {
-				if( strcmp( sn2->classes[i],
-					    sn1->classes[i] ) == 0 ) {
-					j = -1;
-					break;
-				}
-			}
-			if( j != -1 ) {
+			if( !AtomList_Has( sn1->classes, sn2->classes[i] ) ) {
 				return FALSE;
 			}
 		}
 	}
 	if( sn2->status ) {
-		if( !sn1->status ) {
-			return FALSE;
-		}
 		for( i = 0; sn2->status[i]; ++i ) {
-			for( j = 0; sn1->status[j]; ++j ) {
-				if( strcmp( sn2->status[i],
-					    sn1->status[i] ) == 0 ) {
-					j = -1;
-					break;
-				}
-			}
-			if( j != -1 ) {
+			if( !AtomList_Has( sn1->status, sn2->status[i] ) ) {
 				return FALSE;
 			}
 		}
@@ -359,40 +433,129 @@ LCUI_BOOL SelectorNode_Match( LCUI_SelectorNode sn1,
 	return TRUE;
 }
 
-static void SelectorNode_Copy( LCUI_SelectorNode dst, LCUI_SelectorNode src )
+/** 计算匹配指令的哈希值，指令类型也参与计算，以区分同名的 id 和类名 */
+static unsigned int SelectorMatchOp_Hash( SelectorMatchOp op )
+{
+	return (op->atom * 4 + op->type) * 2654435761u;
+}
+
+static void SelectorMatchOp_Init( SelectorMatchOp op, int type,
+				  LCUI_Atom atom )
+{
+	op->type = type;
+	op->atom = atom;
+}
+
+/** 获取选择器结点编译后的指令数量 */
+static int SelectorNode_GetMatchOpCount( LCUI_SelectorNode node )
+{
+	int count = 0;
+	if( SelectorNode_HasType( node ) ) {
+		++count;
+	}
+	if( node->id ) {
+		++count;
+	}
+	count += AtomList_Length( node->classes );
+	count += AtomList_Length( node->status );
+	return count;
+}
+
+/**
+ * 将选择器结点编译为匹配程序
+ * @param[out] ops 指令的存放位置，容量由 SelectorNode_GetMatchOpCount() 决定
+ * @returns 指令数量
+ */
+static int SelectorMatchProg_Compile( SelectorMatchProg prog,
+				      LCUI_SelectorNode node,
+				      SelectorMatchOp ops )
 {
 	int i;
-	dst->id = src->id ? strdup( src->id ) : NULL;
-	dst->type = src->type ? strdup( src->type ) : NULL;
-	dst->fullname = src->fullname ? strdup( src->fullname ) : NULL;
-	if( src->classes ) {
-		for( i = 0; src->classes[i]; ++i ) {
-			sortedstrsadd( &dst->classes, src->classes[i] );
+	prog->ops = ops;
+	prog->length = 0;
+	if( SelectorNode_HasType( node ) ) {
+		SelectorMatchOp_Init( &ops[prog->length++],
+				      MATCH_TYPE, node->type );
+	}
+	if( node->id ) {
+		SelectorMatchOp_Init( &ops[prog->length++],
+				      MATCH_ID, node->id );
+	}
+	if( node->classes ) {
+		for( i = 0; node->classes[i]; ++i ) {
+			SelectorMatchOp_Init( &ops[prog->length++],
+					      MATCH_CLASS, node->classes[i] );
 		}
 	}
-	if( src->status ) {
-		for( i = 0; src->status[i]; ++i ) {
-			sortedstrsadd( &dst->status, src->status[i] );
+	if( node->status ) {
+		for( i = 0; node->status[i]; ++i ) {
+			SelectorMatchOp_Init( &ops[prog->length++],
+					      MATCH_STATUS, node->status[i] );
 		}
 	}
+	return prog->length;
 }
 
-void SelectorNode_Delete( LCUI_SelectorNode node )
+/** 判断 prog 对应的结点是否拥有 pattern 要求的全部属性 */
+static LCUI_BOOL SelectorMatchProg_Match( SelectorMatchProg prog,
+					  SelectorMatchProg pattern )
 {
-	if( node->type ) {
-		free( node->type );
-		node->type = NULL;
-	}
-	if( node->id ) {
-		free( node->id );
-		node->id = NULL;
+	int i, j;
+	SelectorMatchOp op, target;
+	for( i = 0; i < pattern->length; ++i ) {
+		op = &pattern->ops[i];
+		for( j = 0; j < prog->length; ++j ) {
+			target = &prog->ops[j];
+			if( target->atom == op->atom &&
+			    target->type == op->type ) {
+				break;
+			}
+		}
+		if( j >= prog->length ) {
+			return FALSE;
+		}
 	}
+	return TRUE;
+}
+
+/** 将匹配指令记录到布隆过滤器中，每条指令占用两个位 */
+static void SelectorBloom_Add( uint32_t *bloom, SelectorMatchOp op )
+{
+	unsigned int hash = SelectorMatchOp_Hash( op );
+	unsigned int bit1 = hash % SELECTOR_BLOOM_BITS;
+	unsigned int bit2 = (hash >> 16) % SELECTOR_BLOOM_BITS;
+	bloom[bit1 >> 5] |= 1u << (bit1 & 31);
+	bloom[bit2 >> 5] |= 1u << (bit2 & 31);
+}
+
+static LCUI_BOOL SelectorBloom_Has( const uint32_t *bloom, SelectorMatchOp op )
+{
+	unsigned int hash = SelectorMatchOp_Hash( op );
+	unsigned int bit1 = hash % SELECTOR_BLOOM_BITS;
+	unsigned int bit2 = (hash >> 16) % SELECTOR_BLOOM_BITS;
+	return (bloom[bit1 >> 5] & (1u << (bit1 & 31))) &&
+		(bloom[bit2 >> 5] & (1u << (bit2 & 31)));
+}
+
+static void SelectorNode_Copy( LCUI_SelectorNode dst, LCUI_SelectorNode src )
+{
+	dst->id = src->id;
+	dst->type = src->type;
+	dst->fullname = src->fullname ? strdup( src->fullname ) : NULL;
+	dst->classes = AtomList_Duplicate( src->classes );
+	dst->status = AtomList_Duplicate( src->status );
+}
+
+void SelectorNode_Delete( LCUI_SelectorNode node )
+{
+	node->type = 0;
+	node->id = 0;
 	if( node->classes ) {
-		freestrs( node->classes );
+		free( node->classes );
 		node->classes = NULL;
 	}
 	if( node->status ) {
-		freestrs( node->status );
+		free( node->status );
 		node->status = NULL;
 	}
 	if( node->fullname ) {
@@ -570,6 +733,7 @@ static void NamesFinder_Destroy( NamesFinder sfinder )
 /* 生成选择器全名列表 */
 static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 {
+	const char *name;
 	int i, len, old_len, old_level, count = 0;
 	char *fullname = sfinder->name + sfinder->name_i;
 	old_len = len = strlen( fullname );
@@ -580,7 +744,7 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 		if( !sfinder->node->type ) {
 			return 0;
 		}
-		strcpy( fullname, sfinder->node->type );
+		strcpy( fullname, LCUIAtom_GetName( sfinder->node->type ) );
 		LinkedList_Append( list, strdup( fullname ) );
 		break;
 	case LEVEL_ID: 
@@ -590,7 +754,7 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 		}
 		fullname[len++] = '#';
 		fullname[len] = 0;
-		strcpy( fullname + len, sfinder->node->id );
+		strcpy( fullname + len, LCUIAtom_GetName( sfinder->node->id ) );
 		LinkedList_Append( list, strdup( fullname ) );
 		break;
 	case LEVEL_CLASS:
@@ -608,7 +772,8 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 		for( i = 0; sfinder->node->classes[i]; ++i ) {
 			sfinder->level += 1;
 			sfinder->class_i = i;
-			strcpy( fullname + len, sfinder->node->classes[i] );
+			name = LCUIAtom_GetName( sfinder->node->classes[i] );
+			strcpy( fullname + len, name );
 			LinkedList_Append( list, strdup( fullname ) );
 			/* 将当前选择器名与其它层级的选择器名组合 */
 			while( sfinder->level < LEVEL_TOTAL_NUM ) {
@@ -636,7 +801,8 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 			if( i <= sfinder->class_i ) {
 				continue;
 			}
-			strcpy( fullname + len, sfinder->node->classes[i] );
+			name = LCUIAtom_GetName( sfinder->node->classes[i] );
+			strcpy( fullname + len, name );
 			LinkedList_Append( list, strdup( fullname ) );
 			sfinder->class_i = i;
 			count += NamesFinder_Find( sfinder, list );
@@ -672,7 +838,8 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 		 */
 		for( i = 0; sfinder->node->status[i]; ++i ) {
 			sfinder->status_i = i;
-			strcpy( fullname + len, sfinder->node->status[i] );
+			name = LCUIAtom_GetName( sfinder->node->status[i] );
+			strcpy( fullname + len, name );
 			LinkedList_Append( list, strdup( fullname ) );
 			/**
 			 * 递归调用，以一层层拼接出像下面这样的选择器：
@@ -694,7 +861,8 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 				continue;
 			}
 			fullname[len] = ':';
-			strcpy( fullname + len + 1, sfinder->node->status[i] );
+			name = LCUIAtom_GetName( sfinder->node->status[i] );
+			strcpy( fullname + len + 1, name );
 			LinkedList_Append( list, strdup( fullname ) );
 			sfinder->status_i = i;
 			count += NamesFinder_Find( sfinder, list );
@@ -716,30 +884,35 @@ static int NamesFinder_Find( NamesFinder sfinder, LinkedList *list )
 	return count;
 }
 
+/**
+ * 保存选择器结点中的一个名称
+ * @returns 成功返回名称的权重，名称无效时返回 0，无法为名称分配原子时返回 -1
+ */
 static int SelectorNode_Save( LCUI_SelectorNode node,
 			      const char *name, int len, char type )
 {
-	char *str;
+	LCUI_Atom atom;
 	if( len < 1 ) {
 		return 0;
 	}
+	atom = LCUIAtom_Get( name );
+	if( !atom ) {
+		return -1;
+	}
 	switch( type ) {
 	case 0:
 		if( node->type ) {
 			break;
 		}
-		len += 1;
-		str = malloc( sizeof( char ) * len );
-		strncpy( str, name, len );
-		node->type = str;
+		node->type = atom;
 		return TYPE_RANK;
 	case ':':
-		if( sortedstrsadd( &node->status, name ) == 0 ) {
+		if( AtomList_Add( &node->status, atom ) ) {
 			return PCLASS_RANK;
 		}
 		break;
 	case '.':
-		if( sortedstrsadd( &node->classes, name ) == 0 ) {
+		if( AtomList_Add( &node->classes, atom ) ) {
 			return CLASS_RANK;
 		}
 		break;
@@ -747,10 +920,7 @@ static int SelectorNode_Save( LCUI_SelectorNode node,
 		if( node->id ) {
 			break;
 		}
-		len += 1;
-		str = malloc( sizeof( char ) * len );
-		strncpy( str, name, len );
-		node->id = str;
+		node->id = atom;
 		return ID_RANK;
 	default: break;
 	}
@@ -771,25 +941,28 @@ int SelectorNode_Update( LCUI_SelectorNode node )
 {
 	int i, len = 0;
 	char *fullname;
+	const char *name;
 
 	node->rank = 0;
 	if( node->id ) {
-		len += strlen( node->id ) + 1;
+		len += strlen( LCUIAtom_GetName( node->id ) ) + 1;
 		node->rank += ID_RANK;
 	}
 	if( node->type ) {
-		len += strlen( node->type ) + 1;
+		len += strlen( LCUIAtom_GetName( node->type ) ) + 1;
 		node->rank += TYPE_RANK;
 	}
 	if( node->classes ) {
 		for( i = 0; node->classes[i]; ++i ) {
-			len += strlen( node->classes[i] ) + 1;
+			name = LCUIAtom_GetName( node->classes[i] );
+			len += strlen( name ) + 1;
 			node->rank += CLASS_RANK;
 		}
 	}
 	if( node->status ) {
 		for( i = 0; node->status[i]; ++i ) {
-			len += strlen( node->status[i] ) + 1;
+			name = LCUIAtom_GetName( node->status[i] );
+			len += strlen( name ) + 1;
 			node->rank += PCLASS_RANK;
 		}
 	}
@@ -800,23 +973,25 @@ int SelectorNode_Update( LCUI_SelectorNode node )
 		}
 		fullname[0] = 0;
 		if( node->type ) {
-			strcat( fullname, node->type );
+			strcat( fullname, LCUIAtom_GetName( node->type ) );
 		}
 		if( node->id ) {
 			strcat( fullname, "#" );
-			strcat( fullname, node->id );
+			strcat( fullname, LCUIAtom_GetName( node->id ) );
 		}
 		if( node->classes ) {
 			for( i = 0; node->classes[i]; ++i ) {
 				strcat( fullname, "." );
-				strcat( fullname, node->classes[i] );
+				name = LCUIAtom_GetName( node->classes[i] );
+				strcat( fullname, name );
 			}
 			len += 1;
 		}
 		if( node->status ) {
 			for( i = 0; node->status[i]; ++i ) {
 				strcat( fullname, ":" );
-				strcat( fullname, node->status[i] );
+				name = LCUIAtom_GetName( node->status[i] );
+				strcat( fullname, name );
 			}
 			len += 1;
 		}
@@ -882,6 +1057,10 @@ LCUI_Selector Selector( const char *selector )
 			}
 			/* 保存上个结点 */
 			rank = SelectorNode_Save( node, name, ni, type );
+			if( rank < 0 ) {
+				Selector_Delete( s );
+				return NULL;
+			}
 			if( rank > 0 ) {
 				s->rank += rank;
 			} else {
@@ -905,6 +1084,10 @@ LCUI_Selector Selector( const char *selector )
 			}
 			is_saving = FALSE;
 			rank = SelectorNode_Save( node, name, ni, type );
+			if( rank < 0 ) {
+				Selector_Delete( s );
+				return NULL;
+			}
 			if( rank > 0 ) {
 				SelectorNode_Update( node );
 				s->rank += rank;
@@ -936,8 +1119,24 @@ LCUI_Selector Selector( const char *selector )
 			    selector, *p, p - selector );
 		return NULL;
 	}
+	if( is_saving && !node ) {
+		/* 最后一个结点只有一个字符时，结点还未创建 */
+		if( si >= MAX_SELECTOR_DEPTH ) {
+			_DEBUG_MSG( "%s: selector node list is too long.\n",
+				    selector );
+			return NULL;
+		}
+		node = NEW( LCUI_SelectorNodeRec, 1 );
+		s->nodes[si] = node;
+	}
 	if( is_saving ) {
 		rank = SelectorNode_Save( s->nodes[si], name, ni, type );
+		/* 忽略无法分配原子的名称会让选择器匹配到更多部件，所以整个选择器
+		 * 都不能用了 */
+		if( rank < 0 ) {
+			Selector_Delete( s );
+			return NULL;
+		}
 		if( rank > 0 ) {
 			SelectorNode_Update( s->nodes[si] );
 			s->rank += rank;
@@ -971,6 +1170,7 @@ static StyleLink CreateStyleLink( void )
 	StyleLink link = NEW( StyleLinkRec, 1 );
 	link->group = NULL;
 	LinkedList_Init( &link->styles );
+	LinkedList_Init( &link->parent_list );
 	link->parents = Dict_Create( &DictType_StringCopyKey, NULL );
 	return link;
 }
@@ -980,6 +1180,7 @@ static void DeleteStyleLink( StyleLink link )
 	link->group = NULL;
 	Dict_Release( link->parents );
 	link->parents = NULL;
+	LinkedList_Clear( &link->parent_list, NULL );
 	LinkedList_Clear( &link->styles, (FuncPtr)DeleteStyleNode );
 }
 
@@ -990,6 +1191,8 @@ static void OnDeleteStyleLink( void *privdata, void *data )
 
 static StyleLinkGroup CreateStyleLinkGroup( LCUI_SelectorNode snode )
 {
+	int n;
+	SelectorMatchOp ops;
 	DictType *dtype = NEW( DictType, 1 );
 	StyleLinkGroup group = NEW( StyleLinkGroupRec, 1 );
 	SelectorNode_Copy( &group->snode, snode );
@@ -997,11 +1200,19 @@ static StyleLinkGroup CreateStyleLinkGroup( LCUI_SelectorNode snode )
 	*dtype = DictType_StringCopyKey;
 	dtype->valDestructor = OnDeleteStyleLink;
 	group->links = Dict_Create( dtype, dtype );
+	n = SelectorNode_GetMatchOpCount( &group->snode );
+	ops = n > 0 ? NEW( SelectorMatchOpRec, n ) : NULL;
+	SelectorMatchProg_Compile( &group->prog, &group->snode, ops );
 	return group;
 }
 
 static void DeleteStyleLinkGroup( StyleLinkGroup group )
 {
+	if( group->prog.ops ) {
+		free( group->prog.ops );
+		group->prog.ops = NULL;
+	}
+	group->prog.length = 0;
 	free( group->name );
 	Dict_Release( group->links );
 	free( group->links->privdata );
@@ -1032,21 +1243,128 @@ static void DeleteStyleGroup( Dict *dict )
 }
 
 /** 根据选择器，选中匹配的样式表 */
+static void OnDeleteSelectorDependency( void *privdata, void *data )
+{
+	SelectorDependency dep = data;
+	LinkedList_Clear( &dep->subjects, NULL );
+	free( dep );
+}
+
+static SelectorDependency SelectorDependency_Get( int type, LCUI_Atom atom )
+{
+	unsigned int key = atom * 2 + type;
+	return Dict_FetchValue( library.dependencies, &key );
+}
+
+/** 记录一个名称被选择器用到的位置 */
+static void SelectorDependency_Add( int type, LCUI_Atom atom,
+				    LCUI_BOOL is_subject,
+				    StyleLinkGroup subject )
+{
+	LinkedListNode *node;
+	unsigned int key = atom * 2 + type;
+	SelectorDependency dep = Dict_FetchValue( library.dependencies, &key );
+
+	if( !dep ) {
+		dep = NEW( SelectorDependencyRec, 1 );
+		if( !dep ) {
+			return;
+		}
+		LinkedList_Init( &dep->subjects );
+		Dict_Add( library.dependencies, &key, dep );
+	}
+	if( is_subject ) {
+		dep->flags |= SELECTOR_DEP_SUBJECT;
+		return;
+	}
+	dep->flags |= SELECTOR_DEP_ANCESTOR;
+	for( LinkedList_Each( node, &dep->subjects ) ) {
+		if( node->data == subject ) {
+			return;
+		}
+	}
+	LinkedList_Append( &dep->subjects, subject );
+}
+
+/** 记录选择器结点中的类名和状态名被用到的位置 */
+static void SelectorDependency_AddNode( LCUI_SelectorNode sn,
+					LCUI_BOOL is_subject,
+					StyleLinkGroup subject )
+{
+	int i;
+	if( sn->classes ) {
+		for( i = 0; sn->classes[i]; ++i ) {
+			SelectorDependency_Add( 0, sn->classes[i],
+						is_subject, subject );
+		}
+	}
+	if( sn->status ) {
+		for( i = 0; sn->status[i]; ++i ) {
+			SelectorDependency_Add( 1, sn->status[i],
+						is_subject, subject );
+		}
+	}
+}
+
+int LCUI_GetSelectorDependency( int type, LCUI_Atom atom )
+{
+	SelectorDependency dep = SelectorDependency_Get( type, atom );
+	return dep ? dep->flags : 0;
+}
+
+LCUI_BOOL LCUI_IsSelectorNodeAffected( int type, LCUI_Atom atom,
+				       LCUI_SelectorNode sn )
+{
+	int n;
+	LCUI_BOOL affected = FALSE;
+	LinkedListNode *node;
+	SelectorDependency dep;
+	SelectorMatchProgRec prog;
+	SelectorMatchOp ops;
+	SelectorMatchOpRec buf[32];
+
+	dep = SelectorDependency_Get( type, atom );
+	if( !dep || !(dep->flags & SELECTOR_DEP_ANCESTOR) ) {
+		return FALSE;
+	}
+	n = SelectorNode_GetMatchOpCount( sn );
+	if( n > LEN( buf ) ) {
+		ops = NEW( SelectorMatchOpRec, n );
+		if( !ops ) {
+			return TRUE;
+		}
+	} else {
+		ops = buf;
+	}
+	SelectorMatchProg_Compile( &prog, sn, ops );
+	for( LinkedList_Each( node, &dep->subjects ) ) {
+		StyleLinkGroup slg = node->data;
+		if( SelectorMatchProg_Match( &prog, &slg->prog ) ) {
+			affected = TRUE;
+			break;
+		}
+	}
+	if( ops != buf ) {
+		free( ops );
+	}
+	return affected;
+}
+
 static LCUI_StyleSheet LCUI_SelectStyleSheet( LCUI_Selector selector, 
 					      const char *space )
 {
 	int i, right;
-	StyleLink link;
+	Dict *group;
 	StyleNode snode;
-	StyleLinkGroup slg;
+	StyleLinkGroup slg, subject = NULL;
+	StyleLink link, child;
 	LinkedListNode *node;
 	LCUI_SelectorNode sn;
-	Dict *group, *parents;
 	char buf[MAX_SELECTOR_LEN];
 	char fullname[MAX_SELECTOR_LEN];
 
 	link = NULL;
-	parents = NULL;
+	child = NULL;
 	for( i = 0, right = selector->length - 1; right >= 0; --right, ++i ) {
 		group = LinkedList_Get( &library.groups, i );
 		if( !group ) {
@@ -1059,6 +1377,10 @@ static LCUI_StyleSheet LCUI_SelectStyleSheet( LCUI_Selector selector,
 			slg = CreateStyleLinkGroup( sn );
 			Dict_Add( group, sn->fullname, slg );
 		}
+		if( i == 0 ) {
+			subject = slg;
+		}
+		SelectorDependency_AddNode( sn, i == 0, subject );
 		if( i == 0 ) {
 			strcpy( fullname, "*" );
 		} else {
@@ -1079,12 +1401,13 @@ static LCUI_StyleSheet LCUI_SelectStyleSheet( LCUI_Selector selector,
 			sprintf( buf, "%s %s", sn->fullname, fullname );
 		}
 		/* 如果有上一级的父链接记录，则将当前链接添加进去 */
-		if( parents ) {
-			if( !Dict_FetchValue( parents, sn->fullname ) ) {
-				Dict_Add( parents, sn->fullname, link );
+		if( child ) {
+			if( !Dict_FetchValue( child->parents, sn->fullname ) ) {
+				Dict_Add( child->parents, sn->fullname, link );
+				LinkedList_Append( &child->parent_list, link );
 			}
 		}
-		parents = link->parents;
+		child = link;
 	}
 	if( !link ) {
 		return NULL;
@@ -1116,18 +1439,9 @@ static LCUI_StyleSheet LCUI_SelectStyleSheet( LCUI_Selector selector,
 	return snode->sheet;
 }
 
-int LCUI_PutStyleSheet( LCUI_Selector selector,
-			LCUI_StyleSheet in_ss, const char *space )
+unsigned int LCUI_GetStyleLibraryVersion( void )
 {
-	LCUI_StyleSheet ss;
-	LCUIMutex_Lock( &library.mutex );
-	Dict_Empty( library.cache );
-	ss = LCUI_SelectStyleSheet( selector, space );
-	if( ss ) {
-		StyleSheet_Replace( ss, in_ss );
-	}
-	LCUIMutex_Unlock( &library.mutex );
-	return 0;
+	return library.version;
 }
 
 static int StyleLink_GetStyleSheets( StyleLink link, LinkedList *outlist )
@@ -1166,29 +1480,87 @@ static int StyleLink_GetStyleSheets( StyleLink link, LinkedList *outlist )
 	return link->styles.length;
 }
 
-static int LCUI_FindStyleSheetFromLink( StyleLink link, LCUI_Selector s,
+/** 初始化选择器匹配器，编译目标选择器的各个结点并生成祖先结点的过滤器 */
+static int SelectorMatcher_Init( SelectorMatcher matcher, LCUI_Selector s )
+{
+	int i, j, n;
+	SelectorMatchOp ops;
+	SelectorMatchProg prog;
+
+	for( n = 0, i = 0; i < s->length; ++i ) {
+		n += SelectorNode_GetMatchOpCount( s->nodes[i] );
+	}
+	matcher->selector = s;
+	matcher->ops = NEW( SelectorMatchOpRec, n > 0 ? n : 1 );
+	if( !matcher->ops ) {
+		return -ENOMEM;
+	}
+	memset( matcher->blooms[0], 0, sizeof( matcher->blooms[0] ) );
+	for( ops = matcher->ops, i = 0; i < s->length; ++i ) {
+		prog = &matcher->nodes[i];
+		ops += SelectorMatchProg_Compile( prog, s->nodes[i], ops );
+		if( i + 1 >= s->length ) {
+			break;
+		}
+		memcpy( matcher->blooms[i + 1], matcher->blooms[i],
+			sizeof( matcher->blooms[i] ) );
+		for( j = 0; j < prog->length; ++j ) {
+			SelectorBloom_Add( matcher->blooms[i + 1],
+					   &prog->ops[j] );
+		}
+	}
+	return 0;
+}
+
+static void SelectorMatcher_Destroy( SelectorMatcher matcher )
+{
+	free( matcher->ops );
+	matcher->ops = NULL;
+	matcher->selector = NULL;
+}
+
+/** 判断第 i 个结点之前的祖先结点是否可能与匹配程序匹配 */
+static LCUI_BOOL SelectorMatcher_Test( SelectorMatcher matcher, int i,
+				       SelectorMatchProg prog )
+{
+	int j;
+	for( j = 0; j < prog->length; ++j ) {
+		if( !SelectorBloom_Has( matcher->blooms[i],
+					&prog->ops[j] ) ) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static int LCUI_FindStyleSheetFromLink( StyleLink link,
+					SelectorMatcher matcher,
 					int i, LinkedList *list )
 {
-	int count = 0;
+	int j, count = 0;
 	StyleLink parent;
-	LinkedList names;
 	LinkedListNode *node;
-	LCUI_SelectorNode sn;
+	SelectorMatchProg prog;
 
-	LinkedList_Init( &names );
 	count += StyleLink_GetStyleSheets( link, list );
-	while( --i >= 0 ) {
-		sn = s->nodes[i];
-		SelectorNode_GetNames( sn, &names );
-		for( LinkedList_Each( node, &names ) ) {
-			parent = Dict_FetchValue( link->parents, node->data );
-			if( !parent ) {
+	if( i < 1 ) {
+		return count;
+	}
+	for( LinkedList_Each( node, &link->parent_list ) ) {
+		parent = node->data;
+		prog = &parent->group->prog;
+		/* 祖先结点中缺少它需要的名称，不可能匹配 */
+		if( !SelectorMatcher_Test( matcher, i, prog ) ) {
+			continue;
+		}
+		for( j = i - 1; j >= 0; --j ) {
+			if( !SelectorMatchProg_Match( &matcher->nodes[j],
+						      prog ) ) {
 				continue;
 			}
-			count += LCUI_FindStyleSheetFromLink( parent, s,
-							      i, list );
+			count += LCUI_FindStyleSheetFromLink( parent, matcher,
+							      j, list );
 		}
-		LinkedList_Clear( &names, free );
 	}
 	return count;
 }
@@ -1201,11 +1573,15 @@ int LCUI_FindStyleSheetFromGroup( int group, const char *name,
 	StyleLinkGroup slg;
 	LinkedListNode *node;
 	LinkedList names;
+	SelectorMatcherRec matcher;
 
 	groups = LinkedList_Get( &library.groups, group );
 	if( !groups || s->length < 1 ) {
 		return 0;
 	}
+	if( SelectorMatcher_Init( &matcher, s ) != 0 ) {
+		return 0;
+	}
 	count = 0;
 	i = s->length - 1;
 	LinkedList_Init( &names );
@@ -1226,12 +1602,13 @@ int LCUI_FindStyleSheetFromGroup( int group, const char *name,
 		iter = Dict_GetIterator( slg->links );
 		while( (entry = Dict_Next( iter )) ) {
 			StyleLink link = DictEntry_GetVal( entry );
-			count += LCUI_FindStyleSheetFromLink( link, s, 
+			count += LCUI_FindStyleSheetFromLink( link, &matcher,
 							      i, list );
 		}
 		Dict_ReleaseIterator( iter );
 	}
 	LinkedList_Clear( &names, free );
+	SelectorMatcher_Destroy( &matcher );
 	return count;
 }
 
@@ -1355,20 +1732,178 @@ void LCUI_PrintCSSLibrary( void )
 	LOG( "style library end\n" );
 }
 
+/** 计算样式表缓存记录占用的内存大小 */
+static size_t StyleSheetCache_GetSize( StyleSheetCache cache )
+{
+	int i;
+	LCUI_Style s;
+	size_t size = sizeof( StyleSheetCacheRec ) + sizeof( LCUI_StyleSheetRec );
+
+	size += sizeof( SelectorMatchOpRec ) * cache->subject.length;
+	size += sizeof( LCUI_StyleRec ) * (cache->sheet->length + 1);
+	for( i = 0; i < cache->sheet->length; ++i ) {
+		s = &cache->sheet->sheet[i];
+		if( !s->is_valid ) {
+			continue;
+		}
+		if( s->type == SVT_STRING && s->string ) {
+			size += strlen( s->string ) + 1;
+		} else if( s->type == SVT_WSTRING && s->wstring ) {
+			size += (wcslen( s->wstring ) + 1) * sizeof( wchar_t );
+		}
+	}
+	return size;
+}
+
+static void OnDeleteStyleSheetCache( void *privdata, void *val )
+{
+	StyleSheetCache cache = val;
+	LinkedList_Unlink( &library.cache_lru, &cache->node );
+	library.cache_stats.size -= cache->size;
+	library.cache_stats.count -= 1;
+	StyleSheet_Delete( cache->sheet );
+	free( cache->subject.ops );
+	free( cache );
+}
+
+/** 淘汰最久没有使用的记录，直到占用的内存不超过上限 */
+static void StyleSheetCache_Trim( void )
+{
+	StyleSheetCache cache;
+	while( library.cache_stats.size > library.cache_stats.max_size &&
+	       library.cache_lru.length > 0 ) {
+		cache = library.cache_lru.head.next->data;
+		library.cache_stats.evictions += 1;
+		Dict_Delete( library.cache, &cache->hash );
+	}
+}
+
+/** 将选择器匹配到的样式表添加到缓存中 */
+static void StyleSheetCache_Add( LCUI_Selector s, LCUI_StyleSheet sheet )
+{
+	int i = s->length - 1;
+	SelectorMatcherRec matcher;
+	SelectorMatchProg prog;
+	StyleSheetCache cache;
+
+	if( i < 0 || SelectorMatcher_Init( &matcher, s ) != 0 ) {
+		StyleSheet_Delete( sheet );
+		return;
+	}
+	cache = NEW( StyleSheetCacheRec, 1 );
+	prog = &matcher.nodes[i];
+	if( cache && prog->length > 0 ) {
+		cache->subject.ops = NEW( SelectorMatchOpRec, prog->length );
+		if( !cache->subject.ops ) {
+			free( cache );
+			cache = NULL;
+		}
+	}
+	if( !cache ) {
+		SelectorMatcher_Destroy( &matcher );
+		StyleSheet_Delete( sheet );
+		return;
+	}
+	if( prog->length > 0 ) {
+		memcpy( cache->subject.ops, prog->ops,
+			sizeof( SelectorMatchOpRec ) * prog->length );
+	}
+	cache->subject.length = prog->length;
+	memcpy( cache->ancestors, matcher.blooms[i],
+		sizeof( cache->ancestors ) );
+	SelectorMatcher_Destroy( &matcher );
+	cache->hash = s->hash;
+	cache->sheet = sheet;
+	cache->node.data = cache;
+	cache->size = StyleSheetCache_GetSize( cache );
+	LinkedList_AppendNode( &library.cache_lru, &cache->node );
+	library.cache_stats.size += cache->size;
+	library.cache_stats.count += 1;
+	Dict_Add( library.cache, &cache->hash, cache );
+	StyleSheetCache_Trim();
+}
+
+/**
+ * 使可能受新样式表影响的缓存记录失效
+ * 只有当缓存记录的最右边结点拥有新选择器最右边结点要求的全部名称，并且新选择器
+ * 祖先结点中的名称都可能出现在它的祖先结点中时，新样式表才可能作用于它
+ */
+static void StyleSheetCache_Invalidate( LCUI_Selector s )
+{
+	int i, j, last = s->length - 1;
+	StyleSheetCache cache;
+	SelectorMatcherRec matcher;
+	LinkedListNode *node, *next;
+
+	if( last < 0 || library.cache_lru.length < 1 ) {
+		return;
+	}
+	if( SelectorMatcher_Init( &matcher, s ) != 0 ) {
+		Dict_Empty( library.cache );
+		return;
+	}
+	for( node = library.cache_lru.head.next; node; node = next ) {
+		next = node->next;
+		cache = node->data;
+		if( !SelectorMatchProg_Match( &cache->subject,
+					      &matcher.nodes[last] ) ) {
+			continue;
+		}
+		for( i = 0; i < last; ++i ) {
+			for( j = 0; j < matcher.nodes[i].length; ++j ) {
+				if( !SelectorBloom_Has( cache->ancestors,
+							&matcher.nodes[i].ops[j] ) ) {
+					break;
+				}
+			}
+			if( j < matcher.nodes[i].length ) {
+				break;
+			}
+		}
+		if( i < last ) {
+			continue;
+		}
+		library.cache_stats.invalidations += 1;
+		Dict_Delete( library.cache, &cache->hash );
+	}
+	SelectorMatcher_Destroy( &matcher );
+}
+
+int LCUI_PutStyleSheet( LCUI_Selector selector,
+			LCUI_StyleSheet in_ss, const char *space )
+{
+	LCUI_StyleSheet ss;
+	LCUIMutex_Lock( &library.mutex );
+	StyleSheetCache_Invalidate( selector );
+	ss = LCUI_SelectStyleSheet( selector, space );
+	if( ss ) {
+		StyleSheet_Replace( ss, in_ss );
+	}
+	library.version += 1;
+	LCUIMutex_Unlock( &library.mutex );
+	return 0;
+}
+
 void LCUI_GetStyleSheet( LCUI_Selector s, LCUI_StyleSheet out_ss )
 {
 	LinkedList list;
 	LinkedListNode *node;
 	LCUI_StyleSheet ss;
+	StyleSheetCache cache;
 	LinkedList_Init( &list );
 	StyleSheet_Clear( out_ss );
 	LCUIMutex_Lock( &library.mutex );
-	ss = Dict_FetchValue( library.cache, &s->hash );
-	if( ss ) {
-		StyleSheet_Replace( out_ss, ss );
+	cache = Dict_FetchValue( library.cache, &s->hash );
+	if( cache ) {
+		library.cache_stats.hits += 1;
+		/* 移到链表末尾，表示最近使用过 */
+		LinkedList_Unlink( &library.cache_lru, &cache->node );
+		LinkedList_AppendNode( &library.cache_lru, &cache->node );
+		StyleSheet_Replace( out_ss, cache->sheet );
 		LCUIMutex_Unlock( &library.mutex );
 		return;
 	}
+	library.cache_stats.misses += 1;
 	ss = StyleSheet();
 	LCUI_FindStyleSheet( s, &list );
 	for( LinkedList_Each( node, &list ) ) {
@@ -1376,14 +1911,24 @@ void LCUI_GetStyleSheet( LCUI_Selector s, LCUI_StyleSheet out_ss )
 		StyleSheet_Merge( ss, sn->sheet );
 	}
 	LinkedList_Clear( &list, NULL );
-	Dict_Add( library.cache, &s->hash, ss );
 	StyleSheet_Replace( out_ss, ss );
+	StyleSheetCache_Add( s, ss );
 	LCUIMutex_Unlock( &library.mutex );
 }
 
-static void DestroyStyleSheetCache( void *privdata, void *val )
+void LCUI_GetStyleCacheStats( LCUI_StyleCacheStats stats )
 {
-	StyleSheet_Delete( val );
+	LCUIMutex_Lock( &library.mutex );
+	*stats = library.cache_stats;
+	LCUIMutex_Unlock( &library.mutex );
+}
+
+void LCUI_SetStyleCacheMaxSize( size_t size )
+{
+	LCUIMutex_Lock( &library.mutex );
+	library.cache_stats.max_size = size;
+	StyleSheetCache_Trim();
+	LCUIMutex_Unlock( &library.mutex );
 }
 
 static void DestroyStyleName( void *privdata, void *val )
@@ -1417,20 +1962,28 @@ static void *IntKeyDict_KeyDup( void *privdata, const void *key )
 void LCUI_InitCSSLibrary( void )
 {
 	KeyNameGroup skn, skn_end;
-	static DictType cachedict, namedict;
+	static DictType cachedict, namedict, depdict;
+	/* 样式库也可以单独使用，所以这里也要初始化原子驻留表 */
+	LCUI_InitAtomTable();
 	cachedict.keyDup = IntKeyDict_KeyDup;
 	cachedict.keyCompare = IntKeyDict_KeyCompare;
 	cachedict.hashFunction = IntKeyDict_HashFunction;
 	cachedict.keyDestructor = IntKeyDict_KeyDestructor;
-	cachedict.valDestructor = DestroyStyleSheetCache;
+	cachedict.valDestructor = OnDeleteStyleSheetCache;
 	cachedict.valDup = namedict.valDup = NULL;
 	namedict.keyDup = IntKeyDict_KeyDup;
 	namedict.keyCompare = IntKeyDict_KeyCompare;
 	namedict.hashFunction = IntKeyDict_HashFunction;
 	namedict.keyDestructor = IntKeyDict_KeyDestructor;
 	namedict.valDestructor = DestroyStyleName;
+	depdict = namedict;
+	depdict.valDestructor = OnDeleteSelectorDependency;
 	library.names = Dict_Create( &namedict, NULL );
+	library.dependencies = Dict_Create( &depdict, NULL );
 	library.cache = Dict_Create( &cachedict, NULL );
+	LinkedList_Init( &library.cache_lru );
+	memset( &library.cache_stats, 0, sizeof( library.cache_stats ) );
+	library.cache_stats.max_size = DEFAULT_STYLE_CACHE_SIZE;
 	library.value_names = Dict_Create( &namedict, NULL );
 	library.value_keys = Dict_Create( &DictType_StringKey, NULL );
 	LinkedList_Init( &library.groups );
@@ -1444,6 +1997,7 @@ void LCUI_InitCSSLibrary( void )
 		LCUI_AddStyleValue( skn->key, skn->name );
 	}
 	library.count = STYLE_KEY_TOTAL;
+	library.universal = LCUIAtom_Get( "*" );
 	library.is_inited = TRUE;
 }
 
@@ -1454,6 +2008,7 @@ void LCUI_ExitCSSLibrary( void )
 	Dict_Release( library.cache );
 	Dict_Release( library.value_keys );
 	Dict_Release( library.value_names );
+	Dict_Release( library.dependencies );
 	LCUIMutex_Destroy( &library.mutex );
 	LinkedList_Clear( &library.groups, (FuncPtr)DeleteStyleGroup );
 }
@@ -46,30 +46,44 @@
 #include <LCUI/gui/css_library.h>
 #include <LCUI/gui/css_parser.h>
 
+#if defined(LCUI_BUILD_IN_LINUX) && defined(HAVE_MUNMAP)
+#define USE_MMAP_CSS_FILE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #define SPLIT_NUMBER	1
 #define SPLIT_COLOR	(1<<1)
 #define SPLIT_STYLE	(1<<2)
+#define SPLIT_MAX_VALUES	8
 
 #define LEN(A) sizeof( A ) / sizeof( *A )
 
+/** CSS 代码扫描器，直接在源码上移动，不会复制源码中的字符 */
+typedef struct CSSTokenizerRec_ {
+	const char *cur;		/**< 当前扫描到的位置 */
+	const char *end;		/**< 源码的结束位置 */
+} CSSTokenizerRec, *CSSTokenizer;
+
+/** 字符串视图，引用源码中的一段字符串 */
+typedef struct CSSStringViewRec_ {
+	const char *str;		/**< 字符串在源码中的起始位置 */
+	size_t len;			/**< 字符串的长度 */
+	LCUI_BOOL has_comment;		/**< 字符串中是否夹杂着注释 */
+} CSSStringViewRec, *CSSStringView;
+
 /** 解析器的环境参数（上下文数据） */
 typedef struct CSSParserContextRec_ {
-	enum {
-		TARGET_NONE,		/**< 无 */
-		TARGET_SELECTOR,	/**< 选择器 */
-		TARGET_KEY,		/**< 属性名 */
-		TARGET_VALUE,		/**< 属性值 */
-		TARGET_COMMENT		/**< 注释 */
-	} target, target_bak;		/**< 当前解析中的目标，以及当前备份的目标 */
-	LCUI_BOOL is_line_comment;	/**< 是否为单行注释 */
-	char *buffer;			/**< 缓存中的字符串 */
-	size_t buffer_size;		/**< 缓存区大小 */
-	int pos;			/**< 缓存中的字符串的下标位置 */
-	const char *ptr;		/**< 用于遍历字符串的指针 */
+	CSSTokenizerRec tokenizer;	/**< 源码扫描器 */
+	char *buffer;			/**< 存放以 0 结尾的字符串的缓存 */
+	size_t buffer_size;		/**< 缓存区大小，会按需增长 */
 	LinkedList selectors;		/**< 当前匹配到的选择器列表 */
 	LCUI_StyleSheet css;		/**< 当前缓存的样式表 */
-	LCUI_StyleParser parser;	/**< 当前找到的解析器 */
-	char *space;			/**< 样式记录所属的空间 */
+	const char *space;		/**< 样式记录所属的空间 */
+	LCUI_CSSRuleHandler handler;	/**< 样式规则的处理函数 */
+	void *data;			/**< 传给处理函数的附加数据 */
 } CSSParserContextRec, *CSSParserContext;
 
 static struct CSSParserModule {
@@ -78,32 +92,47 @@ static struct CSSParserModule {
 	Dict *parsers;		/**< 解析器表，以名称进行索引 */
 } self;
 
+static LCUI_BOOL IsSpaceChar( char ch )
+{
+	return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
 static int SplitValues( const char *str, LCUI_Style slist,
 			int max_len, int mode )
 {
-	int val, vi = 0, vj = 0;
-	char **values;
-	const char *p;
+	size_t len;
+	int val, vi = 0, vj, depth = 0;
+	char buf[256], *copy, *p, *values[SPLIT_MAX_VALUES];
 
-	values = (char**)calloc(max_len, sizeof(char*));
-	values[0] = (char*)malloc(sizeof(char)*64);
-	for( p = str; *p; ++p ) {
-		if( *p != ' ' ) {
-			values[vi][vj++] = *p;
-			continue;
+	/* 只复制一次，然后原地切分，括号内的空格不作为分隔符 */
+	len = strlen( str );
+	copy = len < sizeof( buf ) ? buf : malloc( len + 1 );
+	if( !copy ) {
+		return -1;
+	}
+	memcpy( copy, str, len + 1 );
+	if( max_len > SPLIT_MAX_VALUES ) {
+		max_len = SPLIT_MAX_VALUES;
+	}
+	for( p = copy; *p && vi < max_len; ) {
+		for( ; IsSpaceChar( *p ); ++p );
+		if( !*p ) {
+			break;
 		}
-		if( vj > 0 ) {
-			values[vi][vj] = 0;
-			++vi;
-			vj = 0;
-			if( vi >= max_len ) {
-				goto clean;
+		values[vi++] = p;
+		for( ; *p; ++p ) {
+			if( *p == '(' ) {
+				++depth;
+			} else if( *p == ')' && depth > 0 ) {
+				--depth;
+			} else if( depth == 0 && IsSpaceChar( *p ) ) {
+				break;
 			}
-			values[vi] = (char*)malloc(sizeof(char)*64);
+		}
+		if( *p ) {
+			*p++ = 0;
 		}
 	}
-	values[vi][vj] = 0;
-	vi++;
 	for( vj = 0; vj < vi; ++vj ) {
 		DEBUG_MSG("[%d] %s\n", vj, values[vj]);
 		if( strcmp( values[vj], "auto" ) == 0 ) {
@@ -136,13 +165,11 @@ static int SplitValues( const char *str, LCUI_Style slist,
 		}
 		vi = -1;
 		DEBUG_MSG("[%d]:parse error\n", vj);
-		goto clean;
+		break;
 	}
-clean:
-	for( vj = 0; vj < max_len; ++vj ) {
-		values[vj] ? free(values[vj]) : 0;
+	if( copy != buf ) {
+		free( copy );
 	}
-	free( values );
 	return vi;
 }
 
@@ -207,29 +234,28 @@ static int OnParseColor( LCUI_StyleSheet ss, int key, const char *str )
 static int OnParseImage( LCUI_StyleSheet ss, int key, const char *str )
 {
 	char *data;
-	int n;
-	const char *p, *head, *tail;
+	size_t n;
+	const char *head, *tail;
 
-	p = str;
-	data = malloc( strlen(str) * sizeof(char) );
-	tail = head = strstr( p, "url(" );
-	while( p ) {
-		tail = p;
-		p = strstr( p+1, ")" );
-	}
-	if( tail == head ) {
+	head = strstr( str, "url(" );
+	tail = strrchr( str, ')' );
+	if( !head || !tail || tail < head + 4 ) {
 		return -1;
 	}
 	head += 4;
 	if( *head == '"' ) {
 		++head;
 	}
-	n = tail - head;
-	strncpy( data, head, n );
-	data[n] = 0;
-	if( n > 0 && data[n - 1] == '"' ) {
-		data[n - 1] = 0;
+	n = tail > head ? tail - head : 0;
+	if( n > 0 && head[n - 1] == '"' ) {
+		--n;
+	}
+	data = malloc( (n + 1) * sizeof( char ) );
+	if( !data ) {
+		return -1;
 	}
+	memcpy( data, head, n );
+	data[n] = 0;
 	SetStyle( ss, key, data, string );
 	return 0;
 }
@@ -563,6 +589,88 @@ static int OnParseBackgroundSize( LCUI_StyleSheet ss, int key, const char *str )
 	return 0;
 }
 
+/** 判断是否为不带单位的数字，flex 简写属性以此区分伸缩系数和基准尺寸 */
+static LCUI_BOOL IsFlexFactor( LCUI_Style s, const char *str )
+{
+	if( s->type == SVT_VALUE ) {
+		return TRUE;
+	}
+	return s->type == SVT_SCALE && !strchr( str, '%' );
+}
+
+/**
+ * 解析 flex 简写属性
+ * 依次指定 flex-grow、flex-shrink 和 flex-basis，省略的伸缩系数为 1，省略的
+ * 基准尺寸为 0，none 和 auto 分别等同于 0 0 auto 和 1 1 auto。
+ */
+static int OnParseFlex( LCUI_StyleSheet ss, int key, const char *str )
+{
+	int i, n, factors = 0;
+	char values[3][32];
+	LCUI_StyleRec s, slist[3];
+
+	if( strcmp( str, "none" ) == 0 ) {
+		str = "0 0 auto";
+	} else if( strcmp( str, "auto" ) == 0 ) {
+		str = "1 1 auto";
+	}
+	n = sscanf( str, "%31s %31s %31s", values[0], values[1], values[2] );
+	if( n < 1 ) {
+		return -1;
+	}
+	slist[0].is_valid = slist[1].is_valid = slist[2].is_valid = TRUE;
+	slist[0].type = slist[1].type = SVT_VALUE;
+	slist[0].value = slist[1].value = 1;
+	slist[2].type = SVT_PX;
+	slist[2].px = 0;
+	for( i = 0; i < n; ++i ) {
+		if( strcmp( values[i], "auto" ) == 0 ) {
+			s.is_valid = TRUE;
+			s.type = SVT_AUTO;
+			s.style = SV_AUTO;
+		} else if( !ParseNumber( &s, values[i] ) ) {
+			return -1;
+		}
+		if( factors < 2 && IsFlexFactor( &s, values[i] ) ) {
+			slist[factors++] = s;
+		} else if( i == n - 1 ) {
+			slist[2] = s;
+		} else {
+			return -1;
+		}
+	}
+	ss->sheet[key_flex_grow] = slist[0];
+	ss->sheet[key_flex_shrink] = slist[1];
+	ss->sheet[key_flex_basis] = slist[2];
+	return 0;
+}
+
+/** 解析 flex-flow 简写属性，包括 flex-direction 和 flex-wrap */
+static int OnParseFlexFlow( LCUI_StyleSheet ss, int key, const char *str )
+{
+	int i, n;
+	LCUI_StyleRec slist[2];
+
+	n = SplitValues( str, slist, 2, SPLIT_STYLE );
+	if( n < 1 ) {
+		return -1;
+	}
+	for( i = 0; i < n; ++i ) {
+		switch( slist[i].style ) {
+		case SV_ROW:
+		case SV_COLUMN:
+			ss->sheet[key_flex_direction] = slist[i];
+			break;
+		case SV_WRAP:
+		case SV_NOWRAP:
+			ss->sheet[key_flex_wrap] = slist[i];
+			break;
+		default: return -1;
+		}
+	}
+	return 0;
+}
+
 
 /** 各个样式的解析器映射表 */
 static LCUI_StyleParserRec style_parser_map[] = {
@@ -609,6 +717,13 @@ static LCUI_StyleParserRec style_parser_map[] = {
 	{ key_focusable, NULL, OnParseBoolean },
 	{ key_pointer_events, NULL, OnParseStyleOption },
 	{ key_box_sizing, NULL, OnParseStyleOption },
+	{ key_flex_grow, NULL, OnParseNumber },
+	{ key_flex_shrink, NULL, OnParseNumber },
+	{ key_flex_basis, NULL, OnParseNumber },
+	{ key_flex_direction, NULL, OnParseStyleOption },
+	{ key_flex_wrap, NULL, OnParseStyleOption },
+	{ key_justify_content, NULL, OnParseStyleOption },
+	{ key_align_items, NULL, OnParseStyleOption },
 	{ -1, "border", OnParseBorder },
 	{ -1, "border-left", OnParseBorderLeft },
 	{ -1, "border-top", OnParseBorderTop },
@@ -621,218 +736,384 @@ static LCUI_StyleParserRec style_parser_map[] = {
 	{ -1, "padding", OnParsePadding },
 	{ -1, "margin", OnParseMargin },
 	{ -1, "box-shadow", OnParseBoxShadow },
+	{ -1, "flex", OnParseFlex },
+	{ -1, "flex-flow", OnParseFlexFlow },
 	{ -1, "background", OnParseBackground }
 };
 
-static CSSParserContext NewCSSParserContext( size_t buffer_size, 
-					     const char *space )
+/**
+ * 跳过注释
+ * @param[in] line_comment 是否支持 // 单行注释，属性值中不能支持，否则
+ *  url(http://...) 之类的值会被截断
+ * @returns 注释之后的位置，如果 p 处不是注释则返回 p
+ */
+static const char *SkipComment( const char *p, const char *end,
+				LCUI_BOOL line_comment )
 {
-	CSSParserContext ctx = NEW( CSSParserContextRec, 1 );
-	ctx->buffer = NEW( char, buffer_size );
-	ctx->buffer_size = buffer_size;
-	ctx->target = TARGET_NONE;
-	ctx->target_bak = TARGET_NONE;
-	ctx->space = space ? strdup( space ): NULL;
-	LinkedList_Init( &ctx->selectors );
-	return ctx;
+	if( p + 1 >= end || p[0] != '/' ) {
+		return p;
+	}
+	if( p[1] == '*' ) {
+		for( p += 2; p + 1 < end; ++p ) {
+			if( p[0] == '*' && p[1] == '/' ) {
+				return p + 2;
+			}
+		}
+		return end;
+	}
+	if( p[1] == '/' && line_comment ) {
+		for( p += 2; p < end && *p != '\n'; ++p );
+	}
+	return p;
 }
 
-static void DeleteCSSParserContext( CSSParserContext *ctx_ptr )
+/** 跳过空白字符和注释 */
+static void CSSTokenizer_SkipSpace( CSSTokenizer t, LCUI_BOOL line_comment )
 {
-	CSSParserContext ctx = *ctx_ptr;
-	LinkedList_Clear( &ctx->selectors, (FuncPtr)Selector_Delete );
-	free( ctx->buffer );
-	free( ctx );
-	*ctx_ptr = NULL;
+	const char *p;
+	while( t->cur < t->end ) {
+		if( IsSpaceChar( *t->cur ) ) {
+			++t->cur;
+			continue;
+		}
+		p = SkipComment( t->cur, t->end, line_comment );
+		if( p == t->cur ) {
+			break;
+		}
+		t->cur = p;
+	}
 }
 
-/** 载入CSS代码块，用于实现CSS代码的分块载入 */
-static int LCUI_LoadCSSBlock( CSSParserContext ctx, const char *str )
+/**
+ * 读取一段字符串，直到遇到 stops 中的字符为止
+ * 括号内的字符不会被当成结束符，如果是属性值，引号内的字符也不会。
+ * @param[in] is_value 是否为属性值
+ * @param[out] view 读取到的字符串在源码中的视图
+ * @returns 遇到的结束符，如果已经到了源码末尾则返回 0
+ */
+static char CSSTokenizer_ReadUntil( CSSTokenizer t, const char *stops,
+				    LCUI_BOOL is_value, CSSStringView view )
 {
-	size_t size = 0;
-	LCUI_Selector s;
-	LinkedListNode *node;
+	char ch, quote = 0;
+	int depth = 0;
+	const char *p;
 
-	ctx->ptr = str;
-	for( ; *ctx->ptr && size < ctx->buffer_size; ++ctx->ptr, ++size ) {
-		switch( ctx->target ) {
-		case TARGET_SELECTOR:
-			switch( *ctx->ptr ) {
-			case '/': goto proc_comment;
-			case '{':
-				ctx->target = TARGET_KEY;
-				ctx->css = StyleSheet();
-			case ',':
-				ctx->buffer[ctx->pos] = 0;
-				ctx->pos = 0;
-				DEBUG_MSG("selector: %s\n", ctx->buffer);
-				s = Selector( ctx->buffer );
-				if( !s ) {
-					// 解析出错 ...
-					break;
-				}
-				LinkedList_Append( &ctx->selectors, s );
-				break;
-			default:
-				ctx->buffer[ctx->pos++] = *ctx->ptr;
-				break;
+	view->str = t->cur;
+	view->has_comment = FALSE;
+	while( t->cur < t->end ) {
+		ch = *t->cur;
+		if( quote ) {
+			if( ch == quote ) {
+				quote = 0;
+			} else if( ch == '\\' && t->cur + 1 < t->end ) {
+				++t->cur;
 			}
+			++t->cur;
+			continue;
+		}
+		if( is_value && (ch == '"' || ch == '\'') ) {
+			quote = ch;
+			++t->cur;
+			continue;
+		}
+		p = SkipComment( t->cur, t->end, !is_value );
+		if( p != t->cur ) {
+			view->has_comment = TRUE;
+			t->cur = p;
+			continue;
+		}
+		if( ch == '(' ) {
+			++depth;
+		} else if( ch == ')' && depth > 0 ) {
+			--depth;
+		} else if( depth == 0 && ch && strchr( stops, ch ) ) {
 			break;
-		case TARGET_KEY:
-			switch( *ctx->ptr ) {
-			case '/': goto proc_comment;
-			case ' ':
-			case '\n':
-			case '\r':
-			case '\t':
-			case ';':
-				ctx->pos = 0;
-				continue;
-			case ':': break;
-			case '}':
-				ctx->target = TARGET_NONE;
-				goto put_css;
-			default:
-				ctx->buffer[ctx->pos++] = *ctx->ptr;
-				continue;
+		}
+		++t->cur;
+	}
+	view->len = t->cur - view->str;
+	return t->cur < t->end ? *t->cur : 0;
+}
+
+/**
+ * 将字符串视图转换成以 0 结尾的字符串
+ * 解析器只接受以 0 结尾的字符串，所以每个视图会被复制一次到上下文的缓存中，
+ * 复制时会剔除夹杂的注释和末尾的空白字符，缓存会随着字符串长度而增长。
+ */
+static const char *CSSParser_GetString( CSSParserContext ctx,
+					CSSStringView view,
+					LCUI_BOOL is_value )
+{
+	char *buf, quote = 0;
+	size_t len = 0, size;
+	const char *p, *next, *end = view->str + view->len;
+
+	if( view->len >= ctx->buffer_size ) {
+		size = ctx->buffer_size * 2;
+		if( size <= view->len ) {
+			size = view->len + 1;
+		}
+		buf = realloc( ctx->buffer, size );
+		if( !buf ) {
+			return NULL;
+		}
+		ctx->buffer = buf;
+		ctx->buffer_size = size;
+	}
+	buf = ctx->buffer;
+	if( !view->has_comment ) {
+		memcpy( buf, view->str, view->len );
+		len = view->len;
+	}
+	for( p = view->str; view->has_comment && p < end; ) {
+		if( quote ) {
+			if( *p == quote ) {
+				quote = 0;
+			} else if( *p == '\\' && p + 1 < end ) {
+				buf[len++] = *p++;
 			}
-			goto select_parser;
-		case TARGET_VALUE:
-			switch( *ctx->ptr ) {
-			case '/': goto proc_comment;
-			case '}':
-			case ';':
-				goto parse_value;
-			case '\n':
-			case '\r':
-			case '\t':
-			case ' ':
-				if( ctx->pos == 0 ) {
-					continue;
-				}
-			default:
-				ctx->buffer[ctx->pos++] = *ctx->ptr;
+		} else if( is_value && (*p == '"' || *p == '\'') ) {
+			quote = *p;
+		} else {
+			next = SkipComment( p, end, !is_value );
+			if( next != p ) {
+				p = next;
 				continue;
 			}
-			break;
-		case TARGET_COMMENT:
-			if( ctx->is_line_comment ) {
-				if( *ctx->ptr == '\n' ) {
-					ctx->target = ctx->target_bak;
-				}
-				break;
-			}
-			if( *ctx->ptr == '/' && *(ctx->ptr - 1) == '*' ) {
-				ctx->target = ctx->target_bak;
-			}
-			break;
-		case TARGET_NONE:
-		default:
-			switch( *ctx->ptr ) {
-			case '/': goto proc_comment;
-			case '\n':
-			case '\t':
-			case '\r':
-			case ' ':
-			case ',':
-			case '{':
-			case '\\':
-			case '"':
-			case '}': continue;
-			default: break;
-			}
-			ctx->pos = 0;
-			ctx->buffer[ctx->pos++] = *ctx->ptr;
-			ctx->target = TARGET_SELECTOR;
-			break;
 		}
-		continue;
-proc_comment:
-		switch( *(ctx->ptr + 1) ) {
-		case '/': ctx->is_line_comment = TRUE; break;
-		case '*': ctx->is_line_comment = FALSE; break;
-		default:
-			ctx->buffer[ctx->pos++] = *ctx->ptr;
+		buf[len++] = *p++;
+	}
+	while( len > 0 && IsSpaceChar( buf[len - 1] ) ) {
+		--len;
+	}
+	buf[len] = 0;
+	return buf;
+}
+
+/**
+ * 解析声明块中的属性，直到遇到 } 为止
+ * @returns 声明块是否完整
+ */
+static LCUI_BOOL CSSParser_ParseDeclarations( CSSParserContext ctx )
+{
+	char ch;
+	const char *str;
+	CSSStringViewRec view;
+	LCUI_StyleParser parser;
+	CSSTokenizer t = &ctx->tokenizer;
+
+	while( 1 ) {
+		CSSTokenizer_SkipSpace( t, TRUE );
+		if( t->cur >= t->end ) {
+			return FALSE;
+		}
+		if( *t->cur == ';' ) {
+			++t->cur;
 			continue;
 		}
-		if( ctx->target_bak != TARGET_COMMENT ) {
-			ctx->target_bak = ctx->target;
-			ctx->target = TARGET_COMMENT;
+		if( *t->cur == '}' ) {
+			++t->cur;
+			return TRUE;
 		}
-		continue;
-put_css:
-		DEBUG_MSG("put css\n");
-		/* 将记录的样式表添加至匹配到的选择器中 */
-		for( LinkedList_Each( node, &ctx->selectors ) ) {
-			LCUI_PutStyleSheet( node->data, ctx->css, ctx->space );
+		ch = CSSTokenizer_ReadUntil( t, ":;}", FALSE, &view );
+		if( ch != ':' ) {
+			continue;
 		}
-		LinkedList_Clear( &ctx->selectors, (FuncPtr)Selector_Delete );
-		StyleSheet_Delete( ctx->css );
-		continue;
-select_parser:
-		ctx->target = TARGET_VALUE;
-		ctx->buffer[ctx->pos] = 0;
-		ctx->pos = 0;
-		ctx->parser = Dict_FetchValue( self.parsers, ctx->buffer );
-		DEBUG_MSG("select style: %s, parser: %p\n",
-			   ctx->buffer, ctx->parser);
-		continue;
-parse_value:
-		if( *ctx->ptr == ';' ) {
-			ctx->target = TARGET_KEY;
-		}
-		if( !ctx->parser ) {
+		++t->cur;
+		str = CSSParser_GetString( ctx, &view, FALSE );
+		parser = str ? Dict_FetchValue( self.parsers, str ) : NULL;
+		DEBUG_MSG("select style: %s, parser: %p\n", str, parser);
+		CSSTokenizer_SkipSpace( t, FALSE );
+		CSSTokenizer_ReadUntil( t, ";}", TRUE, &view );
+		if( !parser ) {
 			continue;
 		}
-		ctx->buffer[ctx->pos] = 0;
-		ctx->pos = 0;
-		ctx->parser->parse( ctx->css, ctx->parser->key, ctx->buffer );
-		DEBUG_MSG("parse style value: %s, result: %d\n", ctx->buffer);
-		if( *ctx->ptr == '}' ) {
-			ctx->target = TARGET_NONE;
-			goto put_css;
+		str = CSSParser_GetString( ctx, &view, TRUE );
+		if( str ) {
+			parser->parse( ctx->css, parser->key, str );
+			DEBUG_MSG("parse style value: %s\n", str);
 		}
 	}
-	return size;
 }
 
-/** 从文件中载入CSS样式数据，并导入至样式库中 */
-int LCUI_LoadCSSFile( const char *filepath )
+/** 解析一条规则，包括选择器列表和声明块 */
+static void CSSParser_ParseRule( CSSParserContext ctx )
+{
+	char ch;
+	const char *str;
+	LCUI_Selector s;
+	LinkedListNode *node;
+	CSSStringViewRec view;
+	CSSTokenizer t = &ctx->tokenizer;
+
+	do {
+		CSSTokenizer_SkipSpace( t, TRUE );
+		ch = CSSTokenizer_ReadUntil( t, ",{", FALSE, &view );
+		if( ch ) {
+			++t->cur;
+		}
+		str = CSSParser_GetString( ctx, &view, FALSE );
+		if( !str || !str[0] ) {
+			continue;
+		}
+		DEBUG_MSG("selector: %s\n", str);
+		s = Selector( str );
+		if( s ) {
+			LinkedList_Append( &ctx->selectors, s );
+		}
+	} while( ch == ',' );
+	if( ch == '{' ) {
+		ctx->css = StyleSheet();
+		if( CSSParser_ParseDeclarations( ctx ) ) {
+			DEBUG_MSG("put css\n");
+			/* 将记录的样式表交给处理函数，默认是添加至样式库 */
+			for( LinkedList_Each( node, &ctx->selectors ) ) {
+				ctx->handler( node->data, ctx->css,
+					      ctx->space, ctx->data );
+			}
+		}
+		StyleSheet_Delete( ctx->css );
+		ctx->css = NULL;
+	}
+	LinkedList_Clear( &ctx->selectors, (FuncPtr)Selector_Delete );
+}
+
+/** 解析内存中的 CSS 代码，代码不需要以 0 结尾 */
+static int LCUI_ParseCSSBuffer( const char *data, size_t len,
+				const char *space,
+				LCUI_CSSRuleHandler handler, void *handler_data )
+{
+	CSSParserContextRec ctx;
+	CSSTokenizer t = &ctx.tokenizer;
+
+	DEBUG_MSG("parse begin\n");
+	ctx.css = NULL;
+	ctx.space = space;
+	ctx.handler = handler;
+	ctx.data = handler_data;
+	ctx.buffer_size = 256;
+	ctx.buffer = malloc( ctx.buffer_size );
+	if( !ctx.buffer ) {
+		return -1;
+	}
+	LinkedList_Init( &ctx.selectors );
+	t->cur = data;
+	t->end = data + len;
+	/* 跳过 UTF-8 编码的 BOM */
+	if( len >= 3 && memcmp( data, "\xef\xbb\xbf", 3 ) == 0 ) {
+		t->cur += 3;
+	}
+	while( 1 ) {
+		CSSTokenizer_SkipSpace( t, TRUE );
+		if( t->cur >= t->end ) {
+			break;
+		}
+		switch( *t->cur ) {
+		case ',':
+		case '{':
+		case '\\':
+		case '"':
+		case '}':
+			++t->cur;
+			continue;
+		default: break;
+		}
+		CSSParser_ParseRule( &ctx );
+	}
+	free( ctx.buffer );
+	DEBUG_MSG("parse end\n");
+	return 0;
+}
+
+/** 通过标准输入输出库读取整个文件，然后解析其中的 CSS 代码 */
+static int LCUI_ParseCSSFileByStream( const char *filepath,
+				      LCUI_CSSRuleHandler handler,
+				      void *handler_data )
 {
-	int n;
 	FILE *fp;
-	char buff[512];
-	CSSParserContext ctx;
+	char *data, *buf;
+	size_t n, len = 0, size = 4096;
 
-	fp = fopen( filepath, "r" );
+	fp = fopen( filepath, "rb" );
 	if( !fp ) {
 		return -1;
 	}
-	ctx = NewCSSParserContext( 512, filepath );
-	n = fread( buff, 1, 511, fp );
-	while( n > 0 ) {
-		buff[n] = 0;
-		LCUI_LoadCSSBlock( ctx, buff );
-		n = fread( buff, 1, 511, fp );
+	data = malloc( size );
+	while( data ) {
+		n = fread( data + len, 1, size - len, fp );
+		len += n;
+		if( len < size ) {
+			break;
+		}
+		size *= 2;
+		buf = realloc( data, size );
+		if( !buf ) {
+			free( data );
+		}
+		data = buf;
 	}
-	DeleteCSSParserContext( &ctx );
 	fclose( fp );
+	if( !data ) {
+		return -1;
+	}
+	LCUI_ParseCSSBuffer( data, len, filepath, handler, handler_data );
+	free( data );
 	return 0;
 }
 
-int LCUI_LoadCSSString( const char *str, const char *space )
+int LCUI_ParseCSSFile( const char *filepath,
+		       LCUI_CSSRuleHandler handler, void *data )
 {
-	int len = 1;
-	const char *cur;
-	CSSParserContext ctx;
-	DEBUG_MSG("parse begin\n");
-	ctx = NewCSSParserContext( 512, space );
-	for( cur = str; len > 0; cur += len ) {
-		len = LCUI_LoadCSSBlock( ctx, cur );
+#ifdef USE_MMAP_CSS_FILE
+	int fd;
+	void *buf;
+	struct stat st;
+
+	/* 直接映射文件内容，省去读取到缓存中的开销 */
+	fd = open( filepath, O_RDONLY );
+	if( fd < 0 ) {
+		return -1;
 	}
-	DeleteCSSParserContext( &ctx );
-	DEBUG_MSG("parse end\n");
-	return 0;
+	if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) ) {
+		if( st.st_size == 0 ) {
+			close( fd );
+			return 0;
+		}
+		buf = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( buf != MAP_FAILED ) {
+			close( fd );
+			LCUI_ParseCSSBuffer( buf, st.st_size, filepath,
+					     handler, data );
+			munmap( buf, st.st_size );
+			return 0;
+		}
+	}
+	close( fd );
+#endif
+	return LCUI_ParseCSSFileByStream( filepath, handler, data );
+}
+
+int LCUI_ParseCSSString( const char *str, const char *space,
+			 LCUI_CSSRuleHandler handler, void *data )
+{
+	return LCUI_ParseCSSBuffer( str, strlen( str ), space, handler, data );
+}
+
+static void OnPutStyleSheet( LCUI_Selector s, LCUI_StyleSheet ss,
+			     const char *space, void *data )
+{
+	LCUI_PutStyleSheet( s, ss, space );
+}
+
+/** 从文件中载入CSS样式数据，并导入至样式库中 */
+int LCUI_LoadCSSFile( const char *filepath )
+{
+	return LCUI_ParseCSSFile( filepath, OnPutStyleSheet, NULL );
+}
+
+int LCUI_LoadCSSString( const char *str, const char *space )
+{
+	return LCUI_ParseCSSString( str, space, OnPutStyleSheet, NULL );
 }
 
 int LCUI_AddCSSParser( LCUI_StyleParser sp )
@@ -54,8 +54,6 @@ static struct LCUIWidgetModule {
 	DictType dt_attributes;		/**< 部件属性表的类型模板 */
 } LCUIWidget;
 
-#define StrList_Destroy freestrs
-
 LCUI_Widget LCUIWidget_GetRoot(void)
 {
 	return LCUIWidget.root;
@@ -115,10 +113,17 @@ int Widget_Unlink( LCUI_Widget widget )
 		node = node->next;
 	}
 	node = Widget_GetNode( widget );
+	Widget_RemoveLayoutChild( widget->parent, widget );
 	LinkedList_Unlink( &widget->parent->children, node );
 	LinkedList_Unlink( &widget->parent->children_show, snode );
 	Widget_PostSurfaceEvent( widget, WET_REMOVE );
 	widget->parent = NULL;
+	/* 弹性布局分配的尺寸只在原来的父级部件中有效 */
+	if( widget->layout.flex_width >= 0 || widget->layout.flex_height >= 0 ) {
+		widget->layout.flex_width = -1;
+		widget->layout.flex_height = -1;
+		Widget_AddTask( widget, WTT_RESIZE );
+	}
 	return 0;
 }
 
@@ -151,7 +156,7 @@ int Widget_Append( LCUI_Widget parent, LCUI_Widget widget )
 	Widget_AddTaskForChildren( widget, WTT_REFRESH_STYLE );
 	Widget_UpdateTaskStatus( widget );
 	Widget_UpdateStatus( widget );
-	Widget_UpdateLayout( parent );
+	Widget_UpdateLayoutFrom( parent, widget );
 	return 0;
 }
 
@@ -185,7 +190,7 @@ int Widget_Prepend( LCUI_Widget parent, LCUI_Widget widget )
 	Widget_AddTaskForChildren( widget, WTT_REFRESH_STYLE );
 	Widget_UpdateTaskStatus( widget );
 	Widget_UpdateStatus( widget );
-	Widget_UpdateLayout( parent );
+	Widget_UpdateLayoutFrom( parent, widget );
 	return 0;
 }
 
@@ -231,6 +236,8 @@ int Widget_Unwrap( LCUI_Widget widget )
 		node = LinkedList_GetNode( list, -1 );
 		Widget_AddStatus( node->data, "last-child" );
 	}
+	/* 移入的子部件没有布局缓存，需要重新布局全部子部件 */
+	Widget_UpdateLayout( widget->parent );
 	Widget_Destroy( widget );
 	return 0;
 }
@@ -243,7 +250,8 @@ static void Widget_Init( LCUI_Widget widget )
 	widget->trigger = EventTrigger();
 	widget->style = StyleSheet();
 	widget->custom_style = StyleSheet();
-	widget->inherited_style = StyleSheet();
+	widget->inherited_style = NULL;
+	widget->task.depth = -1;
 	widget->computed_style.opacity = 1.0;
 	widget->computed_style.visible = TRUE;
 	widget->computed_style.focusable = TRUE;
@@ -251,6 +259,15 @@ static void Widget_Init( LCUI_Widget widget )
 	widget->computed_style.position = SV_STATIC;
 	widget->computed_style.pointer_events = SV_AUTO;
 	widget->computed_style.box_sizing = SV_CONTENT_BOX;
+	widget->computed_style.flex.shrink = 1;
+	widget->computed_style.flex.direction = SV_ROW;
+	widget->computed_style.flex.wrap = SV_NOWRAP;
+	widget->computed_style.flex.justify_content = SV_FLEX_START;
+	widget->computed_style.flex.align_items = SV_STRETCH;
+	widget->layout.natural_width = -1;
+	widget->layout.natural_height = -1;
+	widget->layout.flex_width = -1;
+	widget->layout.flex_height = -1;
 	widget->computed_style.margin.top.type = SVT_PX;
 	widget->computed_style.margin.right.type = SVT_PX;
 	widget->computed_style.margin.bottom.type = SVT_PX;
@@ -264,7 +281,9 @@ static void Widget_Init( LCUI_Widget widget )
 	Border_Init( &widget->computed_style.border );
 	LinkedList_Init( &widget->children );
 	LinkedList_Init( &widget->children_show );
-	LinkedList_Init( &widget->dirty_rects );
+	Region_Init( &widget->dirty_rects );
+	Region_Init( &widget->dirty_layer_rects );
+	LCUIMutex_Init( &widget->layer_mutex );
 	Graph_Init( &widget->graph );
 }
 
@@ -313,11 +332,17 @@ void Widget_ExecDestroy( LCUI_Widget widget )
 	if( widget->proto && widget->proto->destroy ) {
 		widget->proto->destroy( widget );
 	}
-	RectList_Clear( &widget->dirty_rects );
-	StyleSheet_Delete( widget->inherited_style );
+	Region_Free( &widget->dirty_rects );
+	Region_Free( &widget->dirty_layer_rects );
+	LCUIMutex_Destroy( &widget->layer_mutex );
+	Graph_Free( &widget->graph );
+	Widget_ReleaseInheritStyle( widget );
 	StyleSheet_Delete( widget->custom_style );
 	StyleSheet_Delete( widget->style );
-	Widget_UpdateLayout( widget->parent );
+	/* 已被移出的部件在移出时就已经更新了父级部件的布局 */
+	if( widget->parent && widget->state != WSTATE_DELETED ) {
+		Widget_RemoveLayoutChild( widget->parent, widget );
+	}
 	Widget_SetId( widget, NULL );
 	if( widget->type && !widget->proto ) {
 		free( widget->type );
@@ -329,10 +354,12 @@ void Widget_ExecDestroy( LCUI_Widget widget )
 		widget->title = NULL;
 	}
 	widget->attributes ? Dict_Release( widget->attributes ) : 0;
-	widget->classes ? StrList_Destroy( widget->classes ) : 0;
-	widget->status ? StrList_Destroy( widget->status ) : 0;
+	widget->classes ? free( widget->classes ) : 0;
+	widget->status ? free( widget->status ) : 0;
 	EventTrigger_Destroy( widget->trigger );
 	widget->trigger = NULL;
+	/* 销毁过程中可能会有新任务，所以最后才将部件移出任务队列 */
+	Widget_ClearTasks( widget );
 	free( widget );
 }
 
@@ -347,6 +374,9 @@ void Widget_Destroy( LCUI_Widget w )
 		e.type = WET_REMOVE;
 		w->state = WSTATE_DELETED;
 		Widget_TriggerEvent( w, &e, NULL );
+		if( w->parent ) {
+			Widget_RemoveLayoutChild( w->parent, w );
+		}
 		Widget_ExecDestroy( w );
 		return;
 	}
@@ -360,9 +390,6 @@ void Widget_Destroy( LCUI_Widget w )
 			child->index -= 1;
 			node = node->next;
 		}
-		if( w->computed_style.position != SV_ABSOLUTE ) {
-			Widget_UpdateLayout( w->parent );
-		}
 		Widget_PushInvalidArea( w, NULL, SV_GRAPH_BOX );
 		Widget_AddToTrash( w );
 	}
@@ -383,7 +410,7 @@ void Widget_Empty( LCUI_Widget w )
 			Widget_AddToTrash( node->data );
 			node = next;
 		}
-		Widget_PushInvalidArea( w, NULL, SV_GRAPH_BOX );
+		Widget_InvalidateArea( w, NULL, SV_GRAPH_BOX );
 		Widget_AddTask( w, WTT_LAYOUT );
 	} else {
 		LinkedList_ClearData( &w->children_show, NULL );
@@ -744,8 +771,24 @@ void Widget_UpdateBoxShadow( LCUI_Widget w )
 	Widget_AddTask( w, WTT_POSITION );
 }
 
+/** 判断部件是否为块级部件，弹性布局容器自身也按块级部件参与布局 */
+static LCUI_BOOL Widget_IsBlockLevel( LCUI_Widget w )
+{
+	return w->computed_style.display == SV_BLOCK ||
+		w->computed_style.display == SV_FLEX;
+}
+
+/** 判断部件的尺寸和位置是否由父级部件的弹性布局决定 */
+static LCUI_BOOL Widget_IsFlexItem( LCUI_Widget w )
+{
+	return w->parent && w->parent->computed_style.display == SV_FLEX &&
+		w->computed_style.display != SV_NONE &&
+		w->computed_style.position != SV_ABSOLUTE;
+}
+
 void Widget_UpdateVisibility( LCUI_Widget w )
 {
+	LinkedListNode *node;
 	int display = w->computed_style.display;
 	LCUI_Style s = &w->style->sheet[key_visible];
 	LCUI_BOOL visible = w->computed_style.visible;
@@ -762,21 +805,67 @@ void Widget_UpdateVisibility( LCUI_Widget w )
 	} else {
 		w->computed_style.display = SV_BLOCK;
 	}
+	/* 切换弹性布局后，子部件的尺寸和位置都需要重新计算 */
+	if( (display == SV_FLEX) != (w->computed_style.display == SV_FLEX) ) {
+		for( LinkedList_Each( node, &w->children ) ) {
+			Widget_AddTask( node->data, WTT_RESIZE );
+		}
+		Widget_UpdateLayout( w );
+	}
+	/* 可见性不变时 display 也可能变了，例如行内块变为块级，或者已隐藏的部件
+	 * 不再显示，父部件的布局都需要从这个部件开始更新 */
+	if( w->parent && w->computed_style.display != display ) {
+		Widget_UpdateLayoutFrom( w->parent, w );
+	}
 	if( visible == w->computed_style.visible ) {
 		return;
 	}
 	visible = w->computed_style.visible;
 	if( w->parent ) {
 		Widget_PushInvalidArea( w, NULL, SV_GRAPH_BOX );
-		if( w->computed_style.display != display ||
+		if( w->computed_style.display == display &&
 		    w->computed_style.position != SV_ABSOLUTE ) {
-			Widget_UpdateLayout( w->parent );
+			Widget_UpdateLayoutFrom( w->parent, w );
 		}
 	}
 	DEBUG_MSG( "visible: %s\n", visible ? "TRUE" : "FALSE" );
 	Widget_PostSurfaceEvent( w, visible ? WET_SHOW : WET_HIDE );
 }
 
+static float ComputeFlexFactor( LCUI_Widget w, int key, float default_value )
+{
+	LCUI_Style s = &w->style->sheet[key];
+	if( !s->is_valid ) {
+		return default_value;
+	}
+	switch( s->type ) {
+	case SVT_VALUE: return 1.0f * s->val_int;
+	case SVT_SCALE: return s->val_scale;
+	default: break;
+	}
+	return default_value;
+}
+
+void Widget_UpdateFlexBox( LCUI_Widget w )
+{
+	LCUI_FlexBoxStyle *flex = &w->computed_style.flex;
+	flex->grow = ComputeFlexFactor( w, key_flex_grow, 0 );
+	flex->shrink = ComputeFlexFactor( w, key_flex_shrink, 1 );
+	flex->direction = ComputeStyleOption( w, key_flex_direction, SV_ROW );
+	flex->wrap = ComputeStyleOption( w, key_flex_wrap, SV_NOWRAP );
+	flex->justify_content = ComputeStyleOption( w, key_justify_content,
+						    SV_FLEX_START );
+	flex->align_items = ComputeStyleOption( w, key_align_items,
+						SV_STRETCH );
+	/* 部件可能既是弹性布局容器，又是另一个容器中的子部件 */
+	if( w->computed_style.display == SV_FLEX ) {
+		Widget_UpdateLayout( w );
+	}
+	if( Widget_IsFlexItem( w ) ) {
+		Widget_UpdateLayoutFrom( w->parent, w );
+	}
+}
+
 void Widget_UpdateOpacity( LCUI_Widget w )
 {
 	float opacity = 1.0;
@@ -794,7 +883,8 @@ void Widget_UpdateOpacity( LCUI_Widget w )
 		}
 	}
 	w->computed_style.opacity = opacity;
-	Widget_InvalidateArea( w, NULL, SV_GRAPH_BOX );
+	/* 只是图层的不透明度有变化，部件自身的图层缓存依然有效 */
+	Widget_PushInvalidArea( w, NULL, SV_GRAPH_BOX );
 	DEBUG_MSG("opacity: %0.2f\n", opacity);
 }
 
@@ -873,7 +963,9 @@ static void Widget_UpdateChildrenSize( LCUI_Widget w )
 	for( LinkedList_Each( node, &w->children ) ) {
 		LCUI_Widget child = node->data;
 		LCUI_Style s = child->style->sheet;
-		if( child->computed_style.display == SV_BLOCK ) {
+		/* 弹性布局的子部件的尺寸由父级部件重新布局时分配 */
+		if( Widget_IsBlockLevel( child ) &&
+		    !Widget_IsFlexItem( child ) ) {
 			if( CheckStyleType( s, key_width, AUTO ) ||
 			    CheckStyleType( s, key_height, AUTO ) ) {
 				Widget_AddTask( child, WTT_RESIZE );
@@ -900,6 +992,58 @@ static void Widget_UpdateChildrenSize( LCUI_Widget w )
 	}
 }
 
+/** 检查部件的尺寸或位置是否依赖父级部件的高度 */
+static LCUI_BOOL Widget_DependsOnParentHeight( LCUI_Widget w )
+{
+	LCUI_Style s = w->style->sheet;
+	if( CheckStyleType( s, key_height, SCALE ) ) {
+		return TRUE;
+	}
+	if( w->computed_style.position == SV_ABSOLUTE &&
+	    (s[key_bottom].is_valid || CheckStyleType( s, key_top, scale )) ) {
+		return TRUE;
+	}
+	return w->computed_style.vertical_align != SV_TOP;
+}
+
+/** 在部件只有高度有变化时，只更新依赖它的高度的子级部件 */
+static void Widget_UpdateChildrenHeight( LCUI_Widget w )
+{
+	LCUI_Style s;
+	LCUI_Widget child;
+	LinkedListNode *node;
+	LCUI_BOOL found = FALSE;
+
+	if( !w->layout.has_height_dependents ) {
+		return;
+	}
+	for( LinkedList_Each( node, &w->children ) ) {
+		child = node->data;
+		if( !Widget_DependsOnParentHeight( child ) ) {
+			continue;
+		}
+		found = TRUE;
+		s = child->style->sheet;
+		if( CheckStyleType( s, key_height, SCALE ) ) {
+			Widget_AddTask( child, WTT_RESIZE );
+		}
+		Widget_AddTask( child, WTT_POSITION );
+	}
+	w->layout.has_height_dependents = found;
+}
+
+/** 标记子部件的占用区域有变动，父级部件在计算内容尺寸时会从这里开始重新计算 */
+static void Widget_MarkSizeChanged( LCUI_Widget w )
+{
+	LCUI_Widget child = w->parent->layout.dirty_size_child;
+	if( !child || w->index < child->index ) {
+		w->parent->layout.dirty_size_child = w;
+	}
+	if( Widget_DependsOnParentHeight( w ) ) {
+		w->parent->layout.has_height_dependents = TRUE;
+	}
+}
+
 void Widget_UpdatePosition( LCUI_Widget w )
 {
 	LCUI_Rect rect;
@@ -911,7 +1055,7 @@ void Widget_UpdatePosition( LCUI_Widget w )
 	w->computed_style.right = ComputeYNumber( w, key_right );
 	w->computed_style.bottom = ComputeYNumber( w, key_bottom );
 	if( w->parent && w->computed_style.position != position ) {
-		Widget_UpdateLayout( w->parent );
+		Widget_UpdateLayoutFrom( w->parent, w );
 		Widget_ClearComputedSize( w );
 		Widget_UpdateChildrenSize( w );
 	}
@@ -995,11 +1139,12 @@ void Widget_UpdatePosition( LCUI_Widget w )
 	w->box.graph.x -= BoxShadow_GetBoxX( &w->computed_style.shadow );
 	w->box.graph.y -= BoxShadow_GetBoxY( &w->computed_style.shadow );
 	if( w->parent ) {
+		Widget_MarkSizeChanged( w );
 		DEBUG_MSG("new-rect: %d,%d,%d,%d\n", w->box.graph.x, w->box.graph.y, w->box.graph.w, w->box.graph.h);
 		DEBUG_MSG("old-rect: %d,%d,%d,%d\n", rect.x, rect.y, rect.width, rect.height);
 		/* 标记移动前后的区域 */
 		Widget_PushInvalidArea( w, NULL, SV_GRAPH_BOX );
-		Widget_PushInvalidArea( w->parent, &rect, SV_PADDING_BOX );
+		Widget_InvalidateArea( w->parent, &rect, SV_PADDING_BOX );
 	}
 	/* 检测是否为顶级部件并做相应处理 */
 	Widget_PostSurfaceEvent( w, WET_MOVE );
@@ -1015,79 +1160,137 @@ static void Widget_UpdateGraphBox( LCUI_Widget w )
 	rg->y = w->y - BoxShadow_GetBoxY( shadow );
 	rg->width = BoxShadow_GetWidth( shadow, rb->width );
 	rg->height = BoxShadow_GetHeight( shadow, rb->height );
-	if( !w->enable_graph ) {
-		Graph_Free( &w->graph );
+	/* 图层缓存会在渲染时按照新的尺寸重新创建 */
+}
+
+/** 计算子部件在父级部件的内容框中占用的区域的右下角坐标 */
+static void Widget_ComputeChildExtent( LCUI_Widget child,
+				       float *width, float *height )
+{
+	float n;
+	LCUI_Style s;
+	LCUI_WidgetBoxRect *box = &child->box;
+	LCUI_WidgetStyle *style = &child->computed_style;
+
+	*width = *height = 0.0;
+	/* 忽略不可见、绝对定位的部件 */
+	if( !style->visible || style->position == SV_ABSOLUTE ) {
 		return;
 	}
-	/* 如果有会产生透明效果的样式 */
-	if( w->computed_style.border.bottom_left_radius > 0
-	    || w->computed_style.border.bottom_right_radius > 0
-	    || w->computed_style.border.top_left_radius > 0
-	    || w->computed_style.border.top_right_radius > 0
-	    || w->computed_style.background.color.alpha < 255
-	    || w->computed_style.shadow.blur > 0 ) {
-		w->graph.color_type = COLOR_TYPE_ARGB;
+	s = &child->style->sheet[key_width];
+	/* 对于宽度以百分比做单位的，计算尺寸时自动去除外间距框、内间距框和
+	 * 边框占用的空间
+	 */
+	if( s->type == SVT_SCALE ) {
+		if( style->box_sizing == SV_BORDER_BOX ) {
+			n = box->border.x + box->border.width;
+		} else {
+			n = box->content.x + box->content.width;
+			n -= box->content.x - box->border.x;
+		}
+		n -= box->outer.x - box->border.x;
+	} else if( box->outer.width <= 0 ) {
+		return;
 	} else {
-		w->graph.color_type = COLOR_TYPE_RGB;
+		n = box->outer.x + box->outer.width;
+	}
+	*width = n;
+	s = &child->style->sheet[key_height];
+	if( s->type == SVT_SCALE ) {
+		if( style->box_sizing == SV_BORDER_BOX ) {
+			n = box->border.y + box->border.height;
+		} else {
+			n = box->content.y + box->content.height;
+			n -= box->content.y - box->border.y;
+		}
+		n -= box->outer.y - box->border.y;
+	} else if( box->outer.height <= 0 ) {
+		return;
+	} else {
+		n = box->outer.y + box->outer.height;
 	}
-	Graph_Create( &w->graph, rg->width, rg->height );
+	*height = n;
 }
 
-/** 计算合适的内容框大小 */
+/** 按照边框盒尺寸设置部件的各个区域的尺寸 */
+static void Widget_SetBorderBoxSize( LCUI_Widget w, float width, float height )
+{
+	LCUI_Border *bbox = &w->computed_style.border;
+	w->width = width;
+	w->height = height;
+	w->box.border.width = width;
+	w->box.border.height = height;
+	w->box.padding.width = width - bbox->left.width - bbox->right.width;
+	w->box.padding.height = height - bbox->top.width - bbox->bottom.width;
+	w->box.content.width = w->box.padding.width;
+	w->box.content.height = w->box.padding.height;
+	w->box.content.width -= w->padding.left + w->padding.right;
+	w->box.content.height -= w->padding.top + w->padding.bottom;
+	w->box.outer.width = width + w->margin.left + w->margin.right;
+	w->box.outer.height = height + w->margin.top + w->margin.bottom;
+}
+
+/**
+ * 记录部件自身计算出的尺寸，然后改用弹性布局分配的尺寸
+ * 记录的尺寸是弹性布局的基准尺寸，它不受分配的尺寸影响，父级部件只在它有变动
+ * 时才需要重新测量。
+ */
+static void Widget_ApplyFlexSize( LCUI_Widget w )
+{
+	float width, height;
+	w->layout.natural_width = w->box.border.width;
+	w->layout.natural_height = w->box.border.height;
+	width = w->layout.flex_width;
+	height = w->layout.flex_height;
+	if( width < 0 ) {
+		width = w->box.border.width;
+	}
+	if( height < 0 ) {
+		height = w->box.border.height;
+	}
+	if( width != w->box.border.width || height != w->box.border.height ) {
+		Widget_SetBorderBoxSize( w, width, height );
+	}
+}
+
+/**
+ * 计算合适的内容框大小
+ * 每个子部件都缓存了它及之前的兄弟部件占用的区域，只需要从第一个有变动的子部件
+ * 开始计算。
+ */
 static void Widget_ComputeContentSize( LCUI_Widget w,
 				       float *width, float *height )
 {
-	float n;
-	LCUI_Style s;
+	float cw, ch;
+	LCUI_Widget child, prev;
 	LinkedListNode *node;
 
 	*width = *height = 0.0;
-	for( LinkedList_Each( node, &w->children_show ) ) {
-		LCUI_Widget child = node->data;
-		LCUI_WidgetBoxRect *box = &child->box;
-		LCUI_WidgetStyle *style = &child->computed_style;
-		/* 忽略不可见、绝对定位的部件 */
-		if( !style->visible || style->position == SV_ABSOLUTE ) {
-			continue;
-		}
-		s = &child->style->sheet[key_width];
-		/* 对于宽度以百分比做单位的，计算尺寸时自动去除外间距框、内间距框和
-		 * 边框占用的空间
-		 */
-		if( s->type == SVT_SCALE ) {
-			if( style->box_sizing == SV_BORDER_BOX ) {
-				n = box->border.x + box->border.width;
-			} else {
-				n = box->content.x + box->content.width;
-				n -= box->content.x - box->border.x;
+	child = w->layout.dirty_size_child;
+	if( child ) {
+		prev = Widget_GetPrev( child );
+		if( prev ) {
+			*width = prev->layout.content_width;
+			*height = prev->layout.content_height;
+		}
+		node = Widget_GetNode( child );
+		for( ; node; node = node->next ) {
+			child = node->data;
+			Widget_ComputeChildExtent( child, &cw, &ch );
+			if( cw > *width ) {
+				*width = cw;
 			}
-			n -= box->outer.x - box->border.x;
-		} else if( box->outer.width <= 0 ) {
-			continue;
-		} else {
-			n = box->outer.x + box->outer.width;
-		}
-		if( n > *width ) {
-			*width = n;
-		}
-		s = &child->style->sheet[key_height];
-		n = box->outer.y + box->outer.height;
-		if( s->type == SVT_SCALE ) {
-			if( style->box_sizing == SV_BORDER_BOX ) {
-				n = box->border.y + box->border.height;
-			} else {
-				n = box->content.y + box->content.height;
-				n -= box->content.y - box->border.y;
+			if( ch > *height ) {
+				*height = ch;
 			}
-			n -= box->outer.y - box->border.y;
-		} else if( box->outer.height <= 0 ) {
-			continue;
-		} else {
-			n = box->outer.y + box->outer.height;
-		}
-		if( n > *height ) {
-			*height = n;
+			child->layout.content_width = *width;
+			child->layout.content_height = *height;
 		}
+		w->layout.dirty_size_child = NULL;
+	} else if( w->children.length > 0 ) {
+		child = LinkedList_GetNode( &w->children, -1 )->data;
+		*width = child->layout.content_width;
+		*height = child->layout.content_height;
 	}
 	/* 计算出来的尺寸是包含 padding-left 和 padding-top 的，因此需要减去它们 */
 	*width -= w->padding.left;
@@ -1121,7 +1324,7 @@ static void Widget_ComputeSize( LCUI_Widget w )
 			height += bbox->top.width + bbox->bottom.width;
 		}
 		if( w->parent && sw->type == SVT_AUTO &&
-		    w->computed_style.display == SV_BLOCK &&
+		    Widget_IsBlockLevel( w ) && !Widget_IsFlexItem( w ) &&
 		    w->computed_style.position != SV_ABSOLUTE ) {
 			width = w->parent->box.content.width;
 			width -= w->margin.left + w->margin.right;
@@ -1225,6 +1428,40 @@ static void Widget_ComputeSize( LCUI_Widget w )
 	w->box.outer.height = w->box.border.height;
 	w->box.outer.width += w->margin.left + w->margin.right;
 	w->box.outer.height += w->margin.top + w->margin.bottom;
+	if( Widget_IsFlexItem( w ) ) {
+		Widget_ApplyFlexSize( w );
+	}
+}
+
+/**
+ * 判断部件是否为布局的边界
+ * 宽高都不是自适应的部件，其尺寸不受子部件影响，子部件的布局变动不需要继续向上
+ * 传递给它的父级部件。
+ */
+static LCUI_BOOL Widget_IsLayoutBoundary( LCUI_Widget w )
+{
+	return w->style->sheet[key_width].type != SVT_AUTO &&
+		w->style->sheet[key_height].type != SVT_AUTO;
+}
+
+/**
+ * 判断部件在水平或垂直方向上的尺寸是否确定
+ * 不确定的尺寸由子部件撑开，弹性布局不能在这个方向上分配剩余空间。
+ */
+static LCUI_BOOL Widget_HasDefiniteSize( LCUI_Widget w, LCUI_BOOL is_width )
+{
+	float size = is_width ? w->layout.flex_width : w->layout.flex_height;
+	LCUI_Style s = &w->style->sheet[is_width ? key_width : key_height];
+	if( Widget_IsFlexItem( w ) ) {
+		if( size >= 0 ) {
+			return TRUE;
+		}
+	} else if( is_width && w->parent && Widget_IsBlockLevel( w ) &&
+		   w->computed_style.position != SV_ABSOLUTE ) {
+		/* 块级部件的宽度会自动填满父级部件 */
+		return TRUE;
+	}
+	return s->is_valid && s->type != SVT_AUTO;
 }
 
 static void Widget_SendResizeEvent( LCUI_Widget w )
@@ -1297,13 +1534,12 @@ void Widget_UpdateMargin( LCUI_Widget w )
 		}
 	}
 	if( w->parent ) {
-		if( w->parent->style->sheet[key_width].type == SVT_AUTO ||
-		    w->parent->style->sheet[key_height].type == SVT_AUTO ) {
+		if( !Widget_IsLayoutBoundary( w->parent ) ) {
 			Widget_AddTask( w->parent, WTT_RESIZE );
 		}
 		if( w->computed_style.display != SV_NONE &&
 		    w->computed_style.position == SV_STATIC ) {
-			Widget_UpdateLayout( w->parent );
+			Widget_UpdateLayoutFrom( w->parent, w );
 		}
 	}
 	Widget_AddTask( w, WTT_POSITION );
@@ -1313,6 +1549,10 @@ void Widget_UpdateSize( LCUI_Widget w )
 {
 	LCUI_RectF rect;
 	int i, box_sizing;
+	float content_width = w->box.content.width;
+	float content_height = w->box.content.height;
+	float natural_width = w->layout.natural_width;
+	float natural_height = w->layout.natural_height;
 	LCUI_Rect2F padding = w->padding;
 	LCUI_BoundBox *pbox = &w->computed_style.padding;
 	struct {
@@ -1342,6 +1582,15 @@ void Widget_UpdateSize( LCUI_Widget w )
 	w->computed_style.box_sizing = box_sizing;
 	Widget_ComputeSize( w );
 	Widget_UpdateGraphBox( w );
+	if( w->parent ) {
+		Widget_MarkSizeChanged( w );
+	}
+	/* 基准尺寸有变化，父级部件需要重新分配弹性布局的空间 */
+	if( Widget_IsFlexItem( w ) &&
+	    (natural_width != w->layout.natural_width ||
+	     natural_height != w->layout.natural_height) ) {
+		Widget_UpdateLayoutFrom( w->parent, w );
+	}
 	/* 如果左右外间距是 auto 类型的，则需要计算外间距 */
 	if( w->style->sheet[key_margin_left].is_valid &&
 	    w->style->sheet[key_margin_left].type == SVT_AUTO ) {
@@ -1366,6 +1615,15 @@ void Widget_UpdateSize( LCUI_Widget w )
 	}
 	if( w->style->sheet[key_height].type != SVT_AUTO ) {
 		Widget_UpdateLayout( w );
+	} else if( w->computed_style.display == SV_FLEX ) {
+		/* 弹性布局按照确定的内容框尺寸分配空间，由子部件撑开的尺寸
+		 * 变化不影响它 */
+		if( (content_width != w->box.content.width &&
+		     Widget_HasDefiniteSize( w, TRUE )) ||
+		    (content_height != w->box.content.height &&
+		     Widget_HasDefiniteSize( w, FALSE )) ) {
+			Widget_UpdateLayout( w );
+		}
 	}
 	/* 如果垂直对齐方式不为顶部对齐 */
 	if( w->computed_style.vertical_align != SV_TOP ) {
@@ -1384,17 +1642,28 @@ void Widget_UpdateSize( LCUI_Widget w )
 		r.width = (int)(w->box.graph.width + 0.5);
 		r.height = (int)(w->box.graph.height + 0.5);
 		Widget_InvalidateArea( w->parent, &r, SV_PADDING_BOX );
-		if( w->parent->style->sheet[key_width].type == SVT_AUTO
-		    || w->parent->style->sheet[key_height].type == SVT_AUTO ) {
+		if( !Widget_IsLayoutBoundary( w->parent ) ) {
 			Widget_AddTask( w->parent, WTT_RESIZE );
 		}
+		/* 弹性布局只在基准尺寸有变化时才需要重新布局，分配的尺寸
+		 * 生效时不需要 */
 		if( w->computed_style.display != SV_NONE &&
-		    w->computed_style.position == SV_STATIC ) {
-			Widget_UpdateLayout( w->parent );
+		    w->computed_style.position == SV_STATIC &&
+		    !Widget_IsFlexItem( w ) ) {
+			Widget_UpdateLayoutFrom( w->parent, w );
 		}
 	}
 	Widget_SendResizeEvent( w );
-	Widget_UpdateChildrenSize( w );
+	/* 如果只有高度有变化，则大部分子部件的尺寸都不需要重新计算 */
+	if( content_width != w->box.content.width ||
+	    padding.top != w->padding.top ||
+	    padding.right != w->padding.right ||
+	    padding.bottom != w->padding.bottom ||
+	    padding.left != w->padding.left ) {
+		Widget_UpdateChildrenSize( w );
+	} else {
+		Widget_UpdateChildrenHeight( w );
+	}
 }
 
 void Widget_UpdateProps( LCUI_Widget w )
@@ -1568,33 +1837,30 @@ LCUI_BOOL Widget_CheckPrototype( LCUI_Widget w, LCUI_WidgetPrototypeC proto )
 /** 为部件添加一个类 */
 int Widget_AddClass( LCUI_Widget w, const char *class_name )
 {
-	if( strshas( w->classes, class_name ) ) {
+	if( Widget_HasClass( w, class_name ) ) {
 		return 1;
 	}
-	if( strsadd( &w->classes, class_name ) <= 0 ) {
+	if( AtomList_AddNames( &w->classes, class_name ) <= 0 ) {
 		return 0;
 	}
-	Widget_HandleChildrenStyleChange( w, 0, class_name );
-	Widget_UpdateStyle( w, TRUE );
+	Widget_HandleStyleChange( w, 0, class_name );
 	return 1;
 }
 
 /** 判断部件是否包含指定的类 */
 LCUI_BOOL Widget_HasClass( LCUI_Widget w, const char *class_name )
 {
-	if( strshas( w->classes, class_name ) ) {
-		return TRUE;
-	}
-	return FALSE;
+	LCUI_Atom atom = LCUIAtom_Find( class_name );
+	return AtomList_Has( w->classes, atom );
 }
 
 /** 从部件中移除一个类 */
 int Widget_RemoveClass( LCUI_Widget w, const char *class_name )
 {
-	if( strshas( w->classes, class_name ) ) {
-		Widget_HandleChildrenStyleChange( w, 0, class_name );
-		strsdel( &w->classes, class_name );
-		Widget_UpdateStyle( w, TRUE );
+	LCUI_Atom atom = LCUIAtom_Find( class_name );
+	if( AtomList_Has( w->classes, atom ) ) {
+		Widget_HandleStyleChange( w, 0, class_name );
+		AtomList_Delete( &w->classes, atom );
 		return 1;
 	}
 	return 0;
@@ -1602,31 +1868,28 @@ int Widget_RemoveClass( LCUI_Widget w, const char *class_name )
 
 int Widget_AddStatus( LCUI_Widget w, const char *status_name )
 {
-	if( strshas( w->status, status_name ) ) {
+	if( Widget_HasStatus( w, status_name ) ) {
 		return 0;
 	}
-	if( strsadd( &w->status, status_name ) <= 0 ) {
+	if( AtomList_AddNames( &w->status, status_name ) <= 0 ) {
 		return 0;
 	}
-	Widget_HandleChildrenStyleChange( w, 1, status_name );
-	Widget_UpdateStyle( w, TRUE );
+	Widget_HandleStyleChange( w, 1, status_name );
 	return 1;
 }
 
 LCUI_BOOL Widget_HasStatus( LCUI_Widget w, const char *status_name )
 {
-	if( strshas( w->status, status_name ) ) {
-		return TRUE;
-	}
-	return FALSE;
+	LCUI_Atom atom = LCUIAtom_Find( status_name );
+	return AtomList_Has( w->status, atom );
 }
 
 int Widget_RemoveStatus( LCUI_Widget w, const char *status_name )
 {
-	if( strshas( w->status, status_name ) ) {
-		Widget_HandleChildrenStyleChange( w, 1, status_name );
-		strsdel( &w->status, status_name );
-		Widget_UpdateStyle( w, TRUE );
+	LCUI_Atom atom = LCUIAtom_Find( status_name );
+	if( AtomList_Has( w->status, atom ) ) {
+		Widget_HandleStyleChange( w, 1, status_name );
+		AtomList_Delete( &w->status, atom );
 		return 1;
 	}
 	return 0;
@@ -1678,46 +1941,110 @@ void Widget_UnlockLayout( LCUI_Widget w )
 void Widget_UpdateLayout( LCUI_Widget w )
 {
 	if( !w->layout_locked ) {
+		w->layout.needs_layout = TRUE;
 		Widget_AddTask( w, WTT_LAYOUT );
 	}
 }
 
-void Widget_ExecUpdateLayout( LCUI_Widget w )
+void Widget_UpdateLayoutFrom( LCUI_Widget w, LCUI_Widget child )
+{
+	LCUI_Widget dirty = w->layout.dirty_child;
+	if( !dirty || child->index < dirty->index ) {
+		w->layout.dirty_child = child;
+	}
+	dirty = w->layout.dirty_size_child;
+	if( !dirty || child->index < dirty->index ) {
+		w->layout.dirty_size_child = child;
+	}
+	if( !w->layout_locked ) {
+		Widget_AddTask( w, WTT_LAYOUT );
+	}
+}
+
+void Widget_RemoveLayoutChild( LCUI_Widget w, LCUI_Widget child )
+{
+	LCUI_Widget next = Widget_GetNext( child );
+	LCUI_Widget dirty = w->layout.dirty_child;
+	/* 被移出的部件之后的子部件都需要重新布局 */
+	if( !dirty || dirty->index >= child->index ) {
+		w->layout.dirty_child = next;
+	}
+	dirty = w->layout.dirty_size_child;
+	if( !dirty || dirty->index >= child->index ) {
+		w->layout.dirty_size_child = next;
+	}
+	if( child->computed_style.position != SV_ABSOLUTE &&
+	    !w->layout_locked ) {
+		Widget_AddTask( w, WTT_LAYOUT );
+	}
+}
+
+/** 更新部件的准备状态，如果已经准备完毕则触发 ready 事件 */
+static void Widget_UpdateLayoutState( LCUI_Widget w )
+{
+	LCUI_WidgetEventRec e;
+	if( w->state >= WSTATE_READY ) {
+		return;
+	}
+	w->state |= WSTATE_LAYOUTED;
+	if( w->state == WSTATE_READY ) {
+		e.type = WET_READY;
+		e.cancel_bubble = TRUE;
+		Widget_TriggerEvent( w, &e, NULL );
+		w->state = WSTATE_NORMAL;
+	}
+}
+
+/** 按照常规流排列子部件 */
+static void Widget_ExecFlowLayout( LCUI_Widget w )
 {
 	struct {
 		float x, y;
 		float line_height;
-		LCUI_Widget prev;
 		int prev_display;
 		float max_width;
 	} ctx = { 0 };
-	LCUI_Widget child;
-	LCUI_WidgetEventRec e;
-	LinkedListNode *node;
+	int display;
+	LCUI_Widget child, prev;
+	LinkedListNode *node = NULL;
 
-	ctx.max_width = Widget_ComputeMaxWidth( w );
-	for( LinkedList_Each( node, &w->children ) ) {
+	if( w->layout.needs_layout ) {
+		node = w->children.head.next;
+	} else if( w->layout.dirty_child ) {
+		node = Widget_GetNode( w->layout.dirty_child );
+	}
+	ctx.prev_display = SV_NONE;
+	if( node ) {
+		child = node->data;
+		/* 从上一个子部件布局完后的状态继续布局 */
+		prev = Widget_GetPrev( child );
+		if( prev ) {
+			ctx.x = prev->layout.x;
+			ctx.y = prev->layout.y;
+			ctx.line_height = prev->layout.line_height;
+			ctx.prev_display = prev->layout.prev_display;
+		}
+		ctx.max_width = Widget_ComputeMaxWidth( w );
+	}
+	w->layout.needs_layout = FALSE;
+	w->layout.dirty_child = NULL;
+	for( ; node; node = node->next ) {
 		child = node->data;
 		if( child->computed_style.position != SV_STATIC &&
 		    child->computed_style.position != SV_RELATIVE ) {
-			/* 如果部件还处于未准备完毕的状态 */
-			if( child->state < WSTATE_READY ) {
-				child->state |= WSTATE_LAYOUTED;
-				/* 如果部件已经准备完毕则触发 ready 事件 */
-				if( child->state == WSTATE_READY ) {
-					LCUI_WidgetEventRec e;
-					e.type = WET_READY;
-					e.cancel_bubble = TRUE;
-					Widget_TriggerEvent( child, &e, NULL );
-					child->state = WSTATE_NORMAL;
-				}
-			}
-			continue;
+			Widget_UpdateLayoutState( child );
+			goto save_state;
 		}
-		switch( child->computed_style.display ) {
+		display = child->computed_style.display;
+		/* 弹性布局容器自身按块级部件排列 */
+		if( display == SV_FLEX ) {
+			display = SV_BLOCK;
+		}
+		switch( display ) {
 		case SV_BLOCK:
 			ctx.x = 0;
-			if( ctx.prev && ctx.prev_display != SV_BLOCK ) {
+			if( ctx.prev_display != SV_NONE &&
+			    ctx.prev_display != SV_BLOCK ) {
 				ctx.y += ctx.line_height;
 			}
 			child->origin_x = ctx.x;
@@ -1726,7 +2053,7 @@ void Widget_ExecUpdateLayout( LCUI_Widget w )
 			ctx.y += child->box.outer.height;
 			break;
 		case SV_INLINE_BLOCK:
-			if( ctx.prev && ctx.prev_display == SV_BLOCK ) {
+			if( ctx.prev_display == SV_BLOCK ) {
 				ctx.x = 0;
 				ctx.line_height = 0;
 			}
@@ -1743,24 +2070,357 @@ void Widget_ExecUpdateLayout( LCUI_Widget w )
 			}
 			break;
 		case SV_NONE:
-		default: continue;
+		default: goto save_state;
 		}
 		Widget_UpdatePosition( child );
-		if( child->state < WSTATE_READY ) {
-			child->state |= WSTATE_LAYOUTED;
-			if( child->state == WSTATE_READY ) {
-				LCUI_WidgetEventRec e;
-				e.type = WET_READY;
-				e.cancel_bubble = TRUE;
-				Widget_TriggerEvent( child, &e, NULL );
-				child->state = WSTATE_NORMAL;
+		Widget_UpdateLayoutState( child );
+		ctx.prev_display = display;
+save_state:
+		child->layout.x = ctx.x;
+		child->layout.y = ctx.y;
+		child->layout.line_height = ctx.line_height;
+		child->layout.prev_display = ctx.prev_display;
+	}
+}
+
+/** 弹性布局的上下文 */
+typedef struct FlexLayoutContextRec_ {
+	LCUI_BOOL is_row;		/**< 主轴是否为水平方向 */
+	LCUI_BOOL is_wrap;		/**< 是否允许换行 */
+	LCUI_BOOL has_main_size;	/**< 容器在主轴方向上的尺寸是否确定 */
+	LCUI_BOOL has_cross_size;	/**< 容器在交叉轴方向上的尺寸是否确定 */
+	float main_size;		/**< 容器在主轴方向上的内容框尺寸 */
+	float cross_size;		/**< 容器在交叉轴方向上的内容框尺寸 */
+	float cross_pos;		/**< 当前行在交叉轴方向上的位置 */
+	float line_main_size;		/**< 当前行中的子部件占用的主轴空间 */
+	float line_cross_size;		/**< 当前行中最高（或最宽）的子部件的尺寸 */
+	float total_grow;		/**< 当前行中的子部件的 flex-grow 之和 */
+	float total_shrink;		/**< 当前行中的子部件按基准尺寸加权的 flex-shrink 之和 */
+	int count;			/**< 当前行中的子部件数量 */
+} FlexLayoutContextRec, *FlexLayoutContext;
+
+/** 获取部件的内边距和边框在水平或垂直方向上占用的尺寸 */
+static float Widget_GetEdgeSize( LCUI_Widget w, LCUI_BOOL is_width )
+{
+	LCUI_Border *bbox = &w->computed_style.border;
+	if( is_width ) {
+		return w->padding.left + w->padding.right +
+			bbox->left.width * 1.0f + bbox->right.width * 1.0f;
+	}
+	return w->padding.top + w->padding.bottom +
+		bbox->top.width * 1.0f + bbox->bottom.width * 1.0f;
+}
+
+/** 获取部件的外边距在水平或垂直方向上占用的尺寸 */
+static float Widget_GetMarginSize( LCUI_Widget w, LCUI_BOOL is_width )
+{
+	if( is_width ) {
+		return w->margin.left + w->margin.right;
+	}
+	return w->margin.top + w->margin.bottom;
+}
+
+/** 将边框盒尺寸限制在部件的最小和最大尺寸之间 */
+static float Widget_ClampFlexSize( LCUI_Widget w, float size,
+				   LCUI_BOOL is_width )
+{
+	LCUI_WidgetStyle *style = &w->computed_style;
+	float edge = Widget_GetEdgeSize( w, is_width );
+	float min_size = is_width ? style->min_width : style->min_height;
+	float max_size = is_width ? style->max_width : style->max_height;
+	/* 最小和最大尺寸是按照 box-sizing 指定的框计算的 */
+	if( style->box_sizing != SV_BORDER_BOX ) {
+		if( min_size > -1 ) {
+			min_size += edge;
+		}
+		if( max_size > -1 ) {
+			max_size += edge;
+		}
+	}
+	if( max_size > -1 && size > max_size ) {
+		size = max_size;
+	}
+	if( size < min_size ) {
+		size = min_size;
+	}
+	if( size < edge ) {
+		size = edge;
+	}
+	return size;
+}
+
+/**
+ * 计算子部件在主轴方向上的基准尺寸
+ * 未指定 flex-basis 时以部件自身计算出的尺寸为准，它在部件调整尺寸时已经测量
+ * 并缓存好了，不需要在布局时再测量一遍。
+ */
+static float Widget_ComputeFlexBasis( LCUI_Widget w, FlexLayoutContext ctx )
+{
+	float basis;
+	LCUI_Style s = &w->style->sheet[key_flex_basis];
+
+	if( !s->is_valid || s->type == SVT_AUTO || s->type == SVT_NONE ||
+	    (s->type == SVT_SCALE && !ctx->has_main_size) ) {
+		return ctx->is_row ? w->layout.natural_width :
+			w->layout.natural_height;
+	}
+	if( ctx->is_row ) {
+		basis = ComputeXNumber( w, key_flex_basis );
+	} else {
+		basis = ComputeYNumber( w, key_flex_basis );
+	}
+	if( w->computed_style.box_sizing != SV_BORDER_BOX ) {
+		basis += Widget_GetEdgeSize( w, ctx->is_row );
+	}
+	return Widget_ClampFlexSize( w, basis, ctx->is_row );
+}
+
+/** 获取子部件在交叉轴方向上的尺寸，不包括外边距 */
+static float Widget_GetFlexCrossSize( LCUI_Widget w, FlexLayoutContext ctx )
+{
+	if( ctx->is_row ) {
+		return w->layout.natural_height;
+	}
+	return w->layout.natural_width;
+}
+
+/** 判断子部件是否需要在交叉轴方向上拉伸至整行的尺寸 */
+static LCUI_BOOL Widget_IsFlexStretched( LCUI_Widget w, FlexLayoutContext ctx )
+{
+	LCUI_Style s = &w->style->sheet[ctx->is_row ? key_height : key_width];
+	if( w->parent->computed_style.flex.align_items != SV_STRETCH ) {
+		return FALSE;
+	}
+	return !s->is_valid || s->type == SVT_AUTO;
+}
+
+/**
+ * 设置弹性布局分配给子部件的尺寸
+ * 新尺寸会在部件调整尺寸时生效，与当前尺寸相同时不需要再调整。
+ */
+static void Widget_SetFlexSize( LCUI_Widget w, float width, float height )
+{
+	float real_width = width >= 0 ? width : w->layout.natural_width;
+	float real_height = height >= 0 ? height : w->layout.natural_height;
+	w->layout.flex_width = width;
+	w->layout.flex_height = height;
+	if( real_width != w->box.border.width ||
+	    real_height != w->box.border.height ) {
+		Widget_AddTask( w, WTT_RESIZE );
+	}
+}
+
+/** 分配一行子部件的尺寸，然后按照对齐方式排列它们 */
+static void Widget_ArrangeFlexLine( LCUI_Widget w, FlexLayoutContext ctx,
+				    LinkedListNode *first,
+				    LinkedListNode *end )
+{
+	LCUI_Widget child;
+	LinkedListNode *node;
+	LCUI_FlexBoxStyle *flex;
+	float free_space = 0, used_size = 0, line_cross_size;
+	float basis, size, cross_size, margin, pos = 0, gap = 0, offset;
+
+	line_cross_size = ctx->line_cross_size;
+	if( !ctx->is_wrap && ctx->has_cross_size ) {
+		line_cross_size = ctx->cross_size;
+	}
+	if( ctx->has_main_size ) {
+		free_space = ctx->main_size - ctx->line_main_size;
+	}
+	/* 按照伸缩系数分配剩余空间，或者按比例收缩超出的部分 */
+	for( node = first; node != end; node = node->next ) {
+		child = node->data;
+		if( !Widget_IsFlexItem( child ) ) {
+			continue;
+		}
+		flex = &child->computed_style.flex;
+		size = basis = Widget_ComputeFlexBasis( child, ctx );
+		if( free_space > 0 && ctx->total_grow > 0 ) {
+			size += free_space * flex->grow / ctx->total_grow;
+		} else if( free_space < 0 && ctx->total_shrink > 0 ) {
+			size += free_space * flex->shrink * basis /
+				ctx->total_shrink;
+		}
+		size = Widget_ClampFlexSize( child, size, ctx->is_row );
+		cross_size = -1;
+		if( Widget_IsFlexStretched( child, ctx ) ) {
+			margin = Widget_GetMarginSize( child, !ctx->is_row );
+			cross_size = Widget_ClampFlexSize( child,
+							   line_cross_size -
+							   margin,
+							   !ctx->is_row );
+		}
+		if( ctx->is_row ) {
+			Widget_SetFlexSize( child, size, cross_size );
+		} else {
+			Widget_SetFlexSize( child, cross_size, size );
+		}
+		used_size += size + Widget_GetMarginSize( child, ctx->is_row );
+	}
+	free_space = ctx->has_main_size ? ctx->main_size - used_size : 0;
+	flex = &w->computed_style.flex;
+	switch( flex->justify_content ) {
+	case SV_FLEX_END:
+		pos = free_space;
+		break;
+	case SV_CENTER:
+		pos = free_space / 2;
+		break;
+	case SV_SPACE_BETWEEN:
+		if( free_space > 0 && ctx->count > 1 ) {
+			gap = free_space / (ctx->count - 1);
+		}
+		break;
+	case SV_SPACE_AROUND:
+		if( free_space > 0 ) {
+			gap = free_space / ctx->count;
+			pos = gap / 2;
+		}
+		break;
+	case SV_FLEX_START:
+	default: break;
+	}
+	for( node = first; node != end; node = node->next ) {
+		child = node->data;
+		if( !Widget_IsFlexItem( child ) ) {
+			continue;
+		}
+		offset = 0;
+		if( ctx->is_row ) {
+			size = child->layout.flex_width;
+			cross_size = child->layout.flex_height;
+		} else {
+			size = child->layout.flex_height;
+			cross_size = child->layout.flex_width;
+		}
+		if( cross_size < 0 ) {
+			cross_size = Widget_GetFlexCrossSize( child, ctx );
+			cross_size += Widget_GetMarginSize( child, !ctx->is_row );
+			switch( flex->align_items ) {
+			case SV_FLEX_END:
+				offset = line_cross_size - cross_size;
+				break;
+			case SV_CENTER:
+				offset = (line_cross_size - cross_size) / 2;
+				break;
+			case SV_FLEX_START:
+			default: break;
+			}
+		}
+		if( ctx->is_row ) {
+			child->origin_x = pos;
+			child->origin_y = ctx->cross_pos + offset;
+		} else {
+			child->origin_x = ctx->cross_pos + offset;
+			child->origin_y = pos;
+		}
+		pos += size + Widget_GetMarginSize( child, ctx->is_row ) + gap;
+		Widget_UpdatePosition( child );
+		Widget_UpdateLayoutState( child );
+	}
+	ctx->cross_pos += line_cross_size;
+	ctx->line_main_size = 0;
+	ctx->line_cross_size = 0;
+	ctx->total_grow = 0;
+	ctx->total_shrink = 0;
+	ctx->count = 0;
+}
+
+/**
+ * 检查子部件是否都已经测量过自身的尺寸
+ * 尚未测量的子部件在测量完后会让容器重新布局，在此之前没有必要分配空间。
+ */
+static LCUI_BOOL Widget_CheckFlexItemsMeasured( LCUI_Widget w )
+{
+	LCUI_Widget child;
+	LinkedListNode *node;
+	LCUI_BOOL measured = TRUE;
+
+	for( LinkedList_Each( node, &w->children ) ) {
+		child = node->data;
+		if( Widget_IsFlexItem( child ) &&
+		    child->layout.natural_width < 0 ) {
+			Widget_AddTask( child, WTT_RESIZE );
+			measured = FALSE;
+		}
+	}
+	return measured;
+}
+
+/**
+ * 按照弹性布局排列子部件
+ * 子部件的基准尺寸都已经缓存好了，只需要遍历一遍子部件来分行和统计，然后
+ * 逐行分配尺寸和位置。分配的尺寸会在子部件调整尺寸时生效，而调整后的基准
+ * 尺寸有变化时才会再次触发布局。
+ */
+static void Widget_ExecFlexLayout( LCUI_Widget w )
+{
+	float size;
+	LCUI_Widget child;
+	LinkedListNode *node, *first = NULL;
+	FlexLayoutContextRec ctx = { 0 };
+
+	w->layout.needs_layout = FALSE;
+	w->layout.dirty_child = NULL;
+	if( !Widget_CheckFlexItemsMeasured( w ) ) {
+		return;
+	}
+	ctx.is_row = w->computed_style.flex.direction != SV_COLUMN;
+	ctx.is_wrap = w->computed_style.flex.wrap == SV_WRAP;
+	ctx.has_main_size = Widget_HasDefiniteSize( w, ctx.is_row );
+	ctx.has_cross_size = Widget_HasDefiniteSize( w, !ctx.is_row );
+	if( ctx.is_row ) {
+		ctx.main_size = w->box.content.width;
+		ctx.cross_size = w->box.content.height;
+	} else {
+		ctx.main_size = w->box.content.height;
+		ctx.cross_size = w->box.content.width;
+	}
+	for( LinkedList_Each( node, &w->children ) ) {
+		child = node->data;
+		if( !Widget_IsFlexItem( child ) ) {
+			if( child->computed_style.position == SV_ABSOLUTE ) {
+				Widget_UpdateLayoutState( child );
 			}
+			continue;
+		}
+		size = Widget_ComputeFlexBasis( child, &ctx );
+		if( ctx.is_wrap && ctx.has_main_size && ctx.count > 0 &&
+		    ctx.line_main_size + size +
+		    Widget_GetMarginSize( child, ctx.is_row ) > ctx.main_size ) {
+			Widget_ArrangeFlexLine( w, &ctx, first, node );
+			first = NULL;
+		}
+		if( !first ) {
+			first = node;
+		}
+		ctx.count += 1;
+		ctx.total_grow += child->computed_style.flex.grow;
+		ctx.total_shrink += child->computed_style.flex.shrink * size;
+		ctx.line_main_size += size;
+		ctx.line_main_size += Widget_GetMarginSize( child, ctx.is_row );
+		size = Widget_GetFlexCrossSize( child, &ctx );
+		size += Widget_GetMarginSize( child, !ctx.is_row );
+		if( size > ctx.line_cross_size ) {
+			ctx.line_cross_size = size;
 		}
-		ctx.prev = child;
-		ctx.prev_display = child->computed_style.display;
 	}
-	if( w->style->sheet[key_width].type == SVT_AUTO ||
-	    w->style->sheet[key_height].type == SVT_AUTO ) {
+	if( first ) {
+		Widget_ArrangeFlexLine( w, &ctx, first, NULL );
+	}
+}
+
+void Widget_ExecUpdateLayout( LCUI_Widget w )
+{
+	LCUI_WidgetEventRec e;
+
+	if( w->computed_style.display == SV_FLEX ) {
+		Widget_ExecFlexLayout( w );
+	} else {
+		Widget_ExecFlowLayout( w );
+	}
+	if( !Widget_IsLayoutBoundary( w ) ) {
 		Widget_AddTask( w, WTT_RESIZE );
 	}
 	e.cancel_bubble = TRUE;
@@ -1839,10 +2499,13 @@ extern void LCUIWidget_AddTextEdit( void );
 
 void LCUI_InitWidget( void )
 {
+	/* 样式库和部件的类都会用到原子，需要最先初始化 */
+	LCUI_InitAtomTable();
 	LCUIWidget_InitTasks();
 	LCUIWidget_InitEvent();
 	LCUIWidget_InitPrototype();
 	LCUIWidget_InitStyle();
+	LCUIWidget_InitPaint();
 	LCUIWidget_AddTextView();
 	LCUIWidget_AddButton();
 	LCUIWidget_AddSideBar();
@@ -1855,9 +2518,11 @@ void LCUI_InitWidget( void )
 	LCUIWidget.dt_attributes = DictType_StringCopyKey;
 	LCUIWidget.dt_attributes.valDestructor = OnClearWidgetAttribute;
 	Widget_SetTitleW( LCUIWidget.root, L"LCUI Display" );
+	/* 根部件在创建时还不能加入任务队列，所以需要在这里补上 */
+	Widget_UpdateTaskStatus( LCUIWidget.root );
 }
 
 void LCUI_ExitWidget( void )
 {
-
+	LCUIWidget_ExitPaint();
 }
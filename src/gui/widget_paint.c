@@ -40,10 +40,21 @@
 //#define DEBUG
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
 #include <LCUI/gui/widget.h>
 
+/** 图层缓存的最大宽度和高度，过大的图层缓存会占用太多内存 */
+#define MAX_LAYER_CACHE_SIZE	4096
+
+/** 部件绘制模块的数据，渲染可能在多个线程中进行，需要加锁访问 */
+static struct WidgetPaintModule {
+	LCUI_Mutex mutex;		/**< 统计数据的互斥锁 */
+	LCUI_WidgetPaintStatsRec stats;
+} self;
+
 /** 判断部件是否有可绘制内容 */
 static LCUI_BOOL Widget_IsPaintable( LCUI_Widget w )
 {
@@ -91,13 +102,46 @@ static void Widget_AdjustArea(	LCUI_Widget w, LCUI_Rect *in_rect,
 	out_rect->y += roundi( box->y - w->box.graph.y );
 }
 
+/**
+ * 将区域标记为部件及其各级父部件的图层缓存中的无效区域
+ * @param[in] w 部件
+ * @param[in] rect 相对于部件呈现框的区域
+ */
+static void Widget_InvalidateLayers( LCUI_Widget w, const LCUI_Rect *rect )
+{
+	LCUI_Rect r = *rect, layer_rect;
+	LCUI_Widget parent;
+	while( w ) {
+		if( Graph_IsValid( &w->graph ) ) {
+			layer_rect = r;
+			LCUIRect_ValidateArea( &layer_rect, w->graph.width,
+					       w->graph.height );
+			if( layer_rect.width > 0 && layer_rect.height > 0 ) {
+				Region_UnionRect( &w->dirty_layer_rects,
+						  &layer_rect );
+			}
+		}
+		parent = w->parent;
+		if( !parent ) {
+			break;
+		}
+		/* 与 Widget_Render() 中计算子部件区域的方式保持一致 */
+		r.x += roundi( w->box.graph.x + parent->box.padding.x -
+			       parent->box.graph.x );
+		r.y += roundi( w->box.graph.y + parent->box.padding.y -
+			       parent->box.graph.y );
+		w = parent;
+	}
+}
+
 void Widget_InvalidateArea( LCUI_Widget w, LCUI_Rect *r, int box_type )
 {
 	LCUI_Rect rect;
 	Widget_AdjustArea( w, r, &rect, box_type );
 	DEBUG_MSG("[%s]: invalidRect:(%d,%d,%d,%d)\n", w->type, 
 		   rect.x, rect.y, rect.width, rect.height);
-	RectList_Add( &w->dirty_rects, &rect );
+	Region_UnionRect( &w->dirty_rects, &rect );
+	Widget_InvalidateLayers( w, &rect );
 	while( w = w->parent, w ) {
 		w->has_dirty_child = TRUE;
 	}
@@ -115,6 +159,15 @@ LCUI_BOOL Widget_PushInvalidArea( LCUI_Widget widget,
 	Widget_AdjustArea( w, r, &rect, box_type );
 	rect.x += w->box.graph.x;
 	rect.y += w->box.graph.y;
+	/* 部件自身的内容没有变化，只需要让父级部件的图层缓存失效 */
+	if( w->parent ) {
+		LCUI_Rect layer_rect = rect;
+		layer_rect.x += roundi( w->parent->box.padding.x -
+					w->parent->box.graph.x );
+		layer_rect.y += roundi( w->parent->box.padding.y -
+					w->parent->box.graph.y );
+		Widget_InvalidateLayers( w->parent, &layer_rect );
+	}
 	while( w && w->parent ) {
 		int width = roundi( w->parent->box.padding.width );
 		int height = roundi( w->parent->box.padding.height );
@@ -133,13 +186,10 @@ LCUI_BOOL Widget_PushInvalidArea( LCUI_Widget widget,
 int Widget_GetInvalidArea( LCUI_Widget widget, LCUI_Rect *area )
 {
 	LCUI_Rect *rect;
-	if( widget->dirty_rects.length <= 0 ) {
+	if( Region_IsEmpty( &widget->dirty_rects ) ) {
 		return -1;
 	}
-	rect = LinkedList_Get( &widget->dirty_rects, 0 );
-	if( !rect ) {
-		return -2;
-	}
+	rect = &widget->dirty_rects.rects[0];
 	DEBUG_MSG("p_rect: %d,%d,%d,%d\n", rect->x, rect->y, rect->width, rect->height);
 	*area = *rect;
 	return 0;
@@ -149,7 +199,7 @@ void Widget_ValidateArea( LCUI_Widget w, LCUI_Rect *r, int box_type )
 {
 	LCUI_Rect rect;
 	Widget_AdjustArea( w, r, &rect, box_type );
-	RectList_Delete( &w->dirty_rects, &rect );
+	Region_SubtractRect( &w->dirty_rects, &rect );
 }
 
 /** 当前部件的绘制函数 */
@@ -162,10 +212,6 @@ static void Widget_OnPaint( LCUI_Widget w, LCUI_PaintContext paint )
 	s = &w->computed_style;
 	box.width = w->box.graph.width;
 	box.height = w->box.graph.height;
-	/* 如果是有位图缓存的话，则先清空缓存里的阴影区域 */
-	if( w->enable_graph ) {
-		Graph_ClearShadowArea( paint, &box, &s->shadow );
-	}
 	Graph_DrawBoxShadow( paint, &box, &s->shadow );
 	box.x = w->box.border.x - w->box.graph.x;
 	box.y = w->box.border.y - w->box.graph.y;
@@ -184,38 +230,31 @@ static void Widget_OnPaint( LCUI_Widget w, LCUI_PaintContext paint )
  * @param[in] x 当前部件的绝对 X 坐标
  * @param[in] y 当前部件的绝对 Y 坐标
  * @param[in] valid_box 当前部件内的有效框
- * @param[out] rlist 收集到的无效区域列表
+ * @param[out] region 收集到的无效区域
  */
 static int _Widget_ProcInvalidArea( LCUI_Widget w, float x, float y, 
 				    LCUI_RectF *valid_box, 
-				    LinkedList *rlist )
+				    LCUI_Region region )
 {
 	int count;
+	LCUI_Rect *r;
 	LCUI_Widget child;
 	LinkedListNode *node;
 	LCUI_RectF child_box;
 	count = w->dirty_rects.length;
 	/* 取出当前记录的无效区域 */
-	for( LinkedList_Each( node, &w->dirty_rects ) ) {
+	for( Region_Each( r, &w->dirty_rects ) ) {
 		LCUI_Rect rect;
-		LCUI_Rect *r = node->data;
-		/* 若有独立位图缓存，则重绘脏矩形区域 */
-		if( w->enable_graph && Graph_IsValid( &w->graph ) ) {
-			LCUI_PaintContextRec paint;
-			paint.rect = *r;
-			Graph_Quote( &paint.canvas, &w->graph, &paint.rect );
-			Widget_OnPaint( w, &paint );
-		}
 		RectF2Rect( *valid_box, rect );
 		/* 取出与容器内有效区域相交的区域 */
 		if( LCUIRect_GetOverlayRect( r, &rect, &rect ) ) {
 			/* 转换成绝对坐标 */
 			rect.x = roundi( rect.x + x );
 			rect.y = roundi( rect.y + y );
-			RectList_Add( rlist, &rect );
+			Region_UnionRect( region, &rect );
 		}
 	}
-	RectList_Clear( &w->dirty_rects );
+	Region_Clear( &w->dirty_rects );
 	/* 若子级部件没有脏矩形记录 */
 	if( !w->has_dirty_child ) {
 		return count;
@@ -248,18 +287,18 @@ static int _Widget_ProcInvalidArea( LCUI_Widget w, float x, float y,
 		child_box.x -= w->box.padding.x - w->box.graph.x;
 		child_box.y -= w->box.padding.y - w->box.graph.y;
 		count += _Widget_ProcInvalidArea( child, child_x, child_y, 
-						  &child_box, rlist );
+						  &child_box, region );
 	}
 	w->has_dirty_child = FALSE;
 	return count;
 }
 
-int Widget_ProcInvalidArea( LCUI_Widget w, LinkedList *rlist )
+int Widget_ProcInvalidArea( LCUI_Widget w, LCUI_Region region )
 {
 	LCUI_RectF valid_box;
 	valid_box = w->box.graph;
 	valid_box.x = valid_box.y = 0;
-	return _Widget_ProcInvalidArea( w, 0, 0, &valid_box, rlist );
+	return _Widget_ProcInvalidArea( w, 0, 0, &valid_box, region );
 }
 
 int Widget_ConvertArea( LCUI_Widget w, LCUI_Rect *in_rect,
@@ -314,9 +353,129 @@ int Widget_ConvertArea( LCUI_Widget w, LCUI_Rect *in_rect,
 	return 0;
 }
 
-void Widget_Render( LCUI_Widget w, LCUI_PaintContext paint )
+/**
+ * 判断部件的边框盒是否完全不透明
+ * 背景色会填满边框盒，边框会直接覆盖背景，所以只要背景色和边框都不透明，且
+ * 没有圆角和阴影，边框盒内的像素就都是不透明的。
+ */
+static LCUI_BOOL Widget_IsOpaque( LCUI_Widget w )
 {
-	LinkedListNode *node;
+	const LCUI_WidgetStyle *s = &w->computed_style;
+	if( s->opacity < 1.0 || s->background.color.alpha < 255 ) {
+		return FALSE;
+	}
+	if( s->shadow.blur > 0 || s->shadow.spread > 0 ||
+	    s->shadow.x != 0 || s->shadow.y != 0 ) {
+		return FALSE;
+	}
+	if( s->border.top_left_radius > 0 || s->border.top_right_radius > 0 ||
+	    s->border.bottom_left_radius > 0 ||
+	    s->border.bottom_right_radius > 0 ) {
+		return FALSE;
+	}
+	if( (s->border.top.width > 0 && s->border.top.color.alpha < 255) ||
+	    (s->border.right.width > 0 && s->border.right.color.alpha < 255) ||
+	    (s->border.bottom.width > 0 &&
+	     s->border.bottom.color.alpha < 255) ||
+	    (s->border.left.width > 0 && s->border.left.color.alpha < 255) ) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** 判断矩形 a 是否包含矩形 b */
+static LCUI_BOOL RectContains( const LCUI_Rect *a, const LCUI_Rect *b )
+{
+	return a->x <= b->x && a->y <= b->y &&
+		a->x + a->width >= b->x + b->width &&
+		a->y + a->height >= b->y + b->height;
+}
+
+/**
+ * 从顶到底查找完全遮挡内容区的子部件
+ * @param[in] w 部件
+ * @param[in] content_rect 需要绘制的内容区域，相对于脏矩形
+ * @param[in] left 内容框相对于部件呈现框的 X 坐标，已减去脏矩形的 X 坐标
+ * @param[in] top 内容框相对于部件呈现框的 Y 坐标，已减去脏矩形的 Y 坐标
+ * @param[out] culled 被遮挡而无需绘制的子部件数量
+ * @returns 找到则返回该子部件在 children_show 中的结点，否则返回 NULL
+ */
+static LinkedListNode *Widget_FindOccluder( LCUI_Widget w,
+					    LCUI_Rect *content_rect,
+					    float left, float top,
+					    size_t *culled )
+{
+	LCUI_Rect rect;
+	LCUI_Widget child;
+	LinkedListNode *node, *occluder = NULL;
+
+	*culled = 0;
+	for( LinkedList_Each( node, &w->children_show ) ) {
+		child = node->data;
+		if( !child->computed_style.visible ||
+		    child->state != WSTATE_NORMAL ) {
+			continue;
+		}
+		/* 与 Widget_Render() 中计算子部件区域的方式保持一致 */
+		rect.x = roundi( child->box.graph.x + left );
+		rect.y = roundi( child->box.graph.y + top );
+		rect.width = roundi( child->box.graph.width );
+		rect.height = roundi( child->box.graph.height );
+		if( occluder ) {
+			if( LCUIRect_IsCoverRect( &rect, content_rect ) ) {
+				++*culled;
+			}
+			continue;
+		}
+		if( !Widget_IsOpaque( child ) ) {
+			continue;
+		}
+		/* 背景是按照边框盒绘制的 */
+		rect.x += (int)(child->box.border.x - child->box.graph.x);
+		rect.y += (int)(child->box.border.y - child->box.graph.y);
+		rect.width = (int)child->box.border.width;
+		rect.height = (int)child->box.border.height;
+		if( RectContains( &rect, content_rect ) ) {
+			occluder = node;
+		}
+	}
+	return occluder;
+}
+
+void LCUIWidget_GetPaintStats( LCUI_WidgetPaintStats stats )
+{
+	LCUIMutex_Lock( &self.mutex );
+	*stats = self.stats;
+	LCUIMutex_Unlock( &self.mutex );
+}
+
+void LCUIWidget_ResetPaintStats( void )
+{
+	LCUIMutex_Lock( &self.mutex );
+	memset( &self.stats, 0, sizeof( self.stats ) );
+	LCUIMutex_Unlock( &self.mutex );
+}
+
+void LCUIWidget_InitPaint( void )
+{
+	LCUIMutex_Init( &self.mutex );
+	memset( &self.stats, 0, sizeof( self.stats ) );
+}
+
+void LCUIWidget_ExitPaint( void )
+{
+	LCUIMutex_Destroy( &self.mutex );
+}
+
+/**
+ * 渲染部件
+ * @param[in] opacity 部件的不透明度，渲染图层缓存时为 1.0
+ */
+static void Widget_RenderLayer( LCUI_Widget w, LCUI_PaintContext paint,
+				float opacity )
+{
+	size_t culled = 0;
+	LinkedListNode *node, *occluder = NULL;
 	float content_left, content_top;
 	LCUI_PaintContextRec self_paint;
 	LCUI_PaintContextRec child_paint;
@@ -329,9 +488,10 @@ void Widget_Render( LCUI_Widget w, LCUI_PaintContext paint )
 	Graph_Init( &self_graph );
 	Graph_Init( &layer_graph );
 	Graph_Init( &content_graph );
-	layer_graph.color_type = COLOR_TYPE_ARGB;
+	/* 中间图层使用预乘 alpha 的格式，混合时不需要做除法 */
+	layer_graph.color_type = COLOR_TYPE_PARGB;
 	/* 若部件本身是透明的 */
-	if( w->computed_style.opacity < 1.0 ) {
+	if( opacity < 1.0 ) {
 		has_self_graph = TRUE;
 		has_content_graph = TRUE;
 		has_layer_graph = TRUE;
@@ -344,25 +504,6 @@ void Widget_Render( LCUI_Widget w, LCUI_PaintContext paint )
 		}
 		*/
 	}
-	is_paintable = Widget_IsPaintable( w );
-	/* 如果部件有需要绘制的内容 */
-	if( is_paintable ) {
-		if( w->enable_graph && Graph_IsValid( &w->graph ) ) {
-			Graph_Quote( &self_graph, &w->graph, &paint->rect );
-		} else {
-			self_graph.color_type = COLOR_TYPE_ARGB;
-			Graph_Create( &self_graph, paint->rect.width,
-				      paint->rect.height );
-			self_paint.canvas = self_graph;
-			self_paint.rect = paint->rect;
-			Widget_OnPaint( w, &self_paint );
-		}
-		/* 若不需要缓存自身位图则直接绘制到画布上 */
-		if( !has_self_graph ) {
-			Graph_Mix( &paint->canvas, &self_graph,
-				   0, 0, paint->with_alpha );
-		}
-	}
 	/* 计算内容框相对于图层的坐标 */
 	content_left = w->box.padding.x - w->box.graph.x;
 	content_top = w->box.padding.y - w->box.graph.y;
@@ -375,26 +516,57 @@ void Widget_Render( LCUI_Widget w, LCUI_PaintContext paint )
 	has_overlay = LCUIRect_GetOverlayRect(
 		&content_rect, &paint->rect, &content_rect
 	);
+	is_paintable = Widget_IsPaintable( w );
+	if( has_overlay ) {
+		/* 将重叠区域的坐标转换为相对于脏矩形的坐标 */
+		content_rect.x -= paint->rect.x;
+		content_rect.y -= paint->rect.y;
+		/* 找出被不透明的子部件完全遮挡住的部分，它们不需要绘制 */
+		occluder = Widget_FindOccluder( w, &content_rect,
+						content_left - paint->rect.x,
+						content_top - paint->rect.y,
+						&culled );
+		/* 如果遮挡了整个脏矩形，那么部件自身也不需要绘制 */
+		if( occluder && is_paintable &&
+		    content_rect.width == paint->rect.width &&
+		    content_rect.height == paint->rect.height ) {
+			is_paintable = FALSE;
+			++culled;
+		}
+	}
+	/* 如果部件有需要绘制的内容 */
+	if( is_paintable ) {
+		/* w->graph 是合成后的图层缓存，部件自身的内容每次都要重新绘制 */
+		self_graph.color_type = COLOR_TYPE_ARGB;
+		Graph_CreateInFrame( &self_graph, paint->rect.width,
+				     paint->rect.height );
+		self_paint.canvas = self_graph;
+		self_paint.rect = paint->rect;
+		Widget_OnPaint( w, &self_paint );
+		/* 若不需要缓存自身位图则直接绘制到画布上 */
+		if( !has_self_graph ) {
+			Graph_Mix( &paint->canvas, &self_graph,
+				   0, 0, paint->with_alpha );
+		}
+	}
 	/* 如果没有与内容框重叠，则跳过内容绘制 */
 	if( !has_overlay ) {
 		goto content_paint_done;
 	}
-	/* 将重叠区域的坐标转换为相对于脏矩形的坐标 */
-	content_rect.x -= paint->rect.x;
-	content_rect.y -= paint->rect.y;
 	/* 若需要部件内容区的位图缓存 */
 	if( has_content_graph ) {
 		child_paint.with_alpha = TRUE;
-		content_graph.color_type = COLOR_TYPE_ARGB;
-		Graph_Create( &content_graph,
-			      content_rect.width, content_rect.height );
+		content_graph.color_type = COLOR_TYPE_PARGB;
+		Graph_CreateInFrame( &content_graph,
+				     content_rect.width, content_rect.height );
 	} else {
 		child_paint.with_alpha = paint->with_alpha;
 		/* 引用该区域的位图，作为内容框的位图 */
 		Graph_Quote( &content_graph, &paint->canvas, &content_rect );
 	}
-	/* 按照显示顺序，从底到顶，递归遍历子级部件 */
-	LinkedList_ForEachReverse( node, &w->children_show ) {
+	/* 按照显示顺序，从底到顶，递归遍历子级部件，被遮挡的部件直接跳过 */
+	node = occluder ? occluder : w->children_show.tail.prev;
+	for( ; node && node != &w->children_show.head; node = node->prev ) {
 		LCUI_Rect child_rect;
 		LCUI_Widget child = node->data;
 		if( !child->computed_style.visible || 
@@ -442,17 +614,18 @@ content_paint_done:
 	 * 前部件的图层，然后将该图层混合到输出的位图中
 	 */
 	if( has_layer_graph ) {
+		Graph_CreateInFrame( &layer_graph, paint->rect.width,
+				     paint->rect.height );
 		if( is_paintable ) {
-			Graph_Copy( &layer_graph, &self_graph );
+			/* 部件自身位图是 ARGB 格式的，在覆盖时预乘 alpha */
+			Graph_Replace( &layer_graph, &self_graph, 0, 0 );
 			Graph_Mix( &layer_graph, &content_graph,
 				   content_rect.x, content_rect.y, TRUE );
 		} else {
-			Graph_Create( &layer_graph, paint->rect.width, 
-				      paint->rect.height );
 			Graph_Replace( &layer_graph, &content_graph, 
 				       content_rect.x, content_rect.y );
 		}
-		layer_graph.opacity = w->computed_style.opacity;
+		layer_graph.opacity = opacity;
 		Graph_Mix( &paint->canvas, &layer_graph, 
 			   0, 0, paint->with_alpha );
 	}
@@ -463,4 +636,102 @@ content_paint_done:
 	Graph_Free( &layer_graph );
 	Graph_Free( &self_graph );
 	Graph_Free( &content_graph );
+	if( culled > 0 ) {
+		LCUIMutex_Lock( &self.mutex );
+		self.stats.culled_paints += culled;
+		LCUIMutex_Unlock( &self.mutex );
+	}
+}
+
+/** 判断部件是否需要使用图层缓存 */
+static LCUI_BOOL Widget_HasLayerCache( LCUI_Widget w )
+{
+	int width = roundi( w->box.graph.width );
+	int height = roundi( w->box.graph.height );
+	if( width <= 0 || height <= 0 || width > MAX_LAYER_CACHE_SIZE ||
+	    height > MAX_LAYER_CACHE_SIZE ) {
+		return FALSE;
+	}
+	return w->enable_graph || w->computed_style.opacity < 1.0;
+}
+
+/**
+ * 重绘图层缓存中的无效区域
+ * 同一部件可能会被多个线程同时渲染，所以只让第一个线程来更新它的图层缓存，
+ * 其它线程等待更新完成后再使用。每个部件都有自己的锁，不同部件的图层缓存可以
+ * 同时更新，嵌套的图层缓存总是先锁父级部件再锁子级部件，不会死锁。
+ */
+static void Widget_UpdateLayerCache( LCUI_Widget w )
+{
+	size_t count = 0;
+	LCUI_PaintContextRec paint;
+	LCUI_Rect rect, *r;
+	int width = roundi( w->box.graph.width );
+	int height = roundi( w->box.graph.height );
+
+	LCUIMutex_Lock( &w->layer_mutex );
+	/* 尺寸有变化的话，重新创建图层缓存并重绘所有区域 */
+	if( !Graph_IsValid( &w->graph ) || w->graph.width != width ||
+	    w->graph.height != height ) {
+		Graph_Free( &w->graph );
+		w->graph.color_type = COLOR_TYPE_PARGB;
+		Graph_Create( &w->graph, width, height );
+		rect.x = rect.y = 0;
+		rect.width = width;
+		rect.height = height;
+		Region_Clear( &w->dirty_layer_rects );
+		Region_UnionRect( &w->dirty_layer_rects, &rect );
+	}
+	for( Region_Each( r, &w->dirty_layer_rects ) ) {
+		paint.rect = *r;
+		paint.with_alpha = TRUE;
+		LCUIRect_ValidateArea( &paint.rect, width, height );
+		if( paint.rect.width <= 0 || paint.rect.height <= 0 ) {
+			continue;
+		}
+		Graph_Quote( &paint.canvas, &w->graph, &paint.rect );
+		Graph_FillRect( &paint.canvas, ARGB( 0, 0, 0, 0 ), NULL, TRUE );
+		Widget_RenderLayer( w, &paint, 1.0f );
+		++count;
+	}
+	Region_Clear( &w->dirty_layer_rects );
+	LCUIMutex_Unlock( &w->layer_mutex );
+	LCUIMutex_Lock( &self.mutex );
+	self.stats.layer_repaints += count;
+	self.stats.layer_composites += 1;
+	LCUIMutex_Unlock( &self.mutex );
+}
+
+/** 释放不再需要的图层缓存 */
+static void Widget_FreeLayerCache( LCUI_Widget w )
+{
+	LCUIMutex_Lock( &w->layer_mutex );
+	Graph_Free( &w->graph );
+	Region_Free( &w->dirty_layer_rects );
+	LCUIMutex_Unlock( &w->layer_mutex );
+}
+
+void Widget_Render( LCUI_Widget w, LCUI_PaintContext paint )
+{
+	LCUI_Graph layer, graph;
+	LCUI_FrameArenaMarkRec mark;
+
+	/* 这一级用到的临时图像在渲染完后就不再需要了，回收给下一个部件用 */
+	Graph_MarkFrameArena( &mark );
+	if( !Widget_HasLayerCache( w ) ) {
+		if( Graph_IsValid( &w->graph ) ) {
+			Widget_FreeLayerCache( w );
+		}
+		Widget_RenderLayer( w, paint, w->computed_style.opacity );
+		Graph_ReleaseFrameArena( &mark );
+		return;
+	}
+	Widget_UpdateLayerCache( w );
+	Graph_ReleaseFrameArena( &mark );
+	/* 在副本上设置不透明度，避免在多个线程中修改图层缓存 */
+	layer = w->graph;
+	layer.opacity = w->computed_style.opacity;
+	Graph_Init( &graph );
+	Graph_Quote( &graph, &layer, &paint->rect );
+	Graph_Mix( &paint->canvas, &graph, 0, 0, paint->with_alpha );
 }
@@ -46,11 +46,35 @@
 #include <LCUI/gui/widget.h>
 #include <LCUI/gui/css_library.h>
 
+/** 样式共享缓存的最大记录数，超出后清空缓存 */
+#define MAX_STYLE_SHARES	1024
+
 typedef struct {
 	int start, end, task;
 	LCUI_BOOL is_valid;
 } TaskMap;
 
+/** 样式共享记录 */
+typedef struct StyleShareRec_ {
+	LCUI_SharedStyleSheet parent;	/**< 父部件的继承样式表 */
+	LCUI_SharedStyleSheet sheet;	/**< 共享的继承样式表 */
+} StyleShareRec, *StyleShare;
+
+/**
+ * 样式共享缓存
+ * 以父部件的继承样式表以及部件的类型、类和状态为键，记录计算好的继承样式表。
+ * 父部件的继承样式表本身也是按同样的方式共享的，所以它能代表所有祖先结点组成
+ * 的选择器，选择器相同的兄弟部件和堂兄弟部件都能共用同一张继承样式表。
+ * 祖先部件的类或状态变动后，没有刷新的后代部件的继承样式表就不能再代表它们的
+ * 祖先结点了，这种样式表会被标记为 is_mixed，不再用作子部件的键。
+ */
+static struct WidgetStyleModule {
+	Dict *shares;			/**< 共享记录表 */
+	DictType shares_dtype;		/**< 共享记录表的类型 */
+	unsigned int version;		/**< 缓存对应的样式库版本号 */
+	LCUI_WidgetStyleStatsRec stats;	/**< 样式刷新的统计数据 */
+} self;
+
 /** 部件的缺省样式 */
 const char *global_css = CodeToString(
 
@@ -69,27 +93,14 @@ const char *global_css = CodeToString(
 
 LCUI_SelectorNode Widget_GetSelectorNode( LCUI_Widget w )
 {
-	int i;
 	ASSIGN( sn, LCUI_SelectorNode );
 	ZEROSET( sn, LCUI_SelectorNode );
-	if( w->id ) {
-		sn->id = strdup( w->id );
-	}
-	if( w->type ) {
-		sn->type = strdup( w->type );
-	}
-	if( w->classes ) {
-		for( i = 0; w->classes[i]; ++i ) {
-			sortedstrsadd( &sn->classes, 
-				       w->classes[i] );
-		}
-	}
-	if( w->status ) {
-		for( i = 0; w->status[i]; ++i ) {
-			sortedstrsadd( &sn->status,
-				       w->status[i] );
-		}
-	}
+	/* ID 的数量没有上限，不能都驻留下来。只有样式库中的选择器用到的 ID 才
+	 * 有原子，没有原子的 ID 不会被任何选择器匹配到，可以忽略 */
+	sn->id = LCUIAtom_Find( w->id );
+	sn->type = LCUIAtom_Get( w->type );
+	sn->classes = AtomList_Duplicate( w->classes );
+	sn->status = AtomList_Duplicate( w->status );
 	SelectorNode_Update( sn );
 	return sn;
 }
@@ -127,64 +138,117 @@ LCUI_Selector Widget_GetSelector( LCUI_Widget w )
 	return s;
 }
 
-int Widget_HandleChildrenStyleChange( LCUI_Widget w, int type, const char *name )
+/**
+ * 获取变动的名称对应的原子列表
+ * @returns 由 SELECTOR_DEP_* 组成的标志，表示这些名称在选择器中被用到的位置
+ */
+static int GetChangedAtoms( int type, const char *name, LCUI_Atom **atoms )
 {
-	LCUI_Selector s;
-	LinkedList snames;
-	LinkedListNode *node;
-	int i, n, count = 0;
-	char ch, **names = NULL;
-
-	/* 选择相应的前缀 */
-	switch( type ) {
-	case 0: ch = '.'; break;
-	case 1: ch = ':'; break;
-	default: return 0;
+	int i, flags = 0;
+	*atoms = NULL;
+	if( type != 0 && type != 1 ) {
+		return 0;
 	}
-	LinkedList_Init( &snames );
-	s = Widget_GetSelector( w );
-	n = strsplit( name, " ", &names );
-	/* 为分割出来的字符串加上前缀 */
-	for( i = 0; i < n; ++i ) {
-		int len = strlen( names[i] ) + 2;
-		char *str = malloc( len * sizeof( char ) );
-		strncpy( str + 1, names[i], len - 1 );
-		str[0] = ch;
-		free( names[i] );
-		names[i] = str;
+	AtomList_AddNames( atoms, name );
+	if( !*atoms ) {
+		return 0;
 	}
-	SelectorNode_GetNames( s->nodes[s->length - 1], &snames );
-	for( LinkedList_Each( node, &snames ) ) {
-		char *sname = node->data;
-		/* 过滤掉不包含 name 中存在的名称 */
-		for( i = 0; i < n; ++i ) {
-			char *p = strstr( sname, names[i] );
-			if( p ) {
-				p += strlen( names[i] );
-				switch( *p ) {
-				case 0:
-				case ':':
-				case '.': break;
-				default: continue;
-				}
+	for( i = 0; (*atoms)[i]; ++i ) {
+		flags |= LCUI_GetSelectorDependency( type, (*atoms)[i] );
+	}
+	return flags;
+}
+
+/**
+ * 标记受祖先部件的类或状态变动影响的后代部件
+ * 变动的部件与受影响的后代部件之间的部件也要刷新，否则它们的继承样式表在样式
+ * 共享缓存中代表的仍然是变动前的祖先结点。其余后代部件的继承样式表内容不变，
+ * 但以后添加的子部件不能再以它为键共享样式表。
+ * @returns 被标记的后代部件数量
+ */
+static int Widget_InvalidateDescendants( LCUI_Widget w, int type,
+					 const LCUI_Atom *atoms )
+{
+	int i, count = 0, n;
+	LCUI_Widget child;
+	LCUI_BOOL affected;
+	LinkedListNode *node;
+	LCUI_SelectorNodeRec sn;
+
+	for( LinkedList_Each( node, &w->children ) ) {
+		child = node->data;
+		self.stats.checked += 1;
+		/* 直接引用部件的原子列表，不需要生成完整的选择器结点 */
+		sn.id = LCUIAtom_Find( child->id );
+		sn.type = LCUIAtom_Find( child->type );
+		sn.classes = child->classes;
+		sn.status = child->status;
+		sn.fullname = NULL;
+		sn.rank = 0;
+		for( affected = FALSE, i = 0; atoms[i]; ++i ) {
+			if( LCUI_IsSelectorNodeAffected( type, atoms[i],
+							 &sn ) ) {
+				affected = TRUE;
 				break;
 			}
 		}
-		if( i < n ) {
-			count += LCUI_FindStyleSheetFromGroup( 1, sname,
-							       s, NULL );
+		n = Widget_InvalidateDescendants( child, type, atoms );
+		if( affected || n > 0 ) {
+			Widget_UpdateStyle( child, TRUE );
+			count += 1;
+		} else if( child->inherited_style ) {
+			child->inherited_style->is_mixed = TRUE;
 		}
+		count += n;
 	}
-	Selector_Delete( s );
-	LinkedList_Clear( &snames, free );
-	/* 若子部件的样式受到了影响，则标记子部件需要刷新 */
-	if( count > 0 ) {
-		Widget_AddTaskForChildren( w, WTT_REFRESH_STYLE );
+	return count;
+}
+
+int Widget_HandleChildrenStyleChange( LCUI_Widget w, int type, const char *name )
+{
+	int flags, count = 0;
+	LCUI_Atom *atoms;
+
+	flags = GetChangedAtoms( type, name, &atoms );
+	if( flags & SELECTOR_DEP_ANCESTOR ) {
+		count = Widget_InvalidateDescendants( w, type, atoms );
 	}
-	freestrs( names );
+	free( atoms );
 	return count;
 }
 
+int Widget_HandleStyleChange( LCUI_Widget w, int type, const char *name )
+{
+	int flags, count = 0;
+	LCUI_Atom *atoms;
+
+	self.stats.changes += 1;
+	flags = GetChangedAtoms( type, name, &atoms );
+	if( flags & SELECTOR_DEP_ANCESTOR ) {
+		count = Widget_InvalidateDescendants( w, type, atoms );
+	}
+	free( atoms );
+	/* 类或状态被用在祖先结点中时，当前部件的继承样式表代表的祖先结点已经变了，
+	 * 即使现在没有受影响的后代部件，也要刷新它，以免以后添加的子部件共用按旧的
+	 * 祖先结点计算的样式表 */
+	if( flags & (SELECTOR_DEP_SUBJECT | SELECTOR_DEP_ANCESTOR) ) {
+		Widget_UpdateStyle( w, TRUE );
+		count += 1;
+	}
+	self.stats.restyled += count;
+	return count;
+}
+
+void LCUIWidget_GetStyleStats( LCUI_WidgetStyleStats stats )
+{
+	*stats = self.stats;
+}
+
+void LCUIWidget_ResetStyleStats( void )
+{
+	memset( &self.stats, 0, sizeof( self.stats ) );
+}
+
 void Widget_GetInheritStyle( LCUI_Widget w, LCUI_StyleSheet out_ss )
 {
 	LCUI_Selector s;
@@ -193,6 +257,147 @@ void Widget_GetInheritStyle( LCUI_Widget w, LCUI_StyleSheet out_ss )
 	Selector_Delete( s );
 }
 
+static LCUI_SharedStyleSheet SharedStyleSheet( void )
+{
+	LCUI_SharedStyleSheet ss = NEW( LCUI_SharedStyleSheetRec, 1 );
+	if( !ss ) {
+		return NULL;
+	}
+	ss->sheet = StyleSheet();
+	if( !ss->sheet ) {
+		free( ss );
+		return NULL;
+	}
+	ss->refs = 1;
+	return ss;
+}
+
+static void SharedStyleSheet_Release( LCUI_SharedStyleSheet ss )
+{
+	ss->refs -= 1;
+	if( ss->refs > 0 ) {
+		return;
+	}
+	StyleSheet_Delete( ss->sheet );
+	ss->sheet = NULL;
+	free( ss );
+}
+
+static void OnDeleteStyleShare( void *privdata, void *data )
+{
+	StyleShare share = data;
+	if( share->parent ) {
+		SharedStyleSheet_Release( share->parent );
+	}
+	SharedStyleSheet_Release( share->sheet );
+	free( share );
+}
+
+/** 将原子列表追加到键中，原子列表是有序的，名称的添加顺序不会影响键 */
+static int StyleShareKey_AddAtoms( char *key, int len, char prefix,
+				   const LCUI_Atom *atoms )
+{
+	int i;
+	if( !atoms ) {
+		return len;
+	}
+	for( i = 0; atoms[i]; ++i ) {
+		/* 前缀加上十进制的原子最多占用 11 个字符 */
+		if( len + 12 > MAX_SELECTOR_LEN ) {
+			return -1;
+		}
+		len += sprintf( key + len, "%c%u", prefix, atoms[i] );
+	}
+	return len;
+}
+
+/**
+ * 生成部件的样式共享键
+ * 有 ID 的部件不共享样式，父部件还没有继承样式表或者它的继承样式表已不能
+ * 代表祖先结点时也无法共享
+ * @returns 成功返回键的长度，不能共享时返回 -1
+ */
+static int Widget_GetStyleShareKey( LCUI_Widget w, char *key )
+{
+	int len;
+	LCUI_SharedStyleSheet parent = NULL;
+
+	if( w->id ) {
+		return -1;
+	}
+	if( w->parent ) {
+		parent = w->parent->inherited_style;
+		if( !parent || parent->is_mixed ) {
+			return -1;
+		}
+	}
+	len = sprintf( key, "%p ", (void*)parent );
+	if( w->type ) {
+		if( len + strlen( w->type ) + 1 > MAX_SELECTOR_LEN ) {
+			return -1;
+		}
+		strcpy( key + len, w->type );
+		len += strlen( w->type );
+	}
+	len = StyleShareKey_AddAtoms( key, len, '.', w->classes );
+	if( len < 0 ) {
+		return -1;
+	}
+	return StyleShareKey_AddAtoms( key, len, ':', w->status );
+}
+
+/** 更新部件继承得到的样式表，优先使用样式共享缓存中的记录 */
+static void Widget_UpdateInheritStyle( LCUI_Widget w )
+{
+	StyleShare share;
+	LCUI_BOOL can_share;
+	LCUI_SharedStyleSheet ss;
+	char key[MAX_SELECTOR_LEN];
+
+	/* 样式库有变动时，缓存的样式表都已过时 */
+	if( self.version != LCUI_GetStyleLibraryVersion() ||
+	    Dict_Size( self.shares ) >= MAX_STYLE_SHARES ) {
+		Dict_Empty( self.shares );
+		self.version = LCUI_GetStyleLibraryVersion();
+	}
+	can_share = Widget_GetStyleShareKey( w, key ) >= 0;
+	share = can_share ? Dict_FetchValue( self.shares, key ) : NULL;
+	if( share ) {
+		ss = share->sheet;
+		ss->refs += 1;
+	} else {
+		ss = SharedStyleSheet();
+		if( !ss ) {
+			return;
+		}
+		Widget_GetInheritStyle( w, ss->sheet );
+		share = can_share ? NEW( StyleShareRec, 1 ) : NULL;
+		if( share ) {
+			/* 键中引用了父部件的样式表，需要保证它不会被释放 */
+			share->parent = NULL;
+			if( w->parent ) {
+				share->parent = w->parent->inherited_style;
+				share->parent->refs += 1;
+			}
+			share->sheet = ss;
+			ss->refs += 1;
+			Dict_Add( self.shares, key, share );
+		}
+	}
+	if( w->inherited_style ) {
+		SharedStyleSheet_Release( w->inherited_style );
+	}
+	w->inherited_style = ss;
+}
+
+void Widget_ReleaseInheritStyle( LCUI_Widget w )
+{
+	if( w->inherited_style ) {
+		SharedStyleSheet_Release( w->inherited_style );
+		w->inherited_style = NULL;
+	}
+}
+
 void Widget_UpdateStyle( LCUI_Widget w, LCUI_BOOL is_update_all )
 {
 	if( is_update_all ) {
@@ -221,16 +426,19 @@ void Widget_ExecUpdateStyle( LCUI_Widget w, LCUI_BOOL is_update_all )
 		{ key_background_start, key_background_end, WTT_BACKGROUND, TRUE },
 		{ key_box_shadow_start, key_box_shadow_end, WTT_SHADOW, TRUE },
 		{ key_pointer_events, key_focusable, WTT_PROPS, TRUE },
-		{ key_box_sizing, key_box_sizing, WTT_RESIZE, TRUE }
+		{ key_box_sizing, key_box_sizing, WTT_RESIZE, TRUE },
+		{ key_flex_box_start, key_flex_box_end, WTT_FLEX, TRUE }
 	};
 
 	if( is_update_all ) {
-		Widget_GetInheritStyle( w, w->inherited_style );
+		Widget_UpdateInheritStyle( w );
 	}
 	ss = w->style;
 	w->style = StyleSheet();
 	StyleSheet_Merge( w->style, w->custom_style );
-	StyleSheet_Merge( w->style, w->inherited_style );
+	if( w->inherited_style ) {
+		StyleSheet_Merge( w->style, w->inherited_style->sheet );
+	}
 	/* 对比两张样式表，确定哪些需要更新 */
 	for( key = 0; key < w->style->length; ++key ) {
 		s = &w->style->sheet[key];
@@ -263,13 +471,19 @@ void Widget_ExecUpdateStyle( LCUI_Widget w, LCUI_BOOL is_update_all )
 
 void LCUIWidget_InitStyle( void )
 {
+	self.shares_dtype = DictType_StringCopyKey;
+	self.shares_dtype.valDestructor = OnDeleteStyleShare;
+	self.shares = Dict_Create( &self.shares_dtype, NULL );
 	LCUI_InitCSSLibrary();
 	LCUI_InitCSSParser();
 	LCUI_LoadCSSString( global_css, NULL );
+	self.version = LCUI_GetStyleLibraryVersion();
 }
 
 void LCUIWidget_ExitStyle( void )
 {
+	Dict_Release( self.shares );
+	self.shares = NULL;
 	LCUI_ExitCSSLibrary();
 	LCUI_ExitCSSParser();
 }
@@ -43,6 +43,11 @@
 #include <LCUI/LCUI.h>
 #include <LCUI/gui/widget.h>
 
+/** 每处理这么多个部件后检查一次是否超时 */
+#define TIMEOUT_CHECK_INTERVAL	500
+
+#define TaskFlag(T) (1u << (T))
+
 /** 部件任务模块数据 */
 static struct WidgetTaskModule {
 	size_t count;					/**< 当前已处理的部件数量 */
@@ -50,12 +55,19 @@ static struct WidgetTaskModule {
 	LCUI_BOOL is_timeout;				/**< 是否已经超时 */
 	LinkedList trash;				/**< 待删除的部件列表 */
 	LCUI_WidgetFunction handlers[WTT_TOTAL_NUM];	/**< 任务处理器 */
+	struct {
+		LinkedList **levels;			/**< 按部件所在层级划分的待处理部件列表 */
+		int depth;				/**< 已分配的层级数量 */
+		int min_depth;				/**< 最浅的非空层级，不会比它更浅 */
+		int sweep_depth;			/**< 本轮处理到的层级 */
+		size_t length;				/**< 队列中的部件总数 */
+	} queue;					/**< 待处理部件队列 */
 } self;
 
 static void HandleRefreshStyle( LCUI_Widget w )
 {
 	Widget_ExecUpdateStyle( w, TRUE );
-	w->task.buffer[WTT_UPDATE_STYLE] = FALSE;
+	w->task.flags &= ~TaskFlag( WTT_UPDATE_STYLE );
 }
 
 static void HandleUpdateStyle( LCUI_Widget w )
@@ -81,15 +93,196 @@ static void HandleRefresh( LCUI_Widget w )
 	Widget_InvalidateArea( w, NULL, SV_GRAPH_BOX );
 }
 
+/**
+ * 获取部件在部件树中的层级
+ * @returns 根部件的层级为 0，如果部件不在根部件中或者它的祖先部件已经被删除，
+ *  则返回 -1
+ */
+static int Widget_GetDepth( LCUI_Widget w )
+{
+	int depth = 0;
+	LCUI_Widget root = LCUIWidget_GetRoot();
+	while( w->parent ) {
+		if( w->state == WSTATE_DELETED ) {
+			return -1;
+		}
+		w = w->parent;
+		++depth;
+	}
+	return w == root && root ? depth : -1;
+}
+
+/** 确保任务队列有足够的层级 */
+static LCUI_BOOL TaskQueue_Reserve( int depth )
+{
+	int i, n;
+	LinkedList **levels;
+
+	if( depth < self.queue.depth ) {
+		return TRUE;
+	}
+	n = self.queue.depth > 0 ? self.queue.depth * 2 : 16;
+	while( n <= depth ) {
+		n *= 2;
+	}
+	levels = realloc( self.queue.levels, sizeof( LinkedList* ) * n );
+	if( !levels ) {
+		return FALSE;
+	}
+	self.queue.levels = levels;
+	/* 链表的首结点会引用链表头，所以每个层级的链表需要单独分配 */
+	for( i = self.queue.depth; i < n; ++i ) {
+		levels[i] = malloc( sizeof( LinkedList ) );
+		if( !levels[i] ) {
+			self.queue.depth = i;
+			return FALSE;
+		}
+		LinkedList_Init( levels[i] );
+	}
+	self.queue.depth = n;
+	return TRUE;
+}
+
+static void TaskQueue_Remove( LCUI_Widget w )
+{
+	if( w->task.depth < 0 ) {
+		return;
+	}
+	LinkedList_Unlink( self.queue.levels[w->task.depth], &w->task.node );
+	w->task.depth = -1;
+	self.queue.length -= 1;
+}
+
+/** 标记祖先部件，以便在部件被添加到根部件中时能够找到它 */
+static void Widget_MarkPendingChild( LCUI_Widget w )
+{
+	w = w->parent;
+	while( w && !w->task.for_children ) {
+		w->task.for_children = TRUE;
+		w = w->parent;
+	}
+}
+
+/**
+ * 将部件加入任务队列
+ * 不在根部件中的部件不会被加入，它的任务会在它被添加到根部件中时，由
+ * Widget_UpdateTaskStatus() 重新加入队列。
+ */
+static void TaskQueue_Add( LCUI_Widget w )
+{
+	int depth = Widget_GetDepth( w );
+	if( depth < 0 || !TaskQueue_Reserve( depth ) ) {
+		Widget_MarkPendingChild( w );
+		return;
+	}
+	w->task.depth = depth;
+	w->task.node.data = w;
+	LinkedList_AppendNode( self.queue.levels[depth], &w->task.node );
+	if( depth < self.queue.min_depth ) {
+		self.queue.min_depth = depth;
+	}
+	self.queue.length += 1;
+}
+
+/**
+ * 将被移动过的部件按新的层级重新加入队列
+ * 它可能被移动到了本轮已经处理过的层级中，需要让本轮回到这个层级，以保证它仍然
+ * 先于它的子级部件被处理。
+ */
+static void TaskQueue_Requeue( LCUI_Widget w )
+{
+	TaskQueue_Add( w );
+	if( w->task.depth >= 0 && w->task.depth < self.queue.sweep_depth ) {
+		self.queue.sweep_depth = w->task.depth;
+	}
+}
+
+/**
+ * 检查已移出队列的部件及其祖先部件在队列中的层级是否正确
+ * 部件加入队列后可能会被移动到其它位置，此时需要按新的层级重新排队，以保证
+ * 父级部件总是先于子级部件被处理。
+ * @param[in] depth 部件原来在队列中的层级
+ * @returns 部件是否可以被处理，不能处理的部件会重新加入队列
+ */
+static LCUI_BOOL TaskQueue_Check( LCUI_Widget w, int depth )
+{
+	LCUI_Widget parent;
+	LCUI_BOOL ok = TRUE;
+
+	if( Widget_GetDepth( w ) != depth ) {
+		TaskQueue_Requeue( w );
+		return FALSE;
+	}
+	for( parent = w->parent; parent; parent = parent->parent ) {
+		--depth;
+		if( parent->task.depth >= 0 && parent->task.depth != depth ) {
+			TaskQueue_Remove( parent );
+			TaskQueue_Requeue( parent );
+			ok = FALSE;
+		}
+	}
+	if( !ok ) {
+		TaskQueue_Requeue( w );
+	}
+	return ok;
+}
+
+/**
+ * 从任务队列中取出部件
+ * 每一轮都从浅到深地处理各个层级，在本轮中被加入到已处理过的层级中的部件会留到
+ * 下一轮再处理，这样，子级部件的变动引起的父级部件的布局更新可以在处理完全部
+ * 子级部件后一并进行，而不是每处理一个子级部件就进行一次。
+ */
+static LCUI_Widget TaskQueue_Pop( void )
+{
+	int depth;
+	LCUI_Widget w;
+	LinkedList *list;
+
+	while( self.queue.length > 0 ) {
+		depth = self.queue.min_depth;
+		if( depth < self.queue.sweep_depth ) {
+			depth = self.queue.sweep_depth;
+		}
+		while( depth < self.queue.depth &&
+		       self.queue.levels[depth]->length == 0 ) {
+			++depth;
+		}
+		if( depth >= self.queue.depth ) {
+			/* 本轮已经处理到最深的层级，从最浅的层级开始新一轮 */
+			self.queue.sweep_depth = 0;
+			continue;
+		}
+		if( self.queue.sweep_depth <= self.queue.min_depth ) {
+			self.queue.min_depth = depth;
+		}
+		self.queue.sweep_depth = depth;
+		list = self.queue.levels[depth];
+		w = list->head.next->data;
+		TaskQueue_Remove( w );
+		if( TaskQueue_Check( w, depth ) ) {
+			return w;
+		}
+	}
+	self.queue.min_depth = self.queue.depth;
+	self.queue.sweep_depth = 0;
+	return NULL;
+}
+
 /** 更新当前任务状态，确保部件的任务能够被处理到 */
 void Widget_UpdateTaskStatus( LCUI_Widget widget )
 {
-	int i;
-	for( i = 0; i < WTT_TOTAL_NUM; ++i ) {
-		if( widget->task.buffer[i] ) {
-			widget->task.for_self = TRUE;
-			Widget_AddTask( widget, widget->task.buffer[i] );
-		}
+	LinkedListNode *node;
+	if( widget->task.flags && widget->task.depth < 0 ) {
+		TaskQueue_Add( widget );
+	}
+	if( !widget->task.for_children ) {
+		return;
+	}
+	/* 如果子级部件仍然不在根部件中，它们会重新标记当前部件 */
+	widget->task.for_children = FALSE;
+	for( LinkedList_Each( node, &widget->children ) ) {
+		Widget_UpdateTaskStatus( node->data );
 	}
 }
 
@@ -97,7 +290,6 @@ void Widget_AddTaskForChildren( LCUI_Widget widget, int task )
 {
 	LCUI_Widget child;
 	LinkedListNode *node;
-	widget->task.for_children = TRUE;
 	for( LinkedList_Each( node, &widget->children ) ) {
 		child = node->data;
 		Widget_AddTask( child, task );
@@ -110,20 +302,24 @@ void Widget_AddTask( LCUI_Widget widget, int task )
 	if( widget->state == WSTATE_DELETED ) {
 		return;
 	}
-	widget->task.for_self = TRUE;
-	widget->task.buffer[task] = TRUE;
-	widget = widget->parent;
-	/* 向没有标记的父级部件添加标记 */
-	while( widget && !widget->task.for_children ) {
-		widget->task.for_children = TRUE;
-		widget = widget->parent;
+	widget->task.flags |= TaskFlag( task );
+	if( widget->task.depth < 0 ) {
+		TaskQueue_Add( widget );
 	}
 }
 
+void Widget_ClearTasks( LCUI_Widget w )
+{
+	TaskQueue_Remove( w );
+	w->task.flags = 0;
+	w->task.for_children = FALSE;
+}
+
 /** 映射任务处理器 */
 static void MapTaskHandler(void)
 {
 	self.handlers[WTT_VISIBLE] = Widget_UpdateVisibility;
+	self.handlers[WTT_FLEX] = Widget_UpdateFlexBox;
 	self.handlers[WTT_POSITION] = Widget_UpdatePosition;
 	self.handlers[WTT_RESIZE] = Widget_UpdateSize;
 	self.handlers[WTT_SHADOW] = Widget_UpdateBoxShadow;
@@ -145,12 +341,25 @@ void LCUIWidget_InitTasks( void )
 {
 	MapTaskHandler();
 	self.timeout = 0;
+	self.queue.depth = 0;
+	self.queue.length = 0;
+	self.queue.min_depth = 0;
+	self.queue.sweep_depth = 0;
+	self.queue.levels = NULL;
 	LinkedList_Init( &self.trash );
 }
 
 void LCUIWidget_ExitTasks( void )
 {
+	int i;
 	LinkedList_Clear( &self.trash, NULL );
+	for( i = 0; i < self.queue.depth; ++i ) {
+		free( self.queue.levels[i] );
+	}
+	free( self.queue.levels );
+	self.queue.levels = NULL;
+	self.queue.depth = 0;
+	self.queue.length = 0;
 }
 
 void Widget_AddToTrash( LCUI_Widget w )
@@ -166,36 +375,37 @@ void Widget_AddToTrash( LCUI_Widget w )
 	}
 	node = Widget_GetNode( w );
 	snode = Widget_GetShowNode( w );
+	Widget_RemoveLayoutChild( w->parent, w );
 	LinkedList_Unlink( &w->parent->children, node );
 	LinkedList_Unlink( &w->parent->children_show, snode );
 	LinkedList_AppendNode( &self.trash, node );
 	Widget_PostSurfaceEvent( w, WET_REMOVE );
 }
 
-int Widget_UpdateEx( LCUI_Widget w, LCUI_BOOL has_timeout )
+/** 处理部件自身的任务 */
+static void Widget_ExecTasks( LCUI_Widget w )
 {
 	int i;
-	LCUI_BOOL *buffer;
-	LinkedListNode *node, *next;
+	unsigned int flag;
 
-	/* 如果该部件没有任务需要处理 */
-	if( !w->task.for_self ) {
-		goto proc_children_task;
-	}
-	w->task.for_self = FALSE;
-	buffer = w->task.buffer;
+	TaskQueue_Remove( w );
 	/* 如果有用户自定义任务 */
-	if( buffer[WTT_USER] && w->proto && w->proto->runtask ) {
-		w->proto->runtask( w );
+	if( w->task.flags & TaskFlag( WTT_USER ) ) {
+		w->task.flags &= ~TaskFlag( WTT_USER );
+		if( w->proto && w->proto->runtask ) {
+			w->proto->runtask( w );
+		}
 	}
-	for( i = 0; i < WTT_USER; ++i ) {
-		if( buffer[i] ) {
-			buffer[i] = FALSE;
-			if( self.handlers[i] ) {
-				self.handlers[i]( w );
-			}
-		} else {
-			buffer[i] = FALSE;
+	/* 处理器可能会添加新任务，排在后面的任务会在本轮中被处理，
+	 * 其余的则留到下次再处理 */
+	for( i = 0; i < WTT_USER && w->task.flags; ++i ) {
+		flag = TaskFlag( i );
+		if( !(w->task.flags & flag) ) {
+			continue;
+		}
+		w->task.flags &= ~flag;
+		if( self.handlers[i] ) {
+			self.handlers[i]( w );
 		}
 	}
 	/* 如果部件还处于未准备完毕的状态 */
@@ -211,50 +421,66 @@ int Widget_UpdateEx( LCUI_Widget w, LCUI_BOOL has_timeout )
 		}
 	}
 	self.count += 1;
+}
+
+/** 检查是否已经超时，为减少获取时间的开销，每处理一批部件才检查一次 */
+static LCUI_BOOL CheckTimeout( void )
+{
+	if( !self.is_timeout && self.count >= TIMEOUT_CHECK_INTERVAL ) {
+		self.count = 0;
+		if( LCUI_GetTime() >= self.timeout ) {
+			self.is_timeout = TRUE;
+		}
+	}
+	return self.is_timeout;
+}
 
-proc_children_task:
+int Widget_UpdateEx( LCUI_Widget w, LCUI_BOOL has_timeout )
+{
+	LCUI_BOOL has_task = FALSE;
+	LinkedListNode *node, *next;
 
-	if( !w->task.for_children ) {
-		return w->task.for_self;
+	if( w->task.flags ) {
+		Widget_ExecTasks( w );
 	}
-	/* 如果子级部件中有待处理的部件，则递归进去 */
-	w->task.for_children = FALSE;
 	node = w->children.head.next;
 	while( node ) {
-		LCUI_Widget child = node->data;
 		/* 如果当前部件有销毁任务，结点空间会连同部件一起被
 		 * 释放，为避免因访问非法空间而出现异常，预先保存下
 		 * 个结点。
 		 */
 		next = node->next;
-		/* 如果该级部件的任务需要留到下次再处理 */
-		if(  Widget_UpdateEx( child, has_timeout ) ) {
-			w->task.for_children = TRUE;
+		if( Widget_UpdateEx( node->data, has_timeout ) ) {
+			has_task = TRUE;
 		}
-		if( has_timeout ) {
-			if( !self.is_timeout && self.count >= 500 ) {
-				self.count = 0;
-				if( LCUI_GetTime() >= self.timeout ) {
-					self.is_timeout = TRUE;
-				}
-			}
-			if( self.is_timeout ) {
-				break;
-			}
+		if( has_timeout && CheckTimeout() ) {
+			/* 剩余的子部件留到下次再处理 */
+			return TRUE;
 		}
 		node = next;
 	}
-	return w->task.for_self || w->task.for_children;
+	return w->task.flags || has_task;
 }
 
 void LCUIWidget_Update( void )
 {
-	LCUI_Widget root;
+	LCUI_Widget w;
 	LinkedListNode *node;
+
 	self.is_timeout = FALSE;
 	self.timeout = LCUI_GetTime() + 20;
-	root = LCUIWidget_GetRoot();
-	while( !self.is_timeout && Widget_UpdateEx( root, TRUE ) );
+	self.queue.sweep_depth = 0;
+	/* 按层级从浅到深处理队列中的部件，父级部件总是先于子级部件被处理 */
+	while( !CheckTimeout() ) {
+		w = TaskQueue_Pop();
+		if( !w ) {
+			break;
+		}
+		/* 处理器给部件自身添加的任务可能已经在本轮中被处理掉了 */
+		if( w->task.flags ) {
+			Widget_ExecTasks( w );
+		}
+	}
 	/* 删除无用部件 */
 	node = self.trash.head.next;
 	while( node ) {
@@ -264,3 +490,8 @@ void LCUIWidget_Update( void )
 		node = next;
 	}
 }
+
+LCUI_BOOL LCUIWidget_HasPendingTasks( void )
+{
+	return self.queue.length > 0 || self.trash.length > 0;
+}
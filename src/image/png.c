@@ -141,6 +141,7 @@ int LCUI_ReadPNG( LCUI_ImageReader reader, LCUI_Graph *graph )
 	png_structp png_ptr;
 	LCUI_PNGReader png_reader;
 	int ret = 0, x, y, width, height;
+	LCUI_BOOL premultiply;
 
 	if( reader->type != LCUI_PNG_READER ) {
 		return -EINVAL;
@@ -155,10 +156,16 @@ int LCUI_ReadPNG( LCUI_ImageReader reader, LCUI_Graph *graph )
 	height = png_get_image_height( png_ptr, info_ptr );
 	/* 获取所有行像素数据，row_pointers里边就是rgba数据 */
 	rows = png_get_rows( png_ptr, info_ptr );
+	/* 如果调用者要求 PARGB 格式，则在读取时预乘 alpha */
+	premultiply = graph->color_type == COLOR_TYPE_PARGB;
 	/* 根据不同的色彩类型进行相应处理 */
 	switch( png_get_color_type( png_ptr, info_ptr ) ) {
 	case PNG_COLOR_TYPE_RGB_ALPHA:
-		graph->color_type = COLOR_TYPE_ARGB;
+		if( premultiply ) {
+			graph->color_type = COLOR_TYPE_PARGB;
+		} else {
+			graph->color_type = COLOR_TYPE_ARGB;
+		}
 		if( Graph_Create( graph, width, height ) != 0 ) {
 			ret = -ENOMEM;
 			break;
@@ -175,6 +182,12 @@ int LCUI_ReadPNG( LCUI_ImageReader reader, LCUI_Graph *graph )
 				*byte++ = rows[y][x];
 				*byte++ = rows[y][x + 3];
 			}
+			if( premultiply ) {
+				byte -= width * 4;
+				PixelsFormat( byte, COLOR_TYPE_ARGB,
+					      byte, COLOR_TYPE_PARGB, width );
+				byte += width * 4;
+			}
 		}
 		break;
 	case PNG_COLOR_TYPE_RGB:
@@ -325,8 +338,8 @@ int LCUI_WritePNGFile( const char *file_name, const LCUI_Graph *graph )
 
 	Graph_GetValidRect( graph, &rect );
 	graph = Graph_GetQuote( graph );
-	if( graph->color_type == COLOR_TYPE_ARGB ) {
-		LCUI_ARGB *px_ptr, *px_row_ptr;
+	if( Graph_HasAlpha( graph ) ) {
+		LCUI_ARGB px, *px_ptr, *px_row_ptr;
 
 		row_size = png_get_rowbytes( png_ptr, info_ptr );
 		px_row_ptr = graph->argb + rect.y * graph->width + rect.x;
@@ -335,10 +348,18 @@ int LCUI_WritePNGFile( const char *file_name, const LCUI_Graph *graph )
 			row_pointers[y] = png_malloc( png_ptr, row_size );
 			px_ptr = px_row_ptr;
 			for( x = 0; x < row_size; ++px_ptr ) {
-				row_pointers[y][x++] = px_ptr->red;
-				row_pointers[y][x++] = px_ptr->green;
-				row_pointers[y][x++] = px_ptr->blue;
-				row_pointers[y][x++] = px_ptr->alpha;
+				px = *px_ptr;
+				/* PNG 文件中存储的是非预乘 alpha 的颜色 */
+				if( graph->color_type == COLOR_TYPE_PARGB ) {
+					PixelsFormat( (uchar_t*)px_ptr,
+						      COLOR_TYPE_PARGB,
+						      (uchar_t*)&px,
+						      COLOR_TYPE_ARGB, 1 );
+				}
+				row_pointers[y][x++] = px.red;
+				row_pointers[y][x++] = px.green;
+				row_pointers[y][x++] = px.blue;
+				row_pointers[y][x++] = px.alpha;
 			}
 			px_row_ptr += graph->w;
 		}
@@ -61,6 +61,12 @@
 /** 一秒内的最大更新帧数 */
 #define MAX_FRAMES_PER_SEC 100
 
+/** 任务队列的容量，超出的任务会暂存在溢出列表中 */
+#define TASK_QUEUE_SIZE 1024
+
+/** 每帧处理任务的默认时间预算（毫秒） */
+#define DEFAULT_TASK_BUDGET 5
+
 /** 主循环的状态 */
 enum MainLoopState {
 	STATE_PAUSED,
@@ -102,7 +108,11 @@ static struct LCUI_App {
 	LCUI_BOOL driver_ready;		/**< 事件驱动支持是否已经准备就绪 */
 	struct LCUI_AppTaskAgent {
 		int state;		/**< 状态 */
-		LinkedList tasks;	/**< 任务队列 */
+		RingQueueRec queue;	/**< 任务队列，任务直接存放在队列的格子里 */
+		LinkedList tasks;	/**< 溢出列表，存放任务队列满时投递的任务 */
+		volatile LCUI_BOOL overflowed;	/**< 溢出列表中是否有任务 */
+		volatile LCUI_BOOL waiting;	/**< 主线程是否正在等待任务 */
+		int budget;		/**< 每帧处理任务的时间预算（毫秒） */
 		LCUI_Mutex mutex;	/**< 互斥锁 */
 		LCUI_Cond cond;		/**< 条件变量 */
 	} agent;
@@ -212,48 +222,109 @@ void LCUI_DestroyEvent( LCUI_SysEvent e )
 
 /*--------------------------- system event <END> ----------------------------*/
 
-LCUI_BOOL LCUI_ProcessTask( void )
+/** 判断是否有待处理的任务 */
+static LCUI_BOOL LCUIApp_HasTask( void )
+{
+	return !RingQueue_IsEmpty( &MainApp.agent.queue ) ||
+		MainApp.agent.overflowed;
+}
+
+/** 从溢出列表中取出一个任务 */
+static LCUI_BOOL LCUIApp_PopOverflowTask( LCUI_AppTask task )
 {
-	LCUI_AppTask task;
 	LinkedListNode *node;
 	LCUIMutex_Lock( &MainApp.agent.mutex );
 	node = LinkedList_GetNode( &MainApp.agent.tasks, 0 );
-	if( node ) {
-		task = node->data;
-		LinkedList_Unlink( &MainApp.agent.tasks, node );
+	if( !node ) {
+		MainApp.agent.overflowed = FALSE;
 		LCUIMutex_Unlock( &MainApp.agent.mutex );
-		LCUI_RunTask( task );
-		LCUI_DeleteTask( task );
-		free( task );
-		free( node );
-		return TRUE;
+		return FALSE;
 	}
+	LinkedList_Unlink( &MainApp.agent.tasks, node );
 	LCUIMutex_Unlock( &MainApp.agent.mutex );
-	return FALSE;
+	*task = *(LCUI_AppTask)node->data;
+	free( node->data );
+	free( node );
+	return TRUE;
+}
+
+/**
+ * 唤醒正在等待任务的主线程
+ * 只有投递任务时主线程正在等待，才需要唤醒它，而且只需唤醒一次
+ */
+static void LCUIApp_WakeUp( void )
+{
+	LCUI_AppTask task;
+	LCUIMutex_Lock( &MainApp.agent.mutex );
+	if( !MainApp.agent.waiting ) {
+		LCUIMutex_Unlock( &MainApp.agent.mutex );
+		return;
+	}
+	MainApp.agent.waiting = FALSE;
+	if( MainApp.agent.state == STATE_RUNNING || !MainApp.driver_ready ) {
+		LCUICond_Signal( &MainApp.agent.cond );
+		LCUIMutex_Unlock( &MainApp.agent.mutex );
+		return;
+	}
+	LCUIMutex_Unlock( &MainApp.agent.mutex );
+	/* 主线程在等待平台的事件，通过驱动投递一个空任务来唤醒它 */
+	task = NEW( LCUI_AppTaskRec, 1 );
+	MainApp.driver->PostTask( task );
+}
+
+LCUI_BOOL LCUI_ProcessTask( void )
+{
+	LCUI_AppTaskRec task;
+	if( RingQueue_Pop( &MainApp.agent.queue, &task ) != 0 ) {
+		/* 溢出列表中的任务比任务队列中的晚，所以放在后面处理 */
+		if( !MainApp.agent.overflowed ||
+		    !LCUIApp_PopOverflowTask( &task ) ) {
+			return FALSE;
+		}
+	}
+	LCUI_RunTask( &task );
+	LCUI_DeleteTask( &task );
+	return TRUE;
 }
 
 void LCUI_ProcessEvents( void )
 {
-	int i;
-	for( i = 0; LCUI_ProcessTask() && i < 100; ++i );
+	int64_t start = LCUI_GetTime();
+	/* 超出时间预算后，剩余的任务会让 LCUI_WaitEvent() 立即返回，留到下一帧 */
+	while( LCUI_ProcessTask() ) {
+		if( LCUI_GetTimeDelta( start ) >= MainApp.agent.budget ) {
+			break;
+		}
+	}
 	if( MainApp.driver_ready ) {
 		MainApp.driver->ProcessEvents();
 	}
 }
 
+void LCUI_SetTaskBudget( int ms )
+{
+	MainApp.agent.budget = ms > 0 ? ms : DEFAULT_TASK_BUDGET;
+}
+
 LCUI_BOOL LCUI_PostTask( LCUI_AppTask task )
 {
 	LCUI_AppTask newtask;
-	newtask = NEW( LCUI_AppTaskRec, 1 );
-	*newtask = *task;
-	if( MainApp.driver_ready && MainApp.agent.state != STATE_RUNNING ) {
-		return MainApp.driver->PostTask( newtask );
-	} else {
+	/* 溢出列表不为空时，新任务也要放进溢出列表，以保证任务的先后顺序。
+	 * 在 LCUI_InitApp() 之前投递的任务也会暂存在溢出列表中 */
+	if( MainApp.agent.overflowed ||
+	    RingQueue_Push( &MainApp.agent.queue, task ) != 0 ) {
+		newtask = NEW( LCUI_AppTaskRec, 1 );
+		*newtask = *task;
 		LCUIMutex_Lock( &MainApp.agent.mutex );
+		MainApp.agent.overflowed = TRUE;
 		LinkedList_Append( &MainApp.agent.tasks, newtask );
-		LCUICond_Signal( &MainApp.agent.cond );
 		LCUIMutex_Unlock( &MainApp.agent.mutex );
 	}
+	/* 确保主线程在判断是否有任务前已经能看到新任务，否则它会错过唤醒 */
+	RingQueue_Barrier();
+	if( MainApp.agent.waiting ) {
+		LCUIApp_WakeUp();
+	}
 	return TRUE;
 }
 
@@ -310,7 +381,10 @@ int LCUIMainLoop_Run( LCUI_MainLoop loop )
 	DEBUG_MSG( "loop: %p, enter\n", loop );
 	MainApp.loop = loop;
 	while( loop->state != STATE_EXITED ) {
-		//LCUI_WaitEvent();
+		/* 没有需要更新的内容时，休眠到有新的任务或事件为止 */
+		if( !LCUIDisplay_HasPendingUpdate() ) {
+			LCUI_WaitEvent();
+		}
 		LCUI_ProcessEvents();
 		LCUIDisplay_Update();
 		LCUIDisplay_Render();
@@ -340,6 +414,8 @@ int LCUIMainLoop_Run( LCUI_MainLoop loop )
 void LCUIMainLoop_Quit( LCUI_MainLoop loop )
 {
 	loop->state = STATE_EXITED;
+	/* 主循环可能正在等待事件，投递一个空任务来唤醒它 */
+	LCUI_PostSimpleTask( NULL, NULL, NULL );
 }
 
 void LCUI_InitApp( LCUI_AppDriver app )
@@ -364,6 +440,11 @@ void LCUI_InitApp( LCUI_AppDriver app )
 	LCUIMutex_Init( &MainApp.agent.mutex );
 	LCUICond_Init( &MainApp.agent.cond );
 	LinkedList_Init( &MainApp.agent.tasks );
+	RingQueue_Init( &MainApp.agent.queue, sizeof( LCUI_AppTaskRec ),
+			TASK_QUEUE_SIZE );
+	MainApp.agent.overflowed = FALSE;
+	MainApp.agent.waiting = FALSE;
+	MainApp.agent.budget = DEFAULT_TASK_BUDGET;
 	StepTimer_SetFrameLimit( MainApp.timer, MAX_FRAMES_PER_SEC );
 }
 
@@ -375,6 +456,7 @@ static void OnDeleteTask( void *arg )
 
 static void LCUI_ExitApp( void )
 {
+	LCUI_AppTaskRec task;
 	LCUI_MainLoop loop;
 	LinkedListNode *node;
 	for( LinkedList_Each( node, &MainApp.loops ) ) {
@@ -389,27 +471,46 @@ static void LCUI_ExitApp( void )
 	LCUICond_Destroy( &MainApp.agent.cond );
 	LinkedList_Clear( &MainApp.loops, free );
 	LinkedList_Clear( &MainApp.agent.tasks, OnDeleteTask );
+	while( RingQueue_Pop( &MainApp.agent.queue, &task ) == 0 ) {
+		LCUI_DeleteTask( &task );
+	}
+	RingQueue_Destroy( &MainApp.agent.queue );
 	LCUI_DestroyAppDriver( MainApp.driver );
 	MainApp.driver_ready = FALSE;
 }
 
 LCUI_BOOL LCUI_WaitEvent( void )
 {
-	if( MainApp.agent.tasks.length > 0 ) {
+	LCUI_BOOL ret;
+	if( LCUIApp_HasTask() ) {
 		return TRUE;
 	}
+	/* 先标记主线程正在等待，再检查一次任务队列，与 LCUI_PostTask() 中的顺序
+	 * 相反，这样两边至少有一方能看到对方的修改，不会错过唤醒 */
+	LCUIMutex_Lock( &MainApp.agent.mutex );
 	if( MainApp.agent.state != STATE_RUNNING ) {
-		return MainApp.driver->WaitEvent();
+		MainApp.agent.waiting = TRUE;
+		LCUIMutex_Unlock( &MainApp.agent.mutex );
+		RingQueue_Barrier();
+		if( !MainApp.driver_ready || LCUIApp_HasTask() ) {
+			MainApp.agent.waiting = FALSE;
+			return MainApp.driver_ready;
+		}
+		ret = MainApp.driver->WaitEvent();
+		MainApp.agent.waiting = FALSE;
+		return ret;
 	}
-	LCUIMutex_Lock( &MainApp.agent.mutex );
 	while( MainApp.agent.state == STATE_RUNNING ) {
-		if( MainApp.agent.tasks.length > 0 ||
-		    MainApp.agent.state != STATE_RUNNING ) {
+		MainApp.agent.waiting = TRUE;
+		RingQueue_Barrier();
+		if( LCUIApp_HasTask() ) {
+			MainApp.agent.waiting = FALSE;
 			LCUIMutex_Unlock( &MainApp.agent.mutex );
 			return TRUE;
 		}
 		LCUICond_Wait( &MainApp.agent.cond, &MainApp.agent.mutex );
 	}
+	MainApp.agent.waiting = FALSE;
 	LCUIMutex_Unlock( &MainApp.agent.mutex );
 	return FALSE;
 }
@@ -463,6 +564,7 @@ static void LCUIApp_QuitAllMainLoop(void)
 			loop->state = STATE_EXITED;
 		}
 	}
+	LCUI_PostSimpleTask( NULL, NULL, NULL );
 }
 
 /** 打印LCUI的信息 */
@@ -97,7 +97,7 @@ typedef struct LCUI_SurfaceRec_ {
 	LCUI_Mutex mutex;		/**< 互斥锁 */
 	int64_t timestamp;		/**< 时间戳，记录上次清空 ignored_size 时的时间 */
 	LinkedList ignored_size;	/**< 列表，记录被忽略的尺寸，用于屏蔽重复的窗口尺寸更改操作 */
-	LinkedList rects;		/**< 列表，记录当前需要重绘的区域 */
+	LCUI_RegionRec rects;		/**< 当前需要呈现到窗口的区域 */
 	LinkedListNode node;		/**< 在表面列表中的结点 */
 } LCUI_SurfaceRec;
 
@@ -183,7 +183,7 @@ static void X11Surface_OnResize( LCUI_Surface s, int width, int height )
 	switch( depth ) {
 	case 32:
 	case 24:
-		s->fb.color_type = COLOR_TYPE_ARGB;
+		s->fb.color_type = COLOR_TYPE_PARGB;
 		break;
 	default: 
 		printf("[x11display] unsupport depth: %d.\n", depth);
@@ -216,7 +216,7 @@ static void X11Surface_OnCreate( LCUI_Surface s )
 					 0, 100, MIN_WIDTH, MIN_HEIGHT, 1, 
 					 bdcolor, bgcolor );
 	LCUIMutex_Init( &s->mutex );
-	LinkedList_Init( &s->rects );
+	Region_Init( &s->rects );
 	LinkedList_Init( &s->ignored_size );
 	LCUI_SetLinuxX11MainWindow( s->window );
 }
@@ -263,16 +263,15 @@ static void X11Surface_OnTask( LCUI_Surface surface, LCUI_SurfaceTask task )
         	break;
         }
         case TASK_PRESENT: {
-		LinkedListNode *node;
+		LCUI_Rect *rect;
 		LCUIMutex_Lock( &surface->mutex );
-		LinkedList_ForEach( node, &surface->rects ) {
-			LCUI_Rect *rect = node->data;
+		for( Region_Each( rect, &surface->rects ) ) {
 			XPutImage( x11.app->display, surface->window, 
 				   surface->gc, surface->ximage, 
 				   rect->x, rect->y, rect->x, rect->y, 
 				   rect->width, rect->height );
 		}
-		LinkedList_Clear( &surface->rects, free );
+		Region_Clear( &surface->rects );
 		LCUIMutex_Unlock( &surface->mutex );
 		break;
         }
@@ -319,7 +318,7 @@ static LCUI_Surface X11Surface_New( void )
 	surface->config.x = 0;
 	surface->config.y = 0;
 	Graph_Init( &surface->fb );
-	surface->fb.color_type = COLOR_TYPE_ARGB;
+	surface->fb.color_type = COLOR_TYPE_PARGB;
 	LinkedList_AppendNode( &x11.surfaces, &surface->node );
 	X11Surface_SendTask( surface, &task );
 	return surface;
@@ -409,6 +408,10 @@ static LCUI_PaintContext X11Surface_BeginPaint( LCUI_Surface surface,
 	LCUIMutex_Lock( &surface->mutex );
 	LCUIRect_ValidateArea( &paint->rect, surface->width, surface->height );
 	Graph_Quote( &paint->canvas, &surface->fb, &paint->rect );
+	/*
+	 * 帧缓存是 PARGB 格式的，先填充为不透明的白色，之后混合的结果也都是
+	 * 不透明的，而不透明像素在预乘 alpha 前后相同，所以呈现时无需转换
+	 */
 	Graph_FillRect( &paint->canvas, RGB( 255, 255, 255 ), NULL, TRUE );
 	return paint;
 }
@@ -416,10 +419,7 @@ static LCUI_PaintContext X11Surface_BeginPaint( LCUI_Surface surface,
 static void X11Surface_EndPaint( LCUI_Surface surface, 
 				LCUI_PaintContext paint )
 {
-	LCUI_Rect *r;
-	r = NEW( LCUI_Rect, 1 );
-	*r = paint->rect;
-	LinkedList_Append( &surface->rects, r );
+	Region_UnionRect( &surface->rects, &paint->rect );
 	free( paint );
 	LCUIMutex_Unlock( &surface->mutex );
 }
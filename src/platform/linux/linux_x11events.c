@@ -41,13 +41,23 @@
 #include <stdlib.h>
 #include <LCUI_Build.h>
 #ifdef LCUI_BUILD_IN_LINUX
+#include <fcntl.h>
+#include <unistd.h>
 #include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
 #include <LCUI/display.h>
 #include <LCUI/platform.h>
 #include LCUI_EVENTS_H
 
 static LCUI_X11AppDriverRec x11;
 
+/** 任务队列，保存其它线程投递过来的任务 */
+static struct X11TaskQueue {
+	LinkedList tasks;		/**< 任务列表 */
+	LCUI_Mutex mutex;		/**< 互斥锁 */
+	int wakeup_fd[2];		/**< 管道，用于唤醒正在等待事件的主线程 */
+} queue;
+
 void LCUI_SetLinuxX11MainWindow( Window win )
 {
 	x11.win_main = win;
@@ -59,34 +69,64 @@ void LCUI_SetLinuxX11MainWindow( Window win )
 	LCUI_SetTaskAgent( FALSE );
 }
 
+/**
+ * 投递任务
+ * 任务可能来自定时器等其它线程，而 Xlib 的连接不能在多个线程中同时使用，所以
+ * 先将任务存入队列，再通过管道唤醒主线程。
+ */
 static LCUI_BOOL X11_PostTask( LCUI_AppTask task )
 {
-	XEvent ev;
-	memset( &ev, 0, sizeof (ev) );
-	ev.xclient.type = ClientMessage;
-	ev.xclient.window = x11.win_main;
-	ev.xclient.format = 32;
-	ev.xclient.message_type = x11.wm_lcui;
-	XSendEvent( x11.display, x11.win_main, FALSE, NoEventMask, &ev );
+	char c = 0;
+	LCUIMutex_Lock( &queue.mutex );
+	LinkedList_Append( &queue.tasks, task );
+	LCUIMutex_Unlock( &queue.mutex );
+	/* 写入失败说明管道已满，主线程已经会被唤醒，可以忽略 */
+	if( write( queue.wakeup_fd[1], &c, 1 ) < 0 ) {
+		DEBUG_MSG( "wakeup pipe is full\n" );
+	}
 	return TRUE;
 }
 
+static void X11_ProcessTasks( void )
+{
+	int i;
+	char buf[64];
+	LCUI_AppTask task;
+	LinkedListNode *node;
+	while( read( queue.wakeup_fd[0], buf, sizeof( buf ) ) > 0 );
+	/* 剩余的任务会让 X11_WaitEvent() 立即返回，留到下次再处理 */
+	for( i = 0; i < 100; ++i ) {
+		LCUIMutex_Lock( &queue.mutex );
+		node = LinkedList_GetNode( &queue.tasks, 0 );
+		if( !node ) {
+			LCUIMutex_Unlock( &queue.mutex );
+			break;
+		}
+		LinkedList_Unlink( &queue.tasks, node );
+		LCUIMutex_Unlock( &queue.mutex );
+		task = node->data;
+		LCUI_RunTask( task );
+		LCUI_DeleteTask( task );
+		free( task );
+		free( node );
+	}
+}
+
+/** 等待 X11 事件或者任务，在它们到来前一直休眠 */
 static LCUI_BOOL X11_WaitEvent( void )
 {
-	int fd;
+	int fd, max_fd;
 	fd_set fdset;
-	struct timeval tv;
-	XFlush( x11.display );
-	fd = ConnectionNumber( x11.display );
-	if( XEventsQueued(x11.display, QueuedAlready) ) {
+	if( XPending( x11.display ) || queue.tasks.length > 0 ) {
 		return TRUE;
 	}
+	fd = ConnectionNumber( x11.display );
+	max_fd = fd > queue.wakeup_fd[0] ? fd : queue.wakeup_fd[0];
 	FD_ZERO( &fdset );
 	FD_SET( fd, &fdset );
-	tv.tv_sec = 0;
-	tv.tv_usec = 10000;
-	if( select(fd + 1, &fdset, NULL, NULL, &tv) == 1 ) {
-	    return XPending( x11.display );
+	FD_SET( queue.wakeup_fd[0], &fdset );
+	if( select( max_fd + 1, &fdset, NULL, NULL, NULL ) > 0 ) {
+		return TRUE;
 	}
 	return FALSE;
 }
@@ -94,7 +134,7 @@ static LCUI_BOOL X11_WaitEvent( void )
 static LCUI_BOOL X11_DispatchEvent( void )
 {
 	XEvent xevent;
-	if( !XEventsQueued(x11.display, QueuedAlready) ) {
+	if( !XEventsQueued( x11.display, QueuedAfterReading ) ) {
 		return FALSE;
 	}
 	XNextEvent( x11.display, &xevent );
@@ -110,6 +150,7 @@ static LCUI_BOOL X11_DispatchEvent( void )
 static void X11_ProcessEvents( void )
 {
 	int i;
+	X11_ProcessTasks();
 	for( i = 0; X11_DispatchEvent() && i < 10000; ++i );
 }
 
@@ -151,6 +192,14 @@ LCUI_AppDriver LCUI_CreateLinuxX11AppDriver( void )
 	x11.cmap = DefaultColormap( x11.display, x11.screen );
 	x11.wm_lcui = XInternAtom( x11.display, "WM_LCUI", FALSE );
 	XSetWMProtocols( x11.display, x11.win_root, &x11.wm_lcui, 1 );
+	if( pipe( queue.wakeup_fd ) != 0 ) {
+		XCloseDisplay( x11.display );
+		return NULL;
+	}
+	fcntl( queue.wakeup_fd[0], F_SETFL, O_NONBLOCK );
+	fcntl( queue.wakeup_fd[1], F_SETFL, O_NONBLOCK );
+	LinkedList_Init( &queue.tasks );
+	LCUIMutex_Init( &queue.mutex );
 	app->WaitEvent = X11_WaitEvent;
 	app->ProcessEvents = X11_ProcessEvents;
 	app->PostTask = X11_PostTask;
@@ -162,8 +211,17 @@ LCUI_AppDriver LCUI_CreateLinuxX11AppDriver( void )
 	return app;
 }
 
-void LCUI_DestroyLinuxX11AppDriver( LCUI_AppDriver app )
+static void OnDeleteTask( void *arg )
 {
+	LCUI_DeleteTask( arg );
+	free( arg );
+}
 
+void LCUI_DestroyLinuxX11AppDriver( LCUI_AppDriver app )
+{
+	LinkedList_Clear( &queue.tasks, OnDeleteTask );
+	LCUIMutex_Destroy( &queue.mutex );
+	close( queue.wakeup_fd[0] );
+	close( queue.wakeup_fd[1] );
 }
 #endif
@@ -84,6 +84,7 @@ struct LCUI_SurfaceRec_ {
 	HBITMAP fb_bmp;				/**< 帧缓存 */
 	LCUI_BOOL is_ready;			/**< 是否已经准备好 */
 	LCUI_Graph fb;				/**< 帧缓存，保存当前窗口内呈现的图像内容 */
+	LCUI_RegionRec rects;			/**< 帧缓存中需要呈现到窗口的区域 */
 	LCUI_SurfaceTask tasks[TASK_TOTAL_NUM];	/**< 任务缓存 */
 	LinkedListNode node;			/**< 在链表中的结点 */
 };
@@ -123,6 +124,7 @@ static void WinSurface_ExecDestroy( LCUI_Surface surface )
 	surface->fb_bmp = NULL;
 	surface->hwnd = NULL;
 	Graph_Free( &surface->fb );
+	Region_Free( &surface->rects );
 }
 
 static void WinSurface_Destroy( LCUI_Surface surface )
@@ -179,7 +181,8 @@ static LCUI_Surface WinSurface_New( void )
 	surface->is_ready = FALSE;
 	surface->node.data = surface;
 	Graph_Init( &surface->fb );
-	surface->fb.color_type = COLOR_TYPE_ARGB;
+	Region_Init( &surface->rects );
+	surface->fb.color_type = COLOR_TYPE_PARGB;
 	for( i = 0; i < TASK_TOTAL_NUM; ++i ) {
 		surface->tasks[i].is_valid = FALSE;
 	}
@@ -324,6 +327,10 @@ static LCUI_PaintContext WinSurface_BeginPaint( LCUI_Surface surface, LCUI_Rect
 	Graph_Init( &paint->canvas );
 	LCUIRect_ValidateArea( &paint->rect, surface->width, surface->height );
 	Graph_Quote( &paint->canvas, &surface->fb, &paint->rect );
+	/*
+	 * 帧缓存是 PARGB 格式的，先填充为不透明的白色，之后混合的结果也都是
+	 * 不透明的，而不透明像素在预乘 alpha 前后相同，所以呈现时无需转换
+	 */
 	Graph_FillRect( &paint->canvas, RGB( 255, 255, 255 ), NULL, TRUE );
 	return paint;
 }
@@ -335,6 +342,7 @@ static LCUI_PaintContext WinSurface_BeginPaint( LCUI_Surface surface, LCUI_Rect
 */
 static void WinSurface_EndPaint( LCUI_Surface surface, LCUI_PaintContext paint_ctx )
 {
+	Region_UnionRect( &surface->rects, &paint_ctx->rect );
 	free( paint_ctx );
 }
 
@@ -343,6 +351,7 @@ static void WinSurface_Present( LCUI_Surface surface )
 {
 	HDC hdc_client;
 	RECT client_rect;
+	LCUI_Rect *rect;
 
 	DEBUG_MSG( "surface: %p, hwnd: %p\n", surface, surface->hwnd );
 	hdc_client = GetDC( surface->hwnd );
@@ -357,10 +366,15 @@ static void WinSurface_Present( LCUI_Surface surface )
 		break;
 	case RENDER_MODE_BIT_BLT:
 	default:
-		BitBlt( hdc_client, 0, 0, surface->width, surface->height,
-			surface->fb_hdc, 0, 0, SRCCOPY );
+		/* 只呈现这一帧中重绘过的区域 */
+		for( Region_Each( rect, &surface->rects ) ) {
+			BitBlt( hdc_client, rect->x, rect->y,
+				rect->width, rect->height,
+				surface->fb_hdc, rect->x, rect->y, SRCCOPY );
+		}
 		break;
 	}
+	Region_Clear( &surface->rects );
 	ValidateRect( surface->hwnd, NULL );
 }
 
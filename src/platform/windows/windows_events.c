@@ -65,6 +65,7 @@ static LRESULT CALLBACK WndProc( HWND hwnd, UINT msg,
 	case WM_LCUI_TASK:
 		LCUI_RunTask( (LCUI_AppTask)arg2 );
 		LCUI_DeleteTask( (LCUI_AppTask)arg2 );
+		free( (LCUI_AppTask)arg2 );
 		return 0;
 	case WM_CLOSE:
 		surface = LCUIDisplay_GetSurfaceByHandle( hwnd );
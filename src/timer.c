@@ -38,6 +38,7 @@
  * ***************************************************************************/
 
 //#define DEBUG
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <LCUI_Build.h>
@@ -48,24 +49,40 @@
 #define STATE_RUN	1
 #define STATE_PAUSE	0
 
+/** 定时器堆的分支数，四叉堆比二叉堆更浅，调整位置时访问的内存更集中 */
+#define HEAP_ARITY	4
+
 /*----------------------------- Timer --------------------------------*/
 
 typedef struct TimerRec_ {
 	int state;			/**< 状态 */
 	LCUI_BOOL reuse;		/**< 是否重复使用该定时器 */
 	long int id;			/**< 定时器ID */
-	int64_t start_time;		/**< 定时器启动时的时间 */
+	int64_t deadline;		/**< 到期时间 */
 	int64_t pause_time;		/**< 定时器暂停时的时间 */
 	long int total_ms;		/**< 定时时间（单位：毫秒） */
-	long int pause_ms;		/**< 定时器处于暂停状态的时长（单位：毫秒） */
+	int index;			/**< 在定时器堆中的下标，不在堆中时为 -1 */
 	void (*func)(void*);		/**< 回调函数 */
 	void *arg;			/**< 函数的参数 */
-	LinkedListNode node;		/**< 位于定时器列表中的节点 */
 } TimerRec, *Timer;
 
+/** 定时器调用记录，一次唤醒中到期的定时器会合并到同一个任务中执行 */
+typedef struct TimerCallRec_ {
+	void (*func)(void*);
+	void *arg;
+} TimerCallRec, *TimerCall;
+
+typedef struct TimerCallListRec_ {
+	int length;
+	TimerCallRec calls[1];
+} TimerCallListRec, *TimerCallList;
+
 static struct TimerModule {
 	int id_count;			/**< 定时器ID计数 */
-	LinkedList timer_list;		/**< 定时器数据记录 */
+	RBTree timers;			/**< 定时器表，以 ID 为索引 */
+	Timer *heap;			/**< 按到期时间排列的最小堆，只包含运行中的定时器 */
+	int heap_length;		/**< 堆中的定时器数量 */
+	int heap_capacity;		/**< 堆的容量 */
 	LCUI_BOOL is_running;		/**< 定时器线程是否正在运行 */
 	LCUI_Cond sleep_cond;		/**< 用于控制定时器睡眠的条件变量 */
 	LCUI_Mutex mutex;		/**< 定时器记录操作互斥锁 */
@@ -74,93 +91,207 @@ static struct TimerModule {
 
 /*----------------------------- Private ------------------------------*/
 
-/** 更新定时器在定时器列表中的位置 */
-static void TimerList_AddNode( LinkedListNode *node )
+static void TimerHeap_Set( int i, Timer timer )
 {
-	Timer timer;
-	int64_t t, tt;
-	LinkedListNode *cur;
-	/* 计算该定时器的剩余定时时长 */
-	timer = node->data;
-	t = LCUI_GetTimeDelta( timer->start_time );
-	t = timer->total_ms - t + timer->pause_ms;
-	for( LinkedList_Each( cur, &self.timer_list ) ) {
-		timer = cur->data;
-		tt = LCUI_GetTimeDelta( timer->start_time );
-		tt = timer->total_ms - tt + timer->pause_ms;
-		if( t <= tt ) {
-			LinkedList_Link( &self.timer_list, cur->prev, node );
-			return;
+	self.heap[i] = timer;
+	timer->index = i;
+}
+
+/** 将定时器往堆顶方向移动，直到它不早于父节点 */
+static void TimerHeap_SiftUp( int i )
+{
+	int parent;
+	Timer timer = self.heap[i];
+	while( i > 0 ) {
+		parent = (i - 1) / HEAP_ARITY;
+		if( self.heap[parent]->deadline <= timer->deadline ) {
+			break;
+		}
+		TimerHeap_Set( i, self.heap[parent] );
+		i = parent;
+	}
+	TimerHeap_Set( i, timer );
+}
+
+/** 将定时器往堆底方向移动，直到它不晚于所有子节点 */
+static void TimerHeap_SiftDown( int i )
+{
+	int child, min_child, last;
+	Timer timer = self.heap[i];
+	while( 1 ) {
+		child = i * HEAP_ARITY + 1;
+		if( child >= self.heap_length ) {
+			break;
+		}
+		min_child = child;
+		last = child + HEAP_ARITY;
+		if( last > self.heap_length ) {
+			last = self.heap_length;
+		}
+		for( ++child; child < last; ++child ) {
+			if( self.heap[child]->deadline <
+			    self.heap[min_child]->deadline ) {
+				min_child = child;
+			}
+		}
+		if( timer->deadline <= self.heap[min_child]->deadline ) {
+			break;
+		}
+		TimerHeap_Set( i, self.heap[min_child] );
+		i = min_child;
+	}
+	TimerHeap_Set( i, timer );
+}
+
+static int TimerHeap_Push( Timer timer )
+{
+	Timer *heap;
+	if( self.heap_length >= self.heap_capacity ) {
+		int capacity = self.heap_capacity > 0 ?
+			self.heap_capacity * 2 : 64;
+		heap = realloc( self.heap, sizeof( Timer ) * capacity );
+		if( !heap ) {
+			return -ENOMEM;
 		}
+		self.heap = heap;
+		self.heap_capacity = capacity;
+	}
+	self.heap_length += 1;
+	TimerHeap_Set( self.heap_length - 1, timer );
+	TimerHeap_SiftUp( self.heap_length - 1 );
+	return 0;
+}
+
+static void TimerHeap_Remove( Timer timer )
+{
+	int i = timer->index;
+	Timer last;
+	if( i < 0 ) {
+		return;
+	}
+	timer->index = -1;
+	last = self.heap[--self.heap_length];
+	if( i == self.heap_length ) {
+		return;
+	}
+	TimerHeap_Set( i, last );
+	if( i > 0 && self.heap[(i - 1) / HEAP_ARITY]->deadline >
+	    last->deadline ) {
+		TimerHeap_SiftUp( i );
+	} else {
+		TimerHeap_SiftDown( i );
+	}
+}
+
+/** 在定时器的到期时间改变后，更新它在堆中的位置 */
+static void TimerHeap_Update( Timer timer )
+{
+	int i = timer->index;
+	if( i > 0 && self.heap[(i - 1) / HEAP_ARITY]->deadline >
+	    timer->deadline ) {
+		TimerHeap_SiftUp( i );
+	} else if( i >= 0 ) {
+		TimerHeap_SiftDown( i );
+	}
+}
+
+/** 如果定时器成为了最早到期的定时器，则唤醒定时器线程重新计算睡眠时长 */
+static void TimerThread_Notify( Timer timer )
+{
+	if( self.heap_length > 0 && self.heap[0] == timer ) {
+		LCUICond_Signal( &self.sleep_cond );
 	}
-	LinkedList_AppendNode( &self.timer_list, node );
 }
 
 //#define DEBUG_TIMER
 #ifdef DEBUG_TIMER
-/** 打印列表中的定时器信息 */
-static void TimerList_Print( void )
+/** 打印堆中的定时器信息 */
+static void TimerHeap_Print( void )
 {
-	int i = 0;
+	int i;
 	Timer timer;
-	LinkedListNode *node;
-	_DEBUG_MSG("timer list(%d) start:\n", self.timer_list.length);
-	for( LinkedList_Each( node, &self.timer_list ) {
-		timer = node->data;
+	_DEBUG_MSG("timer heap(%d) start:\n", self.heap_length);
+	for( i = 0; i < self.heap_length; ++i ) {
+		timer = self.heap[i];
 		_DEBUG_MSG("[%02d] %ld, func: %p, cur_ms: %ldms, total_ms: %ldms\n",
-			i++, timer->id, timer->func, timer->total_ms - (long int)LCUI_GetTimeDelta(timer->start_time), timer->total_ms );
+			i, timer->id, timer->func, (long int)(timer->deadline - LCUI_GetTime()), timer->total_ms );
 	}
-	_DEBUG_MSG("timer list end\n\n");
+	_DEBUG_MSG("timer heap end\n\n");
 }
 #endif
 
+/** 依次调用在同一次唤醒中到期的定时器的回调函数 */
+static void OnTimerCalls( void *arg, void *unused )
+{
+	int i;
+	TimerCallList list = arg;
+	for( i = 0; i < list->length; ++i ) {
+		list->calls[i].func( list->calls[i].arg );
+	}
+}
 
-/** 定时器线程，用于处理列表中各个定时器 */
+/** 取出所有已到期的定时器，返回它们的调用记录 */
+static TimerCallList TimerThread_CollectCalls( int64_t now )
+{
+	Timer timer;
+	TimerCallList list;
+	/* 到期的定时器数量不会超过堆中的定时器数量 */
+	list = malloc( sizeof( TimerCallListRec ) +
+		       sizeof( TimerCallRec ) * self.heap_length );
+	if( !list ) {
+		return NULL;
+	}
+	list->length = 0;
+	while( self.heap_length > 0 && self.heap[0]->deadline <= now ) {
+		timer = self.heap[0];
+		list->calls[list->length].func = timer->func;
+		list->calls[list->length].arg = timer->arg;
+		list->length += 1;
+		if( timer->reuse ) {
+			/* 以上次的到期时间为基准，避免误差积累 */
+			timer->deadline += timer->total_ms;
+			if( timer->deadline <= now ) {
+				timer->deadline = now + (timer->total_ms > 0 ?
+							 timer->total_ms : 1);
+			}
+			TimerHeap_SiftDown( 0 );
+		} else {
+			TimerHeap_Remove( timer );
+			RBTree_Erase( &self.timers, timer->id );
+		}
+	}
+	return list;
+}
+
+/** 定时器线程，用于处理堆中各个定时器 */
 static void TimerThread( void *arg )
 {
-	long int n_ms;
-	int64_t lost_ms;
-	LinkedListNode *node;
+	int64_t now;
+	TimerCallList list;
 	LCUI_AppTaskRec task = {0};
 	LCUIMutex_Lock( &self.mutex );
 	while( self.is_running ) {
-		Timer timer = NULL;
-		for( LinkedList_Each( node, &self.timer_list ) ) {
-			timer = node->data;
-			if( timer && timer->state == STATE_RUN ) {
-				break;
-			}
-		}
-		/* 没有要处理的定时器，停留一段时间再进行下次循环 */
-		if( !node ) {
-			LCUIMutex_Unlock( &self.mutex );
-			LCUI_MSleep( 10 );
-			LCUIMutex_Lock( &self.mutex );
+		/* 没有运行中的定时器，一直睡眠到有新的定时器为止 */
+		if( self.heap_length < 1 ) {
+			LCUICond_Wait( &self.sleep_cond, &self.mutex );
 			continue;
 		}
-		lost_ms = LCUI_GetTimeDelta( timer->start_time );
-		/* 减去处于暂停状态的时长 */
-		lost_ms -= timer->pause_ms;
-		/* 若流失的时间未达到总定时时长，则睡眠一段时间 */
-		if( lost_ms < timer->total_ms ) {
-			n_ms = timer->total_ms - lost_ms;
-			LCUICond_TimedWait( &self.sleep_cond,
-					    &self.mutex, n_ms );
+		now = LCUI_GetTime();
+		/* 最早的定时器还未到期，睡眠到它的到期时间 */
+		if( self.heap[0]->deadline > now ) {
+			LCUICond_TimedWait( &self.sleep_cond, &self.mutex,
+					    (unsigned int)(self.heap[0]->deadline
+							   - now) );
 			continue;
 		}
-		/* 准备任务数据 */
-		task.func = (LCUI_AppTaskFunc)timer->func;
-		task.arg[0] = timer->arg;
-		/* 若需要重复使用，则重置剩余等待时间 */
-		LinkedList_Unlink( &self.timer_list, node );
-		if( timer->reuse ) {
-			timer->pause_ms = 0;
-			timer->start_time = LCUI_GetTime();
-			TimerList_AddNode( node );
-		} else {
-			free( timer );
+		list = TimerThread_CollectCalls( now );
+		if( !list ) {
+			continue;
 		}
-		/* 添加该任务至指定程序的任务队列 */
+		/* 将到期的定时器合并成一个任务，添加至程序的任务队列 */
+		task.func = OnTimerCalls;
+		task.arg[0] = list;
+		task.destroy_arg[0] = free;
 		LCUI_PostTask( &task );
 	}
 	LCUIMutex_Unlock( &self.mutex );
@@ -169,15 +300,7 @@ static void TimerThread( void *arg )
 
 static Timer TimerList_Find( int timer_id )
 {
-	Timer timer;
-	LinkedListNode *node;
-	for( LinkedList_Each( node, &self.timer_list ) ) {
-		timer = node->data;
-		if( timer && timer->id == timer_id ) {
-			return timer;
-		}
-	}
-	return NULL;
+	return RBTree_GetData( &self.timers, timer_id );
 }
 /*--------------------------- End Private ----------------------------*/
 
@@ -195,16 +318,18 @@ int LCUITimer_Set( long int n_ms, void (*func)(void*),
 	timer->arg = arg;
 	timer->func = func;
 	timer->reuse = reuse;
-	timer->pause_ms = 0;
 	timer->total_ms = n_ms;
 	timer->state = STATE_RUN;
 	timer->id = ++self.id_count;
-	timer->start_time = LCUI_GetTime();
-	timer->node.next = NULL;
-	timer->node.prev = NULL;
-	timer->node.data = timer;
-	TimerList_AddNode( &timer->node );
-	LCUICond_Signal( &self.sleep_cond );
+	timer->deadline = LCUI_GetTime() + n_ms;
+	timer->index = -1;
+	if( TimerHeap_Push( timer ) != 0 ) {
+		LCUIMutex_Unlock( &self.mutex );
+		free( timer );
+		return -1;
+	}
+	RBTree_Insert( &self.timers, timer->id, timer );
+	TimerThread_Notify( timer );
 	LCUIMutex_Unlock( &self.mutex );
 	DEBUG_MSG("set timer, id: %ld, total_ms: %ld\n", timer->id, timer->total_ms);
 	return timer->id;
@@ -222,9 +347,9 @@ int LCUITimer_Free( int timer_id )
 		LCUIMutex_Unlock( &self.mutex );
 		return -1;
 	}
-	LinkedList_Unlink( &self.timer_list, &timer->node );
-	free( timer );
-	LCUICond_Signal( &self.sleep_cond );
+	/* 移除堆顶的定时器后，定时器线程会多醒一次，不影响结果，所以不用唤醒它 */
+	TimerHeap_Remove( timer );
+	RBTree_Erase( &self.timers, timer_id );
 	LCUIMutex_Unlock( &self.mutex );
 	return 0;
 }
@@ -237,12 +362,12 @@ int LCUITimer_Pause( int timer_id )
 	}
 	LCUIMutex_Lock( &self.mutex );
 	timer = TimerList_Find( timer_id );
-	if( timer ) {
+	if( timer && timer->state == STATE_RUN ) {
 		/* 记录暂停时的时间 */
 		timer->pause_time = LCUI_GetTime();
 		timer->state = STATE_PAUSE;
+		TimerHeap_Remove( timer );
 	}
-	LCUICond_Signal( &self.sleep_cond );
 	LCUIMutex_Unlock( &self.mutex );
 	return timer ? 0:-1;
 }
@@ -255,12 +380,14 @@ int LCUITimer_Continue( int timer_id )
 	}
 	LCUIMutex_Lock( &self.mutex );
 	timer = TimerList_Find( timer_id );
-	if( timer ) {
-		/* 计算处于暂停状态的时长 */
-		timer->pause_ms += (long int)LCUI_GetTimeDelta( timer->pause_time );
+	if( timer && timer->state == STATE_PAUSE ) {
+		/* 将到期时间推迟处于暂停状态的时长 */
+		timer->deadline += LCUI_GetTimeDelta( timer->pause_time );
 		timer->state = STATE_RUN;
+		if( TimerHeap_Push( timer ) == 0 ) {
+			TimerThread_Notify( timer );
+		}
 	}
-	LCUICond_Signal( &self.sleep_cond );
 	LCUIMutex_Unlock( &self.mutex );
 	return timer ? 0:-1;
 }
@@ -274,11 +401,12 @@ int LCUITimer_Reset( int timer_id, long int n_ms )
 	LCUIMutex_Lock( &self.mutex );
 	timer = TimerList_Find( timer_id );
 	if( timer ) {
-		timer->pause_ms = 0;
 		timer->total_ms = n_ms;
-		timer->start_time = LCUI_GetTime();
+		timer->pause_time = LCUI_GetTime();
+		timer->deadline = timer->pause_time + n_ms;
+		TimerHeap_Update( timer );
+		TimerThread_Notify( timer );
 	}
-	LCUICond_Signal( &self.sleep_cond );
 	LCUIMutex_Unlock( &self.mutex );
 	return timer ? 0:-1;
 }
@@ -288,19 +416,27 @@ void LCUI_InitTimer( void )
 	LCUITime_Init();
 	LCUIMutex_Init( &self.mutex );
 	LCUICond_Init( &self.sleep_cond );
-	LinkedList_Init( &self.timer_list );
-	LCUIThread_Create( &self.tid, TimerThread, NULL );
+	RBTree_Init( &self.timers );
+	RBTree_OnDestroy( &self.timers, free );
+	self.heap = NULL;
+	self.heap_length = 0;
+	self.heap_capacity = 0;
 	self.is_running = TRUE;
+	LCUIThread_Create( &self.tid, TimerThread, NULL );
 }
 
 void LCUI_ExitTimer( void )
 {
-	self.is_running = FALSE;
 	LCUIMutex_Lock( &self.mutex );
+	self.is_running = FALSE;
 	LCUICond_Broadcast( &self.sleep_cond );
 	LCUIMutex_Unlock( &self.mutex );
 	LCUIThread_Join( self.tid, NULL );
-	LinkedList_ClearData( &self.timer_list, free );
+	RBTree_Destroy( &self.timers );
+	free( self.heap );
+	self.heap = NULL;
+	self.heap_length = 0;
+	self.heap_capacity = 0;
 	LCUICond_Destroy( &self.sleep_cond );
 	LCUIMutex_Destroy( &self.mutex );
 }
@@ -0,0 +1,296 @@
+/* ***************************************************************************
+ * atom.c -- Global string interning table
+ * 
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ * 
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ * 
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ * 
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *  
+ * The LCUI project is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ * 
+ * You should have received a copy of the GPLv2 along with this file. It is 
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+ 
+/* ****************************************************************************
+ * atom.c -- 全局字符串驻留表
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ * 
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ * 
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ * 
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>. 
+ * ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include <LCUI/util/atom.h>
+
+/** 每页记录的原子数量 */
+#define ATOM_PAGE_SIZE	256
+/** 最大页数，原子的数量上限为 ATOM_PAGE_SIZE * ATOM_MAX_PAGES - 1 */
+#define ATOM_MAX_PAGES	4096
+#define ATOM_NAME_LEN	256
+
+/**
+ * 字符串驻留表
+ * 原子对应的字符串分页存放，已分配的页不会移动，所以获取原子的名称时不需要
+ * 加锁，只有查找和分配原子时才需要加锁。驻留表在 LCUI_InitWidget() 和
+ * LCUI_InitCSSLibrary() 中初始化，此时还没有其它线程会用到它。
+ */
+static struct LCUI_AtomTable {
+	LCUI_BOOL is_inited;
+	LCUI_Mutex mutex;		/**< 互斥锁 */
+	Dict *atoms;			/**< 原子表，以字符串索引 */
+	LCUI_Atom count;		/**< 下一个原子 */
+	char **pages[ATOM_MAX_PAGES];	/**< 原子的名称，以原子索引 */
+} table = { 0 };
+
+void LCUI_InitAtomTable( void )
+{
+	if( table.is_inited ) {
+		return;
+	}
+	LCUIMutex_Init( &table.mutex );
+	table.atoms = Dict_Create( &DictType_StringKey, NULL );
+	/* 原子 0 保留为无效原子 */
+	table.count = 1;
+	table.is_inited = TRUE;
+}
+
+static LCUI_Atom LCUIAtom_Add( const char *name )
+{
+	char *str;
+	char **page;
+	LCUI_Atom atom = table.count;
+	unsigned int i = atom / ATOM_PAGE_SIZE;
+
+	if( i >= ATOM_MAX_PAGES ) {
+		return 0;
+	}
+	page = table.pages[i];
+	if( !page ) {
+		page = NEW( char*, ATOM_PAGE_SIZE );
+		if( !page ) {
+			return 0;
+		}
+		table.pages[i] = page;
+	}
+	str = strdup( name );
+	if( !str ) {
+		return 0;
+	}
+	page[atom % ATOM_PAGE_SIZE] = str;
+	if( Dict_Add( table.atoms, str, (void*)(size_t)atom ) != 0 ) {
+		page[atom % ATOM_PAGE_SIZE] = NULL;
+		free( str );
+		return 0;
+	}
+	table.count += 1;
+	return atom;
+}
+
+LCUI_Atom LCUIAtom_Get( const char *name )
+{
+	LCUI_Atom atom;
+	DictEntry *entry;
+	if( !name || !name[0] ) {
+		return 0;
+	}
+	if( !table.is_inited ) {
+		_DEBUG_MSG( "%s: the atom table is not initialized\n", name );
+		return 0;
+	}
+	LCUIMutex_Lock( &table.mutex );
+	entry = Dict_Find( table.atoms, name );
+	if( entry ) {
+		atom = (LCUI_Atom)(size_t)DictEntry_GetVal( entry );
+	} else {
+		atom = LCUIAtom_Add( name );
+	}
+	LCUIMutex_Unlock( &table.mutex );
+	/* 名称被悄悄丢掉的话，选择器会匹配错部件，所以要报告出来 */
+	if( !atom ) {
+		_DEBUG_MSG( "%s: cannot allocate an atom, the atom table "
+			    "is full or out of memory\n", name );
+	}
+	return atom;
+}
+
+LCUI_Atom LCUIAtom_Find( const char *name )
+{
+	LCUI_Atom atom = 0;
+	DictEntry *entry;
+	if( !name || !table.is_inited ) {
+		return 0;
+	}
+	LCUIMutex_Lock( &table.mutex );
+	entry = Dict_Find( table.atoms, name );
+	if( entry ) {
+		atom = (LCUI_Atom)(size_t)DictEntry_GetVal( entry );
+	}
+	LCUIMutex_Unlock( &table.mutex );
+	return atom;
+}
+
+const char *LCUIAtom_GetName( LCUI_Atom atom )
+{
+	char **page;
+	unsigned int i = atom / ATOM_PAGE_SIZE;
+	if( atom == 0 || i >= ATOM_MAX_PAGES ) {
+		return NULL;
+	}
+	page = table.pages[i];
+	if( !page ) {
+		return NULL;
+	}
+	return page[atom % ATOM_PAGE_SIZE];
+}
+
+int AtomList_Length( const LCUI_Atom *list )
+{
+	int i = 0;
+	if( list ) {
+		for( ; list[i]; ++i );
+	}
+	return i;
+}
+
+LCUI_Atom *AtomList_Duplicate( const LCUI_Atom *list )
+{
+	int n;
+	LCUI_Atom *newlist;
+	if( !list ) {
+		return NULL;
+	}
+	n = AtomList_Length( list ) + 1;
+	newlist = malloc( sizeof( LCUI_Atom ) * n );
+	if( newlist ) {
+		memcpy( newlist, list, sizeof( LCUI_Atom ) * n );
+	}
+	return newlist;
+}
+
+int AtomList_Add( LCUI_Atom **list, LCUI_Atom atom )
+{
+	int i, pos, n;
+	LCUI_Atom *newlist;
+	if( atom == 0 ) {
+		return 0;
+	}
+	n = AtomList_Length( *list );
+	for( pos = 0; pos < n; ++pos ) {
+		if( (*list)[pos] == atom ) {
+			return 0;
+		}
+		if( (*list)[pos] > atom ) {
+			break;
+		}
+	}
+	newlist = realloc( *list, sizeof( LCUI_Atom ) * (n + 2) );
+	if( !newlist ) {
+		return 0;
+	}
+	for( i = n + 1; i > pos; --i ) {
+		newlist[i] = newlist[i - 1];
+	}
+	newlist[pos] = atom;
+	newlist[n + 1] = 0;
+	*list = newlist;
+	return 1;
+}
+
+LCUI_BOOL AtomList_Has( const LCUI_Atom *list, LCUI_Atom atom )
+{
+	if( !list || atom == 0 ) {
+		return FALSE;
+	}
+	for( ; *list && *list <= atom; ++list ) {
+		if( *list == atom ) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+int AtomList_Delete( LCUI_Atom **list, LCUI_Atom atom )
+{
+	int i;
+	LCUI_Atom *p = *list;
+	if( !p || atom == 0 ) {
+		return 0;
+	}
+	for( i = 0; p[i] && p[i] != atom; ++i );
+	if( !p[i] ) {
+		return 0;
+	}
+	for( ; p[i]; ++i ) {
+		p[i] = p[i + 1];
+	}
+	if( !p[0] ) {
+		free( p );
+		*list = NULL;
+	}
+	return 1;
+}
+
+/** 将名称列表拆分成单个名称，并逐个转换成原子 */
+static int AtomList_EachName( LCUI_Atom **list, const char *names,
+			      LCUI_BOOL add )
+{
+	LCUI_Atom atom;
+	const char *p, *head;
+	char name[ATOM_NAME_LEN];
+	int len, count = 0;
+
+	for( head = p = names; ; ++p ) {
+		if( *p && *p != ' ' ) {
+			continue;
+		}
+		len = p - head;
+		if( len > 0 && len < ATOM_NAME_LEN ) {
+			strncpy( name, head, len );
+			name[len] = 0;
+			if( add ) {
+				atom = LCUIAtom_Get( name );
+				count += AtomList_Add( list, atom );
+			} else {
+				atom = LCUIAtom_Find( name );
+				count += AtomList_Delete( list, atom );
+			}
+		}
+		if( !*p ) {
+			break;
+		}
+		head = p + 1;
+	}
+	return count;
+}
+
+int AtomList_AddNames( LCUI_Atom **list, const char *names )
+{
+	return AtomList_EachName( list, names, TRUE );
+}
+
+int AtomList_DeleteNames( LCUI_Atom **list, const char *names )
+{
+	return AtomList_EachName( list, names, FALSE );
+}
@@ -43,42 +43,60 @@
 #include <LCUI/LCUI.h>
 #include <LCUI/util/parse.h>
 
+/**
+ * 直接在字符串上扫描出一个数值，不需要复制到临时缓存中
+ * @param[out] has_point 数值中是否有小数点
+ * @returns 数值后面的字符的位置，如果没有数值则返回 NULL
+ */
+static const char *ScanNumber( const char *p, double *num,
+			       LCUI_BOOL *has_point )
+{
+	int digits = 0;
+	double sign = 1.0, scale = 1.0;
+
+	*num = 0;
+	*has_point = FALSE;
+	if( *p == '-' || *p == '+' ) {
+		sign = *p == '-' ? -1.0 : 1.0;
+		++p;
+	}
+	for( ; *p >= '0' && *p <= '9'; ++p, ++digits ) {
+		*num = *num * 10.0 + (*p - '0');
+	}
+	if( *p == '.' ) {
+		*has_point = TRUE;
+		for( ++p; *p >= '0' && *p <= '9'; ++p, ++digits ) {
+			scale /= 10.0;
+			*num += (*p - '0') * scale;
+		}
+	}
+	if( digits == 0 ) {
+		return NULL;
+	}
+	*num *= sign;
+	return p;
+}
+
 /** 从字符串中解析出数值，包括px、%、dp等单位 */
 LCUI_BOOL ParseNumber( LCUI_Style s, const char *str )
 {
-	int n = 0;
-	char num_str[32];
-	const char *p = str;
-	LCUI_BOOL has_sign = FALSE, has_point = FALSE;
+	double num;
+	const char *p;
+	LCUI_BOOL has_point;
 
 	if( str == NULL ) {
 		return FALSE;
 	}
-	/* 先取出数值 */
-	while( 1 ) {
-		if( *p >= '0' && *p <= '9' );
-		else if( !has_sign && (*p == '-' || *p == '+') ) {
-			has_sign = TRUE;
-		} else if( !has_point && *p == '.' ) {
-			has_point = TRUE;
-		} else {
-			break;
-		}
-		if( n < 30 ) {
-			num_str[n++] = *p;
-		}
-		++p;
-	}
-	if( n == 0 ) {
+	p = ScanNumber( str, &num, &has_point );
+	if( !p ) {
 		return FALSE;
 	}
-	num_str[n] = 0;
 	switch( *p ) {
 	case 'd':
 	case 'D':
 		if( p[1] == 'p' || p[1] == 'P' ) {
 			s->type = SVT_DP;
-			sscanf( num_str, "%f", &s->dp );
+			s->dp = (float)num;
 		} else {
 			s->type = SVT_NONE;
 		}
@@ -87,30 +105,27 @@ LCUI_BOOL ParseNumber( LCUI_Style s, const char *str )
 	case 'p':
 		if( p[1] == 'x' || p[1] == 'X' ) {
 			s->type = SVT_PX;
-			sscanf( num_str, "%f", &s->px );
+			s->px = (float)num;
 		} else if( p[1] == 't' || p[1] == 'T' ) {
 			s->type = SVT_PT;
-			sscanf( num_str, "%f", &s->pt );
+			s->pt = (float)num;
 		} else {
 			s->type = SVT_NONE;
 		}
 		break;
 	case '%':
-		if( 1 != sscanf( num_str, "%f", &s->scale ) ) {
-			return FALSE;
-		}
-		s->scale /= 100.0;
+		s->scale = (float)(num / 100.0);
 		s->type = SVT_SCALE;
 		break;
 	case 0:
-		if( has_point && 1 == sscanf( num_str, "%f", &s->scale ) ) {
+		if( has_point ) {
+			s->scale = (float)num;
 			s->type = SVT_SCALE;
-			break;
-		}
-		if( 1 == sscanf( num_str, "%d", &s->value ) ) {
+		} else {
+			s->value = (int)num;
 			s->type = SVT_VALUE;
-			break;
 		}
+		break;
 	default:
 		s->type = SVT_NONE;
 		s->is_valid = FALSE;
@@ -120,74 +135,123 @@ LCUI_BOOL ParseNumber( LCUI_Style s, const char *str )
 	return TRUE;
 }
 
-/** 从字符串中解析出色彩值，支持格式：#fff、#ffffff, rgba(R,G,B,A)、rgb(R,G,B) */
-LCUI_BOOL ParseColor( LCUI_Style var, const char *str )
+static int ParseHexDigit( char ch )
 {
-	double a;
-	const char *p;
-	int len = 0, status = 0, r, g, b;
-	for( p=str; *p; ++p, ++len ) {
-		switch( *p ) {
-		case '#':
-			len == 0 ? status = 3 : 0;
-			break;
-		case 'r':
-			status == 0 ? status = 1 : 0;
-			break;
-		case 'g':
-			status == 1 ? status <<= 1 : 0;
-			break;
-		case 'b':
-			status == 2 ? status <<= 1 : 0;
-			break;
-		case 'a':
-			status == 4 ? status <<= 1 : 0;
-			break;
-		default:
-			if( status < 3 ) {
-				break;
-			}
+	if( ch >= '0' && ch <= '9' ) {
+		return ch - '0';
+	}
+	if( ch >= 'a' && ch <= 'f' ) {
+		return ch - 'a' + 10;
+	}
+	if( ch >= 'A' && ch <= 'F' ) {
+		return ch - 'A' + 10;
+	}
+	return -1;
+}
+
+/** 解析 #fff 和 #ffffff 格式的色彩值 */
+static LCUI_BOOL ParseHexColor( LCUI_Color *color, const char *str )
+{
+	int i, n, digits[6];
+
+	for( n = 0; str[n]; ++n ) {
+		if( n >= 6 ) {
+			return FALSE;
+		}
+		digits[n] = ParseHexDigit( str[n] );
+		if( digits[n] < 0 ) {
+			return FALSE;
 		}
 	}
-	switch( status ) {
-	case 3:
-		status = 0;
-		if( len == 4 ) {
-			status = sscanf( str, "#%1X%1X%1X", &r, &g, &b );
-			r *= 255/0xf; g *= 255/0xf; b *= 255/0xf;
-		} else if( len == 7 ) {
-			status = sscanf( str, "#%2X%2X%2X", &r, &g, &b );
+	if( n == 3 ) {
+		for( i = 2; i >= 0; --i ) {
+			digits[i * 2] = digits[i * 2 + 1] = digits[i];
 		}
-		break;
-	case 4:
-		status = sscanf( str, "rgb(%d,%d,%d)", &r, &g, &b );
-		break;
-	case 8:
-		status = sscanf( str, "rgba(%d,%d,%d,%lf)", &r, &g, &b, &a );
-	default:break;
+	} else if( n != 6 ) {
+		return FALSE;
 	}
-	if( status >= 3 ) {
-		var->type = SVT_COLOR;
-		if( status == 4 ) {
-			var->color.a = (uchar_t)(255.0*a);
-		} else {
-			var->color.a = 255;
+	color->r = (uchar_t)(digits[0] * 16 + digits[1]);
+	color->g = (uchar_t)(digits[2] * 16 + digits[3]);
+	color->b = (uchar_t)(digits[4] * 16 + digits[5]);
+	color->a = 255;
+	return TRUE;
+}
+
+/** 将数值限制在 0 到 max 之间，超出范围的浮点数不能直接转换成 uchar_t */
+static double ClampColorValue( double value, double max )
+{
+	if( value > max ) {
+		return max;
+	}
+	return value > 0 ? value : 0;
+}
+
+/**
+ * 解析 rgb(R,G,B) 和 rgba(R,G,B,A) 格式的色彩值
+ * 超出范围的色彩分量会被限制在 0 到 255 之间，透明度会被限制在 0 到 1 之间
+ */
+static LCUI_BOOL ParseRGBColor( LCUI_Color *color, const char *str )
+{
+	int i, n = 3;
+	double values[4];
+	LCUI_BOOL has_point;
+	const char *p = str + 3;
+
+	if( *p == 'a' ) {
+		n = 4;
+		++p;
+	}
+	if( *p != '(' ) {
+		return FALSE;
+	}
+	for( i = 0; i < n; ++i ) {
+		for( ++p; *p == ' ' || *p == '\t'; ++p );
+		p = ScanNumber( p, &values[i], &has_point );
+		if( !p ) {
+			return FALSE;
 		}
-		var->color.r = r;
-		var->color.g = g;
-		var->color.b = b;
-		var->is_valid = TRUE;
-		return TRUE;
-	} else {
-		if( strcmp("transparent", str) == 0 ) {
-			var->is_valid = TRUE;
-			var->color.alpha = 0;
-			var->color.red = 255;
-			var->color.green = 255;
-			var->color.blue = 255;
-			var->type = SVT_COLOR;
-			return TRUE;
+		for( ; *p == ' ' || *p == '\t'; ++p );
+		if( i < n - 1 && *p != ',' ) {
+			return FALSE;
 		}
 	}
-	return FALSE;
+	if( *p != ')' ) {
+		return FALSE;
+	}
+	for( ++p; *p == ' ' || *p == '\t'; ++p );
+	if( *p ) {
+		return FALSE;
+	}
+	color->r = (uchar_t)ClampColorValue( values[0], 255.0 );
+	color->g = (uchar_t)ClampColorValue( values[1], 255.0 );
+	color->b = (uchar_t)ClampColorValue( values[2], 255.0 );
+	if( n == 4 ) {
+		color->a = (uchar_t)(255.0 * ClampColorValue( values[3], 1.0 ));
+	} else {
+		color->a = 255;
+	}
+	return TRUE;
+}
+
+/** 从字符串中解析出色彩值，支持格式：#fff、#ffffff, rgba(R,G,B,A)、rgb(R,G,B) */
+LCUI_BOOL ParseColor( LCUI_Style var, const char *str )
+{
+	LCUI_BOOL ok = FALSE;
+
+	if( str[0] == '#' ) {
+		ok = ParseHexColor( &var->color, str + 1 );
+	} else if( strncmp( str, "rgb", 3 ) == 0 ) {
+		ok = ParseRGBColor( &var->color, str );
+	} else if( strcmp( str, "transparent" ) == 0 ) {
+		var->color.alpha = 0;
+		var->color.red = 255;
+		var->color.green = 255;
+		var->color.blue = 255;
+		ok = TRUE;
+	}
+	if( ok ) {
+		var->type = SVT_COLOR;
+		var->is_valid = TRUE;
+	}
+	return ok;
 }
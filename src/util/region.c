@@ -0,0 +1,695 @@
+/* ***************************************************************************
+ * region.c -- Banded region, a set of non-overlapping rectangles
+ *
+ * Copyright (C) 2012-2014 by
+ * Liu Chao
+ *
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ *
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ *
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *
+ * The LCUI project is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ *
+ * You should have received a copy of the GPLv2 along with this file. It is
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/* ****************************************************************************
+ * region.c -- 带状区域，由互不重叠的矩形组成的区域集合
+ *
+ * 版权所有 (C) 2012-2014 归属于
+ * 刘超
+ *
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ *
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ *
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+
+#define RectRight(R) ((R)->x + (R)->width)
+#define RectBottom(R) ((R)->y + (R)->height)
+
+enum RegionOpType {
+	REGION_OP_UNION,
+	REGION_OP_SUBTRACT,
+	REGION_OP_INTERSECT
+};
+
+/** 区域运算结果的写入器，运算结果写入到区域的缓存中 */
+typedef struct RegionWriterRec_ {
+	LCUI_Region region;	/**< 目标区域 */
+	int length;		/**< 已写入的矩形数量 */
+	int band;		/**< 上一个行带的起始位置，-1 表示没有 */
+	int error;		/**< 错误码 */
+} RegionWriterRec, *RegionWriter;
+
+static int ReserveRects( LCUI_Rect **rects, int *capacity, int n )
+{
+	int new_capacity;
+	LCUI_Rect *new_rects;
+	if( n <= *capacity ) {
+		return 0;
+	}
+	new_capacity = *capacity > 0 ? *capacity : 16;
+	while( new_capacity < n ) {
+		new_capacity *= 2;
+	}
+	new_rects = realloc( *rects, new_capacity * sizeof( LCUI_Rect ) );
+	if( !new_rects ) {
+		return -ENOMEM;
+	}
+	*rects = new_rects;
+	*capacity = new_capacity;
+	return 0;
+}
+
+static LCUI_BOOL RectIncludes( const LCUI_Rect *a, const LCUI_Rect *b )
+{
+	return b->x >= a->x && RectRight( b ) <= RectRight( a ) &&
+		b->y >= a->y && RectBottom( b ) <= RectBottom( a );
+}
+
+static LCUI_BOOL RectOverlaps( const LCUI_Rect *a, const LCUI_Rect *b )
+{
+	return a->x < RectRight( b ) && b->x < RectRight( a ) &&
+		a->y < RectBottom( b ) && b->y < RectBottom( a );
+}
+
+/** 获取从 i 开始的行带的结束位置 */
+static int GetBandEnd( const LCUI_Rect *rects, int n, int i )
+{
+	int end;
+	for( end = i + 1; end < n && rects[end].y == rects[i].y; ++end );
+	return end;
+}
+
+static void Region_UpdateExtents( LCUI_Region region )
+{
+	int i, x1, x2;
+	LCUI_Rect *last;
+	if( region->length == 0 ) {
+		region->extents.x = region->extents.y = 0;
+		region->extents.width = region->extents.height = 0;
+		return;
+	}
+	x1 = region->rects[0].x;
+	x2 = RectRight( &region->rects[0] );
+	for( i = 1; i < region->length; ++i ) {
+		if( region->rects[i].x < x1 ) {
+			x1 = region->rects[i].x;
+		}
+		if( RectRight( &region->rects[i] ) > x2 ) {
+			x2 = RectRight( &region->rects[i] );
+		}
+	}
+	last = &region->rects[region->length - 1];
+	region->extents.x = x1;
+	region->extents.y = region->rects[0].y;
+	region->extents.width = x2 - x1;
+	region->extents.height = RectBottom( last ) - region->extents.y;
+}
+
+static void RegionWriter_Push( RegionWriter w, int x1, int x2, int y1, int y2 )
+{
+	LCUI_Rect *rect;
+	LCUI_Region region = w->region;
+	if( w->error ) {
+		return;
+	}
+	w->error = ReserveRects( &region->buffer, &region->buffer_capacity,
+				 w->length + 1 );
+	if( w->error ) {
+		return;
+	}
+	rect = &region->buffer[w->length++];
+	rect->x = x1;
+	rect->y = y1;
+	rect->width = x2 - x1;
+	rect->height = y2 - y1;
+}
+
+/** 结束当前行带，如果它与上一个行带相邻且横向分布相同，则合并它们 */
+static void RegionWriter_EndBand( RegionWriter w, int start )
+{
+	int i, n;
+	LCUI_Rect *prev, *cur;
+	if( w->length == start ) {
+		return;
+	}
+	n = w->length - start;
+	if( w->band < 0 || start - w->band != n ) {
+		w->band = start;
+		return;
+	}
+	prev = &w->region->buffer[w->band];
+	cur = &w->region->buffer[start];
+	if( RectBottom( prev ) != cur->y ) {
+		w->band = start;
+		return;
+	}
+	for( i = 0; i < n; ++i ) {
+		if( prev[i].x != cur[i].x || prev[i].width != cur[i].width ) {
+			w->band = start;
+			return;
+		}
+	}
+	for( i = 0; i < n; ++i ) {
+		prev[i].height += cur[0].height;
+	}
+	w->length = start;
+}
+
+static void RegionWriter_UnionSpans( RegionWriter w,
+				     const LCUI_Rect *a, int na,
+				     const LCUI_Rect *b, int nb,
+				     int y1, int y2 )
+{
+	int i = 0, j = 0, x1 = 0, x2 = 0;
+	LCUI_BOOL has_span = FALSE;
+	const LCUI_Rect *r;
+	while( i < na || j < nb ) {
+		if( j >= nb || (i < na && a[i].x <= b[j].x) ) {
+			r = &a[i++];
+		} else {
+			r = &b[j++];
+		}
+		if( has_span && r->x <= x2 ) {
+			if( RectRight( r ) > x2 ) {
+				x2 = RectRight( r );
+			}
+			continue;
+		}
+		if( has_span ) {
+			RegionWriter_Push( w, x1, x2, y1, y2 );
+		}
+		x1 = r->x;
+		x2 = RectRight( r );
+		has_span = TRUE;
+	}
+	if( has_span ) {
+		RegionWriter_Push( w, x1, x2, y1, y2 );
+	}
+}
+
+static void RegionWriter_SubtractSpans( RegionWriter w,
+					const LCUI_Rect *a, int na,
+					const LCUI_Rect *b, int nb,
+					int y1, int y2 )
+{
+	int i, j = 0, x1, x2;
+	for( i = 0; i < na; ++i ) {
+		x1 = a[i].x;
+		x2 = RectRight( &a[i] );
+		while( j < nb && RectRight( &b[j] ) <= x1 ) {
+			++j;
+		}
+		while( j < nb && b[j].x < x2 ) {
+			if( b[j].x > x1 ) {
+				RegionWriter_Push( w, x1, b[j].x, y1, y2 );
+			}
+			if( RectRight( &b[j] ) > x1 ) {
+				x1 = RectRight( &b[j] );
+			}
+			/* 超出当前区间的部分可能还会覆盖下一个区间 */
+			if( RectRight( &b[j] ) >= x2 ) {
+				break;
+			}
+			++j;
+		}
+		if( x1 < x2 ) {
+			RegionWriter_Push( w, x1, x2, y1, y2 );
+		}
+	}
+}
+
+static void RegionWriter_IntersectSpans( RegionWriter w,
+					 const LCUI_Rect *a, int na,
+					 const LCUI_Rect *b, int nb,
+					 int y1, int y2 )
+{
+	int i = 0, j = 0, x1, x2;
+	while( i < na && j < nb ) {
+		x1 = a[i].x > b[j].x ? a[i].x : b[j].x;
+		x2 = RectRight( &a[i] );
+		if( RectRight( &b[j] ) < x2 ) {
+			x2 = RectRight( &b[j] );
+		}
+		if( x1 < x2 ) {
+			RegionWriter_Push( w, x1, x2, y1, y2 );
+		}
+		if( RectRight( &a[i] ) < RectRight( &b[j] ) ) {
+			++i;
+		} else {
+			++j;
+		}
+	}
+}
+
+/**
+ * 对两组按行带排列的矩形进行运算，结果写入区域的缓存中
+ * 自上而下扫描两者的行带边界，在每一段水平条带内对横向区间进行运算。
+ * @returns 结果中的矩形数量，出错时返回负数
+ */
+static int Region_Op( LCUI_Region region, const LCUI_Rect *a, int na,
+		      const LCUI_Rect *b, int nb, int op )
+{
+	int i = 0, j = 0, a_end = 0, b_end = 0, y, y2, start, tmp;
+	LCUI_BOOL a_active, b_active;
+	RegionWriterRec w;
+
+	w.region = region;
+	w.length = 0;
+	w.band = -1;
+	w.error = 0;
+	y = INT_MAX;
+	if( na > 0 ) {
+		y = a[0].y;
+		a_end = GetBandEnd( a, na, 0 );
+	}
+	if( nb > 0 ) {
+		b_end = GetBandEnd( b, nb, 0 );
+		if( b[0].y < y ) {
+			y = b[0].y;
+		}
+	}
+	while( i < na || j < nb ) {
+		if( op != REGION_OP_UNION && i >= na ) {
+			break;
+		}
+		if( op == REGION_OP_INTERSECT && j >= nb ) {
+			break;
+		}
+		y2 = INT_MAX;
+		a_active = b_active = FALSE;
+		if( i < na ) {
+			if( a[i].y > y ) {
+				y2 = a[i].y;
+			} else {
+				a_active = TRUE;
+				y2 = RectBottom( &a[i] );
+			}
+		}
+		if( j < nb ) {
+			if( b[j].y > y ) {
+				tmp = b[j].y;
+			} else {
+				b_active = TRUE;
+				tmp = RectBottom( &b[j] );
+			}
+			if( tmp < y2 ) {
+				y2 = tmp;
+			}
+		}
+		start = w.length;
+		switch( op ) {
+		case REGION_OP_UNION:
+			RegionWriter_UnionSpans( &w, a + i, a_active ? a_end - i : 0,
+						 b + j, b_active ? b_end - j : 0,
+						 y, y2 );
+			break;
+		case REGION_OP_SUBTRACT:
+			RegionWriter_SubtractSpans( &w, a + i,
+						    a_active ? a_end - i : 0,
+						    b + j,
+						    b_active ? b_end - j : 0,
+						    y, y2 );
+			break;
+		case REGION_OP_INTERSECT:
+		default:
+			if( a_active && b_active ) {
+				RegionWriter_IntersectSpans( &w, a + i, a_end - i,
+							     b + j, b_end - j,
+							     y, y2 );
+			}
+			break;
+		}
+		RegionWriter_EndBand( &w, start );
+		if( a_active && RectBottom( &a[i] ) == y2 ) {
+			i = a_end;
+			if( i < na ) {
+				a_end = GetBandEnd( a, na, i );
+			}
+		}
+		if( b_active && RectBottom( &b[j] ) == y2 ) {
+			j = b_end;
+			if( j < nb ) {
+				b_end = GetBandEnd( b, nb, j );
+			}
+		}
+		y = y2;
+	}
+	if( w.error ) {
+		return w.error;
+	}
+	return w.length;
+}
+
+/** 用另一组矩形与整个区域进行运算 */
+static int Region_OpAll( LCUI_Region region, const LCUI_Rect *b, int nb,
+			 int op )
+{
+	int n, capacity;
+	LCUI_Rect *rects;
+
+	n = Region_Op( region, region->rects, region->length, b, nb, op );
+	if( n < 0 ) {
+		return n;
+	}
+	rects = region->rects;
+	region->rects = region->buffer;
+	region->buffer = rects;
+	capacity = region->capacity;
+	region->capacity = region->buffer_capacity;
+	region->buffer_capacity = capacity;
+	region->length = n;
+	Region_UpdateExtents( region );
+	return 0;
+}
+
+/** 查找第一个底边在 y 之下的矩形 */
+static int Region_FindBand( LCUI_Region region, int y )
+{
+	int low = 0, high = region->length, mid;
+	while( low < high ) {
+		mid = (low + high) / 2;
+		if( RectBottom( &region->rects[mid] ) > y ) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+	/* 回到行带的起始位置 */
+	while( low > 0 && low < region->length &&
+	       region->rects[low - 1].y == region->rects[low].y ) {
+		--low;
+	}
+	return low;
+}
+
+/**
+ * 用矩形与区域进行并集或差集运算
+ * 只有与矩形在纵向上重叠的行带会受影响，所以只对这些行带及其上下相邻的行带
+ * （用于合并行带）进行运算，然后将结果替换回原位置，不必处理整个区域。
+ */
+static int Region_OpRect( LCUI_Region region, const LCUI_Rect *rect, int op )
+{
+	int start, end, n, length;
+
+	start = Region_FindBand( region, rect->y );
+	if( start > 0 ) {
+		start = Region_FindBand( region, region->rects[start - 1].y );
+	}
+	for( end = start; end < region->length; ++end ) {
+		if( region->rects[end].y >= RectBottom( rect ) ) {
+			end = GetBandEnd( region->rects, region->length, end );
+			break;
+		}
+	}
+	n = Region_Op( region, region->rects + start, end - start,
+		       rect, 1, op );
+	if( n < 0 ) {
+		return n;
+	}
+	length = region->length - (end - start) + n;
+	if( ReserveRects( &region->rects, &region->capacity, length ) != 0 ) {
+		return -ENOMEM;
+	}
+	memmove( region->rects + start + n, region->rects + end,
+		 (region->length - end) * sizeof( LCUI_Rect ) );
+	memcpy( region->rects + start, region->buffer, n * sizeof( LCUI_Rect ) );
+	region->length = length;
+	return 0;
+}
+
+static int Region_SetRect( LCUI_Region region, const LCUI_Rect *rect )
+{
+	int ret;
+	ret = ReserveRects( &region->rects, &region->capacity, 1 );
+	if( ret != 0 ) {
+		return ret;
+	}
+	region->rects[0] = *rect;
+	region->length = 1;
+	region->extents = *rect;
+	return 0;
+}
+
+/** 将矩形追加到区域的底部，矩形的顶边不能高于区域的底边 */
+static int Region_AppendRect( LCUI_Region region, const LCUI_Rect *rect )
+{
+	int ret, x1, x2;
+	LCUI_Rect *last;
+	last = &region->rects[region->length - 1];
+	if( RectBottom( last ) == rect->y && last->x == rect->x &&
+	    last->width == rect->width &&
+	    (region->length == 1 || last[-1].y != last->y) ) {
+		last->height += rect->height;
+		region->extents.height += rect->height;
+		return 0;
+	}
+	ret = ReserveRects( &region->rects, &region->capacity,
+			    region->length + 1 );
+	if( ret != 0 ) {
+		return ret;
+	}
+	region->rects[region->length++] = *rect;
+	x1 = region->extents.x < rect->x ? region->extents.x : rect->x;
+	x2 = RectRight( &region->extents );
+	if( RectRight( rect ) > x2 ) {
+		x2 = RectRight( rect );
+	}
+	region->extents.x = x1;
+	region->extents.width = x2 - x1;
+	region->extents.height = RectBottom( rect ) - region->extents.y;
+	return 0;
+}
+
+void Region_Init( LCUI_Region region )
+{
+	region->rects = NULL;
+	region->buffer = NULL;
+	region->length = 0;
+	region->capacity = 0;
+	region->buffer_capacity = 0;
+	region->extents.x = region->extents.y = 0;
+	region->extents.width = region->extents.height = 0;
+}
+
+void Region_Clear( LCUI_Region region )
+{
+	region->length = 0;
+	region->extents.x = region->extents.y = 0;
+	region->extents.width = region->extents.height = 0;
+}
+
+void Region_Free( LCUI_Region region )
+{
+	if( region->rects ) {
+		free( region->rects );
+	}
+	if( region->buffer ) {
+		free( region->buffer );
+	}
+	Region_Init( region );
+}
+
+int Region_Copy( LCUI_Region dst, LCUI_Region src )
+{
+	int ret;
+	if( dst == src ) {
+		return 0;
+	}
+	ret = ReserveRects( &dst->rects, &dst->capacity, src->length );
+	if( ret != 0 ) {
+		return ret;
+	}
+	if( src->length > 0 ) {
+		memcpy( dst->rects, src->rects,
+			src->length * sizeof( LCUI_Rect ) );
+	}
+	dst->length = src->length;
+	dst->extents = src->extents;
+	return 0;
+}
+
+void Region_Translate( LCUI_Region region, int dx, int dy )
+{
+	int i;
+	for( i = 0; i < region->length; ++i ) {
+		region->rects[i].x += dx;
+		region->rects[i].y += dy;
+	}
+	if( region->length > 0 ) {
+		region->extents.x += dx;
+		region->extents.y += dy;
+	}
+}
+
+LCUI_BOOL Region_ContainsRect( LCUI_Region region, const LCUI_Rect *rect )
+{
+	int i, end, y;
+	if( rect->width <= 0 || rect->height <= 0 ) {
+		return TRUE;
+	}
+	if( region->length == 0 || !RectIncludes( &region->extents, rect ) ) {
+		return FALSE;
+	}
+	y = rect->y;
+	i = Region_FindBand( region, y );
+	while( i < region->length ) {
+		/* 行带之间有空隙 */
+		if( region->rects[i].y > y ) {
+			return FALSE;
+		}
+		end = GetBandEnd( region->rects, region->length, i );
+		for( ; i < end; ++i ) {
+			if( region->rects[i].x <= rect->x &&
+			    RectRight( &region->rects[i] ) >= RectRight( rect ) ) {
+				break;
+			}
+		}
+		if( i >= end ) {
+			return FALSE;
+		}
+		y = RectBottom( &region->rects[i] );
+		if( y >= RectBottom( rect ) ) {
+			return TRUE;
+		}
+		i = end;
+	}
+	return FALSE;
+}
+
+int Region_UnionRect( LCUI_Region region, const LCUI_Rect *rect )
+{
+	int ret;
+	LCUI_Rect extents;
+
+	if( rect->width <= 0 || rect->height <= 0 ) {
+		return 0;
+	}
+	if( region->length == 0 || RectIncludes( rect, &region->extents ) ) {
+		return Region_SetRect( region, rect );
+	}
+	if( rect->y >= RectBottom( &region->extents ) ) {
+		return Region_AppendRect( region, rect );
+	}
+	if( Region_ContainsRect( region, rect ) ) {
+		return 0;
+	}
+	ret = Region_OpRect( region, rect, REGION_OP_UNION );
+	if( ret != 0 ) {
+		return ret;
+	}
+	/* 并集的外接矩形可以直接算出来，不必遍历所有矩形 */
+	extents = region->extents;
+	LCUIRect_MergeRect( &region->extents, &extents, (LCUI_Rect*)rect );
+	return 0;
+}
+
+int Region_SubtractRect( LCUI_Region region, const LCUI_Rect *rect )
+{
+	int ret;
+
+	if( rect->width <= 0 || rect->height <= 0 || region->length == 0 ||
+	    !RectOverlaps( rect, &region->extents ) ) {
+		return 0;
+	}
+	if( RectIncludes( rect, &region->extents ) ) {
+		Region_Clear( region );
+		return 0;
+	}
+	ret = Region_OpRect( region, rect, REGION_OP_SUBTRACT );
+	if( ret != 0 ) {
+		return ret;
+	}
+	/* 只有减去的矩形碰到外接矩形的边时，外接矩形才可能缩小 */
+	if( rect->x <= region->extents.x || rect->y <= region->extents.y ||
+	    RectRight( rect ) >= RectRight( &region->extents ) ||
+	    RectBottom( rect ) >= RectBottom( &region->extents ) ) {
+		Region_UpdateExtents( region );
+	}
+	return 0;
+}
+
+int Region_IntersectRect( LCUI_Region region, const LCUI_Rect *rect )
+{
+	if( region->length == 0 ) {
+		return 0;
+	}
+	if( rect->width <= 0 || rect->height <= 0 ||
+	    !RectOverlaps( rect, &region->extents ) ) {
+		Region_Clear( region );
+		return 0;
+	}
+	if( RectIncludes( rect, &region->extents ) ) {
+		return 0;
+	}
+	return Region_OpAll( region, rect, 1, REGION_OP_INTERSECT );
+}
+
+int Region_Union( LCUI_Region region, LCUI_Region other )
+{
+	if( other->length == 0 || region == other ) {
+		return 0;
+	}
+	if( region->length == 0 ) {
+		return Region_Copy( region, other );
+	}
+	if( other->length == 1 ) {
+		return Region_UnionRect( region, &other->rects[0] );
+	}
+	return Region_OpAll( region, other->rects, other->length,
+			     REGION_OP_UNION );
+}
+
+int Region_Subtract( LCUI_Region region, LCUI_Region other )
+{
+	if( region == other ) {
+		Region_Clear( region );
+		return 0;
+	}
+	if( region->length == 0 || other->length == 0 ||
+	    !RectOverlaps( &region->extents, &other->extents ) ) {
+		return 0;
+	}
+	return Region_OpAll( region, other->rects, other->length,
+			     REGION_OP_SUBTRACT );
+}
+
+int Region_Intersect( LCUI_Region region, LCUI_Region other )
+{
+	if( region == other ) {
+		return 0;
+	}
+	if( other->length == 0 ||
+	    !RectOverlaps( &region->extents, &other->extents ) ) {
+		Region_Clear( region );
+		return 0;
+	}
+	if( region->length == 0 ) {
+		return 0;
+	}
+	return Region_OpAll( region, other->rects, other->length,
+			     REGION_OP_INTERSECT );
+}
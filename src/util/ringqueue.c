@@ -0,0 +1,157 @@
+/* ***************************************************************************
+ * ringqueue.c -- Bounded lock-free ring queue for passing data between threads
+ * 
+ * Copyright (C) 2017 by Liu Chao <lc-soft@live.cn>
+ * 
+ * This file is part of the LCUI project, and may only be used, modified, and
+ * distributed under the terms of the GPLv2.
+ * 
+ * (GPLv2 is abbreviation of GNU General Public License Version 2)
+ * 
+ * By continuing to use, modify, or distribute this file you indicate that you
+ * have read the license and understand and accept it fully.
+ *  
+ * The LCUI project is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GPL v2 for more details.
+ * 
+ * You should have received a copy of the GPLv2 along with this file. It is 
+ * usually in the LICENSE.TXT file, If not, see <http://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+ 
+/* ****************************************************************************
+ * ringqueue.c -- 容量固定的无锁环形队列，用于在线程间传递数据
+ *
+ * 版权所有 (C) 2017 归属于 刘超 <lc-soft@live.cn>
+ * 
+ * 这个文件是LCUI项目的一部分，并且只可以根据GPLv2许可协议来使用、更改和发布。
+ *
+ * (GPLv2 是 GNU通用公共许可证第二版 的英文缩写)
+ * 
+ * 继续使用、修改或发布本文件，表明您已经阅读并完全理解和接受这个许可协议。
+ * 
+ * LCUI 项目是基于使用目的而加以散布的，但不负任何担保责任，甚至没有适销性或特
+ * 定用途的隐含担保，详情请参照GPLv2许可协议。
+ *
+ * 您应已收到附随于本文件的GPLv2许可协议的副本，它通常在LICENSE.TXT文件中，如果
+ * 没有，请查看：<http://www.gnu.org/licenses/>. 
+ * ****************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#define AtomicCompareAndSwap(PTR, OLD, NEW) \
+	(InterlockedCompareExchange( (LONG volatile*)(PTR), \
+				     (LONG)(NEW), (LONG)(OLD) ) == (LONG)(OLD))
+#define FullBarrier() MemoryBarrier()
+#else
+#define AtomicCompareAndSwap(PTR, OLD, NEW) \
+	__sync_bool_compare_and_swap( PTR, OLD, NEW )
+#define FullBarrier() __sync_synchronize()
+#endif
+
+#define RingQueue_Item(Q, POS) \
+	((Q)->items + ((POS) & (Q)->mask) * (Q)->item_size)
+
+int RingQueue_Init( RingQueue queue, size_t item_size, unsigned int capacity )
+{
+	unsigned int i, size = 2;
+	while( size < capacity ) {
+		size <<= 1;
+	}
+	queue->head = 0;
+	queue->tail = 0;
+	queue->mask = size - 1;
+	queue->item_size = item_size;
+	queue->seqs = malloc( sizeof( unsigned int ) * size );
+	queue->items = malloc( item_size * size );
+	if( !queue->seqs || !queue->items ) {
+		RingQueue_Destroy( queue );
+		return -ENOMEM;
+	}
+	for( i = 0; i < size; ++i ) {
+		queue->seqs[i] = i;
+	}
+	return 0;
+}
+
+void RingQueue_Destroy( RingQueue queue )
+{
+	if( queue->seqs ) {
+		free( (void*)queue->seqs );
+	}
+	if( queue->items ) {
+		free( queue->items );
+	}
+	queue->seqs = NULL;
+	queue->items = NULL;
+	queue->mask = 0;
+}
+
+int RingQueue_Push( RingQueue queue, const void *item )
+{
+	int diff;
+	unsigned int pos, seq;
+	if( !queue->seqs ) {
+		return -1;
+	}
+	pos = queue->head;
+	while( 1 ) {
+		seq = queue->seqs[pos & queue->mask];
+		FullBarrier();
+		diff = (int)(seq - pos);
+		/* 格子的序号等于写入位置，说明它是空的，尝试占用它 */
+		if( diff == 0 ) {
+			if( AtomicCompareAndSwap( &queue->head, pos, pos + 1 ) ) {
+				break;
+			}
+		} else if( diff < 0 ) {
+			/* 格子里还是上一轮的元素，队列已满 */
+			return -1;
+		}
+		pos = queue->head;
+	}
+	memcpy( RingQueue_Item( queue, pos ), item, queue->item_size );
+	/* 先让元素对读取线程可见，再更新序号 */
+	FullBarrier();
+	queue->seqs[pos & queue->mask] = pos + 1;
+	return 0;
+}
+
+int RingQueue_Pop( RingQueue queue, void *item )
+{
+	unsigned int pos = queue->tail, seq;
+	if( !queue->seqs ) {
+		return -1;
+	}
+	seq = queue->seqs[pos & queue->mask];
+	FullBarrier();
+	/* 序号不等于 pos + 1 时，格子为空或者还在写入中 */
+	if( (int)(seq - (pos + 1)) < 0 ) {
+		return -1;
+	}
+	memcpy( item, RingQueue_Item( queue, pos ), queue->item_size );
+	FullBarrier();
+	queue->seqs[pos & queue->mask] = pos + queue->mask + 1;
+	queue->tail = pos + 1;
+	return 0;
+}
+
+LCUI_BOOL RingQueue_IsEmpty( RingQueue queue )
+{
+	unsigned int pos = queue->tail;
+	if( !queue->seqs ) {
+		return TRUE;
+	}
+	return (int)(queue->seqs[pos & queue->mask] - (pos + 1)) < 0;
+}
+
+void RingQueue_Barrier( void )
+{
+	FullBarrier();
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include "test.h"
+
+/* 性能测试只输出耗时，不检查结果，所以单独编译成 bench 程序，不在 test 中运行 */
+int main( void )
+{
+	bench_region();
+	bench_task_queue();
+	bench_widget_task();
+	bench_widget_layout();
+	bench_css_loader();
+	bench_font_cache();
+	bench_font_mix();
+	bench_textlayer();
+	return 0;
+}
@@ -31,6 +31,18 @@ int main(void)
 	InitConsoleWindow();
 #endif
 	ret |= test_string();
+	ret |= test_graph_mix();
+	ret |= test_display_render();
+	ret |= test_region();
+	ret |= test_task_queue();
+	ret |= test_timer();
+	ret |= test_widget_style();
+	ret |= test_widget_task();
+	ret |= test_widget_layout();
+	ret |= test_font_cache();
+	ret |= test_font_mix();
+	ret |= test_textlayer();
+	ret |= test_css_loader();
 	ret |= test_image_reader();
 	ret |= test_css_parser();/*
 	ret |= test_widget_render();
@@ -7,3 +7,40 @@ int test_char_render( void );
 int test_string_render( void );
 int test_widget_render( void );
 int test_image_reader( void );
+int test_graph_mix( void );
+int test_display_render( void );
+int test_region( void );
+int test_task_queue( void );
+int test_timer( void );
+int test_widget_style( void );
+int test_css_loader( void );
+int test_widget_task( void );
+int test_widget_layout( void );
+int test_font_cache( void );
+int test_font_mix( void );
+int test_textlayer( void );
+
+void bench_region( void );
+void bench_task_queue( void );
+void bench_widget_task( void );
+void bench_widget_layout( void );
+void bench_css_loader( void );
+void bench_font_cache( void );
+void bench_font_mix( void );
+void bench_textlayer( void );
+
+/** 用不处理系统事件的驱动初始化应用，以便在没有图形界面的环境中处理任务 */
+void InitDummyApp( void );
+
+/** 处理完部件的全部任务 */
+void UpdateWidgets( void );
+
+/** 获取 alpha 混合内核的名称 */
+const char *GetBlendKernelName( int kernel );
+
+/**
+ * 检查 ARGB 图像的混合结果与参考结果的误差
+ * 颜色通道的误差按预乘 alpha 后的值计算，因为几乎透明的像素的颜色值对画面
+ * 没有影响
+ */
+int CheckARGB( const LCUI_Graph *out, const LCUI_Graph *ref );
@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/css_library.h>
+#include <LCUI/gui/css_parser.h>
+#include <LCUI/gui/css_binary.h>
+#include "test.h"
+
+#define LONG_URL_LEN	4000
+#define BENCH_RULES	20000
+#define BENCH_ROUNDS	5
+
+static const char *test_css =
+	"/* 注释中的 { 和 } 不会影响解析 */\n"
+	".loader-a, .loader-b\n"
+	"{\n"
+	"	width: 10px; // 单行注释\n"
+	"	height: /* 值中的注释 */ 20px ;\n"
+	"	background-color: rgba( 255, 0, 128, 0.5 );\n"
+	"}\n"
+	".loader-c { border: 1px solid #abc; padding: 1px 2px 3px 4px }\n"
+	".loader-d { margin: 5dp; z-index: -3; left: 0.25; }";
+
+static LCUI_BOOL CheckPx( LCUI_StyleSheet ss, int key, float px )
+{
+	return CheckStyleType( ss->sheet, key, px ) &&
+		ss->sheet[key].val_px == px;
+}
+
+/** 获取选择器对应的样式表 */
+static void GetStyleSheet( const char *str, LCUI_StyleSheet ss )
+{
+	LCUI_Selector s = Selector( str );
+	StyleSheet_Clear( ss );
+	LCUI_GetStyleSheet( s, ss );
+	Selector_Delete( s );
+}
+
+/** 检查选择器列表、注释、空白字符和各种值的解析结果 */
+static int TestCSSSyntax( void )
+{
+	int ret = 0;
+	LCUI_Color *color;
+	LCUI_StyleSheet ss = StyleSheet();
+
+	LCUI_LoadCSSString( test_css, NULL );
+	GetStyleSheet( ".loader-b", ss );
+	color = &ss->sheet[key_background_color].val_color;
+	if( !CheckPx( ss, key_width, 10 ) || !CheckPx( ss, key_height, 20 ) ) {
+		_DEBUG_MSG( "wrong size of .loader-b\n" );
+		ret = -1;
+	}
+	if( !CheckStyleType( ss->sheet, key_background_color, color ) ||
+	    color->r != 255 || color->g != 0 || color->b != 128 ||
+	    color->a != 127 ) {
+		_DEBUG_MSG( "wrong background color of .loader-b\n" );
+		ret = -1;
+	}
+	GetStyleSheet( ".loader-c", ss );
+	color = &ss->sheet[key_border_top_color].val_color;
+	if( !CheckPx( ss, key_border_left_width, 1 ) ||
+	    ss->sheet[key_border_top_style].val_style != SV_SOLID ||
+	    color->r != 0xaa || color->g != 0xbb || color->b != 0xcc ) {
+		_DEBUG_MSG( "wrong border of .loader-c\n" );
+		ret = -1;
+	}
+	if( !CheckPx( ss, key_padding_top, 1 ) ||
+	    !CheckPx( ss, key_padding_right, 2 ) ||
+	    !CheckPx( ss, key_padding_bottom, 3 ) ||
+	    !CheckPx( ss, key_padding_left, 4 ) ) {
+		_DEBUG_MSG( "wrong padding of .loader-c\n" );
+		ret = -1;
+	}
+	/* 最后一条规则的声明块没有以分号结尾 */
+	GetStyleSheet( ".loader-d", ss );
+	if( ss->sheet[key_margin_top].type != SVT_DP ||
+	    ss->sheet[key_margin_top].val_dp != 5 ||
+	    ss->sheet[key_z_index].val_int != -3 ||
+	    !CheckStyleType( ss->sheet, key_left, scale ) ||
+	    ss->sheet[key_left].val_scale != 0.25 ) {
+		_DEBUG_MSG( "wrong style of .loader-d\n" );
+		ret = -1;
+	}
+	StyleSheet_Delete( ss );
+	return ret;
+}
+
+static LCUI_BOOL CheckColor( const char *str, uchar_t r, uchar_t g,
+			     uchar_t b, uchar_t a )
+{
+	LCUI_StyleRec style = { 0 };
+	return ParseColor( &style, str ) && style.color.r == r &&
+		style.color.g == g && style.color.b == b &&
+		style.color.a == a;
+}
+
+/** 检查色彩值的解析，超出范围的值会被限制，格式不完整的值会被拒绝 */
+static int TestParseColor( void )
+{
+	int ret = 0;
+	LCUI_StyleRec style = { 0 };
+
+	if( !CheckColor( "rgb(1, 2, 3)", 1, 2, 3, 255 ) ||
+	    !CheckColor( "rgba(10,20,30,0.5)", 10, 20, 30, 127 ) ||
+	    !CheckColor( "#abc", 0xaa, 0xbb, 0xcc, 255 ) ) {
+		_DEBUG_MSG( "wrong color value\n" );
+		ret = -1;
+	}
+	if( !CheckColor( "rgb(300, -20, 1000000)", 255, 0, 255, 255 ) ||
+	    !CheckColor( "rgba(0, 0, 0, 2)", 0, 0, 0, 255 ) ||
+	    !CheckColor( "rgba(0, 0, 0, -1)", 0, 0, 0, 0 ) ) {
+		_DEBUG_MSG( "out of range color value was not clamped\n" );
+		ret = -1;
+	}
+	if( ParseColor( &style, "rgb(1,2,3" ) ||
+	    ParseColor( &style, "rgba(1,2,3,0.5" ) ||
+	    ParseColor( &style, "rgb(1,2,3)x" ) ) {
+		_DEBUG_MSG( "malformed color value was accepted\n" );
+		ret = -1;
+	}
+	return ret;
+}
+
+/** 检查很长的属性值不会被截断，值中的 // 和引号内的分号也不会打断解析 */
+static int TestCSSLongValue( void )
+{
+	int i, ret = 0;
+	char *css, *url, *p;
+	const char *str;
+	LCUI_StyleSheet ss = StyleSheet();
+
+	url = malloc( LONG_URL_LEN + 1 );
+	css = malloc( LONG_URL_LEN + 128 );
+	strcpy( url, "http://example.com/a;b/" );
+	for( i = strlen( url ); i < LONG_URL_LEN; ++i ) {
+		url[i] = 'a' + i % 26;
+	}
+	url[LONG_URL_LEN] = 0;
+	p = css + sprintf( css, ".loader-long { background-image: url(\"" );
+	p += sprintf( p, "%s\"); width: 7px; }", url );
+	LCUI_LoadCSSString( css, NULL );
+	GetStyleSheet( ".loader-long", ss );
+	str = ss->sheet[key_background_image].val_string;
+	if( !CheckStyleType( ss->sheet, key_background_image, string ) ||
+	    !str || strcmp( str, url ) != 0 ) {
+		_DEBUG_MSG( "long url was truncated\n" );
+		ret = -1;
+	}
+	if( !CheckPx( ss, key_width, 7 ) ) {
+		_DEBUG_MSG( "declaration after long value was lost\n" );
+		ret = -1;
+	}
+	StyleSheet_Delete( ss );
+	free( url );
+	free( css );
+	return ret;
+}
+
+/** 检查从文件中载入的样式 */
+static int TestCSSFile( void )
+{
+	int ret = 0;
+	FILE *fp;
+	const char *file = "test_css_loader.css";
+	LCUI_StyleSheet ss = StyleSheet();
+
+	fp = fopen( file, "wb" );
+	if( !fp ) {
+		return -1;
+	}
+	fputs( "\xef\xbb\xbf.loader-file { height: 9px; }", fp );
+	fclose( fp );
+	if( LCUI_LoadCSSFile( file ) != 0 ) {
+		_DEBUG_MSG( "cannot load %s\n", file );
+		ret = -1;
+	}
+	remove( file );
+	GetStyleSheet( ".loader-file", ss );
+	if( !CheckPx( ss, key_height, 9 ) ) {
+		_DEBUG_MSG( "wrong style loaded from file\n" );
+		ret = -1;
+	}
+	StyleSheet_Delete( ss );
+	return ret;
+}
+
+/** 检查编译后的二进制样式数据与直接解析 CSS 代码的结果是否一致 */
+static int TestCSSBinary( void )
+{
+	int ret = 0;
+	char *data;
+	size_t size;
+	const char *str;
+	LCUI_CSSCompiler compiler;
+	LCUI_StyleSheet ss = StyleSheet();
+
+	compiler = CSSCompiler();
+	CSSCompiler_AddString( compiler, ".binary-a { width: 5px; "
+			       "background-image: url(binary.png); }\n"
+			       ".binary-list .binary-a:hover { width: 6px; }\n"
+			       ".binary-a { height: 2dp; width: 7px; }", NULL );
+	data = CSSCompiler_Build( compiler, &size );
+	CSSCompiler_Delete( compiler );
+	if( !data ) {
+		StyleSheet_Delete( ss );
+		return -1;
+	}
+	/* 无效的数据不能被载入 */
+	data[0] = 'X';
+	if( LCUI_LoadCSSBinary( data, size ) >= 0 ) {
+		_DEBUG_MSG( "binary with bad magic was loaded\n" );
+		ret = -1;
+	}
+	data[0] = 'L';
+	if( LCUI_LoadCSSBinary( data, size / 2 ) >= 0 ) {
+		_DEBUG_MSG( "truncated binary was loaded\n" );
+		ret = -1;
+	}
+	if( LCUI_LoadCSSBinary( data, size ) != 3 ) {
+		_DEBUG_MSG( "cannot load binary css\n" );
+		ret = -1;
+	}
+	free( data );
+	/* 后面的规则覆盖前面的，优先级高的规则覆盖优先级低的 */
+	GetStyleSheet( ".binary-a", ss );
+	str = ss->sheet[key_background_image].val_string;
+	if( !CheckPx( ss, key_width, 7 ) ||
+	    ss->sheet[key_height].type != SVT_DP ||
+	    ss->sheet[key_height].val_dp != 2 ||
+	    !str || strcmp( str, "binary.png" ) != 0 ) {
+		_DEBUG_MSG( "wrong style loaded from binary\n" );
+		ret = -1;
+	}
+	GetStyleSheet( ".binary-list .binary-a:hover", ss );
+	if( !CheckPx( ss, key_width, 6 ) ) {
+		_DEBUG_MSG( "wrong rank of rule loaded from binary\n" );
+		ret = -1;
+	}
+	StyleSheet_Delete( ss );
+	return ret;
+}
+
+int test_css_loader( void )
+{
+	int ret = 0;
+	LCUI_InitBase();
+	ret |= TestParseColor();
+	ret |= TestCSSSyntax();
+	ret |= TestCSSLongValue();
+	ret |= TestCSSFile();
+	ret |= TestCSSBinary();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 生成用于测试解析速度的 CSS 代码 */
+static char *CreateBenchmarkCSS( size_t *size )
+{
+	int i;
+	char *css, *p;
+
+	css = malloc( BENCH_RULES * 256 );
+	for( p = css, i = 0; i < BENCH_RULES; ++i ) {
+		p += sprintf( p, ".bench-list .bench-item-%d:hover {\n"
+			      "  /* rule %d */\n"
+			      "  width: %dpx; height: %d.5dp;\n"
+			      "  margin: 1px 2px 3px 4px;\n"
+			      "  border: 1px solid #%06x;\n"
+			      "  background-color: rgba(%d, %d, %d, 0.5);\n"
+			      "}\n", i % 32, i, i % 100, i % 50,
+			      i * 2654435761u & 0xffffff,
+			      i % 256, i * 7 % 256, i * 13 % 256 );
+	}
+	*size = p - css;
+	return css;
+}
+
+/** 测试 CSS 代码的解析速度 */
+static void BenchCSSParse( void )
+{
+	int round;
+	char *css;
+	size_t size;
+	int64_t t, time = 0;
+	double mb;
+
+	css = CreateBenchmarkCSS( &size );
+	for( round = 0; round < BENCH_ROUNDS; ++round ) {
+		t = LCUI_GetTime();
+		LCUI_LoadCSSString( css, NULL );
+		time += LCUI_GetTimeDelta( t );
+	}
+	mb = 1.0 * size * BENCH_ROUNDS / 1024 / 1024;
+	_DEBUG_MSG( "parsed %.2fMB css in %dms, %.2fMB/s\n", mb, (int)time,
+		    time > 0 ? mb * 1000 / time : 0 );
+	free( css );
+}
+
+/** 比较载入二进制样式数据和解析 CSS 代码所需的时间 */
+static void BenchCSSBinary( void )
+{
+	int round;
+	char *css;
+	void *data;
+	size_t size;
+	int64_t t, text_time = 0, binary_time = 0;
+	LCUI_CSSCompiler compiler;
+
+	css = CreateBenchmarkCSS( &size );
+	compiler = CSSCompiler();
+	CSSCompiler_AddString( compiler, css, NULL );
+	data = CSSCompiler_Build( compiler, &size );
+	CSSCompiler_Delete( compiler );
+	for( round = 0; data && round < BENCH_ROUNDS; ++round ) {
+		t = LCUI_GetTime();
+		LCUI_LoadCSSString( css, NULL );
+		text_time += LCUI_GetTimeDelta( t );
+		t = LCUI_GetTime();
+		LCUI_LoadCSSBinary( data, size );
+		binary_time += LCUI_GetTimeDelta( t );
+	}
+	_DEBUG_MSG( "loaded %d rules from text in %dms, from binary in %dms\n",
+		    BENCH_RULES * BENCH_ROUNDS, (int)text_time,
+		    (int)binary_time );
+	free( data );
+	free( css );
+}
+
+/** 测试 CSS 代码和二进制样式数据的载入速度 */
+void bench_css_loader( void )
+{
+	LCUI_InitBase();
+	BenchCSSParse();
+	BenchCSSBinary();
+}
@@ -0,0 +1,464 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define LCUI_SURFACE_C
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/display.h>
+#include <LCUI/gui/widget.h>
+#include "test.h"
+
+#define SCREEN_WIDTH	800
+#define SCREEN_HEIGHT	600
+
+/** 内存中的 surface，用于在没有图形界面的环境中测试渲染 */
+struct LCUI_SurfaceRec_ {
+	int width, height;
+	LCUI_Graph fb;
+};
+
+static struct LCUI_SurfaceRec_ memory_surface;
+
+static int MemSurface_GetWidth( void )
+{
+	return SCREEN_WIDTH;
+}
+
+static int MemSurface_GetHeight( void )
+{
+	return SCREEN_HEIGHT;
+}
+
+static LCUI_Surface MemSurface_New( void )
+{
+	Graph_Init( &memory_surface.fb );
+	memory_surface.fb.color_type = COLOR_TYPE_PARGB;
+	return &memory_surface;
+}
+
+static void MemSurface_Delete( LCUI_Surface surface )
+{
+	Graph_Free( &surface->fb );
+}
+
+static void MemSurface_Resize( LCUI_Surface surface, int w, int h )
+{
+	surface->width = w;
+	surface->height = h;
+	Graph_Create( &surface->fb, w, h );
+}
+
+static void MemSurface_Move( LCUI_Surface surface, int x, int y )
+{
+	return;
+}
+
+static void MemSurface_Apply( LCUI_Surface surface )
+{
+	return;
+}
+
+static void MemSurface_SetCaptionW( LCUI_Surface surface, const wchar_t *str )
+{
+	return;
+}
+
+static void MemSurface_SetRenderMode( LCUI_Surface surface, int mode )
+{
+	return;
+}
+
+static void *MemSurface_GetHandle( LCUI_Surface surface )
+{
+	return surface;
+}
+
+static void MemSurface_SetOpacity( LCUI_Surface surface, float opacity )
+{
+	return;
+}
+
+static LCUI_BOOL MemSurface_IsReady( LCUI_Surface surface )
+{
+	return TRUE;
+}
+
+static LCUI_PaintContext MemSurface_BeginPaint( LCUI_Surface surface,
+						LCUI_Rect *rect )
+{
+	LCUI_PaintContext paint = NEW( LCUI_PaintContextRec, 1 );
+	paint->rect = *rect;
+	Graph_Init( &paint->canvas );
+	LCUIRect_ValidateArea( &paint->rect, surface->width, surface->height );
+	Graph_Quote( &paint->canvas, &surface->fb, &paint->rect );
+	Graph_FillRect( &paint->canvas, RGB( 255, 255, 255 ), NULL, TRUE );
+	paint->with_alpha = FALSE;
+	return paint;
+}
+
+static void MemSurface_EndPaint( LCUI_Surface surface, LCUI_PaintContext paint )
+{
+	free( paint );
+}
+
+static int MemSurface_BindEvent( int event_id, LCUI_EventFunc func,
+				 void *data, void( *destroy_data )(void*) )
+{
+	return 0;
+}
+
+static LCUI_DisplayDriverRec memory_driver = {
+	"memory",
+	MemSurface_GetWidth,
+	MemSurface_GetHeight,
+	MemSurface_New,
+	MemSurface_Delete,
+	MemSurface_Delete,
+	MemSurface_Resize,
+	MemSurface_Move,
+	MemSurface_Apply,
+	MemSurface_Apply,
+	MemSurface_Apply,
+	MemSurface_Apply,
+	MemSurface_IsReady,
+	MemSurface_BeginPaint,
+	MemSurface_EndPaint,
+	MemSurface_SetCaptionW,
+	MemSurface_SetRenderMode,
+	MemSurface_GetHandle,
+	MemSurface_SetOpacity,
+	MemSurface_BindEvent
+};
+
+/** 创建一些相互重叠、跨越多个分块的部件 */
+static void CreateWidgets( LCUI_Widget root )
+{
+	int i;
+	LCUI_Widget w;
+	for( i = 0; i < 24; ++i ) {
+		w = LCUIWidget_New( NULL );
+		Widget_SetStyle( w, key_position, SV_ABSOLUTE, style );
+		Widget_Move( w, (float)(i * 29 % 640), (float)(i * 47 % 480) );
+		Widget_Resize( w, (float)(60 + i * 13 % 200),
+			       (float)(40 + i * 31 % 150) );
+		Widget_SetBorder( w, 1 + i % 3, SV_SOLID,
+				  RGB( i * 10, 100, 255 - i * 10 ) );
+		Widget_SetStyle( w, key_background_color,
+				 ARGB( 128 + i * 5, 255 - i * 10, i * 10, 128 ),
+				 color );
+		if( i % 3 == 0 ) {
+			Widget_SetStyle( w, key_opacity, 0.5f, scale );
+		}
+		Widget_Append( root, w );
+	}
+}
+
+static void RenderFrame( LCUI_Rect *rect )
+{
+	LCUI_Widget root = LCUIWidget_GetRoot();
+	Widget_InvalidateArea( root, rect, SV_GRAPH_BOX );
+	LCUIDisplay_Update();
+	LCUIDisplay_Render();
+	LCUIDisplay_Present();
+}
+
+/** 检查并行渲染的结果是否与单线程渲染的一致 */
+static int TestParallelRender( void )
+{
+	int ret = 0;
+	LCUI_Graph ref;
+
+	Graph_Init( &ref );
+	CreateWidgets( LCUIWidget_GetRoot() );
+	/* 先用单线程渲染一帧作为参考 */
+	RenderFrame( NULL );
+	Graph_Copy( &ref, &memory_surface.fb );
+	if( LCUIDisplay_SetRenderThreads( 4 ) != 0 ) {
+		_DEBUG_MSG( "cannot create render threads\n" );
+		ret = -1;
+	}
+	Graph_FillRect( &memory_surface.fb, ARGB( 0, 0, 0, 0 ), NULL, TRUE );
+	RenderFrame( NULL );
+	if( ref.mem_size != memory_surface.fb.mem_size ||
+	    memcmp( ref.bytes, memory_surface.fb.bytes, ref.mem_size ) != 0 ) {
+		_DEBUG_MSG( "parallel render result differs\n" );
+		ret = -1;
+	}
+	LCUIDisplay_SetRenderThreads( 1 );
+	Widget_Empty( LCUIWidget_GetRoot() );
+	Graph_Free( &ref );
+	return ret;
+}
+
+/** 检查被不透明部件遮挡的部件是否被跳过，且不影响渲染结果 */
+static int TestOcclusion( void )
+{
+	int ret = 0;
+	LCUI_Graph ref, area;
+	LCUI_Widget panel, text;
+	LCUI_WidgetPaintStatsRec stats;
+	LCUI_Rect rect = { 100, 100, 400, 300 };
+
+	Graph_Init( &ref );
+	Graph_Init( &area );
+	panel = LCUIWidget_New( NULL );
+	text = LCUIWidget_New( NULL );
+	Widget_SetStyle( panel, key_position, SV_ABSOLUTE, style );
+	Widget_SetStyle( panel, key_z_index, 100, int );
+	Widget_Move( panel, (float)rect.x, (float)rect.y );
+	Widget_Resize( panel, (float)rect.width, (float)rect.height );
+	Widget_SetBorder( panel, 2, SV_SOLID, RGB( 0, 0, 0 ) );
+	Widget_SetStyle( panel, key_background_color,
+			 RGB( 40, 80, 120 ), color );
+	Widget_Resize( text, 200, 100 );
+	Widget_SetStyle( text, key_background_color,
+			 ARGB( 100, 255, 255, 255 ), color );
+	Widget_Append( panel, text );
+	Widget_Append( LCUIWidget_GetRoot(), panel );
+	/* 只有面板时渲染一帧作为参考 */
+	RenderFrame( NULL );
+	Graph_Cut( &memory_surface.fb, rect, &ref );
+	/* 在面板下面添加部件，然后只重绘面板区域，渲染结果应该不变 */
+	CreateWidgets( LCUIWidget_GetRoot() );
+	RenderFrame( NULL );
+	Graph_FillRect( &memory_surface.fb, ARGB( 0, 0, 0, 0 ), NULL, TRUE );
+	LCUIWidget_ResetPaintStats();
+	RenderFrame( &rect );
+	Graph_Cut( &memory_surface.fb, rect, &area );
+	LCUIWidget_GetPaintStats( &stats );
+	if( memcmp( ref.bytes, area.bytes, ref.mem_size ) != 0 ) {
+		_DEBUG_MSG( "occluded area render result differs\n" );
+		ret = -1;
+	}
+	if( stats.culled_paints == 0 ) {
+		_DEBUG_MSG( "no occluded paint was culled\n" );
+		ret = -1;
+	}
+	Widget_Empty( LCUIWidget_GetRoot() );
+	Graph_Free( &area );
+	Graph_Free( &ref );
+	return ret;
+}
+
+/** 检查渲染时的临时图像是否都从帧内存池中分配，且稳定后不再申请内存 */
+static int TestFrameArena( void )
+{
+	int ret = 0;
+	LCUI_FrameArenaStatsRec stats;
+
+	CreateWidgets( LCUIWidget_GetRoot() );
+	RenderFrame( NULL );
+	RenderFrame( NULL );
+	Graph_GetFrameArenaStats( &stats );
+	if( stats.allocs == 0 ) {
+		_DEBUG_MSG( "no graph was allocated from the frame arena\n" );
+		ret = -1;
+	}
+	if( stats.heap_allocs > 0 ) {
+		_DEBUG_MSG( "frame arena allocated %lu blocks in steady state\n",
+			    (unsigned long)stats.heap_allocs );
+		ret = -1;
+	}
+	Widget_Empty( LCUIWidget_GetRoot() );
+	return ret;
+}
+
+/** 检查回收的内存能否被重新使用，以及用量一直较少时帧内存池能否收缩 */
+static int TestFrameArenaRelease( void )
+{
+	int i, ret = 0;
+	LCUI_Graph a, b;
+	LCUI_FrameArenaMarkRec mark;
+	LCUI_FrameArenaStatsRec stats;
+
+	Graph_Init( &a );
+	Graph_Init( &b );
+	a.color_type = COLOR_TYPE_ARGB;
+	b.color_type = COLOR_TYPE_ARGB;
+	Graph_ResetFrameArena();
+	Graph_MarkFrameArena( &mark );
+	Graph_CreateInFrame( &a, 1000, 1000 );
+	Graph_ReleaseFrameArena( &mark );
+	Graph_CreateInFrame( &b, 1000, 1000 );
+	if( !a.bytes || a.bytes != b.bytes ) {
+		_DEBUG_MSG( "released memory was not reused\n" );
+		ret = -1;
+	}
+	Graph_Free( &a );
+	Graph_Free( &b );
+	Graph_ResetFrameArena();
+	Graph_GetFrameArenaStats( &stats );
+	if( stats.used != 1000 * 1000 * 4 ) {
+		_DEBUG_MSG( "frame arena peak usage is %lu bytes\n",
+			    (unsigned long)stats.used );
+		ret = -1;
+	}
+	/* 之后的帧一直只用少量内存 */
+	for( i = 0; i < 100; ++i ) {
+		Graph_CreateInFrame( &a, 10, 10 );
+		Graph_Free( &a );
+		Graph_ResetFrameArena();
+	}
+	Graph_GetFrameArenaStats( &stats );
+	if( stats.capacity >= 1000 * 1000 * 4 ) {
+		_DEBUG_MSG( "frame arena was not trimmed, capacity: %lu\n",
+			    (unsigned long)stats.capacity );
+		ret = -1;
+	}
+	return ret;
+}
+
+/** 检查半透明部件的图层缓存是否只在内容变化时重绘，且不影响渲染结果 */
+static int TestLayerCache( void )
+{
+	int ret = 0;
+	LCUI_Graph ref;
+	LCUI_Widget panel, child;
+	LCUI_WidgetPaintStatsRec stats;
+
+	Graph_Init( &ref );
+	panel = LCUIWidget_New( NULL );
+	child = LCUIWidget_New( NULL );
+	Widget_SetStyle( panel, key_position, SV_ABSOLUTE, style );
+	Widget_SetStyle( panel, key_opacity, 0.5f, scale );
+	Widget_Move( panel, 50, 50 );
+	Widget_Resize( panel, 300, 200 );
+	Widget_SetBorder( panel, 1, SV_SOLID, RGB( 0, 0, 0 ) );
+	Widget_SetStyle( panel, key_background_color,
+			 ARGB( 200, 40, 80, 120 ), color );
+	Widget_Move( child, 20, 20 );
+	Widget_Resize( child, 100, 50 );
+	Widget_SetStyle( child, key_background_color,
+			 ARGB( 128, 255, 0, 0 ), color );
+	Widget_Append( panel, child );
+	CreateWidgets( LCUIWidget_GetRoot() );
+	Widget_Append( LCUIWidget_GetRoot(), panel );
+	RenderFrame( NULL );
+	/* 只改变不透明度，图层缓存不需要重绘 */
+	Widget_SetStyle( panel, key_opacity, 0.8f, scale );
+	Widget_UpdateStyle( panel, FALSE );
+	LCUIWidget_ResetPaintStats();
+	RenderFrame( NULL );
+	LCUIWidget_GetPaintStats( &stats );
+	if( stats.layer_composites == 0 || stats.layer_repaints > 0 ) {
+		_DEBUG_MSG( "layer cache was not reused\n" );
+		ret = -1;
+	}
+	Graph_Copy( &ref, &memory_surface.fb );
+	/* 重绘整个图层缓存，渲染结果应该不变 */
+	Widget_InvalidateArea( panel, NULL, SV_GRAPH_BOX );
+	Graph_FillRect( &memory_surface.fb, ARGB( 0, 0, 0, 0 ), NULL, TRUE );
+	LCUIWidget_ResetPaintStats();
+	RenderFrame( NULL );
+	LCUIWidget_GetPaintStats( &stats );
+	if( stats.layer_repaints == 0 ) {
+		_DEBUG_MSG( "layer cache was not repainted\n" );
+		ret = -1;
+	}
+	if( memcmp( ref.bytes, memory_surface.fb.bytes, ref.mem_size ) != 0 ) {
+		_DEBUG_MSG( "cached layer render result differs\n" );
+		ret = -1;
+	}
+	/* 子部件的变化需要让图层缓存失效 */
+	Widget_SetStyle( child, key_background_color,
+			 RGB( 0, 255, 0 ), color );
+	Widget_UpdateStyle( child, FALSE );
+	LCUIWidget_ResetPaintStats();
+	RenderFrame( NULL );
+	LCUIWidget_GetPaintStats( &stats );
+	if( stats.layer_repaints == 0 ) {
+		_DEBUG_MSG( "child change did not invalidate layer cache\n" );
+		ret = -1;
+	}
+	/* 手动启用图层缓存的不透明部件，渲染结果应该与不使用图层缓存时的一样 */
+	Widget_SetStyle( panel, key_opacity, 1.0f, scale );
+	Widget_UpdateStyle( panel, FALSE );
+	RenderFrame( NULL );
+	Graph_Copy( &ref, &memory_surface.fb );
+	panel->enable_graph = TRUE;
+	Widget_InvalidateArea( panel, NULL, SV_GRAPH_BOX );
+	RenderFrame( NULL );
+	if( CheckARGB( &memory_surface.fb, &ref ) != 0 ) {
+		_DEBUG_MSG( "enabled layer cache render result differs\n" );
+		ret = -1;
+	}
+	/* 多个线程同时更新嵌套的图层缓存，结果应该与单线程渲染的一致 */
+	child->enable_graph = TRUE;
+	Widget_InvalidateArea( panel, NULL, SV_GRAPH_BOX );
+	RenderFrame( NULL );
+	Graph_Copy( &ref, &memory_surface.fb );
+	LCUIDisplay_SetRenderThreads( 4 );
+	Widget_InvalidateArea( panel, NULL, SV_GRAPH_BOX );
+	Graph_FillRect( &memory_surface.fb, ARGB( 0, 0, 0, 0 ), NULL, TRUE );
+	RenderFrame( NULL );
+	if( memcmp( ref.bytes, memory_surface.fb.bytes, ref.mem_size ) != 0 ) {
+		_DEBUG_MSG( "parallel layer cache render result differs\n" );
+		ret = -1;
+	}
+	LCUIDisplay_SetRenderThreads( 1 );
+	Widget_Empty( LCUIWidget_GetRoot() );
+	Graph_Free( &ref );
+	return ret;
+}
+
+/** 检查没有需要更新的内容时，主循环能否进入休眠 */
+static int TestIdle( void )
+{
+	int i, ret = 0;
+	LCUI_Widget w;
+
+	CreateWidgets( LCUIWidget_GetRoot() );
+	w = LCUIWidget_New( NULL );
+	Widget_Resize( w, 100, 100 );
+	Widget_Append( LCUIWidget_GetRoot(), w );
+	for( i = 0; i < 10 && LCUIDisplay_HasPendingUpdate(); ++i ) {
+		LCUIDisplay_Update();
+		LCUIDisplay_Render();
+		LCUIDisplay_Present();
+	}
+	if( LCUIDisplay_HasPendingUpdate() ) {
+		_DEBUG_MSG( "display never became idle\n" );
+		ret = -1;
+	}
+	Widget_Move( w, 200, 200 );
+	if( !LCUIDisplay_HasPendingUpdate() ) {
+		_DEBUG_MSG( "widget task did not wake the display\n" );
+		ret = -1;
+	}
+	LCUIDisplay_Update();
+	LCUIDisplay_Render();
+	LCUIDisplay_Present();
+	if( LCUIDisplay_HasPendingUpdate() ) {
+		_DEBUG_MSG( "display is still busy after one frame\n" );
+		ret = -1;
+	}
+	LCUIDisplay_InvalidateArea( NULL );
+	if( !LCUIDisplay_HasPendingUpdate() ) {
+		_DEBUG_MSG( "invalid area did not wake the display\n" );
+		ret = -1;
+	}
+	RenderFrame( NULL );
+	Widget_Empty( LCUIWidget_GetRoot() );
+	return ret;
+}
+
+int test_display_render( void )
+{
+	int ret = 0;
+
+	LCUI_InitBase();
+	LCUI_InitDisplay( &memory_driver );
+	LCUIDisplay_SetSize( SCREEN_WIDTH, SCREEN_HEIGHT );
+	/* 内存驱动不会触发 resize 事件，需要手动设置根部件的尺寸 */
+	Widget_Resize( LCUIWidget_GetRoot(), SCREEN_WIDTH, SCREEN_HEIGHT );
+	ret |= TestParallelRender();
+	ret |= TestOcclusion();
+	ret |= TestFrameArena();
+	ret |= TestFrameArenaRelease();
+	ret |= TestLayerCache();
+	ret |= TestIdle();
+	LCUI_ExitDisplay();
+	assert( ret == 0 );
+	return 0;
+}
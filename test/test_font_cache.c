@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/font.h>
+#include "test.h"
+
+#define FIRST_CHAR	'!'
+#define LAST_CHAR	'~'
+#define MIN_SIZE	12
+#define MAX_SIZE	18
+#define SMALL_CACHE_SIZE	4096
+#define GLYPH_CODE	0x10000
+#define GLYPH_SIZE	40
+#define GLYPH_COUNT	200
+#define BENCH_LOOKUPS	1000000
+
+/** 载入所有可打印的 ASCII 字符的字体位图 */
+static void LoadChars( int font_id, int size )
+{
+	wchar_t ch;
+	const LCUI_FontBitmap *bmp;
+	for( ch = FIRST_CHAR; ch <= LAST_CHAR; ++ch ) {
+		LCUIFont_GetBitmap( ch, font_id, size, &bmp );
+	}
+}
+
+/** 添加一些用于测试的字体位图，每个位图的内容都不一样 */
+static const LCUI_FontBitmap *AddGlyph( int font_id, int i )
+{
+	int x, y;
+	LCUI_FontBitmap bmp;
+
+	FontBitmap_Init( &bmp );
+	FontBitmap_Create( &bmp, GLYPH_SIZE, GLYPH_SIZE );
+	for( y = 0; y < bmp.rows; ++y ) {
+		for( x = 0; x < bmp.width; ++x ) {
+			bmp.buffer[y * bmp.width + x] = (uchar_t)(x + y + i);
+		}
+	}
+	return LCUIFont_AddBitmap( GLYPH_CODE + i, font_id, GLYPH_SIZE, &bmp );
+}
+
+/** 检查缓存中的字体位图的内容是否与添加时的一致 */
+static LCUI_BOOL CheckGlyph( const LCUI_FontBitmap *bmp, int i )
+{
+	int x, y;
+	for( y = 0; y < bmp->rows; ++y ) {
+		for( x = 0; x < bmp->width; ++x ) {
+			if( bmp->buffer[y * bmp->pitch + x] !=
+			    (uchar_t)(x + y + i) ) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+/** 检查缓存的命中和未命中 */
+static int TestFontCacheLookup( int font_id )
+{
+	int ret = 0;
+	const LCUI_FontBitmap *a, *b;
+	LCUI_FontCacheStatsRec s1, s2, s3;
+
+	LCUIFont_GetCacheStats( &s1 );
+	if( LCUIFont_GetBitmap( 'A', font_id, 14, &a ) != 0 || !a ) {
+		_DEBUG_MSG( "cannot load bitmap of 'A'\n" );
+		return -1;
+	}
+	LCUIFont_GetCacheStats( &s2 );
+	LCUIFont_GetBitmap( 'A', font_id, 14, &b );
+	LCUIFont_GetCacheStats( &s3 );
+	if( s2.misses != s1.misses + 1 || s2.count != s1.count + 1 ||
+	    s2.size <= s1.size ) {
+		_DEBUG_MSG( "first lookup was not a miss\n" );
+		ret = -1;
+	}
+	if( a != b || s3.hits != s2.hits + 1 || s3.misses != s2.misses ) {
+		_DEBUG_MSG( "second lookup was not a hit\n" );
+		ret = -1;
+	}
+	/* 相邻的两个字的位图数据存放在同一个图集页中 */
+	LCUIFont_GetBitmap( 'B', font_id, 14, &b );
+	if( a->pitch <= a->width || a->pitch != b->pitch ||
+	    b->buffer - a->buffer >= a->pitch * a->rows ) {
+		_DEBUG_MSG( "glyphs were not packed into an atlas page\n" );
+		ret = -1;
+	}
+	return ret;
+}
+
+/** 检查缓存不会超出内存上限，被引用的字体位图不会被淘汰 */
+static int TestFontCacheEviction( int font_id )
+{
+	int i, ret = 0;
+	size_t max_size;
+	const LCUI_FontBitmap *a, *b;
+	LCUI_FontCacheStatsRec s1, s2;
+
+	LCUIFont_GetCacheStats( &s1 );
+	max_size = s1.max_size;
+	LCUIFont_SetCacheMaxSize( SMALL_CACHE_SIZE );
+	a = AddGlyph( font_id, 0 );
+	LCUIFont_PinBitmap( a );
+	for( i = 1; i < GLYPH_COUNT; ++i ) {
+		AddGlyph( font_id, i );
+	}
+	LCUIFont_GetCacheStats( &s2 );
+	/* 只保留被引用的图集页和当前正在使用的图集页 */
+	if( s2.pages > 2 || s2.evictions <= s1.evictions ) {
+		_DEBUG_MSG( "%lu atlas pages exceed the limit\n",
+			    (unsigned long)s2.pages );
+		ret = -1;
+	}
+	LCUIFont_GetBitmap( GLYPH_CODE, font_id, GLYPH_SIZE, &b );
+	LCUIFont_GetCacheStats( &s1 );
+	if( a != b || s1.misses != s2.misses || !CheckGlyph( a, 0 ) ) {
+		_DEBUG_MSG( "pinned bitmap was evicted\n" );
+		ret = -1;
+	}
+	LCUIFont_GetBitmap( GLYPH_CODE + GLYPH_COUNT - 1, font_id,
+			    GLYPH_SIZE, &b );
+	if( !b || !CheckGlyph( b, GLYPH_COUNT - 1 ) ) {
+		_DEBUG_MSG( "wrong content of the last added bitmap\n" );
+		ret = -1;
+	}
+	LCUIFont_UnpinBitmap( a );
+	LCUIFont_GetCacheStats( &s1 );
+	LCUIFont_GetBitmap( GLYPH_CODE, font_id, GLYPH_SIZE, &b );
+	LCUIFont_GetCacheStats( &s2 );
+	if( s2.hits != s1.hits ) {
+		_DEBUG_MSG( "unpinned bitmap was not evicted\n" );
+		ret = -1;
+	}
+	LCUIFont_SetCacheMaxSize( max_size );
+	return ret;
+}
+
+int test_font_cache( void )
+{
+	int ret = 0, font_id;
+	LCUI_InitFont();
+	font_id = LCUIFont_GetId( "inconsolata", NULL );
+	ret |= TestFontCacheLookup( font_id );
+	ret |= TestFontCacheEviction( font_id );
+	LCUI_ExitFont();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 测试从缓存中获取字体位图的速度 */
+void bench_font_cache( void )
+{
+	int i, size, font_id;
+	wchar_t ch;
+	int64_t t;
+	const LCUI_FontBitmap *bmp;
+	LCUI_FontCacheStatsRec stats;
+
+	LCUI_InitFont();
+	font_id = LCUIFont_GetId( "inconsolata", NULL );
+	for( size = MIN_SIZE; size <= MAX_SIZE; ++size ) {
+		LoadChars( font_id, size );
+	}
+	t = LCUI_GetTime();
+	for( i = 0; i < BENCH_LOOKUPS; ++i ) {
+		ch = FIRST_CHAR + i % (LAST_CHAR - FIRST_CHAR + 1);
+		size = MIN_SIZE + i % (MAX_SIZE - MIN_SIZE + 1);
+		LCUIFont_GetBitmap( ch, font_id, size, &bmp );
+	}
+	t = LCUI_GetTimeDelta( t );
+	LCUIFont_GetCacheStats( &stats );
+	_DEBUG_MSG( "%d lookups in %dms, %lu glyphs in %lu pages, "
+		    "%lu bytes cached\n", BENCH_LOOKUPS, (int)t,
+		    (unsigned long)stats.count, (unsigned long)stats.pages,
+		    (unsigned long)stats.size );
+	LCUI_ExitFont();
+}
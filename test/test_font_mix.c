@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/font.h>
+#include "test.h"
+
+#define TEST_WIDTH	67
+#define TEST_HEIGHT	13
+#define FIRST_CHAR	'!'
+#define LAST_CHAR	'~'
+#define BENCH_FONT_SIZE	14
+#define BENCH_GLYPHS	10000
+#define BENCH_ROUNDS	20
+#define BENCH_WIDTH	640
+#define BENCH_HEIGHT	480
+#define BENCH_LINES	1000
+#define GLYPHS_COUNT	24
+
+/** 生成随机的字体位图，让覆盖率为 0 和 255 的像素多一些 */
+static void CreateRandomGlyph( LCUI_FontBitmap *bmp )
+{
+	int i, n;
+	FontBitmap_Init( bmp );
+	FontBitmap_Create( bmp, TEST_WIDTH, TEST_HEIGHT );
+	n = bmp->pitch * bmp->rows;
+	for( i = 0; i < n; ++i ) {
+		switch( rand() % 4 ) {
+		case 0: bmp->buffer[i] = 0; break;
+		case 1: bmp->buffer[i] = 255; break;
+		default: bmp->buffer[i] = rand() & 0xff; break;
+		}
+	}
+	/* 加一段全为 0 的覆盖率，覆盖内核中跳过空白像素组的路径 */
+	memset( bmp->buffer + bmp->pitch, 0, bmp->pitch * 2 );
+}
+
+/** 生成随机的背景图像，opaque_rows 行以上的像素都是不透明的 */
+static void CreateRandomBackground( LCUI_Graph *graph, int color_type,
+				    int opaque_rows )
+{
+	int i, n;
+	/* 不经过颜色类型转换，直接生成随机的 RGB 像素数据 */
+	if( color_type == COLOR_TYPE_RGB ) {
+		graph->color_type = COLOR_TYPE_RGB;
+		Graph_Create( graph, TEST_WIDTH + 8, TEST_HEIGHT + 4 );
+		for( i = 0; i < (int)graph->mem_size; ++i ) {
+			graph->bytes[i] = (uchar_t)rand();
+		}
+		return;
+	}
+	graph->color_type = COLOR_TYPE_ARGB;
+	Graph_Create( graph, TEST_WIDTH + 8, TEST_HEIGHT + 4 );
+	n = graph->w * graph->h;
+	for( i = 0; i < n; ++i ) {
+		graph->argb[i].value = rand() << 16 ^ rand();
+		if( i < opaque_rows * graph->w ) {
+			graph->argb[i].a = 255;
+			continue;
+		}
+		switch( rand() % 4 ) {
+		case 0: graph->argb[i].a = 0; break;
+		case 1: graph->argb[i].a = 255; break;
+		default: break;
+		}
+	}
+	Graph_SetColorType( graph, color_type );
+}
+
+/** 以前的双精度浮点数版本的字体位图混合算法，用作对比 */
+static void MixGlyph_Double( LCUI_Graph *graph, LCUI_Pos pos,
+			     const LCUI_FontBitmap *bmp, LCUI_Color color )
+{
+	int x, y;
+	LCUI_ARGB *px;
+	double a, out_a, out_r, out_g, out_b, src_a;
+	for( y = 0; y < bmp->rows; ++y ) {
+		px = graph->argb + (pos.y + y) * graph->w + pos.x;
+		for( x = 0; x < bmp->width; ++x, ++px ) {
+			src_a = bmp->buffer[y * bmp->pitch + x] / 255.0;
+			if( src_a == 0 ) {
+				continue;
+			}
+			a = (1.0 - src_a) * px->a / 255.0;
+			out_r = px->r * a + color.r * src_a;
+			out_g = px->g * a + color.g * src_a;
+			out_b = px->b * a + color.b * src_a;
+			out_a = src_a + a;
+			px->r = (uchar_t)(out_r / out_a + 0.5);
+			px->g = (uchar_t)(out_g / out_a + 0.5);
+			px->b = (uchar_t)(out_b / out_a + 0.5);
+			px->a = (uchar_t)(255.0 * out_a + 0.5);
+		}
+	}
+}
+
+/** 用当前内核混合，并与标量内核的结果对比 */
+static int TestKernel( int kernel, int color_type, int opaque_rows )
+{
+	int ret = 0;
+	LCUI_Pos pos;
+	LCUI_Color color;
+	LCUI_FontBitmap bmp;
+	LCUI_Graph back, out, ref;
+
+	pos.x = 5;
+	pos.y = 2;
+	color = RGB( 40, 120, 230 );
+	Graph_Init( &back );
+	Graph_Init( &out );
+	Graph_Init( &ref );
+	CreateRandomGlyph( &bmp );
+	CreateRandomBackground( &back, color_type, opaque_rows );
+	Graph_Copy( &ref, &back );
+	Graph_Copy( &out, &back );
+	Graph_SetBlendKernel( BLEND_KERNEL_SCALAR );
+	FontBitmap_Mix( &ref, pos, &bmp, color );
+	Graph_SetBlendKernel( kernel );
+	FontBitmap_Mix( &out, pos, &bmp, color );
+	if( memcmp( ref.bytes, out.bytes, ref.mem_size ) != 0 ) {
+		_DEBUG_MSG( "%s: result differs from scalar kernel\n",
+			    GetBlendKernelName( kernel ) );
+		ret = -1;
+	}
+	if( color_type == COLOR_TYPE_ARGB ) {
+		Graph_Copy( &ref, &back );
+		MixGlyph_Double( &ref, pos, &bmp, color );
+		ret |= CheckARGB( &out, &ref );
+	}
+	FontBitmap_Free( &bmp );
+	Graph_Free( &back );
+	Graph_Free( &out );
+	Graph_Free( &ref );
+	return ret;
+}
+
+/**
+ * 检查批量绘制字形的结果与逐个绘制的结果是否相同
+ * 字形分布在图像的边界上，以覆盖裁剪的各种情况
+ */
+static int TestMixGlyphs( int color_type )
+{
+	int i, ret = 0;
+	LCUI_Pos pos;
+	LCUI_Rect rect;
+	LCUI_Graph back, out, ref, slot;
+	LCUI_FontBitmap bmps[GLYPHS_COUNT];
+	LCUI_GlyphRec glyphs[GLYPHS_COUNT];
+
+	pos.x = 3;
+	pos.y = -4;
+	rect.x = 5;
+	rect.y = 2;
+	rect.width = TEST_WIDTH - 20;
+	rect.height = TEST_HEIGHT - 5;
+	Graph_Init( &back );
+	Graph_Init( &out );
+	Graph_Init( &ref );
+	CreateRandomBackground( &back, color_type, 0 );
+	Graph_Copy( &ref, &back );
+	Graph_Copy( &out, &back );
+	for( i = 0; i < GLYPHS_COUNT; ++i ) {
+		CreateRandomGlyph( &bmps[i] );
+		bmps[i].width = 1 + rand() % TEST_WIDTH;
+		bmps[i].rows = 1 + rand() % TEST_HEIGHT;
+		glyphs[i].x = rand() % (TEST_WIDTH + 40) - TEST_WIDTH;
+		glyphs[i].y = rand() % (TEST_HEIGHT * 2) - TEST_HEIGHT / 2;
+		glyphs[i].color = RGB( rand() & 0xff, rand() & 0xff,
+				       rand() & 0xff );
+		glyphs[i].bitmap = &bmps[i];
+	}
+	Graph_Quote( &slot, &ref, &rect );
+	for( i = 0; i < GLYPHS_COUNT; ++i ) {
+		LCUI_Pos glyph_pos;
+		glyph_pos.x = pos.x + glyphs[i].x;
+		glyph_pos.y = pos.y + glyphs[i].y;
+		FontBitmap_Mix( &slot, glyph_pos, glyphs[i].bitmap,
+				glyphs[i].color );
+	}
+	Graph_Quote( &slot, &out, &rect );
+	FontBitmap_MixGlyphs( &slot, pos, glyphs, GLYPHS_COUNT );
+	/* RGB 图像的缓冲区比像素数据大，只比较像素数据 */
+	if( memcmp( ref.bytes, out.bytes, ref.bytes_per_row * ref.h ) != 0 ) {
+		_DEBUG_MSG( "glyphs were drawn differently in one batch\n" );
+		ret = -1;
+	}
+	for( i = 0; i < GLYPHS_COUNT; ++i ) {
+		FontBitmap_Free( &bmps[i] );
+	}
+	Graph_Free( &back );
+	Graph_Free( &out );
+	Graph_Free( &ref );
+	return ret;
+}
+
+int test_font_mix( void )
+{
+	int kernel, ret = 0, current;
+
+	srand( 2048 );
+	current = Graph_GetBlendKernel();
+	LCUI_InitFont();
+	for( kernel = BLEND_KERNEL_SCALAR; kernel <= BLEND_KERNEL_NEON;
+	     ++kernel ) {
+		if( Graph_SetBlendKernel( kernel ) != 0 ) {
+			continue;
+		}
+		ret |= TestKernel( kernel, COLOR_TYPE_ARGB, 0 );
+		ret |= TestKernel( kernel, COLOR_TYPE_ARGB, TEST_HEIGHT );
+		ret |= TestKernel( kernel, COLOR_TYPE_PARGB, 0 );
+	}
+	Graph_SetBlendKernel( current );
+	ret |= TestMixGlyphs( COLOR_TYPE_ARGB );
+	ret |= TestMixGlyphs( COLOR_TYPE_PARGB );
+	ret |= TestMixGlyphs( COLOR_TYPE_RGB );
+	LCUI_ExitFont();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 测试在 ARGB 图像上绘制大量字形的速度 */
+static void BenchMix( int kernel, LCUI_Color bg )
+{
+	int i, x, y, round;
+	int64_t t;
+	LCUI_Pos pos;
+	LCUI_Graph canvas;
+	LCUI_Color color = RGB( 20, 20, 20 );
+	const LCUI_FontBitmap *bmps[LAST_CHAR - FIRST_CHAR + 1];
+
+	for( i = 0; i <= LAST_CHAR - FIRST_CHAR; ++i ) {
+		LCUIFont_GetBitmap( FIRST_CHAR + i, -1,
+				    BENCH_FONT_SIZE, &bmps[i] );
+	}
+	Graph_Init( &canvas );
+	canvas.color_type = COLOR_TYPE_ARGB;
+	Graph_Create( &canvas, BENCH_WIDTH, BENCH_HEIGHT );
+	Graph_FillRect( &canvas, bg, NULL, TRUE );
+	Graph_SetBlendKernel( kernel );
+	t = LCUI_GetTime();
+	for( round = 0; round < BENCH_ROUNDS; ++round ) {
+		for( i = 0, x = 0, y = 0; i < BENCH_GLYPHS; ++i ) {
+			const LCUI_FontBitmap *bmp;
+			bmp = bmps[i % (LAST_CHAR - FIRST_CHAR + 1)];
+			pos.x = x + bmp->left;
+			pos.y = y + BENCH_FONT_SIZE - bmp->top;
+			FontBitmap_Mix( &canvas, pos, bmp, color );
+			x += BENCH_FONT_SIZE / 2;
+			if( x + BENCH_FONT_SIZE > BENCH_WIDTH ) {
+				x = 0;
+				y = (y + BENCH_FONT_SIZE) %
+				    (BENCH_HEIGHT - BENCH_FONT_SIZE);
+			}
+		}
+	}
+	t = LCUI_GetTimeDelta( t );
+	_DEBUG_MSG( "%s: %d rounds of %d glyphs on %s background in %dms\n",
+		    GetBlendKernelName( kernel ), BENCH_ROUNDS, BENCH_GLYPHS,
+		    bg.a == 255 ? "opaque" : "translucent", (int)t );
+	Graph_Free( &canvas );
+}
+
+/** 测试滚动浏览一个有很多行的日志文本时的绘制速度 */
+static void BenchTextLayerScroll( void )
+{
+	int i, y;
+	int64_t t;
+	char line[128];
+	wchar_t wline[128];
+	LCUI_Rect area;
+	LCUI_Graph canvas;
+	LCUI_Pos pos = { 0, 0 };
+	LCUI_TextLayer layer = TextLayer_New();
+
+	TextLayer_SetMultiline( layer, TRUE );
+	TextLayer_SetFixedSize( layer, BENCH_WIDTH, BENCH_HEIGHT );
+	for( i = 0; i < BENCH_LINES; ++i ) {
+		sprintf( line, "[%04d] GET /api/items?page=%d 200 OK "
+			 "(%d bytes in %dms)\n", i, i % 50,
+			 i * 37 % 9000, i % 120 );
+		for( y = 0; line[y]; ++y ) {
+			wline[y] = line[y];
+		}
+		wline[y] = 0;
+		TextLayer_AppendTextW( layer, wline, NULL );
+	}
+	TextLayer_Update( layer, NULL );
+	area.x = 0;
+	area.y = 0;
+	area.width = BENCH_WIDTH;
+	area.height = BENCH_HEIGHT;
+	Graph_Init( &canvas );
+	canvas.color_type = COLOR_TYPE_ARGB;
+	Graph_Create( &canvas, BENCH_WIDTH, BENCH_HEIGHT );
+	t = LCUI_GetTime();
+	/* 每次向下滚动一小段距离，然后重绘整个视图 */
+	for( y = 0; y < TextLayer_GetHeight( layer ) - BENCH_HEIGHT;
+	     y += BENCH_FONT_SIZE * 3 ) {
+		TextLayer_SetOffset( layer, 0, -y );
+		TextLayer_Update( layer, NULL );
+		TextLayer_ClearInvalidRect( layer );
+		Graph_FillRect( &canvas, RGB( 255, 255, 255 ), NULL, TRUE );
+		TextLayer_DrawToGraph( layer, area, pos, &canvas );
+	}
+	t = LCUI_GetTimeDelta( t );
+	_DEBUG_MSG( "scrolled through %d lines in %dms\n",
+		    TextLayer_GetRowTotal( layer ), (int)t );
+	Graph_Free( &canvas );
+	TextLayer_Destroy( layer );
+}
+
+/** 测试各个混合内核绘制字形的速度，以及滚动文本图层时的绘制速度 */
+void bench_font_mix( void )
+{
+	int kernel, current;
+
+	current = Graph_GetBlendKernel();
+	LCUI_InitFont();
+	for( kernel = BLEND_KERNEL_SCALAR; kernel <= BLEND_KERNEL_NEON;
+	     ++kernel ) {
+		if( Graph_SetBlendKernel( kernel ) != 0 ) {
+			continue;
+		}
+		BenchMix( kernel, RGB( 255, 255, 255 ) );
+		BenchMix( kernel, ARGB( 128, 255, 255, 255 ) );
+	}
+	Graph_SetBlendKernel( current );
+	BenchTextLayerScroll();
+	LCUI_ExitFont();
+}
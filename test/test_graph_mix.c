@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include "test.h"
+
+#define TEST_WIDTH	67
+#define TEST_HEIGHT	13
+
+static void FillRandomARGB( LCUI_Graph *graph )
+{
+	int i, n = graph->w * graph->h;
+	for( i = 0; i < n; ++i ) {
+		graph->argb[i].value = rand() << 16 ^ rand();
+		/* 让完全透明和完全不透明的像素多一些，覆盖内核中的快速路径 */
+		switch( rand() % 4 ) {
+		case 0: graph->argb[i].a = 0; break;
+		case 1: graph->argb[i].a = 255; break;
+		default: break;
+		}
+	}
+}
+
+static void FillRandomBytes( LCUI_Graph *graph )
+{
+	size_t i;
+	for( i = 0; i < graph->mem_size; ++i ) {
+		graph->bytes[i] = rand() & 0xff;
+	}
+}
+
+/** 以前的双精度浮点数版本的 ARGB 混合算法，用作对比 */
+static void MixARGB_Double( LCUI_ARGB *dst, const LCUI_ARGB *src,
+			    int n, double opacity )
+{
+	int i;
+	double a, src_a, out_a, out_r, out_g, out_b;
+	for( i = 0; i < n; ++i, ++src, ++dst ) {
+		src_a = src->a / 255.0 * opacity;
+		a = (1.0 - src_a) * dst->a / 255.0;
+		out_r = dst->r * a + src->r * src_a;
+		out_g = dst->g * a + src->g * src_a;
+		out_b = dst->b * a + src->b * src_a;
+		out_a = src_a + a;
+		if( out_a > 0 ) {
+			out_r /= out_a;
+			out_g /= out_a;
+			out_b /= out_a;
+		}
+		dst->r = (uchar_t)(out_r + 0.5);
+		dst->g = (uchar_t)(out_g + 0.5);
+		dst->b = (uchar_t)(out_b + 0.5);
+		dst->a = (uchar_t)(255.0 * out_a + 0.5);
+	}
+}
+
+/**
+ * 双精度浮点数版本的混合到 PARGB 的算法，结果也是预乘 alpha 的
+ * @param[in] premultiplied 源像素是否已经预乘 alpha
+ */
+static void MixPARGB_Double( LCUI_ARGB *dst, const LCUI_ARGB *src, int n,
+			     double opacity, LCUI_BOOL premultiplied )
+{
+	int i;
+	double a, k;
+	for( i = 0; i < n; ++i, ++src, ++dst ) {
+		a = src->a / 255.0 * opacity;
+		k = premultiplied ? opacity : a;
+		dst->r = (uchar_t)(src->r * k + dst->r * (1.0 - a) + 0.5);
+		dst->g = (uchar_t)(src->g * k + dst->g * (1.0 - a) + 0.5);
+		dst->b = (uchar_t)(src->b * k + dst->b * (1.0 - a) + 0.5);
+		dst->a = (uchar_t)(255.0 * a + dst->a * (1.0 - a) + 0.5);
+	}
+}
+
+/** 双精度浮点数版本的颜色混合算法，背景色视为不透明 */
+static uchar_t MixColor_Double( uchar_t back, uchar_t fore, double a )
+{
+	return (uchar_t)(fore * a + back * (1.0 - a) + 0.5);
+}
+
+static int CheckBytes( const LCUI_Graph *out, const LCUI_Graph *ref )
+{
+	size_t i;
+	for( i = 0; i < out->mem_size; ++i ) {
+		if( abs( out->bytes[i] - ref->bytes[i] ) > 1 ) {
+			_DEBUG_MSG( "byte %lu: %d, expected %d\n",
+				    (unsigned long)i, out->bytes[i],
+				    ref->bytes[i] );
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** 用当前内核混合，并与标量内核的结果对比 */
+static int TestKernel( int kernel, const LCUI_Graph *fore,
+		       const LCUI_Graph *back, LCUI_BOOL with_alpha,
+		       LCUI_Graph *out )
+{
+	LCUI_Graph ref;
+	Graph_Init( &ref );
+	Graph_Copy( &ref, back );
+	Graph_Copy( out, back );
+	Graph_SetBlendKernel( BLEND_KERNEL_SCALAR );
+	Graph_Mix( &ref, fore, 0, 0, with_alpha );
+	Graph_SetBlendKernel( kernel );
+	Graph_Mix( out, fore, 0, 0, with_alpha );
+	if( memcmp( ref.bytes, out->bytes, ref.mem_size ) != 0 ) {
+		_DEBUG_MSG( "%s: result differs from scalar kernel\n",
+			    GetBlendKernelName( kernel ) );
+		Graph_Free( &ref );
+		return -1;
+	}
+	Graph_Free( &ref );
+	return 0;
+}
+
+static int TestMix( int kernel, float opacity )
+{
+	int i, n, ret = 0;
+	LCUI_Graph fore, back, out, ref;
+
+	Graph_Init( &fore );
+	Graph_Init( &back );
+	Graph_Init( &out );
+	Graph_Init( &ref );
+	fore.color_type = COLOR_TYPE_ARGB;
+	back.color_type = COLOR_TYPE_ARGB;
+	Graph_Create( &fore, TEST_WIDTH, TEST_HEIGHT );
+	Graph_Create( &back, TEST_WIDTH, TEST_HEIGHT );
+	FillRandomARGB( &fore );
+	FillRandomARGB( &back );
+	fore.opacity = opacity;
+	n = TEST_WIDTH * TEST_HEIGHT;
+	/* ARGB 混合到 ARGB */
+	ret |= TestKernel( kernel, &fore, &back, TRUE, &out );
+	Graph_Copy( &ref, &back );
+	MixARGB_Double( ref.argb, fore.argb, n, opacity );
+	ret |= CheckARGB( &out, &ref );
+	/* ARGB 混合到 ARGB，保留背景的 alpha 通道 */
+	ret |= TestKernel( kernel, &fore, &back, FALSE, &out );
+	for( i = 0; i < n; ++i ) {
+		double a = fore.argb[i].a * opacity / 255.0;
+		LCUI_ARGB *px = &ref.argb[i], *bg = &back.argb[i];
+		px->r = MixColor_Double( bg->r, fore.argb[i].r, a );
+		px->g = MixColor_Double( bg->g, fore.argb[i].g, a );
+		px->b = MixColor_Double( bg->b, fore.argb[i].b, a );
+		px->a = bg->a;
+	}
+	ret |= CheckBytes( &out, &ref );
+	/* ARGB 混合到 RGB */
+	back.color_type = COLOR_TYPE_RGB;
+	ref.color_type = COLOR_TYPE_RGB;
+	Graph_Create( &back, TEST_WIDTH, TEST_HEIGHT );
+	Graph_Create( &ref, TEST_WIDTH, TEST_HEIGHT );
+	FillRandomBytes( &back );
+	ret |= TestKernel( kernel, &fore, &back, TRUE, &out );
+	for( i = 0; i < n; ++i ) {
+		double a = fore.argb[i].a * opacity / 255.0;
+		uchar_t *px = ref.bytes + i * 3, *bg = back.bytes + i * 3;
+		px[0] = MixColor_Double( bg[0], fore.argb[i].b, a );
+		px[1] = MixColor_Double( bg[1], fore.argb[i].g, a );
+		px[2] = MixColor_Double( bg[2], fore.argb[i].r, a );
+	}
+	ret |= CheckBytes( &out, &ref );
+	Graph_Free( &fore );
+	Graph_Free( &back );
+	Graph_Free( &out );
+	Graph_Free( &ref );
+	return ret;
+}
+
+static void CreateRandomPARGB( LCUI_Graph *graph )
+{
+	graph->color_type = COLOR_TYPE_ARGB;
+	Graph_Create( graph, TEST_WIDTH, TEST_HEIGHT );
+	FillRandomARGB( graph );
+	Graph_SetColorType( graph, COLOR_TYPE_PARGB );
+}
+
+static int TestMixPARGB( int kernel, float opacity )
+{
+	int i, n, ret = 0;
+	LCUI_Graph fore, back, out, ref;
+
+	Graph_Init( &fore );
+	Graph_Init( &back );
+	Graph_Init( &out );
+	Graph_Init( &ref );
+	CreateRandomPARGB( &fore );
+	CreateRandomPARGB( &back );
+	fore.opacity = opacity;
+	n = TEST_WIDTH * TEST_HEIGHT;
+	/* PARGB 混合到 PARGB */
+	ret |= TestKernel( kernel, &fore, &back, TRUE, &out );
+	Graph_Copy( &ref, &back );
+	MixPARGB_Double( ref.argb, fore.argb, n, opacity, TRUE );
+	ret |= CheckBytes( &out, &ref );
+	/* ARGB 混合到 PARGB */
+	Graph_SetColorType( &fore, COLOR_TYPE_ARGB );
+	ret |= TestKernel( kernel, &fore, &back, TRUE, &out );
+	Graph_Copy( &ref, &back );
+	MixPARGB_Double( ref.argb, fore.argb, n, opacity, FALSE );
+	ret |= CheckBytes( &out, &ref );
+	/* PARGB 混合到 RGB */
+	Graph_SetColorType( &fore, COLOR_TYPE_PARGB );
+	back.color_type = COLOR_TYPE_RGB;
+	ref.color_type = COLOR_TYPE_RGB;
+	Graph_Create( &back, TEST_WIDTH, TEST_HEIGHT );
+	Graph_Create( &ref, TEST_WIDTH, TEST_HEIGHT );
+	FillRandomBytes( &back );
+	ret |= TestKernel( kernel, &fore, &back, TRUE, &out );
+	for( i = 0; i < n; ++i ) {
+		double a = fore.argb[i].a * opacity / 255.0;
+		uchar_t *px = ref.bytes + i * 3, *bg = back.bytes + i * 3;
+		px[0] = (uchar_t)(fore.argb[i].b * opacity +
+				  bg[0] * (1.0 - a) + 0.5);
+		px[1] = (uchar_t)(fore.argb[i].g * opacity +
+				  bg[1] * (1.0 - a) + 0.5);
+		px[2] = (uchar_t)(fore.argb[i].r * opacity +
+				  bg[2] * (1.0 - a) + 0.5);
+	}
+	ret |= CheckBytes( &out, &ref );
+	Graph_Free( &fore );
+	Graph_Free( &back );
+	Graph_Free( &out );
+	Graph_Free( &ref );
+	return ret;
+}
+
+/** 检查 ARGB 和 PARGB 之间的转换 */
+static int TestPremultiply( void )
+{
+	int i, ret = 0;
+	LCUI_Graph graph, copy, out;
+
+	Graph_Init( &out );
+	Graph_Init( &copy );
+	Graph_Init( &graph );
+	CreateRandomPARGB( &graph );
+	Graph_Copy( &copy, &graph );
+	Graph_SetColorType( &copy, COLOR_TYPE_ARGB );
+	/* 覆盖到 PARGB 图像时会预乘 alpha，预乘后的像素在还原后再次预乘，
+	 * 结果应该不变 */
+	out.color_type = COLOR_TYPE_PARGB;
+	Graph_Create( &out, TEST_WIDTH, TEST_HEIGHT );
+	Graph_Replace( &out, &copy, 0, 0 );
+	if( memcmp( out.bytes, graph.bytes, graph.mem_size ) != 0 ) {
+		_DEBUG_MSG( "replace with premultiplied alpha failed\n" );
+		ret = -1;
+	}
+	/* 覆盖到 RGB 图像时还原成 ARGB 后去掉 alpha 通道 */
+	Graph_Free( &out );
+	out.color_type = COLOR_TYPE_RGB;
+	Graph_Create( &out, TEST_WIDTH, TEST_HEIGHT );
+	Graph_Replace( &out, &graph, 0, 0 );
+	for( i = 0; i < TEST_WIDTH * TEST_HEIGHT; ++i ) {
+		const uchar_t *px = out.bytes + i * 3;
+		const LCUI_ARGB *ref = &copy.argb[i];
+		if( ref->a > 0 && (px[0] != ref->b || px[1] != ref->g ||
+				   px[2] != ref->r) ) {
+			_DEBUG_MSG( "pixel %d: replace PARGB with RGB failed\n",
+				    i );
+			ret = -1;
+			break;
+		}
+	}
+	Graph_SetColorType( &copy, COLOR_TYPE_PARGB );
+	if( memcmp( copy.bytes, graph.bytes, graph.mem_size ) != 0 ) {
+		_DEBUG_MSG( "premultiply round trip failed\n" );
+		ret = -1;
+	}
+	Graph_Free( &graph );
+	Graph_Free( &copy );
+	Graph_Free( &out );
+	return ret;
+}
+
+int test_graph_mix( void )
+{
+	int kernel, ret = 0, current;
+
+	srand( 1024 );
+	current = Graph_GetBlendKernel();
+	for( kernel = BLEND_KERNEL_SCALAR; kernel <= BLEND_KERNEL_NEON;
+	     ++kernel ) {
+		if( Graph_SetBlendKernel( kernel ) != 0 ) {
+			continue;
+		}
+		_DEBUG_MSG( "kernel: %s\n", GetBlendKernelName( kernel ) );
+		ret |= TestMix( kernel, 1.0f );
+		ret |= TestMix( kernel, 0.6f );
+		ret |= TestMixPARGB( kernel, 1.0f );
+		ret |= TestMixPARGB( kernel, 0.6f );
+	}
+	Graph_SetBlendKernel( current );
+	ret |= TestPremultiply();
+	assert( ret == 0 );
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/gui/widget.h>
+#include "test.h"
+
+static void Dummy_ProcessEvents( void )
+{
+	return;
+}
+
+static LCUI_BOOL Dummy_WaitEvent( void )
+{
+	return TRUE;
+}
+
+static LCUI_BOOL Dummy_PostTask( LCUI_AppTask task )
+{
+	return FALSE;
+}
+
+static LCUI_AppDriverRec dummy_driver = {
+	Dummy_ProcessEvents,
+	Dummy_WaitEvent,
+	Dummy_PostTask
+};
+
+void InitDummyApp( void )
+{
+	LCUI_InitApp( &dummy_driver );
+}
+
+void UpdateWidgets( void )
+{
+	while( LCUIWidget_HasPendingTasks() ) {
+		LCUIWidget_Update();
+	}
+}
+
+const char *GetBlendKernelName( int kernel )
+{
+	static const char *names[] = { "scalar", "sse2", "avx2", "neon" };
+	if( kernel < BLEND_KERNEL_SCALAR || kernel > BLEND_KERNEL_NEON ) {
+		return "unknown";
+	}
+	return names[kernel];
+}
+
+/** 计算颜色通道预乘 alpha 后的值 */
+#define Premultiply(C, A) (((C) * (A) + 127) / 255)
+
+/** 检查两个颜色通道预乘 alpha 后的值相差是否超过 max_diff */
+static LCUI_BOOL DiffPremultiplied( uchar_t c1, uchar_t a1,
+				    uchar_t c2, uchar_t a2, int max_diff )
+{
+	return abs( Premultiply( c1, a1 ) - Premultiply( c2, a2 ) ) > max_diff;
+}
+
+/** alpha 通道和颜色通道各自的误差都可能是 1，所以预乘后最多相差 2 */
+int CheckARGB( const LCUI_Graph *out, const LCUI_Graph *ref )
+{
+	int i, n = out->w * out->h;
+	for( i = 0; i < n; ++i ) {
+		const LCUI_ARGB *a = &out->argb[i], *b = &ref->argb[i];
+		if( abs( a->a - b->a ) > 1 ||
+		    DiffPremultiplied( a->r, a->a, b->r, b->a, 2 ) ||
+		    DiffPremultiplied( a->g, a->a, b->g, b->a, 2 ) ||
+		    DiffPremultiplied( a->b, a->a, b->b, b->a, 2 ) ) {
+			_DEBUG_MSG( "pixel %d: 0x%08x, expected 0x%08x\n",
+				    i, a->value, b->value );
+			return -1;
+		}
+	}
+	return 0;
+}
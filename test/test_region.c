@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include "test.h"
+
+#define MAP_SIZE	64
+#define INVALID_RECTS	200
+#define BENCH_RECTS	4000
+#define BENCH_ROUNDS	5
+
+typedef unsigned char Bitmap[MAP_SIZE][MAP_SIZE];
+
+static void RandomRect( LCUI_Rect *rect )
+{
+	rect->x = rand() % (MAP_SIZE + 16) - 8;
+	rect->y = rand() % (MAP_SIZE + 16) - 8;
+	rect->width = rand() % 24 + 1;
+	rect->height = rand() % 24 + 1;
+}
+
+static void Bitmap_Apply( Bitmap map, const LCUI_Rect *rect, int op )
+{
+	int x, y, value;
+	for( y = 0; y < MAP_SIZE; ++y ) {
+		for( x = 0; x < MAP_SIZE; ++x ) {
+			value = LCUIRect_HasPoint( rect, x, y );
+			switch( op ) {
+			case 0: map[y][x] |= value; break;
+			case 1: map[y][x] &= !value; break;
+			default: map[y][x] &= value; break;
+			}
+		}
+	}
+}
+
+static int Region_Apply( LCUI_Region region, const LCUI_Rect *rect, int op )
+{
+	switch( op ) {
+	case 0: return Region_UnionRect( region, rect );
+	case 1: return Region_SubtractRect( region, rect );
+	default: break;
+	}
+	return Region_IntersectRect( region, rect );
+}
+
+/** 检查区域的矩形是否按行带排列、互不重叠，且与位图一致 */
+static int CheckRegion( LCUI_Region region, Bitmap expected )
+{
+	int x, y, i;
+	Bitmap map;
+	LCUI_Rect *rect, *prev = NULL;
+
+	memset( map, 0, sizeof( map ) );
+	for( Region_Each( rect, region ) ) {
+		if( rect->width <= 0 || rect->height <= 0 ) {
+			return -1;
+		}
+		if( prev && prev->y == rect->y ) {
+			/* 同一行带内的矩形高度相同，且互不相邻 */
+			if( prev->height != rect->height ||
+			    prev->x + prev->width >= rect->x ) {
+				return -1;
+			}
+		} else if( prev && prev->y + prev->height > rect->y ) {
+			return -1;
+		}
+		for( y = rect->y; y < rect->y + rect->height; ++y ) {
+			for( x = rect->x; x < rect->x + rect->width; ++x ) {
+				if( x < 0 || y < 0 || x >= MAP_SIZE ||
+				    y >= MAP_SIZE ) {
+					continue;
+				}
+				if( map[y][x] ) {
+					return -1;
+				}
+				map[y][x] = 1;
+			}
+		}
+		prev = rect;
+	}
+	/* 外接矩形要恰好包住所有矩形 */
+	for( i = 0; i < region->length; ++i ) {
+		LCUI_Rect overlay;
+		LCUIRect_GetOverlayRect( &region->extents, &region->rects[i],
+					 &overlay );
+		if( memcmp( &overlay, &region->rects[i],
+			    sizeof( LCUI_Rect ) ) != 0 ) {
+			return -1;
+		}
+	}
+	return memcmp( map, expected, sizeof( map ) ) == 0 ? 0 : -1;
+}
+
+static int TestRectOps( void )
+{
+	int i, op;
+	Bitmap map;
+	LCUI_Rect rect, clip;
+	LCUI_RegionRec region;
+
+	Region_Init( &region );
+	memset( map, 0, sizeof( map ) );
+	/* 只在位图范围内做运算，以便与位图逐像素对比 */
+	clip.x = clip.y = 0;
+	clip.width = clip.height = MAP_SIZE;
+	for( i = 0; i < 2000; ++i ) {
+		RandomRect( &rect );
+		LCUIRect_GetOverlayRect( &rect, &clip, &rect );
+		op = rand() % 10;
+		op = op < 6 ? 0 : (op < 9 ? 1 : 2);
+		Bitmap_Apply( map, &rect, op );
+		Region_Apply( &region, &rect, op );
+		if( CheckRegion( &region, map ) != 0 ) {
+			_DEBUG_MSG( "region differs after op %d on (%d,%d,%d,%d)\n",
+				    op, rect.x, rect.y, rect.width, rect.height );
+			Region_Free( &region );
+			return -1;
+		}
+	}
+	Region_Free( &region );
+	return 0;
+}
+
+static void RandomRegion( LCUI_Region region, Bitmap map )
+{
+	int i;
+	LCUI_Rect rect, clip;
+	clip.x = clip.y = 0;
+	clip.width = clip.height = MAP_SIZE;
+	Region_Clear( region );
+	memset( map, 0, sizeof( Bitmap ) );
+	for( i = rand() % 12; i >= 0; --i ) {
+		RandomRect( &rect );
+		LCUIRect_GetOverlayRect( &rect, &clip, &rect );
+		Region_UnionRect( region, &rect );
+		Bitmap_Apply( map, &rect, 0 );
+	}
+}
+
+static int TestRegionOps( void )
+{
+	int i, x, y, ret = 0;
+	Bitmap a_map, b_map, map;
+	LCUI_RegionRec a, b, c;
+
+	Region_Init( &a );
+	Region_Init( &b );
+	Region_Init( &c );
+	for( i = 0; i < 500 && ret == 0; ++i ) {
+		RandomRegion( &a, a_map );
+		RandomRegion( &b, b_map );
+		Region_Copy( &c, &a );
+		Region_Union( &c, &b );
+		for( y = 0; y < MAP_SIZE; ++y ) {
+			for( x = 0; x < MAP_SIZE; ++x ) {
+				map[y][x] = a_map[y][x] | b_map[y][x];
+			}
+		}
+		ret |= CheckRegion( &c, map );
+		Region_Copy( &c, &a );
+		Region_Subtract( &c, &b );
+		for( y = 0; y < MAP_SIZE; ++y ) {
+			for( x = 0; x < MAP_SIZE; ++x ) {
+				map[y][x] = a_map[y][x] & !b_map[y][x];
+			}
+		}
+		ret |= CheckRegion( &c, map );
+		Region_Copy( &c, &a );
+		Region_Intersect( &c, &b );
+		for( y = 0; y < MAP_SIZE; ++y ) {
+			for( x = 0; x < MAP_SIZE; ++x ) {
+				map[y][x] = a_map[y][x] & b_map[y][x];
+			}
+		}
+		ret |= CheckRegion( &c, map );
+	}
+	if( ret != 0 ) {
+		_DEBUG_MSG( "region operation result differs\n" );
+	}
+	Region_Free( &a );
+	Region_Free( &b );
+	Region_Free( &c );
+	return ret;
+}
+
+/** 生成一些细小的无效区域，模拟文本光标、小图标之类的局部更新 */
+static LCUI_Rect *NewInvalidRects( int n )
+{
+	int i;
+	LCUI_Rect *rects = NEW( LCUI_Rect, n );
+
+	for( i = 0; i < n; ++i ) {
+		rects[i].x = rand() % 1900;
+		rects[i].y = rand() % 1060;
+		rects[i].width = rand() % 16 + 4;
+		rects[i].height = rand() % 16 + 4;
+	}
+	return rects;
+}
+
+/** 计算区域中各个矩形的面积之和 */
+static long GetRegionArea( LCUI_Region region )
+{
+	long area = 0;
+	LCUI_Rect *r;
+
+	for( Region_Each( r, region ) ) {
+		area += r->width * r->height;
+	}
+	return area;
+}
+
+/** 检查合并后的无效区域是否包含所有矩形，且面积不比 RectList 的大 */
+static int TestInvalidate( void )
+{
+	int i, ret = 0;
+	long list_area = 0;
+	LinkedList list;
+	LinkedListNode *node;
+	LCUI_Rect *rects, *r;
+	LCUI_RegionRec region;
+
+	rects = NewInvalidRects( INVALID_RECTS );
+	Region_Init( &region );
+	LinkedList_Init( &list );
+	for( i = 0; i < INVALID_RECTS; ++i ) {
+		Region_UnionRect( &region, &rects[i] );
+		RectList_Add( &list, &rects[i] );
+	}
+	for( i = 0; i < INVALID_RECTS; ++i ) {
+		if( !Region_ContainsRect( &region, &rects[i] ) ) {
+			_DEBUG_MSG( "rect %d is not in the region\n", i );
+			ret = -1;
+			break;
+		}
+	}
+	for( LinkedList_Each( node, &list ) ) {
+		r = node->data;
+		list_area += r->width * r->height;
+	}
+	/* 区域不会重复计算重叠部分，所以它的面积不会比 RectList 的大 */
+	if( GetRegionArea( &region ) > list_area ) {
+		_DEBUG_MSG( "region area is larger than rect list area\n" );
+		ret = -1;
+	}
+	Region_Free( &region );
+	RectList_Clear( &list );
+	free( rects );
+	return ret;
+}
+
+int test_region( void )
+{
+	int ret = 0;
+	srand( 2017 );
+	ret |= TestRectOps();
+	ret |= TestRegionOps();
+	ret |= TestInvalidate();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 对比大量细小的无效区域在区域和 RectList 中的合并耗时和重绘面积 */
+void bench_region( void )
+{
+	int i, round;
+	int64_t t, region_time = 0, list_time = 0;
+	long list_area = 0;
+	LinkedList list;
+	LinkedListNode *node;
+	LCUI_Rect *rects, *r;
+	LCUI_RegionRec region;
+
+	srand( 2017 );
+	rects = NewInvalidRects( BENCH_RECTS );
+	Region_Init( &region );
+	LinkedList_Init( &list );
+	for( round = 0; round < BENCH_ROUNDS; ++round ) {
+		t = LCUI_GetTime();
+		for( i = 0; i < BENCH_RECTS; ++i ) {
+			Region_UnionRect( &region, &rects[i] );
+		}
+		region_time += LCUI_GetTimeDelta( t );
+		t = LCUI_GetTime();
+		for( i = 0; i < BENCH_RECTS; ++i ) {
+			RectList_Add( &list, &rects[i] );
+		}
+		list_time += LCUI_GetTimeDelta( t );
+		if( round < BENCH_ROUNDS - 1 ) {
+			Region_Clear( &region );
+			RectList_Clear( &list );
+		}
+	}
+	for( LinkedList_Each( node, &list ) ) {
+		r = node->data;
+		list_area += r->width * r->height;
+	}
+	_DEBUG_MSG( "%d invalid rects x %d rounds: region %dms, %d rects, "
+		    "area %ld; rect list %dms, %d rects, area %ld\n",
+		    BENCH_RECTS, BENCH_ROUNDS, (int)region_time,
+		    region.length, GetRegionArea( &region ), (int)list_time,
+		    (int)list.length, list_area );
+	Region_Free( &region );
+	RectList_Clear( &list );
+	free( rects );
+}
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include "test.h"
+
+#define PRODUCERS	4
+#define ITEMS		10000
+#define BENCH_ITEMS	200000
+#define QUEUE_SIZE	1024
+
+typedef struct ItemRec_ {
+	int producer;
+	int id;
+} ItemRec, *Item;
+
+/** 对照组：用互斥锁保护的链表实现的队列，每个元素都要申请一次内存 */
+typedef struct ListQueueRec_ {
+	LinkedList items;
+	LCUI_Mutex mutex;
+} ListQueueRec, *ListQueue;
+
+typedef struct ProducerRec_ {
+	int index;
+	int count;
+	RingQueue ring;
+	ListQueue list;
+	int *next_ids;
+	LCUI_Thread tid;
+} ProducerRec, *Producer;
+
+static void RingProducer( void *arg )
+{
+	ItemRec item;
+	Producer p = arg;
+	item.producer = p->index;
+	for( item.id = 0; item.id < p->count; ++item.id ) {
+		while( RingQueue_Push( p->ring, &item ) != 0 ) {
+			LCUI_MSleep( 0 );
+		}
+	}
+	LCUIThread_Exit( NULL );
+}
+
+static void ListProducer( void *arg )
+{
+	Item item;
+	int i;
+	Producer p = arg;
+	for( i = 0; i < p->count; ++i ) {
+		item = NEW( ItemRec, 1 );
+		item->producer = p->index;
+		item->id = i;
+		LCUIMutex_Lock( &p->list->mutex );
+		LinkedList_Append( &p->list->items, item );
+		LCUIMutex_Unlock( &p->list->mutex );
+	}
+	LCUIThread_Exit( NULL );
+}
+
+/** 检查每个写入线程的元素是否按顺序读出，且没有丢失 */
+static int CheckItem( int *next_ids, Item item )
+{
+	if( item->producer < 0 || item->producer >= PRODUCERS ||
+	    next_ids[item->producer] != item->id ) {
+		return -1;
+	}
+	next_ids[item->producer] += 1;
+	return 0;
+}
+
+static int TestRingQueue( void )
+{
+	int i, ret = 0;
+	ItemRec item;
+	RingQueueRec queue;
+
+	RingQueue_Init( &queue, sizeof( ItemRec ), 8 );
+	if( !RingQueue_IsEmpty( &queue ) ) {
+		ret = -1;
+	}
+	/* 多轮写满再读空，检查序号回绕后是否正常 */
+	for( i = 0; i < 8 * 8; ++i ) {
+		item.producer = 0;
+		item.id = i;
+		if( RingQueue_Push( &queue, &item ) != 0 ) {
+			ret = -1;
+		}
+		if( i % 8 == 7 ) {
+			if( RingQueue_Push( &queue, &item ) == 0 ) {
+				_DEBUG_MSG( "full ring queue accepted an item\n" );
+				ret = -1;
+			}
+			while( RingQueue_Pop( &queue, &item ) == 0 );
+		}
+	}
+	if( RingQueue_Pop( &queue, &item ) == 0 ) {
+		_DEBUG_MSG( "empty ring queue returned an item\n" );
+		ret = -1;
+	}
+	RingQueue_Destroy( &queue );
+	return ret;
+}
+
+/**
+ * 启动多个写入线程向环形队列写入元素，在当前线程中读出并检查
+ * @param[in] count 每个写入线程写入的元素数量
+ * @param[out] time 读出所有元素的耗时
+ * @returns 元素没有丢失和乱序时返回 0，否则返回 -1
+ */
+static int RunRingQueue( int count, int64_t *time )
+{
+	int i, n, ret = 0;
+	int next_ids[PRODUCERS];
+	int64_t t;
+	ProducerRec producers[PRODUCERS];
+	RingQueueRec ring;
+	ItemRec item;
+
+	RingQueue_Init( &ring, sizeof( ItemRec ), QUEUE_SIZE );
+	memset( next_ids, 0, sizeof( next_ids ) );
+	t = LCUI_GetTime();
+	for( i = 0; i < PRODUCERS; ++i ) {
+		producers[i].index = i;
+		producers[i].count = count;
+		producers[i].ring = &ring;
+		LCUIThread_Create( &producers[i].tid, RingProducer,
+				   &producers[i] );
+	}
+	for( n = 0; n < PRODUCERS * count; ) {
+		if( RingQueue_Pop( &ring, &item ) != 0 ) {
+			continue;
+		}
+		if( CheckItem( next_ids, &item ) != 0 ) {
+			ret = -1;
+		}
+		++n;
+	}
+	*time = LCUI_GetTimeDelta( t );
+	for( i = 0; i < PRODUCERS; ++i ) {
+		LCUIThread_Join( producers[i].tid, NULL );
+	}
+	RingQueue_Destroy( &ring );
+	return ret;
+}
+
+/** 与 RunRingQueue() 相同，但使用加锁链表作为队列 */
+static int RunListQueue( int count, int64_t *time )
+{
+	int i, n, ret = 0;
+	int next_ids[PRODUCERS];
+	int64_t t;
+	ProducerRec producers[PRODUCERS];
+	LinkedListNode *node;
+	ListQueueRec list;
+
+	LinkedList_Init( &list.items );
+	LCUIMutex_Init( &list.mutex );
+	memset( next_ids, 0, sizeof( next_ids ) );
+	t = LCUI_GetTime();
+	for( i = 0; i < PRODUCERS; ++i ) {
+		producers[i].index = i;
+		producers[i].count = count;
+		producers[i].list = &list;
+		LCUIThread_Create( &producers[i].tid, ListProducer,
+				   &producers[i] );
+	}
+	for( n = 0; n < PRODUCERS * count; ) {
+		LCUIMutex_Lock( &list.mutex );
+		node = LinkedList_GetNode( &list.items, 0 );
+		if( node ) {
+			LinkedList_Unlink( &list.items, node );
+		}
+		LCUIMutex_Unlock( &list.mutex );
+		if( !node ) {
+			continue;
+		}
+		if( CheckItem( next_ids, node->data ) != 0 ) {
+			ret = -1;
+		}
+		free( node->data );
+		free( node );
+		++n;
+	}
+	*time = LCUI_GetTimeDelta( t );
+	for( i = 0; i < PRODUCERS; ++i ) {
+		LCUIThread_Join( producers[i].tid, NULL );
+	}
+	LCUIMutex_Destroy( &list.mutex );
+	return ret;
+}
+
+/** 检查多个线程同时写入环形队列时，元素没有丢失或乱序 */
+static int TestContention( void )
+{
+	int64_t t;
+	if( RunRingQueue( ITEMS, &t ) != 0 ) {
+		_DEBUG_MSG( "items were lost or reordered\n" );
+		return -1;
+	}
+	return 0;
+}
+
+static int task_count, task_errors;
+
+static void OnTask( void *arg1, void *arg2 )
+{
+	ItemRec item;
+	item.producer = (int)(size_t)arg2 / ITEMS;
+	item.id = (int)(size_t)arg2 % ITEMS;
+	if( CheckItem( arg1, &item ) != 0 ) {
+		task_errors += 1;
+	}
+	task_count += 1;
+}
+
+static void TaskProducer( void *arg )
+{
+	int i;
+	Producer p = arg;
+	for( i = 0; i < p->count; ++i ) {
+		LCUI_PostSimpleTask( OnTask, p->next_ids,
+				     (size_t)(p->index * ITEMS + i) );
+	}
+	LCUIThread_Exit( NULL );
+}
+
+/** 检查投递的任务能否唤醒主线程，且在任务队列溢出时不会丢失或乱序 */
+static int TestPostTask( void )
+{
+	int i, ret = 0, rounds = 0;
+	int next_ids[PRODUCERS];
+	int count = QUEUE_SIZE * 4;
+	ProducerRec producers[PRODUCERS];
+
+	task_count = 0;
+	task_errors = 0;
+	memset( next_ids, 0, sizeof( next_ids ) );
+	InitDummyApp();
+	LCUI_SetTaskBudget( 1 );
+	for( i = 0; i < PRODUCERS; ++i ) {
+		producers[i].index = i;
+		producers[i].count = count;
+		producers[i].next_ids = next_ids;
+		LCUIThread_Create( &producers[i].tid, TaskProducer,
+				   &producers[i] );
+	}
+	while( task_count < PRODUCERS * count ) {
+		LCUI_WaitEvent();
+		LCUI_ProcessEvents();
+		++rounds;
+	}
+	for( i = 0; i < PRODUCERS; ++i ) {
+		LCUIThread_Join( producers[i].tid, NULL );
+		if( next_ids[i] != count ) {
+			ret = -1;
+		}
+	}
+	if( ret != 0 || task_errors > 0 ) {
+		_DEBUG_MSG( "posted tasks were lost or reordered\n" );
+		ret = -1;
+	}
+	_DEBUG_MSG( "%d tasks processed in %d rounds\n", task_count, rounds );
+	LCUI_SetTaskBudget( 0 );
+	return ret;
+}
+
+int test_task_queue( void )
+{
+	int ret = 0;
+	ret |= TestRingQueue();
+	ret |= TestContention();
+	ret |= TestPostTask();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 对比多个线程同时写入时，环形队列与加锁链表的耗时 */
+void bench_task_queue( void )
+{
+	int64_t ring_time, list_time;
+
+	RunRingQueue( BENCH_ITEMS, &ring_time );
+	RunListQueue( BENCH_ITEMS, &list_time );
+	_DEBUG_MSG( "%d producers x %d items: ring queue %dms, "
+		    "locked list %dms\n", PRODUCERS, BENCH_ITEMS,
+		    (int)ring_time, (int)list_time );
+}
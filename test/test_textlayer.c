@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/font.h>
+#include "test.h"
+
+#define TEST_WIDTH	160
+#define TEST_HEIGHT	400
+#define TEST_LINES	200
+#define TEST_EDITS	400
+#define MAX_LINE_LEN	60
+#define BENCH_WIDTH	640
+#define BENCH_LINES	50000
+#define BENCH_ROW	10
+#define BENCH_KEYS	200
+
+/** 生成一段有多个段落的文本，段落的长度不一，有的会被自动换行分成好几行 */
+static wchar_t *CreateText( int lines )
+{
+	int i, j, len;
+	wchar_t *text, *p;
+
+	text = malloc( sizeof( wchar_t ) * (lines * (MAX_LINE_LEN + 1) + 1) );
+	for( p = text, i = 0; i < lines; ++i ) {
+		len = rand() % MAX_LINE_LEN;
+		for( j = 0; j < len; ++j ) {
+			*p++ = rand() % 6 == 0 ? L' ' : L'a' + rand() % 26;
+		}
+		*p++ = L'\n';
+	}
+	*p = 0;
+	return text;
+}
+
+/** 获取文本图层中的文本，包括各行末尾的换行符 */
+static wchar_t *GetLayerText( LCUI_TextLayer layer )
+{
+	int row, col, len;
+	wchar_t *text, *p;
+	TextRow txtrow;
+
+	for( len = 1, row = 0; row < layer->rowlist.length; ++row ) {
+		len += layer->rowlist.rows[row]->length + 1;
+	}
+	text = malloc( sizeof( wchar_t ) * len );
+	for( p = text, row = 0; row < layer->rowlist.length; ++row ) {
+		txtrow = layer->rowlist.rows[row];
+		for( col = 0; col < txtrow->length; ++col ) {
+			*p++ = txtrow->string[col]->char_code;
+		}
+		if( txtrow->eol != EOL_NONE ) {
+			*p++ = L'\n';
+		}
+	}
+	*p = 0;
+	return text;
+}
+
+static LCUI_TextLayer CreateTextLayer( int width, const wchar_t *text )
+{
+	LCUI_TextLayer layer = TextLayer_New();
+	TextLayer_SetMultiline( layer, TRUE );
+	TextLayer_SetAutoWrap( layer, TRUE );
+	TextLayer_SetFixedSize( layer, width, TEST_HEIGHT );
+	TextLayer_SetTextW( layer, text, NULL );
+	TextLayer_Update( layer, NULL );
+	TextLayer_ClearInvalidRect( layer );
+	return layer;
+}
+
+/**
+ * 对图层中的文本重新进行完整的排版，检查断行位置是否与图层中的相同，
+ * 以及各行的字形是否已经生成
+ */
+static int CheckTypeset( LCUI_TextLayer layer )
+{
+	int row, ret = 0;
+	wchar_t *text = GetLayerText( layer );
+	LCUI_TextLayer ref = CreateTextLayer( TEST_WIDTH, text );
+
+	if( ref->rowlist.length != layer->rowlist.length ) {
+		_DEBUG_MSG( "%d rows, expected %d\n", layer->rowlist.length,
+			    ref->rowlist.length );
+		ret = -1;
+	}
+	for( row = 0; ret == 0 && row < layer->rowlist.length; ++row ) {
+		if( layer->rowlist.rows[row]->length !=
+		    ref->rowlist.rows[row]->length ) {
+			_DEBUG_MSG( "row %d has %d chars, expected %d\n", row,
+				    layer->rowlist.rows[row]->length,
+				    ref->rowlist.rows[row]->length );
+			ret = -1;
+		}
+		/* 绘制时不会再生成字形，所以更新图层后每一行的字形都应该是有效的 */
+		if( layer->rowlist.rows[row]->glyphs_dirty ) {
+			_DEBUG_MSG( "row %d has no glyphs after update\n", row );
+			ret = -1;
+		}
+	}
+	TextLayer_Destroy( ref );
+	free( text );
+	return ret;
+}
+
+/** 在随机的位置编辑文本，每次只重新排版受影响的行，结果应与完整排版的一样 */
+static int TestIncrementalTypeset( void )
+{
+	int i, row, col, ret = 0;
+	wchar_t *text = CreateText( TEST_LINES );
+	LCUI_TextLayer layer = CreateTextLayer( TEST_WIDTH, text );
+
+	for( i = 0; ret == 0 && i < TEST_EDITS; ++i ) {
+		row = rand() % TextLayer_GetRowTotal( layer );
+		col = TextLayer_GetRowTextLength( layer, row );
+		TextLayer_SetCaretPos( layer, row, rand() % (col + 1) );
+		switch( rand() % 5 ) {
+		case 0: TextLayer_InsertTextW( layer, L"w", NULL ); break;
+		case 1: TextLayer_InsertTextW( layer, L"new line\n", NULL ); break;
+		case 2: TextLayer_InsertTextW( layer, L"mmmmmmmmmmmm", NULL ); break;
+		case 3: TextLayer_TextBackspace( layer, 1 + rand() % 3 ); break;
+		default: TextLayer_TextDelete( layer, 1 + rand() % 3 ); break;
+		}
+		TextLayer_Update( layer, NULL );
+		TextLayer_ClearInvalidRect( layer );
+		ret = CheckTypeset( layer );
+	}
+	if( ret != 0 ) {
+		_DEBUG_MSG( "wrong typeset after %d edits\n", i );
+	}
+	TextLayer_Destroy( layer );
+	free( text );
+	return ret;
+}
+
+int test_textlayer( void )
+{
+	int ret = 0;
+	srand( 4096 );
+	LCUI_InitFont();
+	ret |= TestIncrementalTypeset();
+	LCUI_ExitFont();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 测试在一个很长的文本的开头附近打字时，每次按键后更新文本图层的耗时 */
+void bench_textlayer( void )
+{
+	int i;
+	int64_t t;
+	wchar_t *text = CreateText( BENCH_LINES );
+	LCUI_TextLayer layer;
+
+	LCUI_InitFont();
+	layer = CreateTextLayer( BENCH_WIDTH, text );
+	TextLayer_SetCaretPos( layer, BENCH_ROW, 0 );
+	t = LCUI_GetTime();
+	for( i = 0; i < BENCH_KEYS; ++i ) {
+		if( i % 20 == 19 ) {
+			TextLayer_InsertTextW( layer, L"\n", NULL );
+		} else if( i % 10 == 9 ) {
+			TextLayer_TextBackspace( layer, 1 );
+		} else {
+			TextLayer_InsertTextW( layer, L"a", NULL );
+		}
+		TextLayer_Update( layer, NULL );
+		TextLayer_ClearInvalidRect( layer );
+	}
+	t = LCUI_GetTimeDelta( t );
+	_DEBUG_MSG( "%d keys typed at row %d of %d rows in %dms\n",
+		    BENCH_KEYS, BENCH_ROW, TextLayer_GetRowTotal( layer ),
+		    (int)t );
+	TextLayer_Destroy( layer );
+	LCUI_ExitFont();
+	free( text );
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/timer.h>
+#include "test.h"
+
+#define TIMERS	200
+
+typedef struct TimerRecordRec_ {
+	int id;
+	int64_t deadline;	/**< 最早允许触发的时间 */
+	int64_t fire_time;	/**< 实际触发的时间 */
+	int count;		/**< 触发次数 */
+} TimerRecordRec, *TimerRecord;
+
+static TimerRecordRec records[TIMERS];
+static int fire_count;
+
+static void OnTimer( void *arg )
+{
+	TimerRecord record = arg;
+	record->fire_time = LCUI_GetTime();
+	record->count += 1;
+	fire_count += 1;
+}
+
+/** 处理一段时间内的任务 */
+static void ProcessTasks( int ms )
+{
+	int64_t t = LCUI_GetTime();
+	while( LCUI_GetTimeDelta( t ) < ms ) {
+		LCUI_MSleep( 1 );
+		LCUI_ProcessEvents();
+	}
+}
+
+/** 检查定时器是否都按时触发，且被释放的定时器不会触发 */
+static int TestTimerDeadline( void )
+{
+	int i, ret = 0, expected = 0;
+	int64_t t = LCUI_GetTime();
+
+	fire_count = 0;
+	memset( records, 0, sizeof( records ) );
+	for( i = 0; i < TIMERS; ++i ) {
+		long int ms = 20 + i * 37 % 100;
+		records[i].deadline = LCUI_GetTime() + ms;
+		records[i].id = LCUITimer_Set( ms, OnTimer, &records[i], FALSE );
+	}
+	for( i = 0; i < TIMERS; i += 10 ) {
+		LCUITimer_Free( records[i].id );
+	}
+	for( i = 0; i < TIMERS; ++i ) {
+		expected += i % 10 ? 1 : 0;
+	}
+	/* 定时器线程会唤醒正在等待任务的主线程 */
+	while( fire_count < expected && LCUI_GetTimeDelta( t ) < 2000 ) {
+		LCUI_WaitEvent();
+		LCUI_ProcessEvents();
+	}
+	for( i = 0; i < TIMERS; ++i ) {
+		if( i % 10 == 0 ) {
+			if( records[i].count > 0 ) {
+				_DEBUG_MSG( "freed timer %d was fired\n", i );
+				ret = -1;
+			}
+			continue;
+		}
+		if( records[i].count != 1 ) {
+			_DEBUG_MSG( "timer %d was fired %d times\n",
+				    i, records[i].count );
+			ret = -1;
+		} else if( records[i].fire_time < records[i].deadline ) {
+			_DEBUG_MSG( "timer %d was fired too early\n", i );
+			ret = -1;
+		}
+	}
+	/* 一次性的定时器触发后就被释放了 */
+	if( LCUITimer_Free( records[1].id ) == 0 ) {
+		_DEBUG_MSG( "fired timer was not released\n" );
+		ret = -1;
+	}
+	return ret;
+}
+
+/** 检查重复使用的定时器的暂停、继续和重设 */
+static int TestTimerPause( void )
+{
+	int ret = 0, count;
+	TimerRecord record = &records[0];
+
+	memset( record, 0, sizeof( TimerRecordRec ) );
+	record->id = LCUITimer_Set( 10, OnTimer, record, TRUE );
+	ProcessTasks( 100 );
+	if( record->count < 3 ) {
+		_DEBUG_MSG( "repeating timer was fired %d times\n",
+			    record->count );
+		ret = -1;
+	}
+	LCUITimer_Pause( record->id );
+	ProcessTasks( 20 );
+	count = record->count;
+	ProcessTasks( 60 );
+	if( record->count != count ) {
+		_DEBUG_MSG( "paused timer was fired\n" );
+		ret = -1;
+	}
+	/* 暂停期间重设等待时间，继续后要等满新的时间才触发 */
+	LCUITimer_Reset( record->id, 200 );
+	ProcessTasks( 30 );
+	LCUITimer_Continue( record->id );
+	ProcessTasks( 100 );
+	if( record->count != count ) {
+		_DEBUG_MSG( "reset timer was fired too early\n" );
+		ret = -1;
+	}
+	ProcessTasks( 200 );
+	if( record->count == count ) {
+		_DEBUG_MSG( "continued timer was not fired\n" );
+		ret = -1;
+	}
+	if( LCUITimer_Free( record->id ) != 0 ) {
+		ret = -1;
+	}
+	count = record->count;
+	ProcessTasks( 50 );
+	if( record->count != count ) {
+		_DEBUG_MSG( "freed timer was fired\n" );
+		ret = -1;
+	}
+	return ret;
+}
+
+int test_timer( void )
+{
+	int ret = 0;
+	LCUI_InitBase();
+	InitDummyApp();
+	ret |= TestTimerDeadline();
+	ret |= TestTimerPause();
+	assert( ret == 0 );
+	return 0;
+}
@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/css_parser.h>
+#include "test.h"
+
+#define ITEMS		500
+#define INLINE_ITEMS	20
+#define INLINE_OPS	200
+#define BENCH_ITEMS	5000
+#define BENCH_APPENDS	200
+#define FLEX_ROWS	5
+#define FLEX_CELLS	4
+#define FLEX_RESIZES	3
+#define BENCH_FLEX_ROWS	50
+#define BENCH_FLEX_CELLS	20
+#define BENCH_FLEX_RESIZES	20
+
+static const char *test_css =
+	".layout-list { width: 200px; }\n"
+	".layout-item { height: 10px; }\n"
+	".layout-item.large { height: 25px; }\n"
+	".layout-item.collapsed { display: none; }\n"
+	".layout-inline { display: inline-block; width: 30px; height: 10px; }\n"
+	".layout-inline.block { display: block; }\n"
+	".layout-inline.collapsed { display: none; }\n"
+	".flex-row { display: flex; width: 300px; height: 50px; }\n"
+	".flex-row .fixed { width: 50px; }\n"
+	".flex-row .grow { flex: 1; }\n"
+	".flex-row .grow2 { flex: 2 1 0px; }\n"
+	".flex-row .wide { width: 150px; }\n"
+	".flex-row .rigid { flex: none; }\n"
+	".flex-column { display: flex; flex-direction: column; "
+	"width: 100px; height: 200px; }\n"
+	".flex-column .grow { flex: 1; }\n"
+	".flex-wrap { display: flex; flex-flow: row wrap; width: 100px; }\n"
+	".flex-center { justify-content: center; align-items: center; }\n"
+	".flex-cell { width: 40px; height: 20px; }\n"
+	".flex-bench { display: flex; flex-direction: column; }\n"
+	".flex-bench-row { display: flex; flex: 1; }\n"
+	".flex-bench-cell { display: flex; flex-direction: column; flex: 1; }\n"
+	".flex-bench-leaf { flex: 1; }\n";
+
+static LCUI_Widget NewItem( void )
+{
+	LCUI_Widget w = LCUIWidget_New( NULL );
+	Widget_AddClass( w, "layout-item" );
+	return w;
+}
+
+/**
+ * 检查子级部件是否从上到下依次排列，以及列表的高度是否正确
+ * 隐藏的部件仍然占用布局空间，不显示的部件则不参与布局
+ */
+static int CheckList( LCUI_Widget list )
+{
+	int i = 0;
+	float y = 0;
+	LinkedListNode *node;
+
+	for( LinkedList_Each( node, &list->children ) ) {
+		LCUI_Widget w = node->data;
+		if( w->computed_style.display == SV_NONE ) {
+			continue;
+		}
+		if( w->y != y || w->x != 0 ) {
+			_DEBUG_MSG( "item %d is at (%g, %g), expected (0, %g)\n",
+				    i, w->x, w->y, y );
+			return -1;
+		}
+		y += w->height;
+		++i;
+	}
+	if( list->height != y ) {
+		_DEBUG_MSG( "list height is %g, expected %g\n",
+			    list->height, y );
+		return -1;
+	}
+	return 0;
+}
+
+/** 检查增量布局的结果是否与重新布局全部子级部件的结果一致 */
+static int CheckFullLayout( LCUI_Widget list )
+{
+	int i = 0, ret = 0;
+	float *pos, height = list->height;
+	LinkedListNode *node;
+	LCUI_Widget w;
+
+	pos = malloc( sizeof( float ) * list->children.length * 2 );
+	for( LinkedList_Each( node, &list->children ) ) {
+		w = node->data;
+		pos[i++] = w->x;
+		pos[i++] = w->y;
+	}
+	Widget_UpdateLayout( list );
+	UpdateWidgets();
+	i = 0;
+	for( LinkedList_Each( node, &list->children ) ) {
+		w = node->data;
+		if( pos[i] != w->x || pos[i + 1] != w->y ) {
+			_DEBUG_MSG( "item %d is at (%g, %g), full layout puts it "
+				    "at (%g, %g)\n", i / 2, pos[i], pos[i + 1],
+				    w->x, w->y );
+			ret = -1;
+			break;
+		}
+		i += 2;
+	}
+	if( height != list->height ) {
+		_DEBUG_MSG( "list height is %g, full layout gives %g\n",
+			    height, list->height );
+		ret = -1;
+	}
+	free( pos );
+	return ret;
+}
+
+/** 检查追加、移除、改变尺寸和隐藏子级部件后的布局结果 */
+static int TestIncrementalLayout( void )
+{
+	int i, ret = 0;
+	LCUI_Widget list, w, items[ITEMS];
+
+	list = LCUIWidget_New( NULL );
+	Widget_AddClass( list, "layout-list" );
+	for( i = 0; i < ITEMS; ++i ) {
+		items[i] = NewItem();
+		Widget_Append( list, items[i] );
+	}
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	ret |= CheckList( list );
+	w = NewItem();
+	Widget_Append( list, w );
+	UpdateWidgets();
+	ret |= CheckList( list );
+	Widget_Destroy( items[ITEMS / 2] );
+	UpdateWidgets();
+	ret |= CheckList( list );
+	Widget_AddClass( items[ITEMS / 3], "large" );
+	UpdateWidgets();
+	ret |= CheckList( list );
+	Widget_Hide( items[ITEMS / 4] );
+	Widget_AddClass( items[ITEMS / 5], "collapsed" );
+	UpdateWidgets();
+	ret |= CheckList( list );
+	Widget_RemoveClass( items[ITEMS / 5], "collapsed" );
+	Widget_Prepend( list, NewItem() );
+	UpdateWidgets();
+	ret |= CheckList( list );
+	ret |= CheckFullLayout( list );
+	if( list->height != (ITEMS + 1) * 10 + 15 ) {
+		_DEBUG_MSG( "wrong list height: %g\n", list->height );
+		ret = -1;
+	}
+	Widget_Destroy( list );
+	UpdateWidgets();
+	return ret;
+}
+
+/** 检查切换行内块级部件的 display 和可见性后，增量布局的结果是否正确 */
+static int TestDisplayChange( void )
+{
+	int i, ret = 0;
+	LCUI_Widget list, w, items[INLINE_ITEMS];
+
+	list = LCUIWidget_New( NULL );
+	Widget_AddClass( list, "layout-list" );
+	for( i = 0; i < INLINE_ITEMS; ++i ) {
+		items[i] = LCUIWidget_New( NULL );
+		Widget_AddClass( items[i], "layout-inline" );
+		Widget_Append( list, items[i] );
+	}
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	ret |= CheckFullLayout( list );
+	/* 变为块级部件后，它要独占一行，可见性没有变化 */
+	Widget_AddClass( items[2], "block" );
+	UpdateWidgets();
+	if( items[2]->x != 0 || items[2]->y != 10 ) {
+		_DEBUG_MSG( "block item is at (%g, %g), expected (0, 10)\n",
+			    items[2]->x, items[2]->y );
+		ret = -1;
+	}
+	ret |= CheckFullLayout( list );
+	/* 已隐藏的部件不再显示后，不能再占用布局空间 */
+	Widget_Hide( items[5] );
+	UpdateWidgets();
+	ret |= CheckFullLayout( list );
+	Widget_AddClass( items[5], "collapsed" );
+	UpdateWidgets();
+	ret |= CheckFullLayout( list );
+	srand( 2017 );
+	for( i = 0; i < INLINE_OPS && ret == 0; ++i ) {
+		w = items[rand() % INLINE_ITEMS];
+		switch( rand() % 4 ) {
+		case 0:
+			if( Widget_HasClass( w, "block" ) ) {
+				Widget_RemoveClass( w, "block" );
+			} else {
+				Widget_AddClass( w, "block" );
+			}
+			break;
+		case 1:
+			if( Widget_HasClass( w, "collapsed" ) ) {
+				Widget_RemoveClass( w, "collapsed" );
+			} else {
+				Widget_AddClass( w, "collapsed" );
+			}
+			break;
+		case 2: Widget_Hide( w ); break;
+		default: Widget_Show( w ); break;
+		}
+		UpdateWidgets();
+		if( CheckFullLayout( list ) != 0 ) {
+			_DEBUG_MSG( "layout differs after %d operations\n",
+				    i + 1 );
+			ret = -1;
+		}
+	}
+	Widget_Destroy( list );
+	UpdateWidgets();
+	return ret;
+}
+
+static LCUI_Widget NewFlexItem( LCUI_Widget parent, const char *class_name )
+{
+	LCUI_Widget w = LCUIWidget_New( NULL );
+	Widget_AddClass( w, class_name );
+	Widget_Append( parent, w );
+	return w;
+}
+
+/** 检查部件的位置和尺寸，弹性布局分配的尺寸可能有小数，允许有一点误差 */
+static int CheckRect( LCUI_Widget w, const char *name, float x, float y,
+		      float width, float height )
+{
+	if( fabs( w->x - x ) > 0.01 || fabs( w->y - y ) > 0.01 ||
+	    fabs( w->width - width ) > 0.01 ||
+	    fabs( w->height - height ) > 0.01 ) {
+		_DEBUG_MSG( "%s is (%g, %g, %g, %g), expected (%g, %g, %g, %g)\n",
+			    name, w->x, w->y, w->width, w->height,
+			    x, y, width, height );
+		return -1;
+	}
+	return 0;
+}
+
+/** 检查弹性布局的伸缩、换行和对齐方式 */
+static int TestFlexLayout( void )
+{
+	int i, ret = 0;
+	LCUI_Widget box, w[5];
+
+	/* 剩余空间按照 flex-grow 分配，高度拉伸至整行 */
+	box = NewFlexItem( LCUIWidget_GetRoot(), "flex-row" );
+	w[0] = NewFlexItem( box, "fixed" );
+	w[1] = NewFlexItem( box, "grow" );
+	w[2] = NewFlexItem( box, "grow2" );
+	UpdateWidgets();
+	if( w[2]->computed_style.flex.grow != 2 ||
+	    w[2]->computed_style.flex.shrink != 1 ) {
+		_DEBUG_MSG( "wrong flex factors parsed from shorthand\n" );
+		ret = -1;
+	}
+	ret |= CheckRect( w[0], "fixed item", 0, 0, 50, 50 );
+	ret |= CheckRect( w[1], "grow item", 50, 0, 250.0f / 3, 50 );
+	ret |= CheckRect( w[2], "grow2 item", 50 + 250.0f / 3, 0,
+			  500.0f / 3, 50 );
+	Widget_Destroy( box );
+	/* 超出的空间按照 flex-shrink 和基准尺寸的乘积收缩 */
+	box = NewFlexItem( LCUIWidget_GetRoot(), "flex-row" );
+	w[0] = NewFlexItem( box, "wide" );
+	w[1] = NewFlexItem( box, "wide" );
+	w[2] = NewFlexItem( box, "wide" );
+	Widget_AddClass( w[2], "rigid" );
+	UpdateWidgets();
+	ret |= CheckRect( w[0], "shrunk item", 0, 0, 75, 50 );
+	ret |= CheckRect( w[1], "shrunk item", 75, 0, 75, 50 );
+	ret |= CheckRect( w[2], "rigid item", 150, 0, 150, 50 );
+	/* 移出容器后恢复原来的尺寸 */
+	Widget_Append( LCUIWidget_GetRoot(), w[0] );
+	UpdateWidgets();
+	if( w[0]->width != 150 ) {
+		_DEBUG_MSG( "unlinked item kept its flex size\n" );
+		ret = -1;
+	}
+	Widget_Destroy( w[0] );
+	Widget_Destroy( box );
+	/* 纵向排列时，宽度为 auto 的子部件拉伸至容器的宽度 */
+	box = NewFlexItem( LCUIWidget_GetRoot(), "flex-column" );
+	w[0] = NewFlexItem( box, "flex-cell" );
+	w[1] = NewFlexItem( box, "grow" );
+	UpdateWidgets();
+	ret |= CheckRect( w[0], "column cell", 0, 0, 40, 20 );
+	ret |= CheckRect( w[1], "column grow item", 0, 20, 100, 180 );
+	Widget_Destroy( box );
+	/* 换行后，容器的高度由各行的高度撑开 */
+	box = NewFlexItem( LCUIWidget_GetRoot(), "flex-wrap" );
+	for( i = 0; i < 5; ++i ) {
+		w[i] = NewFlexItem( box, "flex-cell" );
+	}
+	UpdateWidgets();
+	for( i = 0; i < 5; ++i ) {
+		ret |= CheckRect( w[i], "wrapped cell", (i % 2) * 40.0f,
+				  (i / 2) * 20.0f, 40, 20 );
+	}
+	if( box->height != 60 ) {
+		_DEBUG_MSG( "wrong height of wrapped box: %g\n", box->height );
+		ret = -1;
+	}
+	Widget_Destroy( box );
+	/* 在主轴和交叉轴上居中 */
+	box = NewFlexItem( LCUIWidget_GetRoot(), "flex-row" );
+	Widget_AddClass( box, "flex-center" );
+	w[0] = NewFlexItem( box, "flex-cell" );
+	w[1] = NewFlexItem( box, "flex-cell" );
+	UpdateWidgets();
+	ret |= CheckRect( w[0], "centered cell", 110, 15, 40, 20 );
+	ret |= CheckRect( w[1], "centered cell", 150, 15, 40, 20 );
+	/* 不再是弹性布局容器后，子部件按常规流排列 */
+	Widget_RemoveClass( box, "flex-row" );
+	UpdateWidgets();
+	ret |= CheckRect( w[0], "block cell", 0, 0, 40, 20 );
+	ret |= CheckRect( w[1], "block cell", 0, 20, 40, 20 );
+	Widget_Destroy( box );
+	UpdateWidgets();
+	return ret;
+}
+
+/** 创建多层嵌套的弹性布局容器，返回最后一个叶子部件 */
+static LCUI_Widget NewNestedFlexBox( int rows, int cells, float width,
+				     LCUI_Widget *box )
+{
+	int i, j;
+	LCUI_Widget row, cell, leaf = NULL;
+
+	*box = LCUIWidget_New( NULL );
+	Widget_AddClass( *box, "flex-bench" );
+	Widget_Resize( *box, width, 600 );
+	for( i = 0; i < rows; ++i ) {
+		row = NewFlexItem( *box, "flex-bench-row" );
+		for( j = 0; j < cells; ++j ) {
+			cell = NewFlexItem( row, "flex-bench-cell" );
+			NewFlexItem( cell, "flex-bench-leaf" );
+			leaf = NewFlexItem( cell, "flex-bench-leaf" );
+		}
+	}
+	return leaf;
+}
+
+/** 检查调整多层嵌套的弹性布局容器的尺寸后，内层部件的位置和尺寸 */
+static int TestNestedFlexLayout( void )
+{
+	int i, ret = 0;
+	float width = 800;
+	LCUI_Widget box, leaf;
+
+	leaf = NewNestedFlexBox( FLEX_ROWS, FLEX_CELLS, width, &box );
+	Widget_Append( LCUIWidget_GetRoot(), box );
+	UpdateWidgets();
+	ret |= CheckRect( leaf, "last leaf", 0, 600.0f / FLEX_ROWS / 2,
+			  width / FLEX_CELLS, 600.0f / FLEX_ROWS / 2 );
+	for( i = 0; i < FLEX_RESIZES; ++i ) {
+		width = 600.0f + (i % 2) * 200;
+		Widget_Resize( box, width, 600 );
+		UpdateWidgets();
+		ret |= CheckRect( leaf, "last leaf", 0, 600.0f / FLEX_ROWS / 2,
+				  width / FLEX_CELLS, 600.0f / FLEX_ROWS / 2 );
+	}
+	Widget_Destroy( box );
+	UpdateWidgets();
+	return ret;
+}
+
+int test_widget_layout( void )
+{
+	int ret = 0;
+	LCUI_InitBase();
+	LCUI_LoadCSSString( test_css, NULL );
+	ret |= TestIncrementalLayout();
+	ret |= TestDisplayChange();
+	ret |= TestFlexLayout();
+	ret |= TestNestedFlexLayout();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 测试向很长的列表中逐个追加部件，以及调整弹性布局容器的尺寸所需的时间 */
+void bench_widget_layout( void )
+{
+	int i;
+	int64_t t;
+	LCUI_Widget list;
+
+	LCUI_InitBase();
+	LCUI_LoadCSSString( test_css, NULL );
+	list = LCUIWidget_New( NULL );
+	Widget_AddClass( list, "layout-list" );
+	for( i = 0; i < BENCH_ITEMS; ++i ) {
+		Widget_Append( list, NewItem() );
+	}
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	t = LCUI_GetTime();
+	for( i = 0; i < BENCH_APPENDS; ++i ) {
+		Widget_Append( list, NewItem() );
+		UpdateWidgets();
+	}
+	_DEBUG_MSG( "appended %d items to a list of %d items in %dms\n",
+		    BENCH_APPENDS, BENCH_ITEMS, (int)LCUI_GetTimeDelta( t ) );
+	Widget_Destroy( list );
+	UpdateWidgets();
+	/* 调整多层嵌套的弹性布局容器的尺寸所需的时间 */
+	NewNestedFlexBox( BENCH_FLEX_ROWS, BENCH_FLEX_CELLS, 800, &list );
+	t = LCUI_GetTime();
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	_DEBUG_MSG( "laid out %d nested flex containers in %dms\n",
+		    BENCH_FLEX_ROWS * (BENCH_FLEX_CELLS + 1) + 1,
+		    (int)LCUI_GetTimeDelta( t ) );
+	t = LCUI_GetTime();
+	for( i = 0; i < BENCH_FLEX_RESIZES; ++i ) {
+		Widget_Resize( list, 600.0f + (i % 2) * 200, 600 );
+		UpdateWidgets();
+	}
+	_DEBUG_MSG( "resized nested flex containers %d times in %dms\n",
+		    BENCH_FLEX_RESIZES, (int)LCUI_GetTimeDelta( t ) );
+	Widget_Destroy( list );
+	UpdateWidgets();
+}
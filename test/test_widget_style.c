@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/css_parser.h>
+#include "test.h"
+
+#define ITEMS	500
+#define ROWS	100
+
+static const char *test_css =
+	".list .item { width: 10px; }\n"
+	".item.active { height: 20px; }\n"
+	"#special { height: 30px; }\n"
+	".list .item .icon { width: 4px; }\n"
+	".panel.expanded .cell { height: 12px; }\n"
+	".row:hover { width: 9px; }\n";
+
+static LCUI_Widget items[ITEMS];
+static LCUI_Widget icons[ITEMS];
+
+/** 检查部件共用的继承样式表是否与单独计算的结果一致 */
+static LCUI_BOOL CheckInheritStyle( LCUI_Widget w )
+{
+	int key;
+	LCUI_BOOL ok = TRUE;
+	LCUI_StyleSheet ss = StyleSheet();
+	LCUI_StyleSheet shared = w->inherited_style->sheet;
+
+	Widget_GetInheritStyle( w, ss );
+	for( key = 0; key < ss->length && key < shared->length; ++key ) {
+		if( ss->sheet[key].is_valid != shared->sheet[key].is_valid ) {
+			ok = FALSE;
+			break;
+		}
+		if( ss->sheet[key].is_valid &&
+		    ss->sheet[key].value != shared->sheet[key].value ) {
+			ok = FALSE;
+			break;
+		}
+	}
+	StyleSheet_Delete( ss );
+	return ok;
+}
+
+static int CheckAllItems( void )
+{
+	int i;
+	for( i = 0; i < ITEMS; ++i ) {
+		if( !CheckInheritStyle( items[i] ) ||
+		    !CheckInheritStyle( icons[i] ) ) {
+			_DEBUG_MSG( "item %d has wrong style\n", i );
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** 检查选择器相同的兄弟部件和堂兄弟部件是否共用继承样式表 */
+static int TestStyleSharing( void )
+{
+	int i, ret = 0;
+	LCUI_Widget list;
+	LCUI_SharedStyleSheet ss;
+
+	list = LCUIWidget_New( NULL );
+	Widget_AddClass( list, "list" );
+	for( i = 0; i < ITEMS; ++i ) {
+		items[i] = LCUIWidget_New( NULL );
+		icons[i] = LCUIWidget_New( NULL );
+		Widget_AddClass( items[i], "item" );
+		Widget_AddClass( icons[i], "icon" );
+		Widget_Append( items[i], icons[i] );
+		Widget_Append( list, items[i] );
+	}
+	Widget_AddClass( items[7], "active" );
+	Widget_SetId( items[9], "special" );
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	/* 第一个和最后一个部件有 first-child 和 last-child 状态 */
+	ss = items[1]->inherited_style;
+	for( i = 2; i < ITEMS - 1; ++i ) {
+		if( i == 7 || i == 9 ) {
+			continue;
+		}
+		if( items[i]->inherited_style != ss ) {
+			_DEBUG_MSG( "item %d does not share style\n", i );
+			ret = -1;
+			break;
+		}
+		if( icons[i]->inherited_style != icons[1]->inherited_style ) {
+			_DEBUG_MSG( "icon %d does not share style\n", i );
+			ret = -1;
+			break;
+		}
+	}
+	if( items[7]->inherited_style == ss ||
+	    items[9]->inherited_style == ss ) {
+		_DEBUG_MSG( "items with different selectors share style\n" );
+		ret = -1;
+	}
+	ret |= CheckAllItems();
+	/* 类被移除后，应该重新与兄弟部件共用样式表 */
+	Widget_RemoveClass( items[7], "active" );
+	UpdateWidgets();
+	if( items[7]->inherited_style != items[1]->inherited_style ) {
+		_DEBUG_MSG( "item 7 does not share style after update\n" );
+		ret = -1;
+	}
+	/* 样式库有变动后，不能再使用之前缓存的样式表 */
+	LCUI_LoadCSSString( ".list .item { height: 8px; }", NULL );
+	Widget_AddTaskForChildren( LCUIWidget_GetRoot(), WTT_REFRESH_STYLE );
+	UpdateWidgets();
+	ss = items[0]->inherited_style;
+	if( !CheckStyleType( ss->sheet->sheet, key_height, px ) ||
+	    ss->sheet->sheet[key_height].val_px != 8 ) {
+		_DEBUG_MSG( "stale shared style was reused\n" );
+		ret = -1;
+	}
+	ret |= CheckAllItems();
+	Widget_Destroy( list );
+	UpdateWidgets();
+	return ret;
+}
+
+/** 获取变动一次类或状态后被标记为需要刷新样式的部件数量 */
+static size_t GetRestyledCount( void )
+{
+	LCUI_WidgetStyleStatsRec stats;
+	LCUIWidget_GetStyleStats( &stats );
+	LCUIWidget_ResetStyleStats();
+	return stats.restyled;
+}
+
+static LCUI_BOOL CheckCellHeight( LCUI_Widget cell, float height )
+{
+	LCUI_Style s = &cell->style->sheet[key_height];
+	if( height > 0 ) {
+		return CheckStyleType( cell->style->sheet, key_height, px ) &&
+			s->val_px == height;
+	}
+	return !CheckStyleType( cell->style->sheet, key_height, px );
+}
+
+/** 检查类和状态的变动是否只刷新了受影响的部件 */
+static int TestStyleInvalidation( void )
+{
+	int i, ret = 0;
+	size_t count;
+	LCUI_Widget panel, rows[ROWS], cells[ROWS];
+
+	panel = LCUIWidget_New( NULL );
+	Widget_AddClass( panel, "panel" );
+	for( i = 0; i < ROWS; ++i ) {
+		rows[i] = LCUIWidget_New( NULL );
+		cells[i] = LCUIWidget_New( NULL );
+		Widget_AddClass( rows[i], "row" );
+		Widget_AddClass( cells[i], "cell" );
+		Widget_Append( rows[i], cells[i] );
+		Widget_Append( panel, rows[i] );
+	}
+	Widget_Append( LCUIWidget_GetRoot(), panel );
+	UpdateWidgets();
+	LCUIWidget_ResetStyleStats();
+	/* 没有选择器用到的类不影响任何部件 */
+	Widget_AddClass( panel, "unused" );
+	count = GetRestyledCount();
+	if( count != 0 ) {
+		_DEBUG_MSG( "unused class restyled %lu widgets\n",
+			    (unsigned long)count );
+		ret = -1;
+	}
+	/* 只用在最右边结点中的状态只影响部件自身 */
+	Widget_AddStatus( rows[5], "hover" );
+	count = GetRestyledCount();
+	if( count != 1 ) {
+		_DEBUG_MSG( "hover restyled %lu widgets\n",
+			    (unsigned long)count );
+		ret = -1;
+	}
+	/* 祖先结点中的类影响匹配的后代部件，以及它们之间的部件 */
+	Widget_AddClass( panel, "expanded" );
+	count = GetRestyledCount();
+	if( count != 1 + ROWS * 2 ) {
+		_DEBUG_MSG( "expanded restyled %lu widgets\n",
+			    (unsigned long)count );
+		ret = -1;
+	}
+	UpdateWidgets();
+	for( i = 0; i < ROWS; ++i ) {
+		if( !CheckCellHeight( cells[i], 12 ) ) {
+			_DEBUG_MSG( "cell %d was not restyled\n", i );
+			ret = -1;
+			break;
+		}
+	}
+	if( !CheckStyleType( rows[5]->style->sheet, key_width, px ) ||
+	    rows[5]->style->sheet[key_width].val_px != 9 ) {
+		_DEBUG_MSG( "hovered row was not restyled\n" );
+		ret = -1;
+	}
+	Widget_RemoveClass( panel, "expanded" );
+	UpdateWidgets();
+	for( i = 0; i < ROWS; ++i ) {
+		if( !CheckCellHeight( cells[i], 0 ) ) {
+			_DEBUG_MSG( "cell %d kept a stale style\n", i );
+			ret = -1;
+			break;
+		}
+	}
+	Widget_Destroy( panel );
+	UpdateWidgets();
+	return ret;
+}
+
+/** 检查祖先结点中的类变动后，以后添加的后代部件不会共用按旧的祖先结点计算的样式表 */
+static int TestAncestorChange( void )
+{
+	int i, ret = 0;
+	LCUI_Widget list, items[4], cells[4], x1, x2;
+
+	LCUI_LoadCSSString( ".share-a .share-x { width: 10px; }", NULL );
+	list = LCUIWidget_New( NULL );
+	/* 只比较中间的两个部件，首尾部件有 first-child 和 last-child 状态 */
+	for( i = 0; i < 4; ++i ) {
+		items[i] = LCUIWidget_New( NULL );
+		cells[i] = LCUIWidget_New( NULL );
+		Widget_AddClass( items[i], "share-w" );
+		Widget_AddClass( items[i], "share-a" );
+		Widget_Append( items[i], cells[i] );
+		Widget_Append( list, items[i] );
+	}
+	x1 = LCUIWidget_New( NULL );
+	x2 = LCUIWidget_New( NULL );
+	Widget_AddClass( x1, "share-x" );
+	Widget_AddClass( x2, "share-x" );
+	Widget_Append( items[1], x1 );
+	Widget_Append( cells[1], x2 );
+	/* 让两个单元格的状态保持一致 */
+	Widget_Append( items[2], LCUIWidget_New( NULL ) );
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	if( items[1]->inherited_style != items[2]->inherited_style ||
+	    cells[1]->inherited_style != cells[2]->inherited_style ) {
+		_DEBUG_MSG( "sibling items do not share style\n" );
+		ret = -1;
+	}
+	/* 现在没有受影响的后代部件，但以后添加的子部件和孙部件都不能匹配 */
+	Widget_RemoveClass( items[2], "share-a" );
+	UpdateWidgets();
+	x1 = LCUIWidget_New( NULL );
+	x2 = LCUIWidget_New( NULL );
+	Widget_AddClass( x1, "share-x" );
+	Widget_AddClass( x2, "share-x" );
+	Widget_Append( items[2], x1 );
+	Widget_Append( cells[2], x2 );
+	UpdateWidgets();
+	if( CheckStyleType( x1->style->sheet, key_width, px ) ) {
+		_DEBUG_MSG( "new child reused a stale shared style\n" );
+		ret = -1;
+	}
+	if( CheckStyleType( x2->style->sheet, key_width, px ) ) {
+		_DEBUG_MSG( "new grandchild reused a stale shared style\n" );
+		ret = -1;
+	}
+	Widget_Destroy( list );
+	UpdateWidgets();
+	return ret;
+}
+
+/** 查询样式表，返回缓存是否命中 */
+static LCUI_BOOL GetCachedStyleSheet( LCUI_Selector s, LCUI_StyleSheet ss )
+{
+	LCUI_StyleCacheStatsRec stats;
+	size_t hits;
+	LCUI_GetStyleCacheStats( &stats );
+	hits = stats.hits;
+	LCUI_GetStyleSheet( s, ss );
+	LCUI_GetStyleCacheStats( &stats );
+	return stats.hits > hits;
+}
+
+/** 检查样式表缓存的淘汰和失效是否只影响相应的记录 */
+static int TestStyleCache( void )
+{
+	int ret = 0;
+	size_t size;
+	LCUI_StyleSheet ss;
+	LCUI_StyleCacheStatsRec stats;
+	LCUI_Selector s1, s2, s3;
+
+	ss = StyleSheet();
+	s1 = Selector( ".cache-a .cache-item" );
+	s2 = Selector( ".cache-b .cache-other" );
+	s3 = Selector( ".cache-c .cache-third" );
+	/* 清空缓存 */
+	LCUI_SetStyleCacheMaxSize( 0 );
+	LCUI_SetStyleCacheMaxSize( 1024 * 1024 );
+	if( GetCachedStyleSheet( s1, ss ) || GetCachedStyleSheet( s2, ss ) ) {
+		_DEBUG_MSG( "empty cache was hit\n" );
+		ret = -1;
+	}
+	if( !GetCachedStyleSheet( s1, ss ) ) {
+		_DEBUG_MSG( "cached style sheet was not hit\n" );
+		ret = -1;
+	}
+	/* 新样式表只能使匹配它的缓存记录失效 */
+	LCUI_LoadCSSString( ".cache-b .cache-other { width: 3px; }", NULL );
+	if( !GetCachedStyleSheet( s1, ss ) ) {
+		_DEBUG_MSG( "unrelated cache entry was invalidated\n" );
+		ret = -1;
+	}
+	if( GetCachedStyleSheet( s2, ss ) ) {
+		_DEBUG_MSG( "stale cache entry was hit\n" );
+		ret = -1;
+	}
+	if( !CheckStyleType( ss->sheet, key_width, px ) ||
+	    ss->sheet[key_width].val_px != 3 ) {
+		_DEBUG_MSG( "new style sheet was not applied\n" );
+		ret = -1;
+	}
+	/* 超出内存上限时淘汰最久没有使用的记录 */
+	LCUI_GetStyleCacheStats( &stats );
+	size = stats.size;
+	LCUI_SetStyleCacheMaxSize( size + size / 4 );
+	GetCachedStyleSheet( s1, ss );
+	GetCachedStyleSheet( s3, ss );
+	LCUI_GetStyleCacheStats( &stats );
+	if( stats.size > stats.max_size || stats.count != 2 ) {
+		_DEBUG_MSG( "cache exceeded its limit\n" );
+		ret = -1;
+	}
+	if( !GetCachedStyleSheet( s1, ss ) ||
+	    GetCachedStyleSheet( s2, ss ) ) {
+		_DEBUG_MSG( "wrong cache entry was evicted\n" );
+		ret = -1;
+	}
+	LCUI_SetStyleCacheMaxSize( 2 * 1024 * 1024 );
+	Selector_Delete( s1 );
+	Selector_Delete( s2 );
+	Selector_Delete( s3 );
+	StyleSheet_Delete( ss );
+	return ret;
+}
+
+/** 检查部件 ID 只在被选择器用到时才有原子，并且仍能匹配样式 */
+static int TestWidgetId( void )
+{
+	int ret = 0;
+	LCUI_Widget w, special;
+
+	w = LCUIWidget_New( NULL );
+	special = LCUIWidget_New( NULL );
+	Widget_SetId( w, "no-style-for-this-id" );
+	Widget_SetId( special, "special" );
+	Widget_Append( LCUIWidget_GetRoot(), w );
+	Widget_Append( LCUIWidget_GetRoot(), special );
+	UpdateWidgets();
+	if( LCUIAtom_Find( "no-style-for-this-id" ) ) {
+		_DEBUG_MSG( "widget id was interned\n" );
+		ret = -1;
+	}
+	if( !CheckStyleType( special->style->sheet, key_height, px ) ||
+	    special->style->sheet[key_height].val_px != 30 ) {
+		_DEBUG_MSG( "id selector was not applied\n" );
+		ret = -1;
+	}
+	Widget_Destroy( w );
+	Widget_Destroy( special );
+	UpdateWidgets();
+	return ret;
+}
+
+int test_widget_style( void )
+{
+	int ret = 0;
+	LCUI_InitBase();
+	LCUI_LoadCSSString( test_css, NULL );
+	ret |= TestStyleSharing();
+	ret |= TestStyleInvalidation();
+	ret |= TestAncestorChange();
+	ret |= TestStyleCache();
+	ret |= TestWidgetId();
+	assert( ret == 0 );
+	return 0;
+}
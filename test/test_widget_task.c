@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include "test.h"
+
+#define MAX_RECORDS	64
+#define ITEMS		2000
+#define SPARSE_TASKS	32
+#define BENCH_ITEMS	20000
+#define BENCH_UPDATES	100
+
+/** 记录自定义任务的处理顺序 */
+static struct {
+	int length;
+	LCUI_Widget widgets[MAX_RECORDS];
+} records;
+
+static void OnRunTask( LCUI_Widget w )
+{
+	if( records.length < MAX_RECORDS ) {
+		records.widgets[records.length++] = w;
+	}
+}
+
+static void OnInit( LCUI_Widget w )
+{
+}
+
+static LCUI_Widget NewProbe( void )
+{
+	return LCUIWidget_New( "task-probe" );
+}
+
+/** 处理完全部任务，并清空处理记录 */
+static void ResetRecords( void )
+{
+	UpdateWidgets();
+	records.length = 0;
+}
+
+/** 获取部件的任务被处理的次序，没有被处理则返回 -1 */
+static int GetRecordIndex( LCUI_Widget w )
+{
+	int i, index = -1;
+	for( i = 0; i < records.length; ++i ) {
+		if( records.widgets[i] != w ) {
+			continue;
+		}
+		/* 每个部件的任务在一轮更新中只应该被处理一次 */
+		if( index >= 0 ) {
+			return -2;
+		}
+		index = i;
+	}
+	return index;
+}
+
+/** 检查父级部件的任务是否总是先于子级部件被处理 */
+static int TestTaskOrder( void )
+{
+	int ret = 0;
+	LCUI_Widget box, inner, leaf, sub;
+
+	box = NewProbe();
+	inner = NewProbe();
+	leaf = NewProbe();
+	Widget_Append( inner, leaf );
+	Widget_Append( box, inner );
+	Widget_Append( LCUIWidget_GetRoot(), box );
+	ResetRecords();
+	/* 任务添加的顺序与部件层级相反 */
+	Widget_AddTask( leaf, WTT_USER );
+	Widget_AddTask( inner, WTT_USER );
+	Widget_AddTask( box, WTT_USER );
+	UpdateWidgets();
+	if( GetRecordIndex( box ) != 0 || GetRecordIndex( inner ) != 1 ||
+	    GetRecordIndex( leaf ) != 2 ) {
+		_DEBUG_MSG( "children were updated before their parent\n" );
+		ret = -1;
+	}
+	ResetRecords();
+	/* 部件加入队列后被移动到了更浅的层级 */
+	Widget_AddTask( leaf, WTT_USER );
+	Widget_Append( box, leaf );
+	sub = NewProbe();
+	Widget_Append( leaf, sub );
+	Widget_AddTask( sub, WTT_USER );
+	UpdateWidgets();
+	if( GetRecordIndex( leaf ) < 0 ||
+	    GetRecordIndex( leaf ) > GetRecordIndex( sub ) ) {
+		_DEBUG_MSG( "moved widget was updated after its child\n" );
+		ret = -1;
+	}
+	ResetRecords();
+	Widget_Destroy( box );
+	ResetRecords();
+	return ret;
+}
+
+/** 检查不在根部件中的部件的任务是否会在它被添加到根部件后处理 */
+static int TestDetachedTasks( void )
+{
+	int ret = 0;
+	LCUI_Widget box, child;
+
+	box = NewProbe();
+	child = NewProbe();
+	Widget_Append( box, child );
+	ResetRecords();
+	Widget_AddTask( child, WTT_USER );
+	UpdateWidgets();
+	if( GetRecordIndex( child ) >= 0 ) {
+		_DEBUG_MSG( "detached widget was updated\n" );
+		ret = -1;
+	}
+	Widget_Append( LCUIWidget_GetRoot(), box );
+	UpdateWidgets();
+	if( GetRecordIndex( child ) < 0 ) {
+		_DEBUG_MSG( "pending task was lost after attaching\n" );
+		ret = -1;
+	}
+	ResetRecords();
+	/* 移除后的部件不应该再被处理 */
+	Widget_AddTask( child, WTT_USER );
+	Widget_Unlink( box );
+	UpdateWidgets();
+	if( GetRecordIndex( child ) >= 0 ) {
+		_DEBUG_MSG( "unlinked widget was updated\n" );
+		ret = -1;
+	}
+	Widget_Append( LCUIWidget_GetRoot(), box );
+	UpdateWidgets();
+	if( GetRecordIndex( child ) < 0 ) {
+		_DEBUG_MSG( "pending task was lost after relinking\n" );
+		ret = -1;
+	}
+	Widget_Destroy( box );
+	ResetRecords();
+	return ret;
+}
+
+/** 检查在大量部件中只有少数部件有任务时，只有这些部件会被处理 */
+static int TestSparseTasks( void )
+{
+	int i, ret = 0;
+	LCUI_Widget list, items[ITEMS];
+
+	list = NewProbe();
+	for( i = 0; i < ITEMS; ++i ) {
+		items[i] = NewProbe();
+		Widget_Append( list, items[i] );
+	}
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	ResetRecords();
+	for( i = 0; i < SPARSE_TASKS; ++i ) {
+		Widget_AddTask( items[i * 7919 % ITEMS], WTT_USER );
+	}
+	UpdateWidgets();
+	if( records.length != SPARSE_TASKS ) {
+		_DEBUG_MSG( "%d widgets were updated, expected %d\n",
+			    records.length, SPARSE_TASKS );
+		ret = -1;
+	}
+	for( i = 0; ret == 0 && i < SPARSE_TASKS; ++i ) {
+		if( GetRecordIndex( items[i * 7919 % ITEMS] ) < 0 ) {
+			_DEBUG_MSG( "pending task of item %d was lost\n",
+				    i * 7919 % ITEMS );
+			ret = -1;
+		}
+	}
+	Widget_Destroy( list );
+	ResetRecords();
+	return ret;
+}
+
+int test_widget_task( void )
+{
+	int ret = 0;
+	LCUI_WidgetPrototype proto;
+
+	LCUI_InitBase();
+	proto = LCUIWidget_NewPrototype( "task-probe", NULL );
+	if( proto ) {
+		proto->init = OnInit;
+		proto->runtask = OnRunTask;
+	}
+	ResetRecords();
+	ret |= TestTaskOrder();
+	ret |= TestDetachedTasks();
+	ret |= TestSparseTasks();
+	assert( ret == 0 );
+	return 0;
+}
+
+/** 测试在大量部件中只有少数部件有任务时的更新速度 */
+void bench_widget_task( void )
+{
+	int i;
+	int64_t t;
+	LCUI_Widget list, items[BENCH_ITEMS];
+
+	LCUI_InitBase();
+	list = LCUIWidget_New( NULL );
+	for( i = 0; i < BENCH_ITEMS; ++i ) {
+		items[i] = LCUIWidget_New( NULL );
+		Widget_Append( list, items[i] );
+	}
+	Widget_Append( LCUIWidget_GetRoot(), list );
+	UpdateWidgets();
+	t = LCUI_GetTime();
+	for( i = 0; i < BENCH_UPDATES; ++i ) {
+		Widget_AddTask( items[i * 7919 % BENCH_ITEMS], WTT_REFRESH );
+		LCUIWidget_Update();
+	}
+	_DEBUG_MSG( "%d updates of %d widgets in %dms\n", BENCH_UPDATES,
+		    BENCH_ITEMS, (int)LCUI_GetTimeDelta( t ) );
+	Widget_Destroy( list );
+	UpdateWidgets();
+}
@@ -0,0 +1,61 @@
+/*
+ * csscompiler -- 将 CSS 文件编译为二进制样式数据
+ *
+ * 用法：csscompiler -o <输出文件> <CSS 文件>...
+ *
+ * 编译时会初始化 LCUI 的基础模块，以便使用与应用程序相同的样式属性和解析器，
+ * 生成的文件可以用 LCUI_LoadCSSBinaryFile() 载入。
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/css_library.h>
+#include <LCUI/gui/css_binary.h>
+
+static void PrintUsage( const char *name )
+{
+	printf( "usage: %s -o <output> <file.css>...\n", name );
+}
+
+int main( int argc, char **argv )
+{
+	int i, ret = 0;
+	const char *output = NULL;
+	LCUI_CSSCompiler compiler;
+
+	for( i = 1; i < argc; ++i ) {
+		if( strcmp( argv[i], "-o" ) == 0 && i + 1 < argc ) {
+			output = argv[++i];
+		}
+	}
+	if( !output ) {
+		PrintUsage( argv[0] );
+		return -1;
+	}
+	LCUI_InitBase();
+	compiler = CSSCompiler();
+	for( i = 1; i < argc; ++i ) {
+		if( strcmp( argv[i], "-o" ) == 0 ) {
+			++i;
+			continue;
+		}
+		if( CSSCompiler_AddFile( compiler, argv[i] ) != 0 ) {
+			printf( "cannot read file: %s\n", argv[i] );
+			ret = -1;
+			break;
+		}
+	}
+	if( ret == 0 ) {
+		if( CSSCompiler_Save( compiler, output ) == 0 ) {
+			printf( "%lu rules compiled into %s\n", (unsigned long)
+				CSSCompiler_GetRuleCount( compiler ), output );
+		} else {
+			printf( "cannot write file: %s\n", output );
+			ret = -1;
+		}
+	}
+	CSSCompiler_Delete( compiler );
+	return ret;
+}